@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RoomVizMetrics.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpPath.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DelayedAutoRegister.h"
+#include "Misc/Parse.h"
+#include "room_viz.h"
+
+namespace RoomVizMetrics
+{
+    const double FHistogram::BoundsSeconds[NumBounds] = { 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0 };
+
+    FHistogram CatalogFetchSeconds;
+    FHistogram ImageDownloadSeconds;
+    FHistogram ImageDecodeSeconds;
+    FHistogram DropSeconds;
+    FCounter TextureCacheHits;
+    FCounter TextureCacheMisses;
+    FCounter PrefetchHits;
+    FCounter PrefetchMisses;
+    FGauge TileTextureBytes;
+    FGauge MaterialInstances;
+    FGauge QualityLevel;
+    FFrameTimeWindow FrameTimes;
+
+    void FHistogram::Observe(double Seconds)
+    {
+        int32 Bucket = 0;
+        while (Bucket < NumBounds && Seconds > BoundsSeconds[Bucket])
+        {
+            ++Bucket;
+        }
+        Counts[Bucket].fetch_add(1, std::memory_order_relaxed);
+        SumMicroseconds.fetch_add(uint64(FMath::Max(Seconds, 0.0) * 1e6), std::memory_order_relaxed);
+    }
+
+    void FHistogram::Snapshot(uint64 (&OutCounts)[NumBounds + 1], double& OutSumSeconds) const
+    {
+        for (int32 Bucket = 0; Bucket <= NumBounds; ++Bucket)
+        {
+            OutCounts[Bucket] = Counts[Bucket].load(std::memory_order_relaxed);
+        }
+        OutSumSeconds = SumMicroseconds.load(std::memory_order_relaxed) / 1e6;
+    }
+
+    void FFrameTimeWindow::Record(float Seconds)
+    {
+        const uint64 Index = Next.fetch_add(1, std::memory_order_relaxed);
+        Samples[Index % Capacity].store(Seconds, std::memory_order_relaxed);
+    }
+
+    TArray<float> FFrameTimeWindow::Snapshot() const
+    {
+        // A frame recorded during the copy may replace an old one; percentiles do not mind
+        const uint32 Num = uint32(FMath::Min<uint64>(Next.load(std::memory_order_relaxed), Capacity));
+        TArray<float> Out;
+        Out.Reserve(Num);
+        for (uint32 Index = 0; Index < Num; ++Index)
+        {
+            Out.Add(Samples[Index].load(std::memory_order_relaxed));
+        }
+        return Out;
+    }
+
+    namespace
+    {
+        void AppendHeader(FString& Out, const TCHAR* Name, const TCHAR* Type, const TCHAR* Help)
+        {
+            Out += FString::Printf(TEXT("# HELP %s %s\n# TYPE %s %s\n"), Name, Help, Name, Type);
+        }
+
+        void AppendHistogram(FString& Out, const TCHAR* Name, const TCHAR* Help, const FHistogram& Histogram)
+        {
+            uint64 Counts[FHistogram::NumBounds + 1];
+            double SumSeconds = 0.0;
+            Histogram.Snapshot(Counts, SumSeconds);
+
+            AppendHeader(Out, Name, TEXT("histogram"), Help);
+            uint64 Cumulative = 0;
+            for (int32 Bucket = 0; Bucket < FHistogram::NumBounds; ++Bucket)
+            {
+                Cumulative += Counts[Bucket];
+                Out += FString::Printf(TEXT("%s_bucket{le=\"%g\"} %llu\n"), Name, FHistogram::BoundsSeconds[Bucket], Cumulative);
+            }
+            Cumulative += Counts[FHistogram::NumBounds];
+            Out += FString::Printf(TEXT("%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.6f\n%s_count %llu\n"), Name, Cumulative, Name, SumSeconds, Name, Cumulative);
+        }
+
+        void AppendHitMiss(FString& Out, const TCHAR* Name, const TCHAR* Help, const FCounter& Hits, const FCounter& Misses)
+        {
+            AppendHeader(Out, Name, TEXT("counter"), Help);
+            Out += FString::Printf(TEXT("%s{result=\"hit\"} %llu\n%s{result=\"miss\"} %llu\n"), Name, Hits.Get(), Name, Misses.Get());
+        }
+
+        void AppendGauge(FString& Out, const TCHAR* Name, const TCHAR* Help, const FGauge& Gauge)
+        {
+            AppendHeader(Out, Name, TEXT("gauge"), Help);
+            Out += FString::Printf(TEXT("%s %lld\n"), Name, Gauge.Get());
+        }
+
+        void AppendFrameTimes(FString& Out)
+        {
+            TArray<float> Frames = FrameTimes.Snapshot();
+            Frames.Sort();
+
+            const TCHAR* Name = TEXT("roomviz_frame_time_seconds");
+            AppendHeader(Out, Name, TEXT("summary"), TEXT("Game frame time over the last 1024 frames."));
+            if (Frames.Num() > 0)
+            {
+                double Sum = 0.0;
+                for (float Frame : Frames)
+                {
+                    Sum += Frame;
+                }
+                for (const double Quantile : { 0.5, 0.95, 0.99 })
+                {
+                    const int32 Index = FMath::Clamp(FMath::CeilToInt32(Quantile * Frames.Num()) - 1, 0, Frames.Num() - 1);
+                    Out += FString::Printf(TEXT("%s{quantile=\"%g\"} %.6f\n"), Name, Quantile, Frames[Index]);
+                }
+                Out += FString::Printf(TEXT("%s_sum %.6f\n%s_count %d\n"), Name, Sum, Name, Frames.Num());
+            }
+        }
+
+        /** Reads atomics only, so it runs on any thread */
+        FString FormatMetrics()
+        {
+            FString Out;
+            AppendHistogram(Out, TEXT("roomviz_catalog_fetch_seconds"), TEXT("Time to fetch and merge the catalog from every source."), CatalogFetchSeconds);
+            AppendHistogram(Out, TEXT("roomviz_image_download_seconds"), TEXT("Time to download one tile image."), ImageDownloadSeconds);
+            AppendHistogram(Out, TEXT("roomviz_image_decode_seconds"), TEXT("Time to decode one tile image."), ImageDecodeSeconds);
+            AppendHistogram(Out, TEXT("roomviz_drop_seconds"), TEXT("Game-thread time to apply a dropped tile."), DropSeconds);
+            AppendHitMiss(Out, TEXT("roomviz_texture_cache_lookups_total"), TEXT("Downloaded images that reused a texture of identical bytes."), TextureCacheHits, TextureCacheMisses);
+            AppendHitMiss(Out, TEXT("roomviz_prefetch_drops_total"), TEXT("Drops whose PBR maps the palette prefetch had ready."), PrefetchHits, PrefetchMisses);
+            AppendGauge(Out, TEXT("roomviz_tile_texture_bytes"), TEXT("Memory of the tile textures held by tile object pools."), TileTextureBytes);
+            AppendGauge(Out, TEXT("roomviz_material_instances"), TEXT("Tile material instances held by tile object pools."), MaterialInstances);
+            AppendGauge(Out, TEXT("roomviz_quality_level"), TEXT("Adaptive quality rung, 0 = full quality."), QualityLevel);
+            AppendFrameTimes(Out);
+            return Out;
+        }
+
+        struct FEndpoint
+        {
+            int32 Port = 0;
+            TSharedPtr<IHttpRouter> Router;
+            FHttpRouteHandle Route;
+            FTSTicker::FDelegateHandle FrameTicker;
+            double LastFrameTime = 0.0;
+        };
+        TUniquePtr<FEndpoint> GEndpoint;
+
+        bool IsLoopback(const FString& Address)
+        {
+            return Address == TEXT("localhost") || Address == TEXT("::1") || Address.StartsWith(TEXT("127."));
+        }
+
+        /** The address the HTTPServer module will bind Port to, from [HTTPServer.Listeners] */
+        FString GetBindAddress(int32 Port)
+        {
+            FString Address;
+            GConfig->GetString(TEXT("HTTPServer.Listeners"), TEXT("DefaultBindAddress"), Address, GEngineIni);
+
+            TArray<FString> Overrides;
+            GConfig->GetArray(TEXT("HTTPServer.Listeners"), TEXT("ListenerOverrides"), Overrides, GEngineIni);
+            for (const FString& Override : Overrides)
+            {
+                int32 OverridePort = 0;
+                FString OverrideAddress;
+                if (FParse::Value(*Override, TEXT("Port="), OverridePort) && OverridePort == Port && FParse::Value(*Override, TEXT("BindAddress="), OverrideAddress))
+                {
+                    Address = OverrideAddress;
+                }
+            }
+            return Address;
+        }
+
+        bool HandleScrape(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+        {
+            AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [OnComplete]()
+            {
+                FString Text = FormatMetrics();
+                AsyncTask(ENamedThreads::GameThread, [OnComplete, Text = MoveTemp(Text)]()
+                {
+                    OnComplete(FHttpServerResponse::Create(Text, TEXT("text/plain; version=0.0.4")));
+                });
+            });
+            return true;
+        }
+
+        bool RecordFrame(float)
+        {
+            const double Now = FPlatformTime::Seconds();
+            if (GEndpoint->LastFrameTime > 0.0)
+            {
+                FrameTimes.Record(float(Now - GEndpoint->LastFrameTime));
+            }
+            GEndpoint->LastFrameTime = Now;
+            return true;
+        }
+    }
+
+    bool StartEndpoint(int32 Port)
+    {
+        if (GEndpoint)
+        {
+            return GEndpoint->Port == Port;
+        }
+
+        const FString Address = GetBindAddress(Port);
+        if (!IsLoopback(Address))
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Metrics: port %d would bind to '%s'; add +ListenerOverrides=(Port=%d,BindAddress=127.0.0.1) under [HTTPServer.Listeners]"),
+                Port, *Address, Port);
+            return false;
+        }
+
+        FHttpServerModule& HttpServer = FHttpServerModule::Get();
+        TSharedPtr<IHttpRouter> Router = HttpServer.GetHttpRouter(Port, /*bFailOnBindFailure*/ true);
+        if (!Router.IsValid())
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Metrics: could not bind port %d"), Port);
+            return false;
+        }
+
+        GEndpoint = MakeUnique<FEndpoint>();
+        GEndpoint->Port = Port;
+        GEndpoint->Router = Router;
+        GEndpoint->Route = Router->BindRoute(FHttpPath(TEXT("/metrics")), EHttpServerRequestVerbs::VERB_GET, FHttpRequestHandler::CreateStatic(&HandleScrape));
+        GEndpoint->FrameTicker = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&RecordFrame));
+        HttpServer.StartAllListeners();
+
+        // The router has to go before the HTTPServer module does
+        FCoreDelegates::OnPreExit.AddStatic(&StopEndpoint);
+
+        UE_LOG(LogRoomViz, Display, TEXT("Metrics: serving http://%s:%d/metrics"), *Address, Port);
+        return true;
+    }
+
+    void StopEndpoint()
+    {
+        if (!GEndpoint)
+        {
+            return;
+        }
+        FTSTicker::GetCoreTicker().RemoveTicker(GEndpoint->FrameTicker);
+        GEndpoint->Router->UnbindRoute(GEndpoint->Route);
+        GEndpoint.Reset();
+    }
+
+    void StartEndpointIfConfigured()
+    {
+        const URoomVizTileSettings* Settings = URoomVizTileSettings::Get();
+        int32 Port = Settings->bMetricsEndpoint ? Settings->MetricsPort : 0;
+        FParse::Value(FCommandLine::Get(), TEXT("RoomVizMetricsPort="), Port);
+        if (Port > 0)
+        {
+            StartEndpoint(Port);
+        }
+    }
+
+    /** Games and editors; commandlets run before this and start it from FRoomVizHeadlessSession */
+    static FDelayedAutoRegisterHelper GStartEndpointAtEngineInit(EDelayedRegisterRunPhase::EndOfEngineInit, []()
+    {
+        if (!IsRunningCommandlet() && !GIsEditor)
+        {
+            StartEndpointIfConfigured();
+        }
+    });
+}
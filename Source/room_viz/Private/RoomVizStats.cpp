@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RoomVizStats.h"
+
+DEFINE_STAT(STAT_RoomViz_CatalogFetch);
+DEFINE_STAT(STAT_RoomViz_CatalogParse);
+DEFINE_STAT(STAT_RoomViz_ImageDownload);
+DEFINE_STAT(STAT_RoomViz_ImageDecode);
+DEFINE_STAT(STAT_RoomViz_TextureUpload);
+DEFINE_STAT(STAT_RoomViz_ORMPack);
+DEFINE_STAT(STAT_RoomViz_MIDCreation);
+DEFINE_STAT(STAT_RoomViz_PaletteBuild);
+DEFINE_STAT(STAT_RoomViz_HoverTrace);
+DEFINE_STAT(STAT_RoomViz_Drop);
+DEFINE_STAT(STAT_RoomViz_BoxSelect);
+DEFINE_STAT(STAT_RoomViz_PreviewSwap);
+DEFINE_STAT(STAT_RoomViz_WorkQueue);
+DEFINE_STAT(STAT_RoomViz_InboxDrain);
+DEFINE_STAT(STAT_RoomViz_PoolTrim);
+
+DEFINE_STAT(STAT_RoomViz_CatalogFetchLatency);
+DEFINE_STAT(STAT_RoomViz_ImageDownloadLatency);
+DEFINE_STAT(STAT_RoomViz_PrefetchHitRate);
+
+DEFINE_STAT(STAT_RoomViz_PendingImages);
+DEFINE_STAT(STAT_RoomViz_QueuedWork);
+DEFINE_STAT(STAT_RoomViz_InboxCompletions);
+DEFINE_STAT(STAT_RoomViz_NumTileTextures);
+DEFINE_STAT(STAT_RoomViz_NumMIDs);
+DEFINE_STAT(STAT_RoomViz_DownloadedBytes);
+DEFINE_STAT(STAT_RoomViz_DedupSavedBytes);
+DEFINE_STAT(STAT_RoomViz_NumSharedTiles);
+DEFINE_STAT(STAT_RoomViz_PrefetchesInFlight);
+DEFINE_STAT(STAT_RoomViz_PrefetchWastedBytes);
+DEFINE_STAT(STAT_RoomViz_QualityLevel);
+
+UE_TRACE_CHANNEL_DEFINE(RoomVizChannel);
+
+LLM_DEFINE_TAG(RoomViz);
+LLM_DEFINE_TAG(RoomViz_TileTextures, NAME_None, TEXT("RoomViz"));
+LLM_DEFINE_TAG(RoomViz_PaletteWidgets, NAME_None, TEXT("RoomViz"));
+LLM_DEFINE_TAG(RoomViz_MaterialInstances, NAME_None, TEXT("RoomViz"));
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/AdaptiveQualityPolicy.h"
+
+FAdaptiveQualityPolicy::FAdaptiveQualityPolicy(const FConfig& InConfig)
+    : Config(InConfig)
+{
+    Config.NumLevels = FMath::Max(Config.NumLevels, 1);
+    Config.TargetFrameMs = FMath::Max(Config.TargetFrameMs, 1.f);
+    CurrentUpSeconds = Config.UpSeconds;
+}
+
+int32 FAdaptiveQualityPolicy::Update(const FAdaptiveQualitySample& Sample)
+{
+    const float DeltaSeconds = FMath::Max(Sample.DeltaSeconds, 0.f);
+    SecondsIdle = Sample.bInteracting ? 0.f : SecondsIdle + DeltaSeconds;
+    SecondsSinceRaise += DeltaSeconds;
+
+    // A raise that held through its trial was right; forget the backoff earned before it
+    if (bRaiseOnTrial && SecondsSinceRaise > CurrentUpSeconds * 2.f)
+    {
+        bRaiseOnTrial = false;
+        CurrentUpSeconds = Config.UpSeconds;
+    }
+
+    if (SettleLeft > 0.f)
+    {
+        SettleLeft -= DeltaSeconds;
+        return Level;
+    }
+
+    // Whichever of the CPU or the GPU is the bottleneck decides
+    const float CostMs = FMath::Max(Sample.FrameMs, Sample.GPUMs);
+    if (CostMs > Config.TargetFrameMs * Config.DownRatio)
+    {
+        OverSeconds += DeltaSeconds;
+        UnderSeconds = 0.f;
+    }
+    else if (CostMs < Config.TargetFrameMs * Config.UpRatio)
+    {
+        UnderSeconds += DeltaSeconds;
+        OverSeconds = 0.f;
+    }
+    else
+    {
+        // Inside the band: a lone hitch fades out instead of counting toward a drop
+        OverSeconds = FMath::Max(OverSeconds - DeltaSeconds, 0.f);
+        UnderSeconds = 0.f;
+    }
+
+    const float DownSeconds = Sample.bInteracting ? Config.InteractiveDownSeconds : Config.DownSeconds;
+    if (OverSeconds >= DownSeconds && Level < Config.NumLevels - 1)
+    {
+        if (bRaiseOnTrial)
+        {
+            bRaiseOnTrial = false;
+            ++NumFailedRaises;
+            CurrentUpSeconds = FMath::Min(CurrentUpSeconds * 2.f, Config.MaxUpSeconds);
+        }
+        ++NumDrops;
+        ChangeLevel(Level + 1);
+    }
+    else if (Level > 0 && !Sample.bInteracting && SecondsIdle >= Config.IdleSeconds && UnderSeconds >= CurrentUpSeconds)
+    {
+        ++NumRaises;
+        bRaiseOnTrial = true;
+        SecondsSinceRaise = 0.f;
+        ChangeLevel(Level - 1);
+    }
+    return Level;
+}
+
+void FAdaptiveQualityPolicy::SetLevel(int32 InLevel)
+{
+    ChangeLevel(FMath::Clamp(InLevel, 0, Config.NumLevels - 1));
+}
+
+void FAdaptiveQualityPolicy::ChangeLevel(int32 NewLevel)
+{
+    Level = NewLevel;
+    OverSeconds = 0.f;
+    UnderSeconds = 0.f;
+    SettleLeft = Config.SettleSeconds;
+}
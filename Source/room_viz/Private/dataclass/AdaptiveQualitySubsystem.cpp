@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/AdaptiveQualitySubsystem.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "RenderCore.h"
+#include "RHI.h"
+#include "RoomVizMetrics.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+static TAutoConsoleVariable<bool> CVarAdaptiveQuality(
+    TEXT("RoomViz.Quality.Adaptive"),
+    true,
+    TEXT("Step down the quality ladder of the tile settings when frames miss the target. Needs bAdaptiveQuality in the settings."));
+
+static TAutoConsoleVariable<int32> CVarForceQualityLevel(
+    TEXT("RoomViz.Quality.ForceLevel"),
+    -1,
+    TEXT("Pin the adaptive quality ladder to this rung (0 = full quality); -1 lets the controller decide."));
+
+static FAutoConsoleCommand CmdQualityReport(
+    TEXT("RoomViz.Quality.Report"),
+    TEXT("Log the adaptive quality level, the frame and GPU times it sees and how often it changed."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UAdaptiveQualitySubsystem* Quality = UAdaptiveQualitySubsystem::Get(World))
+        {
+            Quality->LogReport();
+        }
+    }));
+
+namespace AdaptiveQuality
+{
+    /** How long a single NoteInteraction keeps the controller in interactive mode */
+    constexpr double InteractionHoldSeconds = 0.5;
+}
+
+UAdaptiveQualitySubsystem* UAdaptiveQualitySubsystem::Get(const UWorld* World)
+{
+    return World ? World->GetSubsystem<UAdaptiveQualitySubsystem>() : nullptr;
+}
+
+bool UAdaptiveQualitySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+    const UWorld* World = Cast<UWorld>(Outer);
+    const URoomVizTileSettings* Settings = URoomVizTileSettings::Get();
+    return World && World->IsGameWorld() && FApp::CanEverRender() && !IsRunningDedicatedServer()
+        && Settings->bAdaptiveQuality && Settings->QualityLadder.Num() > 0 && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UAdaptiveQualitySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    const URoomVizTileSettings* Settings = URoomVizTileSettings::Get();
+    for (const FQualityStepConfig& Step : Settings->QualityLadder)
+    {
+        for (const TPair<FString, FString>& Variable : Step.ConsoleVariables)
+        {
+            if (StartupValues.Contains(Variable.Key))
+            {
+                continue;
+            }
+            if (const IConsoleVariable* ConsoleVariable = IConsoleManager::Get().FindConsoleVariable(*Variable.Key))
+            {
+                StartupValues.Add(Variable.Key, ConsoleVariable->GetString());
+            }
+            else
+            {
+                UE_LOG(LogRoomViz, Warning, TEXT("Quality: rung %s sets unknown console variable %s"), *Step.Name.ToString(), *Variable.Key);
+            }
+        }
+    }
+
+    FAdaptiveQualityPolicy::FConfig Config;
+    Config.TargetFrameMs = Settings->TargetFrameMs;
+    Config.NumLevels = Settings->QualityLadder.Num() + 1;
+    Policy = MakeUnique<FAdaptiveQualityPolicy>(Config);
+}
+
+void UAdaptiveQualitySubsystem::Deinitialize()
+{
+    ApplyLevel(0);
+    Policy.Reset();
+    Super::Deinitialize();
+}
+
+TStatId UAdaptiveQualitySubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UAdaptiveQualitySubsystem, STATGROUP_Tickables);
+}
+
+void UAdaptiveQualitySubsystem::NoteInteraction()
+{
+    LastInteractionTime = FPlatformTime::Seconds();
+}
+
+void UAdaptiveQualitySubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if (!Policy)
+    {
+        return;
+    }
+    if (!CVarAdaptiveQuality.GetValueOnGameThread())
+    {
+        Policy->SetLevel(0);
+        ApplyLevel(0);
+        return;
+    }
+
+    FAdaptiveQualitySample Sample;
+    Sample.DeltaSeconds = DeltaTime;
+    // Thread times are the previous frame's; GPU time lags a frame or two more, which the policy's windows absorb
+    Sample.FrameMs = float(FPlatformTime::ToMilliseconds(FMath::Max(GGameThreadTime, GRenderThreadTime)));
+    Sample.GPUMs = float(FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles()));
+    Sample.bInteracting = LastInteractionTime >= 0.0 && FPlatformTime::Seconds() - LastInteractionTime < AdaptiveQuality::InteractionHoldSeconds;
+
+    AverageFrameMs = FMath::Lerp(AverageFrameMs, Sample.FrameMs, 0.1f);
+    AverageGPUMs = FMath::Lerp(AverageGPUMs, Sample.GPUMs, 0.1f);
+
+    const int32 ForcedLevel = CVarForceQualityLevel.GetValueOnGameThread();
+    if (ForcedLevel >= 0)
+    {
+        Policy->SetLevel(ForcedLevel);
+    }
+    else
+    {
+        Policy->Update(Sample);
+    }
+    ApplyLevel(Policy->GetLevel());
+}
+
+void UAdaptiveQualitySubsystem::ApplyLevel(int32 Level)
+{
+    if (Level == AppliedLevel)
+    {
+        return;
+    }
+
+    // Later rungs override earlier ones; anything no rung down to Level mentions is back at its startup value
+    const TArray<FQualityStepConfig>& Ladder = URoomVizTileSettings::Get()->QualityLadder;
+    TMap<FString, FString> Values = StartupValues;
+    for (int32 Step = 0; Step < FMath::Min(Level, Ladder.Num()); ++Step)
+    {
+        for (const TPair<FString, FString>& Variable : Ladder[Step].ConsoleVariables)
+        {
+            if (Values.Contains(Variable.Key))
+            {
+                Values[Variable.Key] = Variable.Value;
+            }
+        }
+    }
+
+    for (const TPair<FString, FString>& Variable : Values)
+    {
+        IConsoleVariable* ConsoleVariable = IConsoleManager::Get().FindConsoleVariable(*Variable.Key);
+        if (ConsoleVariable && ConsoleVariable->GetString() != Variable.Value)
+        {
+            ConsoleVariable->Set(*Variable.Value, ECVF_SetByCode);
+        }
+    }
+
+    UE_LOG(LogRoomViz, Log, TEXT("Quality: level %d -> %d (%s), frame %.1f ms, GPU %.1f ms"), AppliedLevel, Level,
+        Level > 0 && Level <= Ladder.Num() ? *Ladder[Level - 1].Name.ToString() : TEXT("full"), AverageFrameMs, AverageGPUMs);
+    AppliedLevel = Level;
+    SET_DWORD_STAT(STAT_RoomViz_QualityLevel, AppliedLevel);
+    RoomVizMetrics::QualityLevel.Set(AppliedLevel);
+}
+
+void UAdaptiveQualitySubsystem::LogReport() const
+{
+    const TArray<FQualityStepConfig>& Ladder = URoomVizTileSettings::Get()->QualityLadder;
+    UE_LOG(LogRoomViz, Display, TEXT("Quality: level %d of %d (%s)%s, target %.1f ms, frame %.1f ms, GPU %.1f ms"),
+        AppliedLevel, Ladder.Num(), AppliedLevel > 0 && AppliedLevel <= Ladder.Num() ? *Ladder[AppliedLevel - 1].Name.ToString() : TEXT("full"),
+        CVarForceQualityLevel.GetValueOnGameThread() >= 0 ? TEXT(", forced") : TEXT(""),
+        Policy ? Policy->GetConfig().TargetFrameMs : 0.f, AverageFrameMs, AverageGPUMs);
+    if (Policy)
+    {
+        UE_LOG(LogRoomViz, Display, TEXT("  %d drops, %d raises (%d undone), next raise after %.1f s under target"),
+            Policy->GetNumDrops(), Policy->GetNumRaises(), Policy->GetNumFailedRaises(), Policy->GetCurrentUpSeconds());
+    }
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/FrameBudgetedWorkQueue.h"
+#include "RoomVizStats.h"
+
+void FFrameBudgetedWorkQueue::Enqueue(ERoomVizWorkPriority Priority, FWork&& Work)
+{
+    check(IsInGameThread());
+    Lanes[(int32)Priority].Items.Add(MoveTemp(Work));
+    INC_DWORD_STAT(STAT_RoomViz_QueuedWork);
+}
+
+int32 FFrameBudgetedWorkQueue::Drain(double BudgetSeconds)
+{
+    check(IsInGameThread());
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_WorkQueue);
+
+    const double EndTime = FPlatformTime::Seconds() + BudgetSeconds;
+    int32 NumRun = 0;
+    for (FLane& Lane : Lanes)
+    {
+        // Work may enqueue more work, so the lane is re-read every iteration
+        while (Lane.Head < Lane.Items.Num())
+        {
+            if (NumRun > 0 && FPlatformTime::Seconds() >= EndTime)
+            {
+                break;
+            }
+
+            FWork Work = MoveTemp(Lane.Items[Lane.Head++]);
+            DEC_DWORD_STAT(STAT_RoomViz_QueuedWork);
+            Work();
+            ++NumRun;
+        }
+
+        if (Lane.Head >= Lane.Items.Num())
+        {
+            Lane.Items.Reset();
+            Lane.Head = 0;
+        }
+        else if (FPlatformTime::Seconds() >= EndTime)
+        {
+            break;
+        }
+    }
+    return NumRun;
+}
+
+int32 FFrameBudgetedWorkQueue::Num() const
+{
+    int32 Count = 0;
+    for (const FLane& Lane : Lanes)
+    {
+        Count += Lane.Items.Num() - Lane.Head;
+    }
+    return Count;
+}
+
+void FFrameBudgetedWorkQueue::Reset()
+{
+    DEC_DWORD_STAT_BY(STAT_RoomViz_QueuedWork, Num());
+    for (FLane& Lane : Lanes)
+    {
+        Lane.Items.Reset();
+        Lane.Head = 0;
+    }
+}
@@ -11,6 +11,39 @@
 #include "ImageUtils.h"
 #include "IImageWrapper.h"
 #include "IImageWrapperModule.h"
+#include "dataclass/TileCatalogSources.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "dataclass/TilePBRPacking.h"
+#include "dataclass/TileObjectPool.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "RoomVizMetrics.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+static TAutoConsoleVariable<float> CVarWorkBudgetMs(
+	TEXT("RoomViz.WorkBudgetMs"),
+	2.f,
+	TEXT("Game-thread time per frame for tile finalization work (texture creation, palette entries), in milliseconds."));
+
+namespace
+{
+	UTexture2D* CreateTileTexture(UTileObjectPool& Pool, FIntPoint Size, const TArray<uint8>& BGRA, TextureCompressionSettings Compression, bool bSRGB)
+	{
+		ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_TextureUpload);
+		LLM_SCOPE_BYTAG(RoomViz_TileTextures);
+
+		UTexture2D* Tex = Pool.CreateTexture(Size, PF_B8G8R8A8);
+		void* Dest = Tex->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
+		FMemory::Memcpy(Dest, BGRA.GetData(), BGRA.Num());
+		Tex->GetPlatformData()->Mips[0].BulkData.Unlock();
+		Tex->CompressionSettings = Compression;
+		Tex->SRGB = bSRGB;
+		Tex->UpdateResource();
+		return Tex;
+	}
+}
 
 // Sets default values
 AMaterialAPIManager::AMaterialAPIManager()
@@ -33,88 +66,679 @@ void AMaterialAPIManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	// Finished transfers first, then the work they queued, sharing one budget
+	const double BudgetSeconds = GetWorkBudgetSeconds();
+	const double StartTime = FPlatformTime::Seconds();
+	if (!Inbox->IsEmpty())
+		Inbox->Drain(BudgetSeconds);
+	if (!WorkQueue.IsEmpty())
+		WorkQueue.Drain(FMath::Max(BudgetSeconds - (FPlatformTime::Seconds() - StartTime), 0.0));
 }
+
+void AMaterialAPIManager::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	AMaterialAPIManager* This = CastChecked<AMaterialAPIManager>(InThis);
+	This->TextureCache.AddReferencedObjects(Collector);
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+double AMaterialAPIManager::GetWorkBudgetSeconds()
+{
+	return CVarWorkBudgetMs.GetValueOnGameThread() / 1000.0;
+}
+
 void AMaterialAPIManager::FetchTileMaterials()
 {
-    const FString Url = TEXT("https://raw.githubusercontent.com/Ghanshyam-Shinde/realestateinfo/refs/heads/master/FloorTiles.json");
+    if (Sources.Num() == 0)
+    {
+        if (!CatalogURL.IsEmpty())
+            Sources.Add(MakeShared<FHttpTileCatalogSource>(CatalogURL, 0));
+        else
+            Sources = URoomVizTileSettings::Get()->CreateCatalogSources();
+    }
+
+    if (Sources.Num() == 0)
+    {
+        UE_LOG(LogRoomViz, Warning, TEXT("No tile catalog sources configured"));
+        return;
+    }
 
-    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
-    Request->OnProcessRequestComplete().BindUObject(this, &AMaterialAPIManager::OnResponseReceived);
-    Request->SetURL(Url);
-    Request->SetVerb("GET");
-    Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-    Request->ProcessRequest();
+    LoadAnalysisCache();
+
+    const int32 Generation = ++FetchGeneration;
+    PendingCatalogs = Sources.Num();
+    SourceCatalogs.Reset();
+    SourceCatalogs.SetNum(Sources.Num());
+    FetchStartTime = FPlatformTime::Seconds();
+
+    TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+    for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); ++SourceIndex)
+    {
+        Sources[SourceIndex]->FetchCatalog([WeakThis, Generation, SourceIndex](bool bSuccess, TArray<FTileMaterialData>&& Tiles)
+        {
+            if (AMaterialAPIManager* Manager = WeakThis.Get())
+                Manager->OnCatalogFetched(Generation, SourceIndex, bSuccess, MoveTemp(Tiles));
+        });
+    }
 }
-void AMaterialAPIManager::OnResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+
+void AMaterialAPIManager::SetCatalogSources(const TArray<TSharedRef<ITileCatalogSource>>& InSources)
+{
+    Sources = InSources;
+}
+
+void AMaterialAPIManager::OnCatalogFetched(int32 Generation, int32 SourceIndex, bool bSuccess, TArray<FTileMaterialData>&& Tiles)
+{
+	if (Generation != FetchGeneration || !SourceCatalogs.IsValidIndex(SourceIndex))
+		return;
+
+	if (bSuccess)
+		SourceCatalogs[SourceIndex] = MoveTemp(Tiles);
+	else
+		UE_LOG(LogRoomViz, Error, TEXT("Tile catalog source %s failed"), *Sources[SourceIndex]->GetSourceName().ToString());
+
+	if (--PendingCatalogs == 0)
+	{
+		// The whole fetch, request to merge, rather than the few microseconds of sending it
+		const double FetchSeconds = FPlatformTime::Seconds() - FetchStartTime;
+		SET_CYCLE_COUNTER(STAT_RoomViz_CatalogFetch, uint32(FMath::Min(FetchSeconds / FPlatformTime::GetSecondsPerCycle(), double(MAX_uint32))));
+		SET_FLOAT_STAT(STAT_RoomViz_CatalogFetchLatency, FetchSeconds * 1000.0);
+		RoomVizMetrics::CatalogFetchSeconds.Observe(FetchSeconds);
+		MergeCatalogs();
+	}
+}
+
+void AMaterialAPIManager::MergeCatalogs()
 {
-	if (!bWasSuccessful || !Response.IsValid()) return;
+	// Highest priority first; the first source to list an ID owns it
+	TArray<int32> Order;
+	for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); ++SourceIndex)
+		Order.Add(SourceIndex);
+	Order.StableSort([this](int32 A, int32 B) { return Sources[A]->GetPriority() > Sources[B]->GetPriority(); });
 
-	TSharedPtr<FJsonObject> Root;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid()) return;
+	for (FTileMaterialData& Tile : ParsedTiles)
+	{
+		TextureCache.Release(Tile.ID);
+		ReleaseTileTextures(Tile);
+	}
+	ParsedTiles.Reset();
+	TileSourceIndex.Reset();
+	const bool bPBRMaps = URoomVizTileSettings::Get()->bTilePBRMaps;
+	for (int32 SourceIndex : Order)
+	{
+		for (FTileMaterialData& Tile : SourceCatalogs[SourceIndex])
+		{
+			if (TileSourceIndex.Contains(Tile.ID))
+				continue;
 
-	const TArray<TSharedPtr<FJsonValue>>* Array;
-	if (!Root->TryGetArrayField(TEXT("Tiles"), Array)) return;
+			// Without bTilePBRMaps a tile is its base color; nothing fetches or binds the other maps
+			if (!bPBRMaps)
+				Tile.ClearPBRMaps();
 
-	ParsedTiles.Empty();
-	PendingImages = 0;
+			Tile.SourceName = Sources[SourceIndex]->GetSourceName();
+			TileSourceIndex.Add(Tile.ID, SourceIndex);
+			ParsedTiles.Add(MoveTemp(Tile));
+		}
+	}
+	SourceCatalogs.Reset();
+
+	PendingImages = ParsedTiles.Num();
+	SET_DWORD_STAT(STAT_RoomViz_PendingImages, PendingImages);
+	UE_LOG(LogRoomViz, Log, TEXT("Tile catalog merged: %d tiles from %d sources"), ParsedTiles.Num(), Sources.Num());
+
+	ApplyCachedAnalyses();
+	OnCatalogMerged.Broadcast(ParsedTiles);
+
+	if (ParsedTiles.Num() == 0)
+	{
+		OnMaterialsReady.Broadcast(ParsedTiles);
+		OnCatalogComplete.Broadcast(ParsedTiles);
+		return;
+	}
 
-	for (auto& Val : *Array)
+	const int32 Generation = FetchGeneration;
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	DuplicateTiles.Reset();
+	DecodingByHash.Reset();
+	DeferredPBRFetches.Reset();
+	PBRMapBytes.Reset();
+	DiscardedPBRBytes = 0;
+	NumDownloadsSkipped = 0;
+	NumDecodesSkipped = 0;
+	TMap<TPair<int32, FString>, FString> FetchingTileByURL;
+	for (const FTileMaterialData& Tile : ParsedTiles)
 	{
-		if (auto Obj = Val->AsObject())
+		const int32 SourceIndex = TileSourceIndex[Tile.ID];
+		if (Tile.HasPBRMaps() && !Sources[SourceIndex]->HasCookedTextures() && !bDeferPBRMaps)
 		{
-			FTileMaterialData Tile;
-			Tile.ID = Obj->GetStringField("id");
-			Tile.BaseColorURL = Obj->GetStringField("baseColorUrl");
-			ParsedTiles.Add(Tile);
-			PendingImages++;
-			DownloadTileImage(Tile.BaseColorURL, Tile.ID);
+			// The whole set counts as one pending image
+			++PendingImages;
+			SET_DWORD_STAT(STAT_RoomViz_PendingImages, PendingImages);
+			FetchPBRMaps(*Sources[SourceIndex], Tile, Generation);
 		}
+
+		// Entries pointing at the same image of the same source are fetched once
+		if (const FString* LeadTileID = FetchingTileByURL.Find(TPair<int32, FString>(SourceIndex, Tile.BaseColorURL)))
+		{
+			DuplicateTiles.FindOrAdd(*LeadTileID).Add(Tile.ID);
+			++NumDownloadsSkipped;
+			continue;
+		}
+		FetchingTileByURL.Add(TPair<int32, FString>(SourceIndex, Tile.BaseColorURL), Tile.ID);
+
+		ITileCatalogSource& Source = *Sources[SourceIndex];
+		if (Source.HasCookedTextures())
+		{
+			Source.FetchTexture(Tile, [WeakThis, Generation, TileID = Tile.ID](UTexture2D* Texture)
+			{
+				if (AMaterialAPIManager* Manager = WeakThis.Get())
+					Manager->OnTextureFetched(Generation, TileID, Texture);
+			});
+			continue;
+		}
+
+		ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_ImageDownload);
+
+		// Runs on the transfer's thread: hash there, resolve the manager on the game thread
+		const double StartTime = FPlatformTime::Seconds();
+		Source.FetchImage(Tile.BaseColorURL, [WeakThis, Inbox = Inbox, Generation, TileID = Tile.ID, StartTime](bool bSuccess, FTileImagePayloadPtr Payload)
+		{
+			SET_FLOAT_STAT(STAT_RoomViz_ImageDownloadLatency, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+			RoomVizMetrics::ImageDownloadSeconds.Observe(FPlatformTime::Seconds() - StartTime);
+			const uint64 BytesHash = bSuccess && Payload.IsValid() ? FTileTextureCache::HashBytes(Payload->GetBytes()) : 0;
+			Inbox->Push([WeakThis, Generation, TileID, bSuccess, Payload, BytesHash]()
+			{
+				if (AMaterialAPIManager* Manager = WeakThis.Get())
+					Manager->OnImageFetched(Generation, TileID, bSuccess, Payload, BytesHash);
+			});
+		});
 	}
 }
 
-void AMaterialAPIManager::DownloadTileImage(const FString& URL, const FString& TileID)
+void AMaterialAPIManager::OnTextureFetched(int32 Generation, const FString& TileID, UTexture2D* Texture)
+{
+	if (Generation != FetchGeneration)
+		return;
+
+	if (!Texture)
+		UE_LOG(LogRoomViz, Warning, TEXT("Failed to load cooked texture for tile %s"), *TileID);
+
+	CompleteTile(TileID, Texture);
+}
+
+void AMaterialAPIManager::OnImageFetched(int32 Generation, const FString& TileID, bool bSuccess, FTileImagePayloadPtr Payload, uint64 BytesHash)
 {
-	auto Req = FHttpModule::Get().CreateRequest();
-	Req->OnProcessRequestComplete().BindLambda(
-		[this, TileID](FHttpRequestPtr R, FHttpResponsePtr Res, bool bOK)
-		{ OnImageDownloaded(R, Res, bOK, TileID); });
-	Req->SetURL(URL);
-	Req->SetVerb("GET");
-	Req->ProcessRequest();
+	if (Generation != FetchGeneration)
+		return;
+
+	if (!bSuccess || !Payload.IsValid())
+	{
+		UE_LOG(LogRoomViz, Warning, TEXT("Failed to fetch image for tile %s"), *TileID);
+		CompleteTile(TileID, nullptr);
+		return;
+	}
+
+	const TConstArrayView<uint8> Bytes = Payload->GetBytes();
+	SetDownloadedBytes(TileID, Bytes.Num());
+
+	// Identical bytes under another ID: share that tile's texture and skip the decode
+	if (UTexture2D* Existing = TextureCache.Find(BytesHash))
+	{
+		++NumDecodesSkipped;
+		RoomVizMetrics::TextureCacheHits.Add();
+		CompleteTile(TileID, Existing);
+		return;
+	}
+	if (TArray<FString>* Waiting = DecodingByHash.Find(BytesHash))
+	{
+		++NumDecodesSkipped;
+		RoomVizMetrics::TextureCacheHits.Add();
+		Waiting->Add(TileID);
+		return;
+	}
+	RoomVizMetrics::TextureCacheMisses.Add();
+	DecodingByHash.Add(BytesHash).Add(TileID);
+
+	// Decode on a worker; only the texture creation comes back to the game thread
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	const int32 MaxSize = URoomVizTileSettings::Get()->MaxTileTextureSize;
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Generation, BytesHash, Payload, MaxSize, bHashPixels = bDedupDecodedPixels]()
+	{
+		TSharedRef<FDecodedTileImage, ESPMode::ThreadSafe> Image = MakeShared<FDecodedTileImage, ESPMode::ThreadSafe>();
+		DecodeTileImage(Payload->GetBytes(), ERGBFormat::BGRA, *Image, MaxSize);
+		const uint64 PixelHash = bHashPixels && Image->Pixels.Num() ? FTileTextureCache::HashBytes(Image->Pixels) : 0;
+		FTileImageAnalysis Analysis;
+		TileImageAnalysis::Analyze(*Image, Analysis);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Generation, BytesHash, PixelHash, Image, Analysis = MoveTemp(Analysis)]()
+		{
+			if (AMaterialAPIManager* Manager = WeakThis.Get())
+				Manager->OnImageDecoded(Generation, BytesHash, PixelHash, Image, Analysis);
+		});
+	});
 }
 
-void AMaterialAPIManager::OnImageDownloaded(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString TileID)
+void AMaterialAPIManager::OnImageDecoded(int32 Generation, uint64 BytesHash, uint64 PixelHash, TSharedRef<FDecodedTileImage, ESPMode::ThreadSafe> Image, const FTileImageAnalysis& Analysis)
+{
+	if (Generation != FetchGeneration)
+		return;
+
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	WorkQueue.Enqueue(ERoomVizWorkPriority::High, [WeakThis, Generation, BytesHash, PixelHash, Image, Analysis]()
+	{
+		AMaterialAPIManager* Manager = WeakThis.Get();
+		if (!Manager || Generation != Manager->FetchGeneration)
+			return;
+
+		TArray<FString> TileIDs;
+		Manager->DecodingByHash.RemoveAndCopyValue(BytesHash, TileIDs);
+
+		UTexture2D* Texture = nullptr;
+		if (Image->Pixels.Num() == 0)
+		{
+			UE_LOG(LogRoomViz, Warning, TEXT("Failed to decode image for tile %s"), TileIDs.Num() ? *TileIDs[0] : TEXT("?"));
+		}
+		else if (UTexture2D* Existing = PixelHash != 0 ? Manager->TextureCache.Find(PixelHash) : nullptr)
+		{
+			// Same pixels, different encoding
+			Texture = Existing;
+		}
+		else
+		{
+			Texture = CreateTileTexture(*Manager->GetTilePool(), Image->Size, Image->Pixels, TC_Default, true);
+		}
+
+		for (const FString& TileID : TileIDs)
+			Manager->CompleteTile(TileID, Texture, Texture && Analysis.IsValid() ? &Analysis : nullptr);
+
+		// Hashes only go to a texture some tile took; one nobody took is left to the pool's Trim
+		if (Texture)
+		{
+			Manager->TextureCache.AddHash(Texture, BytesHash, Image->Pixels.Num());
+			if (PixelHash != 0)
+				Manager->TextureCache.AddHash(Texture, PixelHash, Image->Pixels.Num());
+		}
+	});
+}
+
+void AMaterialAPIManager::CompleteTile(const FString& TileID, UTexture2D* Texture, const FTileImageAnalysis* Analysis)
+{
+	TArray<FString> Duplicates;
+	DuplicateTiles.RemoveAndCopyValue(TileID, Duplicates);
+	for (const FString& DuplicateID : Duplicates)
+		CompleteTile(DuplicateID, Texture, Analysis);
+
+	if (Texture)
+	{
+		// Shared textures skipped the decode, and with it the analysis
+		FTileImageAnalysis SharedAnalysis;
+		if (!Analysis)
+		{
+			const FTileMaterialData* Sharing = ParsedTiles.FindByPredicate([Texture](const FTileMaterialData& T) { return T.DownloadedTexture == Texture && T.Analysis.IsValid(); });
+			if (Sharing)
+			{
+				SharedAnalysis = Sharing->Analysis;
+				Analysis = &SharedAnalysis;
+			}
+		}
+
+		// A tile evicted while its fetch was pending takes no reference
+		if (ParsedTiles.ContainsByPredicate([&TileID](const FTileMaterialData& T) { return T.ID == TileID; }))
+			TextureCache.Acquire(TileID, Texture);
+		for (auto& T : ParsedTiles)
+		{
+			if (T.ID == TileID)
+			{
+				SetTileTexture(T.DownloadedTexture, Texture);
+				if (Analysis)
+				{
+					T.Analysis = *Analysis;
+					AnalysisCache.Add(T.BaseColorURL, *Analysis);
+					UnsavedAnalyses.Add(T.BaseColorURL, *Analysis);
+				}
+				OnTileTextureReady.Broadcast(T);
+			}
+		}
+	}
+
+	FinishPendingImage();
+}
+
+void AMaterialAPIManager::FetchPBRMaps(ITileCatalogSource& Source, const FTileMaterialData& Tile, int32 Generation)
 {
-	if (bWasSuccessful && Response.IsValid())
+	struct FPBRFetch
+	{
+		TSharedRef<FTilePBRSources, ESPMode::ThreadSafe> Maps = MakeShared<FTilePBRSources, ESPMode::ThreadSafe>();
+		std::atomic<int32> Remaining = 0;
+	};
+	TSharedRef<FPBRFetch> Fetch = MakeShared<FPBRFetch>();
+
+	const TPair<const FString*, FTileImagePayloadPtr FTilePBRSources::*> Maps[] = {
+		{ &Tile.NormalURL, &FTilePBRSources::Normal },
+		{ &Tile.AOURL, &FTilePBRSources::AO },
+		{ &Tile.RoughnessURL, &FTilePBRSources::Roughness },
+		{ &Tile.MetallicURL, &FTilePBRSources::Metallic },
+	};
+	for (const auto& Map : Maps)
+		Fetch->Remaining += Map.Key->IsEmpty() ? 0 : 1;
+
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	for (const auto& Map : Maps)
 	{
-		const TArray<uint8>& Bytes = Response->GetContent();
-		auto& IWM = FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
-		TSharedPtr<IImageWrapper> IW = IWM.CreateImageWrapper(EImageFormat::JPEG);
-		if (IW.IsValid() && IW->SetCompressed(Bytes.GetData(), Bytes.Num()))
+		if (Map.Key->IsEmpty())
+			continue;
+
+		// Each map lands on its own thread and writes only its member; the last one hands the set over
+		Source.FetchImage(*Map.Key, [WeakThis, Inbox = Inbox, Generation, TileID = Tile.ID, Fetch, Member = Map.Value](bool bSuccess, FTileImagePayloadPtr Payload)
 		{
-			TArray<uint8> Raw;
-			if (IW->GetRaw(ERGBFormat::BGRA, 8, Raw))
+			if (bSuccess)
+				(*Fetch->Maps).*Member = Payload;
+
+			if (Fetch->Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
 			{
-				UTexture2D* Tex = UTexture2D::CreateTransient(IW->GetWidth(), IW->GetHeight(), PF_B8G8R8A8);
-				void* Dest = Tex->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
-				FMemory::Memcpy(Dest, Raw.GetData(), Raw.Num());
-				Tex->GetPlatformData()->Mips[0].BulkData.Unlock();
-				Tex->UpdateResource();
-
-				for (auto& T : ParsedTiles)
-					if (T.ID == TileID)
-						T.DownloadedTexture = Tex;
+				Inbox->Push([WeakThis, Generation, TileID, Maps = Fetch->Maps]()
+				{
+					if (AMaterialAPIManager* Manager = WeakThis.Get())
+						Manager->OnPBRMapsFetched(Generation, TileID, Maps);
+				});
 			}
+		});
+	}
+}
+
+bool AMaterialAPIManager::RequestPBRMaps(const FString& TileID, ERoomVizWorkPriority Priority)
+{
+	if (FDeferredPBRFetch* Deferred = DeferredPBRFetches.Find(TileID))
+	{
+		const bool bRevived = Deferred->bCancelled;
+		Deferred->bCancelled = false;
+		Deferred->Priority = FMath::Min(Deferred->Priority, Priority);
+		return bRevived;
+	}
+
+	const FTileMaterialData* Tile = ParsedTiles.FindByPredicate([&TileID](const FTileMaterialData& T) { return T.ID == TileID; });
+	const int32* SourceIndex = TileSourceIndex.Find(TileID);
+	if (!Tile || !SourceIndex || !Sources.IsValidIndex(*SourceIndex) || !Tile->HasPBRMaps() || Tile->NormalTexture || Tile->ORMTexture
+		|| Sources[*SourceIndex]->HasCookedTextures())
+		return false;
+
+	DeferredPBRFetches.Add(TileID).Priority = Priority;
+	FetchPBRMaps(*Sources[*SourceIndex], *Tile, FetchGeneration);
+	return true;
+}
+
+bool AMaterialAPIManager::CancelPBRMaps(const FString& TileID)
+{
+	FDeferredPBRFetch* Deferred = DeferredPBRFetches.Find(TileID);
+	if (!Deferred || Deferred->bCancelled)
+		return false;
+
+	Deferred->bCancelled = true;
+	return true;
+}
+
+void AMaterialAPIManager::OnPBRMapsFetched(int32 Generation, const FString& TileID, TSharedRef<FTilePBRSources, ESPMode::ThreadSafe> Maps)
+{
+	if (Generation != FetchGeneration)
+		return;
+
+	if (FDeferredPBRFetch* Deferred = DeferredPBRFetches.Find(TileID))
+	{
+		int64 Bytes = 0;
+		for (const FTileImagePayloadPtr& Payload : { Maps->Normal, Maps->AO, Maps->Roughness, Maps->Metallic })
+			Bytes += Payload.IsValid() ? Payload->GetBytes().Num() : 0;
+
+		if (Deferred->bCancelled)
+		{
+			DeferredPBRFetches.Remove(TileID);
+			DiscardedPBRBytes += Bytes;
+			return;
 		}
+		PBRMapBytes.Add(TileID, Bytes);
 	}
 
+	// Workers only look the module up
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	const int32 MaxSize = URoomVizTileSettings::Get()->MaxTileTextureSize;
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Generation, TileID, Maps, MaxSize]()
+	{
+		TSharedRef<FTilePBRTexels, ESPMode::ThreadSafe> Texels = MakeShared<FTilePBRTexels, ESPMode::ThreadSafe>();
+		TilePBRPacking::DecodeAndPack(*Maps, *Texels, MaxSize);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Generation, TileID, Texels]()
+		{
+			if (AMaterialAPIManager* Manager = WeakThis.Get())
+				Manager->OnPBRMapsPacked(Generation, TileID, Texels);
+		});
+	});
+}
+
+void AMaterialAPIManager::OnPBRMapsPacked(int32 Generation, const FString& TileID, TSharedRef<FTilePBRTexels, ESPMode::ThreadSafe> Texels)
+{
+	if (Generation != FetchGeneration)
+		return;
+
+	const FDeferredPBRFetch* Deferred = DeferredPBRFetches.Find(TileID);
+	const ERoomVizWorkPriority Priority = Deferred ? Deferred->Priority : ERoomVizWorkPriority::Normal;
+
+	// One item per texture keeps each step well inside the frame budget
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	WorkQueue.Enqueue(Priority, [WeakThis, Generation, TileID, Priority, Owned = Texels]()
+	{
+		AMaterialAPIManager* Manager = WeakThis.Get();
+		if (!Manager || Generation != Manager->FetchGeneration)
+			return;
+
+		// Cancelled while decoding
+		const FDeferredPBRFetch* Deferred = Manager->DeferredPBRFetches.Find(TileID);
+		if (Deferred && Deferred->bCancelled)
+		{
+			Manager->DeferredPBRFetches.Remove(TileID);
+			Manager->DiscardedPBRBytes += Manager->PBRMapBytes.FindRef(TileID);
+			Manager->PBRMapBytes.Remove(TileID);
+			return;
+		}
+
+		UTexture2D* Normal = Owned->Normal.Num() ? CreateTileTexture(*Manager->GetTilePool(), Owned->NormalSize, Owned->Normal, TC_Normalmap, false) : nullptr;
+		for (auto& T : Manager->ParsedTiles)
+			if (T.ID == TileID)
+				Manager->SetTileTexture(T.NormalTexture, Normal);
+
+		Manager->WorkQueue.Enqueue(Priority, [WeakThis, Generation, TileID, Owned]()
+		{
+			AMaterialAPIManager* Manager = WeakThis.Get();
+			if (!Manager || Generation != Manager->FetchGeneration)
+				return;
+
+			UTexture2D* ORM = Owned->ORM.Num() ? CreateTileTexture(*Manager->GetTilePool(), Owned->ORMSize, Owned->ORM, TC_Masks, false) : nullptr;
+			for (auto& T : Manager->ParsedTiles)
+				if (T.ID == TileID)
+					Manager->SetTileTexture(T.ORMTexture, ORM);
+
+			if (!Manager->DeferredPBRFetches.Remove(TileID))
+			{
+				Manager->FinishPendingImage();
+				return;
+			}
+			if (const FTileMaterialData* Tile = Manager->ParsedTiles.FindByPredicate([&TileID](const FTileMaterialData& T) { return T.ID == TileID; }))
+				Manager->OnTilePBRMapsReady.Broadcast(*Tile);
+		});
+	});
+}
+
+void AMaterialAPIManager::FinishPendingImage()
+{
 	PendingImages--;
+	SET_DWORD_STAT(STAT_RoomViz_PendingImages, FMath::Max(PendingImages, 0));
 	if (PendingImages <= 0)
 	{
+		UE_LOG(LogRoomViz, Log, TEXT("Tile catalog ready: %d tiles in %.1f ms"), ParsedTiles.Num(), (FPlatformTime::Seconds() - FetchStartTime) * 1000.0);
+		SET_MEMORY_STAT(STAT_RoomViz_DedupSavedBytes, TextureCache.GetBytesSaved());
+		SET_DWORD_STAT(STAT_RoomViz_NumSharedTiles, TextureCache.GetNumTiles() - TextureCache.GetNumTextures());
+		UE_LOG(LogRoomViz, Log, TEXT("Tile dedup: %d tiles on %d textures (%.2fx), %.1f MB saved, %d downloads and %d decodes skipped"),
+			TextureCache.GetNumTiles(), TextureCache.GetNumTextures(), TextureCache.GetDedupRatio(),
+			TextureCache.GetBytesSaved() / (1024.0 * 1024.0), NumDownloadsSkipped, NumDecodesSkipped);
+
+		// Textures of the previous catalog and of superseded fetches go now, in one step
+		GetTilePool()->Trim();
+		SaveAnalysisCache();
 		OnMaterialsReady.Broadcast(ParsedTiles);
+		OnCatalogComplete.Broadcast(ParsedTiles);
+	}
+}
+
+void AMaterialAPIManager::LoadAnalysisCache()
+{
+	if (bAnalysisCacheRequested || !URoomVizTileSettings::Get()->bCacheTileAnalysis)
+		return;
+	bAnalysisCacheRequested = true;
+
+	// Parsed on a worker; a catalog merged before it lands gets the analyses through a second OnCatalogMerged
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Saved = SavedAnalyses, Path = TileImageAnalysis::GetCachePath(FHttpTileCatalogSource::GetDefaultDiskCacheDir())]()
+	{
+		TMap<FString, FTileImageAnalysis> Loaded;
+		TileImageAnalysis::LoadCache(Path, Loaded);
+		*Saved = Loaded;
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Loaded = MoveTemp(Loaded)]() mutable
+		{
+			if (AMaterialAPIManager* Manager = WeakThis.Get())
+				Manager->OnAnalysisCacheLoaded(MoveTemp(Loaded));
+		});
+	});
+}
+
+void AMaterialAPIManager::OnAnalysisCacheLoaded(TMap<FString, FTileImageAnalysis>&& Loaded)
+{
+	bAnalysisCacheLoaded = true;
+	UE_LOG(LogRoomViz, Log, TEXT("Tile analysis cache: %d entries"), Loaded.Num());
+
+	// Analyses of images decoded meanwhile are newer
+	for (TPair<FString, FTileImageAnalysis>& Pair : Loaded)
+	{
+		if (!AnalysisCache.Contains(Pair.Key))
+			AnalysisCache.Add(Pair.Key, MoveTemp(Pair.Value));
 	}
+
+	if (PendingImages > 0 && ApplyCachedAnalyses())
+		OnCatalogMerged.Broadcast(ParsedTiles);
+	else if (PendingImages <= 0)
+		SaveAnalysisCache();
+}
+
+bool AMaterialAPIManager::ApplyCachedAnalyses()
+{
+	bool bApplied = false;
+	for (FTileMaterialData& Tile : ParsedTiles)
+	{
+		if (Tile.Analysis.IsValid())
+			continue;
+		if (const FTileImageAnalysis* Cached = AnalysisCache.Find(Tile.BaseColorURL))
+		{
+			Tile.Analysis = *Cached;
+			bApplied = true;
+		}
+	}
+	return bApplied;
+}
+
+void AMaterialAPIManager::SaveAnalysisCache()
+{
+	// Saving before the load finished would drop the entries of tiles outside this catalog;
+	// two writes at once would race on the temp file
+	if (UnsavedAnalyses.Num() == 0 || !bAnalysisCacheLoaded || bAnalysisCacheSaving)
+		return;
+	bAnalysisCacheSaving = true;
+
+	const FString DiskCacheDir = FHttpTileCatalogSource::GetDefaultDiskCacheDir();
+	const bool bPrune = URoomVizTileSettings::Get()->bCacheHttpImages;
+	TWeakObjectPtr<AMaterialAPIManager> WeakThis(this);
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, DiskCacheDir, bPrune, Saved = SavedAnalyses, Added = MoveTemp(UnsavedAnalyses)]() mutable
+	{
+		// Downloaded images trimmed from the disk cache take their analysis along; ones added
+		// now stay, their image may still be on its way to the disk
+		int32 NumPruned = 0;
+		if (bPrune)
+		{
+			for (auto It = Saved->CreateIterator(); It; ++It)
+			{
+				if (It.Key().StartsWith(TEXT("http"), ESearchCase::IgnoreCase) && !Added.Contains(It.Key())
+					&& !IFileManager::Get().FileExists(*FHttpTileCatalogSource::GetDiskCachePath(DiskCacheDir, It.Key())))
+				{
+					It.RemoveCurrent();
+					++NumPruned;
+				}
+			}
+		}
+		Saved->Append(MoveTemp(Added));
+		TileImageAnalysis::SaveCache(TileImageAnalysis::GetCachePath(DiskCacheDir), *Saved);
+		UE_LOG(LogRoomViz, Verbose, TEXT("Tile analysis cache saved: %d entries, %d pruned"), Saved->Num(), NumPruned);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+		{
+			if (AMaterialAPIManager* Manager = WeakThis.Get())
+			{
+				Manager->bAnalysisCacheSaving = false;
+				Manager->SaveAnalysisCache();
+			}
+		});
+	});
 }
+
+void AMaterialAPIManager::EvictTile(const FString& TileID)
+{
+	ParsedTiles.RemoveAll([this, &TileID](FTileMaterialData& Tile)
+	{
+		if (Tile.ID != TileID)
+			return false;
+		OnTileEvicted.Broadcast(Tile);
+		ReleaseTileTextures(Tile);
+		return true;
+	});
+	TextureCache.Release(TileID);
+	GetTilePool()->Trim();
+}
+
+UTileObjectPool* AMaterialAPIManager::GetTilePool()
+{
+	if (!TilePool)
+		TilePool = NewObject<UTileObjectPool>(this, TEXT("TileTexturePool"));
+	return TilePool;
+}
+
+void AMaterialAPIManager::SetTileTexture(UTexture2D*& Field, UTexture2D* Texture)
+{
+	if (Field == Texture)
+		return;
+
+	// Cooked textures are not the pool's; it ignores them
+	GetTilePool()->Release(Field);
+	GetTilePool()->AddRef(Texture);
+	Field = Texture;
+}
+
+void AMaterialAPIManager::ReleaseTileTextures(FTileMaterialData& Tile)
+{
+	SetTileTexture(Tile.DownloadedTexture, nullptr);
+	SetTileTexture(Tile.NormalTexture, nullptr);
+	SetTileTexture(Tile.ORMTexture, nullptr);
+	SetDownloadedBytes(Tile.ID, 0);
+}
+
+void AMaterialAPIManager::SetDownloadedBytes(const FString& TileID, int64 NumBytes)
+{
+	// The stat covers the tiles held now, not every download since launch
+	DEC_MEMORY_STAT_BY(STAT_RoomViz_DownloadedBytes, DownloadedBytesByTile.FindRef(TileID));
+	INC_MEMORY_STAT_BY(STAT_RoomViz_DownloadedBytes, NumBytes);
+	if (NumBytes > 0)
+		DownloadedBytesByTile.Add(TileID, NumBytes);
+	else
+		DownloadedBytesByTile.Remove(TileID);
+}
+
 /*
 void AMaterialAPIManager::OnResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
 {
@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/RoomDesignState.h"
+#include "ui/UIUserWidget.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "UObject/UObjectIterator.h"
+#include "room_viz.h"
+
+static FAutoConsoleCommand CmdDesignReport(
+    TEXT("RoomViz.Design.Report"),
+    TEXT("Log the shared design's assignments and the bytes replicated per assignment, on each machine of the session."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        for (TObjectIterator<ARoomDesignState> It; It; ++It)
+        {
+            if (!It->IsTemplate() && It->GetWorld())
+            {
+                It->LogReport();
+            }
+        }
+    }));
+
+void FRoomSurfaceAssignment::PostReplicatedAdd(const FRoomDesignAssignments& InArraySerializer)
+{
+    PostReplicatedChange(InArraySerializer);
+}
+
+void FRoomSurfaceAssignment::PostReplicatedChange(const FRoomDesignAssignments& InArraySerializer)
+{
+    if (ARoomDesignState* Owner = InArraySerializer.Owner)
+    {
+        Owner->RecordTraffic(false, 0, 1);
+        Owner->ApplyAssignment(*this);
+    }
+}
+
+bool FRoomDesignAssignments::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+    const bool bSending = DeltaParms.Writer != nullptr;
+    const int64 StartBits = bSending ? DeltaParms.Writer->GetNumBits() : DeltaParms.Reader ? DeltaParms.Reader->GetPosBits() : 0;
+
+    const bool bResult = FFastArraySerializer::FastArrayDeltaSerialize<FRoomSurfaceAssignment, FRoomDesignAssignments>(Items, DeltaParms, *this);
+
+    if (Owner && (DeltaParms.Writer || DeltaParms.Reader))
+    {
+        const int64 EndBits = bSending ? DeltaParms.Writer->GetNumBits() : DeltaParms.Reader->GetPosBits();
+        Owner->RecordTraffic(bSending, EndBits - StartBits, 0);
+    }
+    return bResult;
+}
+
+ARoomDesignState::ARoomDesignState()
+{
+    PrimaryActorTick.bCanEverTick = false;
+    bReplicates = true;
+    bAlwaysRelevant = true;
+    NetUpdateFrequency = 10.f;
+}
+
+ARoomDesignState* ARoomDesignState::Get(const UWorld* World)
+{
+    if (World)
+    {
+        for (TActorIterator<ARoomDesignState> It(const_cast<UWorld*>(World)); It; ++It)
+        {
+            return *It;
+        }
+    }
+    return nullptr;
+}
+
+void ARoomDesignState::PostInitializeComponents()
+{
+    Super::PostInitializeComponents();
+    Assignments.Owner = this;
+}
+
+void ARoomDesignState::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // Assignments that replicated before the palette existed are retried per tile by OnTileMaterialAvailable
+    for (const FRoomSurfaceAssignment& Assignment : Assignments.Items)
+    {
+        ApplyAssignment(Assignment);
+    }
+}
+
+void ARoomDesignState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+    DOREPLIFETIME(ARoomDesignState, Assignments);
+}
+
+void ARoomDesignState::SetAssignment(UPrimitiveComponent* Surface, uint8 Slot, const FString& TileID)
+{
+    if (!HasAuthority() || !Surface || TileID.IsEmpty())
+    {
+        return;
+    }
+    if (!Surface->IsSupportedForNetworking())
+    {
+        UE_LOG(LogRoomViz, Warning, TEXT("Design: %s cannot be referenced over the network; '%s' stays local"), *Surface->GetPathName(), *TileID);
+        return;
+    }
+
+    FRoomSurfaceAssignment* Assignment = Assignments.Items.FindByPredicate([Surface, Slot](const FRoomSurfaceAssignment& Item)
+    {
+        return Item.Surface == Surface && Item.Slot == Slot;
+    });
+    if (!Assignment)
+    {
+        Assignment = &Assignments.Items.AddDefaulted_GetRef();
+        Assignment->Surface = Surface;
+        Assignment->Slot = Slot;
+    }
+    else if (Assignment->TileID == TileID)
+    {
+        return;
+    }
+    Assignment->TileID = TileID;
+    Assignments.MarkItemDirty(*Assignment);
+    ++NumAssignmentsMade;
+
+    // A listen server's own view, and clients' drops seen on the server
+    ApplyAssignment(*Assignment);
+}
+
+int32 ARoomDesignState::RemoveAssignmentsIn(const ULevel* Level)
+{
+    if (!HasAuthority())
+    {
+        return 0;
+    }
+
+    const int32 NumRemoved = Assignments.Items.RemoveAll([Level](const FRoomSurfaceAssignment& Item)
+    {
+        return !IsValid(Item.Surface) || (Level && Item.Surface->GetComponentLevel() == Level);
+    });
+    if (NumRemoved > 0)
+    {
+        Assignments.MarkArrayDirty();
+    }
+    return NumRemoved;
+}
+
+void ARoomDesignState::OnTileMaterialAvailable(const FString& TileID)
+{
+    for (const FRoomSurfaceAssignment& Assignment : Assignments.Items)
+    {
+        if (Assignment.TileID == TileID)
+        {
+            ApplyAssignment(Assignment);
+        }
+    }
+}
+
+bool ARoomDesignState::ApplyAssignment(const FRoomSurfaceAssignment& Assignment) const
+{
+    UPrimitiveComponent* Surface = Assignment.Surface;
+    UMaterialInterface* Material = Surface ? ResolveTile(Assignment.TileID) : nullptr;
+    if (!Material)
+    {
+        return false;
+    }
+    if (Surface->GetMaterial(Assignment.Slot) != Material)
+    {
+        Surface->SetMaterial(Assignment.Slot, Material);
+    }
+    return true;
+}
+
+UMaterialInterface* ARoomDesignState::ResolveTile(const FString& TileID) const
+{
+    // PIE runs every client in one process, so only this world's palette counts
+    const UWorld* World = GetWorld();
+    for (TObjectIterator<UUIUserWidget> It; It; ++It)
+    {
+        if (!It->IsTemplate() && It->GetWorld() == World)
+        {
+            if (UMaterialInterface* Material = It->FindTileMaterial(TileID))
+            {
+                return Material;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void ARoomDesignState::RecordTraffic(bool bSent, int64 Bits, int32 ItemsReceived)
+{
+    if (bSent)
+    {
+        BitsSent += Bits;
+        return;
+    }
+
+    BitsReceived += Bits;
+    NumItemsReceived += ItemsReceived;
+
+    // The first bunch a client reads is the full array: the late-join snapshot
+    if (SnapshotBits < 0 && Bits > 0)
+    {
+        SnapshotBits = Bits;
+        SnapshotItems = NumItemsReceived;
+        UE_LOG(LogRoomViz, Log, TEXT("Design: snapshot of %d assignments in %lld bytes"), SnapshotItems, (SnapshotBits + 7) / 8);
+    }
+}
+
+void ARoomDesignState::LogReport() const
+{
+    int32 NumUnresolved = 0;
+    for (const FRoomSurfaceAssignment& Assignment : Assignments.Items)
+    {
+        NumUnresolved += Assignment.Surface && !ResolveTile(Assignment.TileID) ? 1 : 0;
+    }
+
+    UE_LOG(LogRoomViz, Display, TEXT("Design (%s): %d assignments, %d waiting for their tile"),
+        HasAuthority() ? TEXT("server") : TEXT("client"), Assignments.Items.Num(), NumUnresolved);
+    if (HasAuthority())
+    {
+        // Sent bits cover every connection, so with N clients expect about N times the per-client cost
+        UE_LOG(LogRoomViz, Display, TEXT("  %d assignments made, %lld bytes sent, %.1f bytes per assignment"),
+            NumAssignmentsMade, (BitsSent + 7) / 8, NumAssignmentsMade > 0 ? BitsSent / 8.0 / NumAssignmentsMade : 0.0);
+    }
+    else
+    {
+        UE_LOG(LogRoomViz, Display, TEXT("  %d assignments received, %lld bytes, %.1f bytes per assignment; snapshot %d assignments in %lld bytes"),
+            NumItemsReceived, (BitsReceived + 7) / 8, NumItemsReceived > 0 ? BitsReceived / 8.0 / NumItemsReceived : 0.0,
+            SnapshotItems, SnapshotBits > 0 ? (SnapshotBits + 7) / 8 : 0);
+    }
+}
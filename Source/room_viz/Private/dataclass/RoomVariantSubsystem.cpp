@@ -0,0 +1,534 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/RoomVariantSubsystem.h"
+#include "dataclass/RoomDesignState.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/PackageName.h"
+#include "room_viz.h"
+
+static TAutoConsoleVariable<bool> CVarPreloadNext(
+    TEXT("RoomViz.Room.PreloadNext"),
+    true,
+    TEXT("After a room switch, load the room most likely to be visited next in the background, hidden."));
+
+static FAutoConsoleCommand CmdRoomSwitch(
+    TEXT("RoomViz.Room.Switch"),
+    TEXT("RoomViz.Room.Switch <Name>: show room variant Name in place of the current one."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        URoomVariantSubsystem* Rooms = URoomVariantSubsystem::Get(World);
+        if (Rooms && Args.Num() > 0)
+        {
+            Rooms->SwitchToRoom(FName(*Args[0]));
+        }
+    }));
+
+static FAutoConsoleCommand CmdRoomPreload(
+    TEXT("RoomViz.Room.Preload"),
+    TEXT("RoomViz.Room.Preload <Name>: load room variant Name hidden, ready for a switch."),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        URoomVariantSubsystem* Rooms = URoomVariantSubsystem::Get(World);
+        if (Rooms && Args.Num() > 0)
+        {
+            Rooms->PreloadRoom(FName(*Args[0]));
+        }
+    }));
+
+static FAutoConsoleCommand CmdRoomReport(
+    TEXT("RoomViz.Room.Report"),
+    TEXT("Log the loaded room variants and the time of each switch so far, cold and preloaded."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const URoomVariantSubsystem* Rooms = URoomVariantSubsystem::Get(World))
+        {
+            Rooms->LogReport();
+        }
+    }));
+
+namespace
+{
+    enum class ESurfaceRole : uint8
+    {
+        Floor,
+        Top,
+        Wall,
+        None
+    };
+
+    const TCHAR* const SurfaceRoleNames[] = { TEXT("Floor"), TEXT("Top"), TEXT("Wall") };
+
+    /** Horizontal slabs within this height of the lowest one are floor too, e.g. a step or a rug */
+    constexpr double FloorStep = 30.0;
+
+    struct FSurfaceShape
+    {
+        const UStaticMeshComponent* Surface = nullptr;
+        ESurfaceRole Role = ESurfaceRole::None;
+        double Area = 0.0;
+        double TopZ = 0.0;
+        FVector Center = FVector::ZeroVector;
+    };
+
+    /** Thin slabs only, by the mesh's own axes so rotated rooms classify alike: horizontal ones are tops (or floors), vertical ones walls */
+    FSurfaceShape ClassifySurface(const UStaticMeshComponent* Surface)
+    {
+        FSurfaceShape Shape;
+        Shape.Surface = Surface;
+        const UStaticMesh* Mesh = Surface->GetStaticMesh();
+        if (!Mesh)
+        {
+            return Shape;
+        }
+
+        const FTransform& Transform = Surface->GetComponentTransform();
+        const FVector Size = Mesh->GetBoundingBox().GetSize() * Transform.GetScale3D().GetAbs();
+        int32 Thin = 0;
+        for (int32 Axis = 1; Axis < 3; ++Axis)
+        {
+            if (Size[Axis] < Size[Thin])
+            {
+                Thin = Axis;
+            }
+        }
+        const double SideA = Size[(Thin + 1) % 3];
+        const double SideB = Size[(Thin + 2) % 3];
+        if (Size[Thin] > 0.25 * FMath::Min(SideA, SideB))
+        {
+            return Shape;
+        }
+
+        const double Up = FMath::Abs(Transform.GetUnitAxis(EAxis::Type(EAxis::X + Thin)).Z);
+        Shape.Role = Up > 0.9 ? ESurfaceRole::Top : Up < 0.1 ? ESurfaceRole::Wall : ESurfaceRole::None;
+        Shape.Area = SideA * SideB;
+        Shape.TopZ = Surface->Bounds.GetBox().Max.Z;
+        Shape.Center = Surface->Bounds.Origin;
+        return Shape;
+    }
+}
+
+URoomVariantSubsystem* URoomVariantSubsystem::Get(const UWorld* World)
+{
+    return World ? World->GetSubsystem<URoomVariantSubsystem>() : nullptr;
+}
+
+bool URoomVariantSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+    const UWorld* World = Cast<UWorld>(Outer);
+    return World && World->IsGameWorld() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void URoomVariantSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    // The persistent map holds no room of its own; the first of the walking order opens the session
+    const TArray<FRoomVariantConfig>& Variants = URoomVizTileSettings::Get()->RoomVariants;
+    if (Variants.Num() > 0 && CurrentRoom.IsNone() && PendingRoom.IsNone())
+    {
+        SwitchToRoom(Variants[0].Name);
+    }
+}
+
+void URoomVariantSubsystem::Deinitialize()
+{
+    Rooms.Reset();
+    UnloadingRooms.Reset();
+    Super::Deinitialize();
+}
+
+bool URoomVariantSubsystem::SwitchToRoom(FName Name)
+{
+    const FRoomVariantConfig* Room = URoomVizTileSettings::Get()->FindRoomVariant(Name);
+    if (!Room)
+    {
+        UE_LOG(LogRoomViz, Warning, TEXT("Rooms: no room variant '%s' in the settings"), *Name.ToString());
+        return false;
+    }
+    if (Name == CurrentRoom || Name == PendingRoom)
+    {
+        return false;
+    }
+
+    // A switch that has not shown yet is abandoned; its room stays loaded as a preload
+    if (!PendingRoom.IsNone())
+    {
+        if (TObjectPtr<ULevelStreamingDynamic>* Abandoned = Rooms.Find(PendingRoom))
+        {
+            (*Abandoned)->SetShouldBeVisible(false);
+        }
+    }
+
+    if (!CurrentRoom.IsNone())
+    {
+        ++Transitions.FindOrAdd(CurrentRoom).FindOrAdd(Name);
+    }
+    CaptureAssignments();
+
+    PendingRoom = Name;
+    bPendingPreloaded = IsRoomLoaded(Name);
+    SwitchStartTime = FPlatformTime::Seconds();
+
+    ULevelStreamingDynamic* Streaming = Rooms.FindRef(Name);
+    if (!Streaming)
+    {
+        Streaming = StreamRoom(*Room, true);
+        if (!Streaming)
+        {
+            PendingRoom = NAME_None;
+            return false;
+        }
+    }
+    else if (Streaming->IsLevelVisible())
+    {
+        FinishSwitch();
+        return true;
+    }
+    Streaming->SetShouldBeVisible(true);
+
+    UE_LOG(LogRoomViz, Log, TEXT("Rooms: switching %s -> %s (%s)"), *CurrentRoom.ToString(), *Name.ToString(),
+        bPendingPreloaded ? TEXT("preloaded") : PreloadingRoom == Name ? TEXT("preload in flight") : TEXT("cold"));
+    return true;
+}
+
+bool URoomVariantSubsystem::PreloadRoom(FName Name)
+{
+    const FRoomVariantConfig* Room = URoomVizTileSettings::Get()->FindRoomVariant(Name);
+    if (!Room || Rooms.Contains(Name))
+    {
+        return false;
+    }
+
+    if (!StreamRoom(*Room, false))
+    {
+        return false;
+    }
+    PreloadingRoom = Name;
+    PreloadStartTime = FPlatformTime::Seconds();
+    UE_LOG(LogRoomViz, Log, TEXT("Rooms: preloading %s"), *Name.ToString());
+    return true;
+}
+
+FName URoomVariantSubsystem::PredictNextRoom(FName From) const
+{
+    FName Next;
+    int32 NextCount = 0;
+    if (const TMap<FName, int32>* FromCounts = Transitions.Find(From))
+    {
+        for (const TPair<FName, int32>& Count : *FromCounts)
+        {
+            if (Count.Value > NextCount)
+            {
+                Next = Count.Key;
+                NextCount = Count.Value;
+            }
+        }
+    }
+    if (!Next.IsNone())
+    {
+        return Next;
+    }
+
+    // Nothing learned yet: the order of the settings is the showroom's walking order
+    const TArray<FRoomVariantConfig>& Variants = URoomVizTileSettings::Get()->RoomVariants;
+    const int32 FromIndex = Variants.IndexOfByPredicate([From](const FRoomVariantConfig& Room) { return Room.Name == From; });
+    if (Variants.Num() < 2)
+    {
+        return Variants.Num() == 1 && FromIndex == INDEX_NONE ? Variants[0].Name : NAME_None;
+    }
+    return Variants[(FromIndex + 1) % Variants.Num()].Name;
+}
+
+bool URoomVariantSubsystem::IsRoomLoaded(FName Name) const
+{
+    const ULevelStreamingDynamic* Streaming = Rooms.FindRef(Name);
+    return Streaming && Streaming->IsLevelLoaded();
+}
+
+int32 URoomVariantSubsystem::GetNumRoomsUnloading() const
+{
+    const UWorld* World = GetWorld();
+    int32 NumUnloading = 0;
+    for (const TWeakObjectPtr<ULevelStreamingDynamic>& Room : UnloadingRooms)
+    {
+        const ULevelStreamingDynamic* Streaming = Room.Get();
+        if (Streaming && (Streaming->GetLoadedLevel() || (World && World->GetStreamingLevels().Contains(Streaming))))
+        {
+            ++NumUnloading;
+        }
+    }
+    return NumUnloading;
+}
+
+ULevelStreamingDynamic* URoomVariantSubsystem::StreamRoom(const FRoomVariantConfig& Room, bool bVisible)
+{
+    UWorld* World = GetWorld();
+
+    // Same package name on every machine, so actors of the room resolve over the network
+    const FString PackageName = Room.Map.GetLongPackageName();
+    const FString LevelName = FString::Printf(TEXT("%s/Room_%s"), *FPackageName::GetLongPackagePath(PackageName), *Room.Name.ToString());
+    FLoadLevelInstanceParams Params(World, PackageName, Room.Transform);
+    Params.bInitiallyVisible = bVisible;
+    Params.OptionalLevelNameOverride = &LevelName;
+
+    bool bSuccess = false;
+    ULevelStreamingDynamic* Streaming = ULevelStreamingDynamic::LoadLevelInstance(Params, bSuccess);
+    if (!bSuccess || !Streaming)
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Rooms: cannot stream %s from %s"), *Room.Name.ToString(), *Room.Map.ToString());
+        return nullptr;
+    }
+
+    Streaming->OnLevelLoaded.AddDynamic(this, &URoomVariantSubsystem::HandleLevelLoaded);
+    Streaming->OnLevelShown.AddDynamic(this, &URoomVariantSubsystem::HandleLevelShown);
+    Rooms.Add(Room.Name, Streaming);
+    return Streaming;
+}
+
+void URoomVariantSubsystem::UnloadRoom(FName Name)
+{
+    TObjectPtr<ULevelStreamingDynamic> Streaming;
+    if (!Rooms.RemoveAndCopyValue(Name, Streaming) || !Streaming)
+    {
+        return;
+    }
+    Streaming->OnLevelLoaded.RemoveAll(this);
+    Streaming->OnLevelShown.RemoveAll(this);
+
+    // Its surfaces are about to go; their tiles live on in CarriedTiles
+    if (ARoomDesignState* Design = ARoomDesignState::Get(GetWorld()))
+    {
+        Design->RemoveAssignmentsIn(Streaming->GetLoadedLevel());
+    }
+
+    UnloadingRooms.RemoveAll([](const TWeakObjectPtr<ULevelStreamingDynamic>& Room) { return !Room.IsValid(); });
+    UnloadingRooms.Add(Streaming.Get());
+    Streaming->SetShouldBeVisible(false);
+    Streaming->SetShouldBeLoaded(false);
+    Streaming->SetIsRequestingUnloadAndRemoval(true);
+
+    if (PreloadingRoom == Name)
+    {
+        PreloadingRoom = NAME_None;
+    }
+}
+
+void URoomVariantSubsystem::HandleLevelLoaded()
+{
+    if (!PreloadingRoom.IsNone() && IsRoomLoaded(PreloadingRoom))
+    {
+        UE_LOG(LogRoomViz, Log, TEXT("Rooms: %s preloaded in %.1f ms"), *PreloadingRoom.ToString(), (FPlatformTime::Seconds() - PreloadStartTime) * 1000.0);
+        PreloadingRoom = NAME_None;
+    }
+}
+
+void URoomVariantSubsystem::HandleLevelShown()
+{
+    const ULevelStreamingDynamic* Streaming = Rooms.FindRef(PendingRoom);
+    if (Streaming && Streaming->IsLevelVisible())
+    {
+        FinishSwitch();
+    }
+}
+
+void URoomVariantSubsystem::FinishSwitch()
+{
+    const double Seconds = FPlatformTime::Seconds() - SwitchStartTime;
+    SwitchTimings.Add({PendingRoom, bPendingPreloaded, Seconds});
+
+    const FName PreviousRoom = CurrentRoom;
+    CurrentRoom = PendingRoom;
+    PendingRoom = NAME_None;
+    if (PreloadingRoom == CurrentRoom)
+    {
+        PreloadingRoom = NAME_None;
+    }
+
+    // Keep at most the current room and the predicted next one; the previous room stays hidden if it is that one
+    const FName NextRoom = CVarPreloadNext.GetValueOnGameThread() ? PredictNextRoom(CurrentRoom) : NAME_None;
+    TArray<FName> Loaded;
+    Rooms.GetKeys(Loaded);
+    for (const FName& Name : Loaded)
+    {
+        if (Name == CurrentRoom)
+        {
+            continue;
+        }
+        if (Name == NextRoom)
+        {
+            Rooms[Name]->SetShouldBeVisible(false);
+            continue;
+        }
+        UnloadRoom(Name);
+    }
+
+    const ULevelStreamingDynamic* Streaming = Rooms.FindRef(CurrentRoom);
+    const int32 NumCarried = ApplyCarriedAssignments(Streaming ? Streaming->GetLoadedLevel() : nullptr);
+
+    UE_LOG(LogRoomViz, Log, TEXT("Rooms: %s shown in %.1f ms (%s), %d tiles carried over from %s"), *CurrentRoom.ToString(),
+        Seconds * 1000.0, bPendingPreloaded ? TEXT("preloaded") : TEXT("cold"), NumCarried, *PreviousRoom.ToString());
+    OnRoomShown.Broadcast(CurrentRoom);
+
+    if (!NextRoom.IsNone() && NextRoom != CurrentRoom)
+    {
+        PreloadRoom(NextRoom);
+    }
+}
+
+TMap<const UPrimitiveComponent*, FName> URoomVariantSubsystem::GetSurfaceIDs(const ULevel* Level)
+{
+    static const FString SurfacePrefix = TEXT("Surface.");
+    TMap<const UPrimitiveComponent*, FName> IDs;
+    if (!Level)
+    {
+        return IDs;
+    }
+
+    TArray<FSurfaceShape> Shapes;
+    double LowestTop = MAX_dbl;
+    for (const AActor* Actor : Level->Actors)
+    {
+        if (!Actor)
+        {
+            continue;
+        }
+        TInlineComponentArray<UStaticMeshComponent*> Surfaces(Actor);
+        for (const UStaticMeshComponent* Surface : Surfaces)
+        {
+            if (!Surface->IsVisible() || Surface->GetNumMaterials() == 0)
+            {
+                continue;
+            }
+
+            auto IsSurfaceTag = [](const FName& Tag) { return Tag.ToString().StartsWith(SurfacePrefix); };
+            const FName* Tag = Surface->ComponentTags.FindByPredicate(IsSurfaceTag);
+            Tag = Tag ? Tag : Actor->Tags.FindByPredicate(IsSurfaceTag);
+            if (Tag)
+            {
+                IDs.Add(Surface, *Tag);
+                continue;
+            }
+
+            const FSurfaceShape Shape = ClassifySurface(Surface);
+            if (Shape.Role != ESurfaceRole::None)
+            {
+                LowestTop = Shape.Role == ESurfaceRole::Top ? FMath::Min(LowestTop, Shape.TopZ) : LowestTop;
+                Shapes.Add(Shape);
+            }
+        }
+    }
+
+    for (FSurfaceShape& Shape : Shapes)
+    {
+        if (Shape.Role == ESurfaceRole::Top && Shape.TopZ <= LowestTop + FloorStep)
+        {
+            Shape.Role = ESurfaceRole::Floor;
+        }
+    }
+
+    // Largest first within a role; position breaks ties so that copies of one room rank alike
+    Shapes.Sort([](const FSurfaceShape& A, const FSurfaceShape& B)
+    {
+        if (A.Role != B.Role)
+        {
+            return A.Role < B.Role;
+        }
+        if (A.Area != B.Area)
+        {
+            return A.Area > B.Area;
+        }
+        return A.Center.X != B.Center.X ? A.Center.X < B.Center.X : A.Center.Y < B.Center.Y;
+    });
+
+    int32 Rank = 0;
+    for (int32 Index = 0; Index < Shapes.Num(); ++Index)
+    {
+        Rank = Index > 0 && Shapes[Index - 1].Role == Shapes[Index].Role ? Rank + 1 : 0;
+        IDs.Add(Shapes[Index].Surface, FName(*FString::Printf(TEXT("%s.%d"), SurfaceRoleNames[(int32)Shapes[Index].Role], Rank)));
+    }
+    return IDs;
+}
+
+void URoomVariantSubsystem::CaptureAssignments()
+{
+    const ARoomDesignState* Design = ARoomDesignState::Get(GetWorld());
+    if (!Design)
+    {
+        return;
+    }
+
+    // Only surfaces of the rooms travel; the persistent map's own stay where they are
+    TMap<const ULevel*, TMap<const UPrimitiveComponent*, FName>> RoomSurfaceIDs;
+    for (const TPair<FName, TObjectPtr<ULevelStreamingDynamic>>& Room : Rooms)
+    {
+        if (const ULevel* Level = Room.Value ? Room.Value->GetLoadedLevel() : nullptr)
+        {
+            RoomSurfaceIDs.Add(Level, GetSurfaceIDs(Level));
+        }
+    }
+
+    // Later assignments win, and tiles of rooms visited earlier are kept for when the customer returns
+    for (const FRoomSurfaceAssignment& Assignment : Design->GetAssignments())
+    {
+        const TMap<const UPrimitiveComponent*, FName>* SurfaceIDs = Assignment.Surface ? RoomSurfaceIDs.Find(Assignment.Surface->GetComponentLevel()) : nullptr;
+        const FName SurfaceID = SurfaceIDs ? SurfaceIDs->FindRef(Assignment.Surface) : NAME_None;
+        if (!SurfaceID.IsNone())
+        {
+            CarriedTiles.Add({SurfaceID, Assignment.Slot}, Assignment.TileID);
+        }
+    }
+}
+
+int32 URoomVariantSubsystem::ApplyCarriedAssignments(ULevel* Level)
+{
+    ARoomDesignState* Design = ARoomDesignState::Get(GetWorld());
+    if (!Level || !Design || !Design->HasAuthority() || CarriedTiles.IsEmpty())
+    {
+        return 0;
+    }
+
+    int32 NumCarried = 0;
+    for (const TPair<const UPrimitiveComponent*, FName>& SurfaceID : GetSurfaceIDs(Level))
+    {
+        UPrimitiveComponent* Surface = const_cast<UPrimitiveComponent*>(SurfaceID.Key);
+        for (int32 Slot = 0; Slot < FMath::Min(Surface->GetNumMaterials(), 256); ++Slot)
+        {
+            if (const FString* TileID = CarriedTiles.Find({SurfaceID.Value, uint8(Slot)}))
+            {
+                Design->SetAssignment(Surface, uint8(Slot), *TileID);
+                ++NumCarried;
+            }
+        }
+    }
+    return NumCarried;
+}
+
+void URoomVariantSubsystem::LogReport() const
+{
+    UE_LOG(LogRoomViz, Display, TEXT("Rooms: current %s, %s, %d loaded, %d surface tiles remembered"),
+        *CurrentRoom.ToString(), IsSwitching() ? *FString::Printf(TEXT("switching to %s"), *PendingRoom.ToString()) : TEXT("idle"),
+        Rooms.Num(), CarriedTiles.Num());
+    for (const TPair<FName, TObjectPtr<ULevelStreamingDynamic>>& Room : Rooms)
+    {
+        UE_LOG(LogRoomViz, Display, TEXT("  %s: %s"), *Room.Key.ToString(),
+            Room.Value->IsLevelVisible() ? TEXT("visible") : Room.Value->IsLevelLoaded() ? TEXT("loaded, hidden") : TEXT("loading"));
+    }
+
+    double ColdSeconds = 0.0, PreloadedSeconds = 0.0;
+    int32 NumCold = 0, NumPreloaded = 0;
+    for (const FSwitchTiming& Timing : SwitchTimings)
+    {
+        (Timing.bPreloaded ? PreloadedSeconds : ColdSeconds) += Timing.Seconds;
+        ++(Timing.bPreloaded ? NumPreloaded : NumCold);
+    }
+    UE_LOG(LogRoomViz, Display, TEXT("  switches: %d cold, avg %.1f ms; %d preloaded, avg %.1f ms"),
+        NumCold, NumCold > 0 ? ColdSeconds / NumCold * 1000.0 : 0.0, NumPreloaded, NumPreloaded > 0 ? PreloadedSeconds / NumPreloaded * 1000.0 : 0.0);
+}
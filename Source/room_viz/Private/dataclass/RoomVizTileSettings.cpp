@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/RoomVizTileSettings.h"
+#include "dataclass/TileCatalogSources.h"
+#include "Misc/Paths.h"
+
+TArray<TSharedRef<ITileCatalogSource>> URoomVizTileSettings::CreateCatalogSources() const
+{
+    TArray<TSharedRef<ITileCatalogSource>> Sources;
+    for (const FTileCatalogSourceConfig& Config : CatalogSources)
+    {
+        if (Config.bEnabled)
+        {
+            if (TSharedPtr<ITileCatalogSource> Source = CreateCatalogSource(Config))
+            {
+                Sources.Add(Source.ToSharedRef());
+            }
+        }
+    }
+    return Sources;
+}
+
+TSharedPtr<ITileCatalogSource> URoomVizTileSettings::CreateCatalogSource(const FTileCatalogSourceConfig& Config) const
+{
+    if (Config.Location.IsEmpty())
+    {
+        return nullptr;
+    }
+
+    const FString LocalPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), Config.Location);
+    switch (Config.Type)
+    {
+    case ETileCatalogSourceType::Http:
+    {
+        TSharedRef<FHttpTileCatalogSource> Source = MakeShared<FHttpTileCatalogSource>(Config.Location, Config.Priority);
+        if (bCacheHttpImages)
+        {
+            Source->SetDiskCache(FHttpTileCatalogSource::GetDefaultDiskCacheDir(), true, true, GetMaxHttpImageCacheBytes());
+        }
+        return Source;
+    }
+    case ETileCatalogSourceType::LocalDirectory:
+        return MakeShared<FLocalDirectoryTileCatalogSource>(LocalPath, Config.Priority, bMemoryMapLocalFiles);
+    case ETileCatalogSourceType::PakBundle:
+        return MakeShared<FPakBundleTileCatalogSource>(LocalPath, Config.Priority);
+    case ETileCatalogSourceType::TilePack:
+        return MakeShared<FTilePackCatalogSource>(FName(*Config.Location), Config.Priority);
+    }
+    return nullptr;
+}
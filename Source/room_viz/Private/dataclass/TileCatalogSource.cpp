@@ -0,0 +1,259 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TileCatalogSource.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/Paths.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Misc/ScopeExit.h"
+#include "RoomVizMetrics.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+#if ROOMVIZ_WITH_TURBOJPEG
+THIRD_PARTY_INCLUDES_START
+#include "turbojpeg.h"
+THIRD_PARTY_INCLUDES_END
+#endif
+
+TConstArrayView<uint8> FTileImagePayload::GetBytes() const
+{
+    if (MappedRegion.IsValid())
+    {
+        return TConstArrayView<uint8>(MappedRegion->GetMappedPtr(), IntCastChecked<int32>(MappedRegion->GetMappedSize()));
+    }
+    if (Response.IsValid())
+    {
+        return Response->GetContent();
+    }
+    return OwnedBytes;
+}
+
+namespace
+{
+#if ROOMVIZ_WITH_TURBOJPEG
+    /** libjpeg-turbo decode at the ChooseDecodeScale scale; false if Bytes is not a JPEG it can read */
+    bool DecodeJpegScaled(TConstArrayView<uint8> Bytes, ERGBFormat Format, int32 MaxSize, FDecodedTileImage& Out)
+    {
+        tjhandle Handle = tjInitDecompress();
+        if (!Handle)
+        {
+            return false;
+        }
+        ON_SCOPE_EXIT { tjDestroy(Handle); };
+
+        unsigned char* JpegBytes = const_cast<unsigned char*>(Bytes.GetData());
+        int Width = 0, Height = 0, Subsampling = 0, Colorspace = 0;
+        if (tjDecompressHeader3(Handle, JpegBytes, Bytes.Num(), &Width, &Height, &Subsampling, &Colorspace) != 0)
+        {
+            return false;
+        }
+
+        const int32 Denominator = ChooseDecodeScale(FIntPoint(Width, Height), MaxSize);
+        const tjscalingfactor Factor = { 1, Denominator };
+        const int32 ScaledWidth = TJSCALED(Width, Factor);
+        const int32 ScaledHeight = TJSCALED(Height, Factor);
+        const int PixelFormat = Format == ERGBFormat::Gray ? TJPF_GRAY : TJPF_BGRA;
+
+        Out.Pixels.SetNumUninitialized(ScaledWidth * ScaledHeight * tjPixelSize[PixelFormat]);
+        if (tjDecompress2(Handle, JpegBytes, Bytes.Num(), Out.Pixels.GetData(), ScaledWidth, 0, ScaledHeight, PixelFormat, 0) != 0)
+        {
+            Out.Pixels.Reset();
+            return false;
+        }
+        Out.Size = FIntPoint(ScaledWidth, ScaledHeight);
+        Out.ScaleDenominator = Denominator;
+        return true;
+    }
+#endif
+
+    /** Average Denominator x Denominator blocks, rounding the size up like the JPEG decoder does */
+    void BoxDownsample(FDecodedTileImage& Image, int32 BytesPerPixel, int32 Denominator)
+    {
+        const FIntPoint Size(FMath::DivideAndRoundUp(Image.Size.X, Denominator), FMath::DivideAndRoundUp(Image.Size.Y, Denominator));
+        TArray<uint8> Pixels;
+        Pixels.SetNumUninitialized(Size.X * Size.Y * BytesPerPixel);
+
+        for (int32 Y = 0; Y < Size.Y; ++Y)
+        {
+            const int32 Y0 = Y * Denominator;
+            const int32 Y1 = FMath::Min(Y0 + Denominator, Image.Size.Y);
+            for (int32 X = 0; X < Size.X; ++X)
+            {
+                const int32 X0 = X * Denominator;
+                const int32 X1 = FMath::Min(X0 + Denominator, Image.Size.X);
+                const int32 Count = (Y1 - Y0) * (X1 - X0);
+                for (int32 Channel = 0; Channel < BytesPerPixel; ++Channel)
+                {
+                    int32 Sum = 0;
+                    for (int32 SY = Y0; SY < Y1; ++SY)
+                    {
+                        for (int32 SX = X0; SX < X1; ++SX)
+                        {
+                            Sum += Image.Pixels[(SY * Image.Size.X + SX) * BytesPerPixel + Channel];
+                        }
+                    }
+                    Pixels[(Y * Size.X + X) * BytesPerPixel + Channel] = uint8((Sum + Count / 2) / Count);
+                }
+            }
+        }
+
+        Image.Pixels = MoveTemp(Pixels);
+        Image.Size = Size;
+        Image.ScaleDenominator *= Denominator;
+    }
+
+    /**
+     * Box filter the image down until its longer side is MaxSize, for sources still too big at
+     * 1/8 scale. Each output pixel averages the source pixels its footprint covers.
+     */
+    void ResizeToFit(FDecodedTileImage& Image, int32 BytesPerPixel, int32 MaxSize)
+    {
+        const int32 LongerSide = FMath::Max(Image.Size.X, Image.Size.Y);
+        if (MaxSize <= 0 || LongerSide <= MaxSize)
+        {
+            return;
+        }
+
+        const double Scale = double(MaxSize) / LongerSide;
+        const FIntPoint Size(FMath::Max(1, FMath::RoundToInt32(Image.Size.X * Scale)), FMath::Max(1, FMath::RoundToInt32(Image.Size.Y * Scale)));
+        auto SourceSpan = [](int32 Dest, int32 DestSize, int32 SourceSize)
+        {
+            const int32 Begin = int32(int64(Dest) * SourceSize / DestSize);
+            const int32 End = FMath::Max(Begin + 1, int32(int64(Dest + 1) * SourceSize / DestSize));
+            return TPair<int32, int32>(Begin, End);
+        };
+
+        TArray<uint8> Pixels;
+        Pixels.SetNumUninitialized(Size.X * Size.Y * BytesPerPixel);
+        for (int32 Y = 0; Y < Size.Y; ++Y)
+        {
+            const TPair<int32, int32> Rows = SourceSpan(Y, Size.Y, Image.Size.Y);
+            for (int32 X = 0; X < Size.X; ++X)
+            {
+                const TPair<int32, int32> Columns = SourceSpan(X, Size.X, Image.Size.X);
+                const int32 Count = (Rows.Value - Rows.Key) * (Columns.Value - Columns.Key);
+                for (int32 Channel = 0; Channel < BytesPerPixel; ++Channel)
+                {
+                    int32 Sum = 0;
+                    for (int32 SY = Rows.Key; SY < Rows.Value; ++SY)
+                    {
+                        for (int32 SX = Columns.Key; SX < Columns.Value; ++SX)
+                        {
+                            Sum += Image.Pixels[(SY * Image.Size.X + SX) * BytesPerPixel + Channel];
+                        }
+                    }
+                    Pixels[(Y * Size.X + X) * BytesPerPixel + Channel] = uint8((Sum + Count / 2) / Count);
+                }
+            }
+        }
+
+        Image.Pixels = MoveTemp(Pixels);
+        Image.Size = Size;
+    }
+}
+
+int32 ChooseDecodeScale(FIntPoint SourceSize, int32 MaxSize)
+{
+    const int32 LongerSide = FMath::Max(SourceSize.X, SourceSize.Y);
+    int32 Denominator = 1;
+    while (MaxSize > 0 && Denominator < 8 && FMath::DivideAndRoundUp(LongerSide, Denominator) > MaxSize)
+    {
+        Denominator *= 2;
+    }
+    return Denominator;
+}
+
+bool DecodeTileImage(TConstArrayView<uint8> Bytes, ERGBFormat Format, FDecodedTileImage& Out, int32 MaxSize)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_ImageDecode);
+    RoomVizMetrics::FScopedLatency Latency(RoomVizMetrics::ImageDecodeSeconds);
+
+    // Catalogs mix JPEG and PNG tiles
+    IImageWrapperModule& IWM = FModuleManager::GetModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+    const EImageFormat ImageFormat = IWM.DetectImageFormat(Bytes.GetData(), Bytes.Num());
+    Out.ScaleDenominator = 1;
+
+#if ROOMVIZ_WITH_TURBOJPEG
+    if (MaxSize > 0 && ImageFormat == EImageFormat::JPEG && DecodeJpegScaled(Bytes, Format, MaxSize, Out))
+    {
+        ResizeToFit(Out, Format == ERGBFormat::Gray ? 1 : 4, MaxSize);
+        return true;
+    }
+#endif
+
+    TSharedPtr<IImageWrapper> IW = IWM.CreateImageWrapper(ImageFormat != EImageFormat::Invalid ? ImageFormat : EImageFormat::JPEG);
+    if (!IW.IsValid() || !IW->SetCompressed(Bytes.GetData(), Bytes.Num()) || !IW->GetRaw(Format, 8, Out.Pixels))
+    {
+        Out.Pixels.Reset();
+        return false;
+    }
+    Out.Size = FIntPoint(IW->GetWidth(), IW->GetHeight());
+
+    const int32 BytesPerPixel = Format == ERGBFormat::Gray ? 1 : 4;
+    const int32 Denominator = ChooseDecodeScale(Out.Size, MaxSize);
+    if (Denominator > 1)
+    {
+        BoxDownsample(Out, BytesPerPixel, Denominator);
+    }
+    ResizeToFit(Out, BytesPerPixel, MaxSize);
+    return true;
+}
+
+bool FTileCatalogParser::Parse(const FString& Json, const FString& BaseLocation, TArray<FTileMaterialData>& OutTiles)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_CatalogParse);
+
+    TSharedPtr<FJsonObject> Root;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Failed to parse tile catalog from %s"), *BaseLocation);
+        return false;
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* Array;
+    if (!Root->TryGetArrayField(TEXT("Tiles"), Array))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Tiles array missing from tile catalog %s"), *BaseLocation);
+        return false;
+    }
+
+    OutTiles.Reserve(OutTiles.Num() + Array->Num());
+    for (const TSharedPtr<FJsonValue>& Val : *Array)
+    {
+        if (TSharedPtr<FJsonObject> Obj = Val->AsObject())
+        {
+            FTileMaterialData Tile;
+            Tile.ID = Obj->GetStringField(TEXT("id"));
+            Tile.BaseColorURL = ResolveLocation(Obj->GetStringField(TEXT("baseColorUrl")), BaseLocation);
+
+            // Optional PBR maps
+            auto ReadOptional = [&Obj, &BaseLocation](const TCHAR* Field, FString& OutLocation)
+            {
+                FString Location;
+                if (Obj->TryGetStringField(Field, Location) && !Location.IsEmpty())
+                {
+                    OutLocation = ResolveLocation(Location, BaseLocation);
+                }
+            };
+            ReadOptional(TEXT("normalUrl"), Tile.NormalURL);
+            ReadOptional(TEXT("aoUrl"), Tile.AOURL);
+            ReadOptional(TEXT("roughnessUrl"), Tile.RoughnessURL);
+            ReadOptional(TEXT("metallicUrl"), Tile.MetallicURL);
+            OutTiles.Add(Tile);
+        }
+    }
+    return true;
+}
+
+FString FTileCatalogParser::ResolveLocation(const FString& Location, const FString& BaseLocation)
+{
+    if (Location.Contains(TEXT("://")) || !FPaths::IsRelative(Location) || BaseLocation.IsEmpty())
+    {
+        return Location;
+    }
+    return BaseLocation / Location;
+}
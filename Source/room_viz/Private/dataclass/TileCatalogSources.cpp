@@ -0,0 +1,570 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TileCatalogSources.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/AsyncFileHandle.h"
+#include "Async/Async.h"
+#include "Hash/CityHash.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/Texture2D.h"
+#include "dataclass/TilePackManifest.h"
+#include "room_viz.h"
+#include <atomic>
+
+//////////////////////////////////////////////////////////////////////////
+// Async file read
+
+void ReadTileFileAsync(const FString& Path, TUniqueFunction<void(bool bSuccess, TArray<uint8>&& Bytes)>&& OnComplete)
+{
+    struct FPendingRead
+    {
+        IAsyncReadFileHandle* Handle = nullptr;
+        FAsyncFileCallBack Callback; // Must outlive the request
+        TArray<uint8> Bytes;
+        TUniqueFunction<void(bool, TArray<uint8>&&)> OnComplete;
+    };
+
+    const int64 Size = IFileManager::Get().FileSize(*Path);
+    IAsyncReadFileHandle* Handle = Size > 0 ? FPlatformFileManager::Get().GetPlatformFile().OpenAsyncRead(*Path) : nullptr;
+    if (!Handle)
+    {
+        UE_LOG(LogRoomViz, Warning, TEXT("Could not open %s for reading"), *Path);
+        AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [OnComplete = MoveTemp(OnComplete)]() mutable { OnComplete(false, TArray<uint8>()); });
+        return;
+    }
+
+    FPendingRead* Read = new FPendingRead;
+    Read->Handle = Handle;
+    Read->OnComplete = MoveTemp(OnComplete);
+    Read->Bytes.SetNumUninitialized(IntCastChecked<int32>(Size));
+    Read->Callback = [Read](bool bWasCancelled, IAsyncReadRequest* Request)
+    {
+        // IO thread, possibly before ReadRequest has returned: the request may only be deleted
+        // after this callback returns, so finish on a worker with the pointer given here
+        AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Read, Request, bSuccess = !bWasCancelled]()
+        {
+            Request->WaitCompletion();
+            delete Request;
+            delete Read->Handle;
+            Read->OnComplete(bSuccess, MoveTemp(Read->Bytes));
+            delete Read;
+        });
+    };
+
+    // Read straight into the destination array; the callback owns the request
+    Handle->ReadRequest(0, Size, AIOP_Normal, &Read->Callback, Read->Bytes.GetData());
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHttpTileCatalogSource
+
+FHttpTileCatalogSource::FHttpTileCatalogSource(const FString& InCatalogURL, int32 InPriority)
+    : CatalogURL(InCatalogURL)
+    , SourceName(*FString::Printf(TEXT("Http:%s"), *InCatalogURL))
+    , Priority(InPriority)
+{
+}
+
+void FHttpTileCatalogSource::FetchCatalog(FOnTileCatalogFetched&& OnComplete)
+{
+    // Delegates need copyable functors, so the move-only callback travels in a shared holder
+    TSharedRef<FOnTileCatalogFetched> Callback = MakeShared<FOnTileCatalogFetched>(MoveTemp(OnComplete));
+    const FString BaseLocation = FPaths::GetPath(CatalogURL);
+
+    // Parsed on the HTTP thread; only the result goes to the game thread
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+    Request->SetDelegateThreadPolicy(EHttpRequestDelegateThreadPolicy::CompleteOnHttpThread);
+    Request->OnProcessRequestComplete().BindLambda(
+        [Callback, BaseLocation](FHttpRequestPtr Req, FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            TArray<FTileMaterialData> Tiles;
+            const bool bParsed = bWasSuccessful && Response.IsValid()
+                && EHttpResponseCodes::IsOk(Response->GetResponseCode())
+                && FTileCatalogParser::Parse(Response->GetContentAsString(), BaseLocation, Tiles);
+            AsyncTask(ENamedThreads::GameThread, [Callback, bParsed, Tiles = MoveTemp(Tiles)]() mutable
+            {
+                (*Callback)(bParsed, MoveTemp(Tiles));
+            });
+        });
+    Request->SetURL(CatalogURL);
+    Request->SetVerb("GET");
+    Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+    Request->ProcessRequest();
+}
+
+static std::atomic<int32> GPendingDiskCacheWrites{0};
+
+// Size of the cache folder as of the last trim plus writes since, -1 before the first scan. One
+// count for every source, as they all share the default folder.
+static std::atomic<int64> GDiskCacheBytes{-1};
+static std::atomic<bool> GDiskCacheTrimming{false};
+
+void FHttpTileCatalogSource::SetDiskCache(const FString& Dir, bool bRead, bool bWrite, int64 MaxBytes)
+{
+    DiskCacheDir = Dir;
+    MaxDiskCacheBytes = FMath::Max<int64>(MaxBytes, 0);
+    bReadDiskCache = bRead && !Dir.IsEmpty();
+    bWriteDiskCache = bWrite && !Dir.IsEmpty();
+
+    // Cached and downloaded bodies are checked on workers, which only look the module up
+    FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+    // A cache left over the cap by an earlier run, or a lowered cap, is trimmed right away
+    if (bWriteDiskCache && MaxDiskCacheBytes > 0 && !GDiskCacheTrimming.exchange(true))
+    {
+        AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Dir, MaxBytes = MaxDiskCacheBytes]()
+        {
+            TrimDiskCache(Dir, MaxBytes);
+            GDiskCacheTrimming = false;
+        });
+    }
+}
+
+bool FHttpTileCatalogSource::IsCompleteImage(TConstArrayView<uint8> Bytes)
+{
+    IImageWrapperModule& IWM = FModuleManager::GetModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+    switch (IWM.DetectImageFormat(Bytes.GetData(), Bytes.Num()))
+    {
+    case EImageFormat::JPEG:
+    {
+        // EOI marker; encoders may pad after it, a truncated body stops short of it
+        const int32 Tail = FMath::Max(Bytes.Num() - 64, 2);
+        for (int32 Index = Bytes.Num() - 1; Index >= Tail; --Index)
+        {
+            if (Bytes[Index - 1] == 0xFF && Bytes[Index] == 0xD9)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    case EImageFormat::PNG:
+    {
+        // IEND chunk type and CRC close every PNG
+        static const uint8 IEND[] = { 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82 };
+        return Bytes.Num() >= 16 && FMemory::Memcmp(Bytes.GetData() + Bytes.Num() - sizeof(IEND), IEND, sizeof(IEND)) == 0;
+    }
+    default:
+        return false;
+    }
+}
+
+FString FHttpTileCatalogSource::GetDiskCachePath(const FString& Dir, const FString& URL)
+{
+    // Keep a recognizable extension for whoever browses the folder; the decoder sniffs the format anyway
+    FString PathPart;
+    if (!URL.Split(TEXT("?"), &PathPart, nullptr))
+    {
+        PathPart = URL;
+    }
+    FString Extension = FPaths::GetExtension(PathPart).ToLower();
+    if (Extension != TEXT("jpg") && Extension != TEXT("jpeg") && Extension != TEXT("png"))
+    {
+        Extension = TEXT("bin");
+    }
+    const FTCHARToUTF8 UTF8(*URL);
+    return Dir / FString::Printf(TEXT("%016llx.%s"), CityHash64(UTF8.Get(), UTF8.Length()), *Extension);
+}
+
+FString FHttpTileCatalogSource::GetDefaultDiskCacheDir()
+{
+    return FPaths::ProjectSavedDir() / TEXT("TileCache");
+}
+
+int32 FHttpTileCatalogSource::GetNumPendingDiskCacheWrites()
+{
+    return GPendingDiskCacheWrites.load();
+}
+
+void FHttpTileCatalogSource::WriteToDiskCache(const FString& Path, FTileImagePayloadPtr Payload, int64 MaxCacheBytes)
+{
+    ++GPendingDiskCacheWrites;
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Path, Payload, MaxCacheBytes]()
+    {
+        const FString TempPath = Path + TEXT(".tmp");
+        const TConstArrayView<uint8> Bytes = Payload->GetBytes();
+        if (!FFileHelper::SaveArrayToFile(Bytes, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, /*bReplace*/ true))
+        {
+            UE_LOG(LogRoomViz, Warning, TEXT("Could not write %s to the tile disk cache"), *Path);
+            IFileManager::Get().Delete(*TempPath, false, false, true);
+        }
+        else if (MaxCacheBytes > 0)
+        {
+            int64 Total = GDiskCacheBytes.load();
+            if (Total >= 0)
+            {
+                Total = GDiskCacheBytes += Bytes.Num();
+            }
+            if ((Total < 0 || Total > MaxCacheBytes) && !GDiskCacheTrimming.exchange(true))
+            {
+                TrimDiskCache(FPaths::GetPath(Path), MaxCacheBytes);
+                GDiskCacheTrimming = false;
+            }
+        }
+        --GPendingDiskCacheWrites;
+    });
+}
+
+void FHttpTileCatalogSource::TrimDiskCache(const FString& Dir, int64 MaxBytes)
+{
+    struct FCachedImage
+    {
+        FString Path;
+        int64 Size;
+        FDateTime LastUsed;
+    };
+
+    // Only cached images count; the analysis cache and writes in progress stay
+    TArray<FCachedImage> Images;
+    int64 Total = 0;
+    IFileManager::Get().IterateDirectoryStat(*Dir, [&Images, &Total](const TCHAR* Path, const FFileStatData& Stat)
+    {
+        const FString Extension = FPaths::GetExtension(Path).ToLower();
+        if (!Stat.bIsDirectory && (Extension == TEXT("jpg") || Extension == TEXT("jpeg") || Extension == TEXT("png") || Extension == TEXT("bin")))
+        {
+            Images.Add({ Path, Stat.FileSize, Stat.ModificationTime });
+            Total += Stat.FileSize;
+        }
+        return true;
+    });
+
+    // Down to 90% of the cap, so the next few writes do not trim again
+    const int64 Target = MaxBytes - MaxBytes / 10;
+    int32 NumEvicted = 0;
+    if (Total > MaxBytes)
+    {
+        Images.Sort([](const FCachedImage& A, const FCachedImage& B) { return A.LastUsed < B.LastUsed; });
+        for (const FCachedImage& Image : Images)
+        {
+            if (Total <= Target)
+            {
+                break;
+            }
+            if (IFileManager::Get().Delete(*Image.Path, false, false, true))
+            {
+                Total -= Image.Size;
+                ++NumEvicted;
+            }
+        }
+        UE_LOG(LogRoomViz, Log, TEXT("Tile disk cache: evicted %d least recently used images, %.1f MB left of %.1f MB"),
+            NumEvicted, Total / (1024.0 * 1024.0), MaxBytes / (1024.0 * 1024.0));
+    }
+    GDiskCacheBytes = Total;
+}
+
+void FHttpTileCatalogSource::FetchImage(const FString& Location, FOnTileImageFetched&& OnComplete)
+{
+    const FString CachePath = bReadDiskCache || bWriteDiskCache ? GetDiskCachePath(DiskCacheDir, Location) : FString();
+    const FString WritePath = bWriteDiskCache ? CachePath : FString();
+    if (!bReadDiskCache)
+    {
+        Download(Location, WritePath, MaxDiskCacheBytes, MoveTemp(OnComplete));
+        return;
+    }
+
+    // Looked up on a worker next to the open, so a cold disk never stalls the game thread
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Location, CachePath, WritePath, MaxBytes = MaxDiskCacheBytes, OnComplete = MoveTemp(OnComplete)]() mutable
+    {
+        if (!IFileManager::Get().FileExists(*CachePath))
+        {
+            AsyncTask(ENamedThreads::GameThread, [Location, WritePath, MaxBytes, OnComplete = MoveTemp(OnComplete)]() mutable
+            {
+                Download(Location, WritePath, MaxBytes, MoveTemp(OnComplete));
+            });
+            return;
+        }
+
+        ReadTileFileAsync(CachePath, [Location, CachePath, WritePath, MaxBytes, OnComplete = MoveTemp(OnComplete)](bool bSuccess, TArray<uint8>&& Bytes) mutable
+        {
+            if (!bSuccess || !IsCompleteImage(Bytes))
+            {
+                // Cut short by a crash or a full disk, or damaged since: replace it from the catalog
+                UE_LOG(LogRoomViz, Warning, TEXT("Tile disk cache: %s is unreadable or truncated, downloading %s again"), *CachePath, *Location);
+                IFileManager::Get().Delete(*CachePath, false, false, true);
+                AsyncTask(ENamedThreads::GameThread, [Location, WritePath, MaxBytes, OnComplete = MoveTemp(OnComplete)]() mutable
+                {
+                    Download(Location, WritePath, MaxBytes, MoveTemp(OnComplete));
+                });
+                return;
+            }
+
+            // The modification time is the last use for TrimDiskCache
+            if (MaxBytes > 0)
+            {
+                IFileManager::Get().SetTimeStamp(*CachePath, FDateTime::UtcNow());
+            }
+            FTileImagePayloadPtr Payload = MakeShared<FTileImagePayload, ESPMode::ThreadSafe>();
+            Payload->OwnedBytes = MoveTemp(Bytes);
+            OnComplete(true, Payload);
+        });
+    });
+}
+
+void FHttpTileCatalogSource::Download(const FString& Location, const FString& CachePath, int64 MaxCacheBytes, FOnTileImageFetched&& OnComplete)
+{
+    TSharedRef<FOnTileImageFetched> Callback = MakeShared<FOnTileImageFetched>(MoveTemp(OnComplete));
+
+    // Completing on the HTTP thread keeps transfers going however long the game thread's frames are
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+    Request->SetDelegateThreadPolicy(EHttpRequestDelegateThreadPolicy::CompleteOnHttpThread);
+    Request->OnProcessRequestComplete().BindLambda(
+        [Callback, CachePath, MaxCacheBytes](FHttpRequestPtr Req, FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            if (!bWasSuccessful || !Response.IsValid() || !EHttpResponseCodes::IsOk(Response->GetResponseCode()))
+            {
+                (*Callback)(false, nullptr);
+                return;
+            }
+
+            // Keep the response alive instead of copying its content
+            FTileImagePayloadPtr Payload = MakeShared<FTileImagePayload, ESPMode::ThreadSafe>();
+            Payload->Response = Response;
+            if (!CachePath.IsEmpty())
+            {
+                // A 200 can still carry an error page or a body cut short; neither may be served from the cache later
+                if (!IsCompleteImage(Payload->GetBytes()))
+                {
+                    UE_LOG(LogRoomViz, Warning, TEXT("%s did not return a complete JPEG or PNG; not cached"), *Req->GetURL());
+                    (*Callback)(false, nullptr);
+                    return;
+                }
+                WriteToDiskCache(CachePath, Payload, MaxCacheBytes);
+            }
+            (*Callback)(true, Payload);
+        });
+    Request->SetURL(Location);
+    Request->SetVerb("GET");
+    Request->ProcessRequest();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FLocalDirectoryTileCatalogSource
+
+FLocalDirectoryTileCatalogSource::FLocalDirectoryTileCatalogSource(const FString& InDirectory, int32 InPriority, bool bInMemoryMap)
+    : Directory(InDirectory)
+    , SourceName(*FString::Printf(TEXT("Local:%s"), *InDirectory))
+    , Priority(InPriority)
+    , bMemoryMap(bInMemoryMap)
+{
+}
+
+void FLocalDirectoryTileCatalogSource::FetchCatalog(FOnTileCatalogFetched&& OnComplete)
+{
+    const FString ManifestPath = Directory / TEXT("FloorTiles.json");
+    if (IFileManager::Get().FileExists(*ManifestPath))
+    {
+        ReadTileFileAsync(ManifestPath, [BaseLocation = Directory, OnComplete = MoveTemp(OnComplete)](bool bSuccess, TArray<uint8>&& Bytes) mutable
+        {
+            TArray<FTileMaterialData> Tiles;
+            if (bSuccess)
+            {
+                FString Json;
+                FFileHelper::BufferToString(Json, Bytes.GetData(), Bytes.Num());
+                bSuccess = FTileCatalogParser::Parse(Json, BaseLocation, Tiles);
+            }
+            AsyncTask(ENamedThreads::GameThread, [bSuccess, Tiles = MoveTemp(Tiles), OnComplete = MoveTemp(OnComplete)]() mutable
+            {
+                OnComplete(bSuccess, MoveTemp(Tiles));
+            });
+        });
+        return;
+    }
+
+    // No manifest: every image in the folder is a tile. Scan on a worker, deliver on the game thread.
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [BaseLocation = Directory, OnComplete = MoveTemp(OnComplete)]() mutable
+    {
+        TArray<FString> Files;
+        IFileManager::Get().FindFiles(Files, *BaseLocation, nullptr);
+
+        TArray<FTileMaterialData> Tiles;
+        for (const FString& File : Files)
+        {
+            const FString Extension = FPaths::GetExtension(File).ToLower();
+            if (Extension == TEXT("jpg") || Extension == TEXT("jpeg") || Extension == TEXT("png"))
+            {
+                FTileMaterialData& Tile = Tiles.AddDefaulted_GetRef();
+                Tile.ID = FPaths::GetBaseFilename(File);
+                Tile.BaseColorURL = BaseLocation / File;
+            }
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [Tiles = MoveTemp(Tiles), OnComplete = MoveTemp(OnComplete)]() mutable
+        {
+            OnComplete(true, MoveTemp(Tiles));
+        });
+    });
+}
+
+void FLocalDirectoryTileCatalogSource::FetchImage(const FString& Location, FOnTileImageFetched&& OnComplete)
+{
+    auto ReadFile = [](const FString& Path, FOnTileImageFetched&& Callback)
+    {
+        ReadTileFileAsync(Path, [Callback = MoveTemp(Callback)](bool bSuccess, TArray<uint8>&& Bytes) mutable
+        {
+            FTileImagePayloadPtr Payload = MakeShared<FTileImagePayload, ESPMode::ThreadSafe>();
+            Payload->OwnedBytes = MoveTemp(Bytes);
+            Callback(bSuccess, Payload);
+        });
+    };
+
+    if (!bMemoryMap)
+    {
+        ReadFile(Location, MoveTemp(OnComplete));
+        return;
+    }
+
+    // Opening and mapping block on the file system (a NAS share can take milliseconds), so they
+    // run on a worker like the async read; the decoder then faults the pages in
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Location, ReadFile, OnComplete = MoveTemp(OnComplete)]() mutable
+    {
+        if (IMappedFileHandle* MappedFile = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Location))
+        {
+            if (IMappedFileRegion* Region = MappedFile->MapRegion(0, MappedFile->GetFileSize(), /*bPreloadHint*/ true))
+            {
+                FTileImagePayloadPtr Payload = MakeShared<FTileImagePayload, ESPMode::ThreadSafe>();
+                Payload->MappedFile.Reset(MappedFile);
+                Payload->MappedRegion.Reset(Region);
+                OnComplete(true, Payload);
+                return;
+            }
+            delete MappedFile;
+        }
+        ReadFile(Location, MoveTemp(OnComplete));
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FPakBundleTileCatalogSource
+
+FPakBundleTileCatalogSource::FPakBundleTileCatalogSource(const FString& InPakPath, int32 InPriority)
+    : FLocalDirectoryTileCatalogSource(FString(), InPriority, /*bInMemoryMap*/ false)
+    , PakPath(InPakPath)
+{
+    SourceName = FName(*FString::Printf(TEXT("Pak:%s"), *FPaths::GetCleanFilename(InPakPath)));
+}
+
+FPakBundleTileCatalogSource::~FPakBundleTileCatalogSource()
+{
+    if (bMounted && FCoreDelegates::OnUnmountPak.IsBound())
+    {
+        FCoreDelegates::OnUnmountPak.Execute(PakPath);
+    }
+}
+
+void FPakBundleTileCatalogSource::FetchCatalog(FOnTileCatalogFetched&& OnComplete)
+{
+    if (!Mount())
+    {
+        AsyncTask(ENamedThreads::GameThread, [OnComplete = MoveTemp(OnComplete)]() mutable
+        {
+            OnComplete(false, TArray<FTileMaterialData>());
+        });
+        return;
+    }
+
+    FLocalDirectoryTileCatalogSource::FetchCatalog(MoveTemp(OnComplete));
+}
+
+bool FPakBundleTileCatalogSource::Mount()
+{
+    if (bMounted)
+    {
+        return true;
+    }
+
+    if (!FCoreDelegates::MountPak.IsBound())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Cannot mount %s: the pak platform file is not active"), *PakPath);
+        return false;
+    }
+
+    IPakFile* Pak = FCoreDelegates::MountPak.Execute(PakPath, /*PakOrder*/ 0);
+    if (!Pak)
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Failed to mount tile bundle %s"), *PakPath);
+        return false;
+    }
+
+    Directory = Pak->PakGetMountPoint();
+    bMounted = true;
+    UE_LOG(LogRoomViz, Log, TEXT("Mounted tile bundle %s at %s"), *PakPath, *Directory);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FTilePackCatalogSource
+
+FTilePackCatalogSource::FTilePackCatalogSource(FName InPackName, int32 InPriority)
+    : PackName(InPackName)
+    , SourceName(*FString::Printf(TEXT("TilePack:%s"), *InPackName.ToString()))
+    , Priority(InPriority)
+{
+}
+
+void FTilePackCatalogSource::FetchCatalog(FOnTileCatalogFetched&& OnComplete)
+{
+    TSharedRef<FOnTileCatalogFetched> Callback = MakeShared<FOnTileCatalogFetched>(MoveTemp(OnComplete));
+    const FSoftObjectPath ManifestPath = UTilePackManifest::GetManifestPath(PackName);
+
+    ManifestHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(ManifestPath,
+        FStreamableDelegate::CreateLambda([Callback, ManifestPath]()
+        {
+            TArray<FTileMaterialData> Tiles;
+            const UTilePackManifest* Manifest = Cast<UTilePackManifest>(ManifestPath.ResolveObject());
+            if (!Manifest)
+            {
+                UE_LOG(LogRoomViz, Error, TEXT("Tile pack manifest %s could not be loaded"), *ManifestPath.ToString());
+                (*Callback)(false, MoveTemp(Tiles));
+                return;
+            }
+
+            Tiles.Reserve(Manifest->Tiles.Num());
+            for (const FTilePackEntry& Entry : Manifest->Tiles)
+            {
+                FTileMaterialData& Tile = Tiles.AddDefaulted_GetRef();
+                Tile.ID = Entry.ID;
+                Tile.BaseColorURL = Entry.Texture.ToSoftObjectPath().ToString();
+            }
+            (*Callback)(true, MoveTemp(Tiles));
+        }));
+
+    if (!ManifestHandle.IsValid())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Tile pack %s not found"), *PackName.ToString());
+        AsyncTask(ENamedThreads::GameThread, [Callback]() { (*Callback)(false, TArray<FTileMaterialData>()); });
+    }
+}
+
+void FTilePackCatalogSource::FetchImage(const FString& Location, FOnTileImageFetched&& OnComplete)
+{
+    // Packs only hold cooked textures, see FetchTexture. Failing still answers later, never from in here
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [OnComplete = MoveTemp(OnComplete)]() mutable { OnComplete(false, nullptr); });
+}
+
+void FTilePackCatalogSource::FetchTexture(const FTileMaterialData& Tile, FOnTileTextureFetched&& OnComplete)
+{
+    TSharedRef<FOnTileTextureFetched> Callback = MakeShared<FOnTileTextureFetched>(MoveTemp(OnComplete));
+    const FSoftObjectPath TexturePath(Tile.BaseColorURL);
+
+    // Mips above the streaming pool's needs stay on disk; only the resident ones are read here
+    TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(TexturePath,
+        FStreamableDelegate::CreateLambda([Callback, TexturePath]()
+        {
+            (*Callback)(Cast<UTexture2D>(TexturePath.ResolveObject()));
+        }));
+
+    if (!Handle.IsValid())
+    {
+        AsyncTask(ENamedThreads::GameThread, [Callback]() { (*Callback)(nullptr); });
+    }
+}
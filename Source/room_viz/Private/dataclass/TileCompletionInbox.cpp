@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TileCompletionInbox.h"
+#include "RoomVizStats.h"
+
+void FTileCompletionInbox::Push(FCompletion&& Completion)
+{
+    Queue.Enqueue(MoveTemp(Completion));
+    NumPending.fetch_add(1, std::memory_order_relaxed);
+    INC_DWORD_STAT(STAT_RoomViz_InboxCompletions);
+}
+
+int32 FTileCompletionInbox::Drain(double BudgetSeconds)
+{
+    check(IsInGameThread());
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_InboxDrain);
+
+    const double EndTime = FPlatformTime::Seconds() + BudgetSeconds;
+    int32 NumRun = 0;
+    FCompletion Completion;
+    while ((NumRun == 0 || FPlatformTime::Seconds() < EndTime) && Queue.Dequeue(Completion))
+    {
+        NumPending.fetch_sub(1, std::memory_order_relaxed);
+        DEC_DWORD_STAT(STAT_RoomViz_InboxCompletions);
+        Completion();
+        ++NumRun;
+    }
+    return NumRun;
+}
@@ -0,0 +1,308 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TileImageAnalysis.h"
+#include "dataclass/TileCatalogSource.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "room_viz.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace TileImageAnalysis
+{
+    namespace
+    {
+        constexpr int32 CacheVersion = 1;
+
+        /** 3 bits per channel */
+        constexpr int32 NumColorBins = 512;
+
+        FColor MeanColor(const uint64 Sums[3], uint64 Count)
+        {
+            return FColor(
+                uint8((Sums[2] + Count / 2) / Count),
+                uint8((Sums[1] + Count / 2) / Count),
+                uint8((Sums[0] + Count / 2) / Count));
+        }
+    }
+
+    void SumBGR(const uint8* BGRA, int32 NumPixels, uint64 OutSums[3])
+    {
+        int32 Index = 0;
+
+#if PLATFORM_CPU_X86_FAMILY
+        // 16-bit lanes take 256 additions of a byte before they are widened
+        const __m128i Zero = _mm_setzero_si128();
+        const int32 VectorEnd = NumPixels & ~3;
+        while (Index < VectorEnd)
+        {
+            const int32 BlockEnd = FMath::Min(Index + 4 * 256, VectorEnd);
+            __m128i Lo = Zero;
+            __m128i Hi = Zero;
+            for (; Index < BlockEnd; Index += 4)
+            {
+                const __m128i Pixels = _mm_loadu_si128((const __m128i*)(BGRA + Index * 4));
+                Lo = _mm_add_epi16(Lo, _mm_unpacklo_epi8(Pixels, Zero));
+                Hi = _mm_add_epi16(Hi, _mm_unpackhi_epi8(Pixels, Zero));
+            }
+
+            // Both halves of each accumulator hold B, G, R, A
+            const __m128i Wide = _mm_add_epi32(
+                _mm_add_epi32(_mm_unpacklo_epi16(Lo, Zero), _mm_unpackhi_epi16(Lo, Zero)),
+                _mm_add_epi32(_mm_unpacklo_epi16(Hi, Zero), _mm_unpackhi_epi16(Hi, Zero)));
+            alignas(16) uint32 Lanes[4];
+            _mm_store_si128((__m128i*)Lanes, Wide);
+            OutSums[0] += Lanes[0];
+            OutSums[1] += Lanes[1];
+            OutSums[2] += Lanes[2];
+        }
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+        const int32 VectorEnd = NumPixels & ~7;
+        while (Index < VectorEnd)
+        {
+            const int32 BlockEnd = FMath::Min(Index + 8 * 256, VectorEnd);
+            uint16x8_t B = vdupq_n_u16(0);
+            uint16x8_t G = vdupq_n_u16(0);
+            uint16x8_t R = vdupq_n_u16(0);
+            for (; Index < BlockEnd; Index += 8)
+            {
+                const uint8x8x4_t Pixels = vld4_u8(BGRA + Index * 4);
+                B = vaddw_u8(B, Pixels.val[0]);
+                G = vaddw_u8(G, Pixels.val[1]);
+                R = vaddw_u8(R, Pixels.val[2]);
+            }
+
+            const uint16x8_t Channels[3] = { B, G, R };
+            for (int32 Channel = 0; Channel < 3; ++Channel)
+            {
+                const uint64x2_t Pairs = vpaddlq_u32(vpaddlq_u16(Channels[Channel]));
+                OutSums[Channel] += vgetq_lane_u64(Pairs, 0) + vgetq_lane_u64(Pairs, 1);
+            }
+        }
+#endif
+
+        for (; Index < NumPixels; ++Index)
+        {
+            const uint8* Pixel = BGRA + Index * 4;
+            OutSums[0] += Pixel[0];
+            OutSums[1] += Pixel[1];
+            OutSums[2] += Pixel[2];
+        }
+    }
+
+    bool Analyze(const FDecodedTileImage& Image, FTileImageAnalysis& Out)
+    {
+        const int32 Width = Image.Size.X;
+        const int32 Height = Image.Size.Y;
+        if (Width <= 0 || Height <= 0 || Image.Pixels.Num() < int64(Width) * Height * 4)
+        {
+            return false;
+        }
+
+        constexpr int32 NumCells = PlaceholderSize * PlaceholderSize;
+        uint64 CellSums[NumCells][3] = {};
+        uint64 CellCounts[NumCells] = {};
+        uint32 LuminanceCounts[NumLuminanceBins] = {};
+        uint32 ColorCounts[NumColorBins] = {};
+        uint64 ColorSums[NumColorBins][3] = {};
+        uint32 NumSamples = 0;
+
+        for (int32 CellY = 0; CellY < PlaceholderSize; ++CellY)
+        {
+            const int32 Y0 = CellY * Height / PlaceholderSize;
+            const int32 Y1 = (CellY + 1) * Height / PlaceholderSize;
+            const int32 Step = FMath::Max(FMath::DivideAndRoundUp(Y1 - Y0, MaxRowsPerCell), 1);
+            for (int32 Y = Y0 + Step / 2; Y < Y1; Y += Step)
+            {
+                const uint8* Row = Image.Pixels.GetData() + int64(Y) * Width * 4;
+                for (int32 CellX = 0; CellX < PlaceholderSize; ++CellX)
+                {
+                    const int32 X0 = CellX * Width / PlaceholderSize;
+                    const int32 X1 = (CellX + 1) * Width / PlaceholderSize;
+                    const int32 Cell = CellY * PlaceholderSize + CellX;
+                    SumBGR(Row + X0 * 4, X1 - X0, CellSums[Cell]);
+                    CellCounts[Cell] += X1 - X0;
+                }
+
+                // Scattered counters do not vectorize; a quarter of the row is plenty for shares
+                for (int32 X = 0; X < Width; X += 4)
+                {
+                    const uint8* Pixel = Row + X * 4;
+                    const uint32 Luminance = (19 * Pixel[0] + 183 * Pixel[1] + 54 * Pixel[2]) >> 8;
+                    ++LuminanceCounts[Luminance * NumLuminanceBins / 256];
+
+                    const int32 Bin = ((Pixel[2] >> 5) << 6) | ((Pixel[1] >> 5) << 3) | (Pixel[0] >> 5);
+                    ++ColorCounts[Bin];
+                    ColorSums[Bin][0] += Pixel[0];
+                    ColorSums[Bin][1] += Pixel[1];
+                    ColorSums[Bin][2] += Pixel[2];
+                    ++NumSamples;
+                }
+            }
+        }
+
+        uint64 TotalSums[3] = {};
+        uint64 TotalCount = 0;
+        for (int32 Cell = 0; Cell < NumCells; ++Cell)
+        {
+            TotalSums[0] += CellSums[Cell][0];
+            TotalSums[1] += CellSums[Cell][1];
+            TotalSums[2] += CellSums[Cell][2];
+            TotalCount += CellCounts[Cell];
+        }
+        if (TotalCount == 0 || NumSamples == 0)
+        {
+            return false;
+        }
+        Out.AverageColor = MeanColor(TotalSums, TotalCount);
+
+        // Images under PlaceholderSize pixels on a side leave cells empty
+        Out.Placeholder.SetNumUninitialized(NumCells);
+        for (int32 Cell = 0; Cell < NumCells; ++Cell)
+        {
+            Out.Placeholder[Cell] = CellCounts[Cell] ? MeanColor(CellSums[Cell], CellCounts[Cell]) : Out.AverageColor;
+        }
+
+        int32 DominantBin = 0;
+        for (int32 Bin = 1; Bin < NumColorBins; ++Bin)
+        {
+            if (ColorCounts[Bin] > ColorCounts[DominantBin])
+            {
+                DominantBin = Bin;
+            }
+        }
+        Out.DominantColor = MeanColor(ColorSums[DominantBin], ColorCounts[DominantBin]);
+
+        Out.LuminanceHistogram.SetNumUninitialized(NumLuminanceBins);
+        for (int32 Bin = 0; Bin < NumLuminanceBins; ++Bin)
+        {
+            Out.LuminanceHistogram[Bin] = float(LuminanceCounts[Bin]) / NumSamples;
+        }
+        return true;
+    }
+
+    TSharedRef<FJsonObject> ToJson(const FTileImageAnalysis& Analysis)
+    {
+        TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+        Json->SetStringField(TEXT("average"), Analysis.AverageColor.ToHex().Left(6));
+        Json->SetStringField(TEXT("dominant"), Analysis.DominantColor.ToHex().Left(6));
+
+        TArray<TSharedPtr<FJsonValue>> Histogram;
+        for (const float Share : Analysis.LuminanceHistogram)
+        {
+            Histogram.Add(MakeShared<FJsonValueNumber>(FMath::RoundToFloat(Share * 10000.f) / 10000.f));
+        }
+        Json->SetArrayField(TEXT("luminance"), Histogram);
+
+        // RRGGBB per cell, one string
+        FString Placeholder;
+        Placeholder.Reserve(Analysis.Placeholder.Num() * 6);
+        for (const FColor& Color : Analysis.Placeholder)
+        {
+            Placeholder += Color.ToHex().Left(6);
+        }
+        Json->SetStringField(TEXT("placeholder"), Placeholder);
+        return Json;
+    }
+
+    bool FromJson(const FJsonObject& Json, FTileImageAnalysis& Out)
+    {
+        FString Average, Dominant, Placeholder;
+        const TArray<TSharedPtr<FJsonValue>>* Histogram = nullptr;
+        if (!Json.TryGetStringField(TEXT("average"), Average) || !Json.TryGetStringField(TEXT("dominant"), Dominant)
+            || !Json.TryGetStringField(TEXT("placeholder"), Placeholder) || !Json.TryGetArrayField(TEXT("luminance"), Histogram)
+            || Placeholder.Len() != PlaceholderSize * PlaceholderSize * 6 || Histogram->Num() != NumLuminanceBins)
+        {
+            return false;
+        }
+
+        Out.AverageColor = FColor::FromHex(Average);
+        Out.DominantColor = FColor::FromHex(Dominant);
+        Out.LuminanceHistogram.Reset(NumLuminanceBins);
+        for (const TSharedPtr<FJsonValue>& Share : *Histogram)
+        {
+            Out.LuminanceHistogram.Add(float(Share->AsNumber()));
+        }
+        Out.Placeholder.Reset(PlaceholderSize * PlaceholderSize);
+        for (int32 Offset = 0; Offset < Placeholder.Len(); Offset += 6)
+        {
+            Out.Placeholder.Add(FColor::FromHex(Placeholder.Mid(Offset, 6)));
+        }
+        return true;
+    }
+
+    FString GetCachePath(const FString& DiskCacheDir)
+    {
+        return DiskCacheDir / TEXT("TileAnalysis.json");
+    }
+
+    bool LoadCache(const FString& Path, TMap<FString, FTileImageAnalysis>& Out)
+    {
+        FString Text;
+        if (!FFileHelper::LoadFileToString(Text, *Path))
+        {
+            return false;
+        }
+
+        TSharedPtr<FJsonObject> Root;
+        const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Text);
+        const TSharedPtr<FJsonObject>* Tiles = nullptr;
+        if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid()
+            || Root->GetIntegerField(TEXT("version")) != CacheVersion || !Root->TryGetObjectField(TEXT("tiles"), Tiles))
+        {
+            UE_LOG(LogRoomViz, Warning, TEXT("Ignoring tile analysis cache %s: unreadable or from another version"), *Path);
+            return false;
+        }
+
+        Out.Reserve(Out.Num() + (*Tiles)->Values.Num());
+        for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*Tiles)->Values)
+        {
+            FTileImageAnalysis Analysis;
+            const TSharedPtr<FJsonObject>* Entry = nullptr;
+            if (Pair.Value->TryGetObject(Entry) && FromJson(**Entry, Analysis))
+            {
+                Out.Add(Pair.Key, MoveTemp(Analysis));
+            }
+        }
+        return true;
+    }
+
+    bool SaveCache(const FString& Path, const TMap<FString, FTileImageAnalysis>& Analyses)
+    {
+        TSharedRef<FJsonObject> Tiles = MakeShared<FJsonObject>();
+        for (const TPair<FString, FTileImageAnalysis>& Pair : Analyses)
+        {
+            Tiles->SetObjectField(Pair.Key, ToJson(Pair.Value));
+        }
+        TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+        Root->SetNumberField(TEXT("version"), CacheVersion);
+        Root->SetObjectField(TEXT("tiles"), Tiles);
+
+        FString Text;
+        const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Text);
+        if (!FJsonSerializer::Serialize(Root, Writer))
+        {
+            return false;
+        }
+
+        // Readers never see a half-written file
+        const FString TempPath = Path + TEXT(".tmp");
+        if (!FFileHelper::SaveStringToFile(Text, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM)
+            || !IFileManager::Get().Move(*Path, *TempPath, /*bReplace*/ true))
+        {
+            UE_LOG(LogRoomViz, Warning, TEXT("Could not write the tile analysis cache %s"), *Path);
+            IFileManager::Get().Delete(*TempPath, false, false, true);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,262 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TileObjectPool.h"
+#include "Engine/Texture2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Parse.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UObjectIterator.h"
+#include "RoomVizMetrics.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+static TAutoConsoleVariable<bool> CVarClusterTiles(
+    TEXT("RoomViz.GC.ClusterTiles"),
+    true,
+    TEXT("Group each tile object pool into one GC cluster at Trim, so garbage collection visits it as a unit."));
+
+static TAutoConsoleVariable<bool> CVarDestroyReleased(
+    TEXT("RoomViz.GC.DestroyReleased"),
+    false,
+    TEXT("Mark tile objects as garbage as soon as their pool lets go of them. Floors still showing a released\n")
+    TEXT("material lose it, so only set this when nothing outside the palette keeps tile materials."));
+
+static FAutoConsoleCommand CmdGCReport(
+    TEXT("RoomViz.GC.Report"),
+    TEXT("Log every tile object pool: objects, unused objects and whether it is clustered."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        for (TObjectIterator<UTileObjectPool> It; It; ++It)
+        {
+            if (!It->IsTemplate())
+            {
+                It->LogReport();
+            }
+        }
+    }));
+
+static FAutoConsoleCommand CmdGCMeasure(
+    TEXT("RoomViz.GC.Measure"),
+    TEXT("RoomViz.GC.Measure [Iterations=5]: time full garbage collections with the current catalog loaded."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        int32 Iterations = 5;
+        for (const FString& Arg : Args)
+        {
+            FParse::Value(*Arg, TEXT("Iterations="), Iterations);
+        }
+        Iterations = FMath::Max(Iterations, 1);
+        double TotalSeconds = 0.0;
+        double MaxSeconds = 0.0;
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+            const double Seconds = FPlatformTime::Seconds() - StartTime;
+            TotalSeconds += Seconds;
+            MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+        }
+        UE_LOG(LogRoomViz, Display, TEXT("GC: %d collections, avg %.2f ms, max %.2f ms, %d UObjects"),
+            Iterations, TotalSeconds / Iterations * 1000.0, MaxSeconds * 1000.0, GUObjectArray.GetObjectArrayNumMinusAvailable());
+    }));
+
+UTexture2D* UTileObjectPool::CreateTexture(FIntPoint Size, EPixelFormat Format)
+{
+    UTexture2D* Texture = UTexture2D::CreateTransient(Size.X, Size.Y, Format);
+    if (Texture)
+    {
+        Texture->Rename(*MakeUniqueObjectName(this, UTexture2D::StaticClass()).ToString(), this,
+            REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty);
+        Adopt(Texture, FMath::Max<int64>(Texture->CalcTextureMemorySizeEnum(TMC_AllMips), 1));
+    }
+    return Texture;
+}
+
+UMaterialInstanceDynamic* UTileObjectPool::CreateMaterial(UMaterialInterface* Parent)
+{
+    UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(Parent, this);
+    if (Material)
+    {
+        Adopt(Material, 0);
+    }
+    return Material;
+}
+
+void UTileObjectPool::Adopt(UObject* Object, int64 Bytes)
+{
+    IndexOf.Add(Object, Objects.Add(Object));
+    RefCounts.Add(0);
+    TextureBytes.Add(Bytes);
+    if (Bytes > 0)
+    {
+        RoomVizMetrics::TileTextureBytes.Add(Bytes);
+        INC_DWORD_STAT(STAT_RoomViz_NumTileTextures);
+    }
+    else
+    {
+        RoomVizMetrics::MaterialInstances.Add(1);
+        INC_DWORD_STAT(STAT_RoomViz_NumMIDs);
+    }
+
+    // A clustered root's own references are not traced, so a newcomer has to join the cluster
+    if (IsClustered())
+    {
+        Object->AddToCluster(this);
+    }
+}
+
+bool UTileObjectPool::AddRef(UObject* Object)
+{
+    const int32* Index = Object ? IndexOf.Find(Object) : nullptr;
+    if (!Index)
+    {
+        return false;
+    }
+    ++RefCounts[*Index];
+    return true;
+}
+
+bool UTileObjectPool::Release(UObject* Object)
+{
+    const int32* Index = Object ? IndexOf.Find(Object) : nullptr;
+    if (!Index || RefCounts[*Index] == 0)
+    {
+        return false;
+    }
+    --RefCounts[*Index];
+    return true;
+}
+
+int32 UTileObjectPool::GetRefCount(const UObject* Object) const
+{
+    const int32* Index = Object ? IndexOf.Find(Object) : nullptr;
+    return Index ? RefCounts[*Index] : 0;
+}
+
+int32 UTileObjectPool::GetNumUnused() const
+{
+    int32 NumUnused = 0;
+    for (int32 Index = 0; Index < Objects.Num(); ++Index)
+    {
+        NumUnused += RefCounts[Index] == 0 || !Objects[Index] ? 1 : 0;
+    }
+    return NumUnused;
+}
+
+int32 UTileObjectPool::Trim()
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_PoolTrim);
+
+    const int32 NumUnused = GetNumUnused();
+    if (NumUnused > 0 || !CanBeClusterRoot())
+    {
+        DissolveCluster();
+    }
+
+    if (NumUnused > 0)
+    {
+        const bool bDestroy = CVarDestroyReleased.GetValueOnGameThread();
+        for (int32 Index = Objects.Num() - 1; Index >= 0; --Index)
+        {
+            if (RefCounts[Index] > 0 && Objects[Index])
+            {
+                continue;
+            }
+            if (bDestroy && Objects[Index])
+            {
+                Objects[Index]->MarkAsGarbage();
+            }
+            UntrackMetrics(Index);
+            Objects.RemoveAtSwap(Index);
+            RefCounts.RemoveAtSwap(Index);
+            TextureBytes.RemoveAtSwap(Index);
+        }
+
+        IndexOf.Reset();
+        for (int32 Index = 0; Index < Objects.Num(); ++Index)
+        {
+            IndexOf.Add(Objects[Index], Index);
+        }
+    }
+
+    if (Objects.Num() > 0 && CanBeClusterRoot() && !IsClustered())
+    {
+        CreateCluster();
+    }
+
+    UE_LOG(LogRoomViz, Verbose, TEXT("%s: trimmed %d objects, %d left%s"), *GetName(), NumUnused, Objects.Num(), IsClustered() ? TEXT(" (clustered)") : TEXT(""));
+    return NumUnused;
+}
+
+void UTileObjectPool::Reset()
+{
+    DissolveCluster();
+    for (int32 Index = 0; Index < Objects.Num(); ++Index)
+    {
+        UntrackMetrics(Index);
+    }
+    Objects.Reset();
+    RefCounts.Reset();
+    TextureBytes.Reset();
+    IndexOf.Reset();
+}
+
+void UTileObjectPool::BeginDestroy()
+{
+    for (int32 Index = 0; Index < Objects.Num(); ++Index)
+    {
+        UntrackMetrics(Index);
+    }
+    TextureBytes.Reset();
+    Super::BeginDestroy();
+}
+
+void UTileObjectPool::UntrackMetrics(int32 Index)
+{
+    if (TextureBytes[Index] > 0)
+    {
+        RoomVizMetrics::TileTextureBytes.Add(-TextureBytes[Index]);
+        DEC_DWORD_STAT(STAT_RoomViz_NumTileTextures);
+    }
+    else
+    {
+        RoomVizMetrics::MaterialInstances.Add(-1);
+        DEC_DWORD_STAT(STAT_RoomViz_NumMIDs);
+    }
+}
+
+bool UTileObjectPool::IsClustered() const
+{
+    return HasAnyInternalFlags(EInternalObjectFlags::ClusterRoot);
+}
+
+bool UTileObjectPool::CanBeClusterRoot() const
+{
+    return !IsTemplate() && CVarClusterTiles.GetValueOnAnyThread();
+}
+
+void UTileObjectPool::Recluster()
+{
+    if (IsClustered())
+    {
+        DissolveCluster();
+        CreateCluster();
+    }
+}
+
+void UTileObjectPool::DissolveCluster()
+{
+    if (IsClustered())
+    {
+        GUObjectClusters.DissolveCluster(this);
+    }
+}
+
+void UTileObjectPool::LogReport() const
+{
+    UE_LOG(LogRoomViz, Display, TEXT("%s (%s): %d objects, %d unused until the next trim, %s"),
+        *GetName(), GetOuter() ? *GetOuter()->GetName() : TEXT("?"), Objects.Num(), GetNumUnused(),
+        IsClustered() ? TEXT("clustered") : TEXT("not clustered"));
+}
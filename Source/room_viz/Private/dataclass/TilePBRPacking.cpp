@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TilePBRPacking.h"
+#include "Async/ParallelFor.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace TilePBRPacking
+{
+    void PackORM(const uint8* AO, const uint8* Roughness, const uint8* Metallic, uint8* OutBGRA, int32 NumPixels)
+    {
+        int32 Index = 0;
+
+#if PLATFORM_CPU_X86_FAMILY
+        const __m128i DefaultAOVec = _mm_set1_epi8((char)DefaultAO);
+        const __m128i DefaultRoughnessVec = _mm_set1_epi8((char)DefaultRoughness);
+        const __m128i DefaultMetallicVec = _mm_set1_epi8((char)DefaultMetallic);
+        const __m128i Alpha = _mm_set1_epi8((char)0xFF);
+
+        for (; Index + 16 <= NumPixels; Index += 16)
+        {
+            const __m128i R = AO ? _mm_loadu_si128((const __m128i*)(AO + Index)) : DefaultAOVec;
+            const __m128i G = Roughness ? _mm_loadu_si128((const __m128i*)(Roughness + Index)) : DefaultRoughnessVec;
+            const __m128i B = Metallic ? _mm_loadu_si128((const __m128i*)(Metallic + Index)) : DefaultMetallicVec;
+
+            // BGRA byte order: interleave B/G and R/A pairs, then the pairs
+            const __m128i BGLo = _mm_unpacklo_epi8(B, G);
+            const __m128i BGHi = _mm_unpackhi_epi8(B, G);
+            const __m128i RALo = _mm_unpacklo_epi8(R, Alpha);
+            const __m128i RAHi = _mm_unpackhi_epi8(R, Alpha);
+
+            __m128i* Out = (__m128i*)(OutBGRA + Index * 4);
+            _mm_storeu_si128(Out + 0, _mm_unpacklo_epi16(BGLo, RALo));
+            _mm_storeu_si128(Out + 1, _mm_unpackhi_epi16(BGLo, RALo));
+            _mm_storeu_si128(Out + 2, _mm_unpacklo_epi16(BGHi, RAHi));
+            _mm_storeu_si128(Out + 3, _mm_unpackhi_epi16(BGHi, RAHi));
+        }
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+        const uint8x16_t DefaultAOVec = vdupq_n_u8(DefaultAO);
+        const uint8x16_t DefaultRoughnessVec = vdupq_n_u8(DefaultRoughness);
+        const uint8x16_t DefaultMetallicVec = vdupq_n_u8(DefaultMetallic);
+
+        for (; Index + 16 <= NumPixels; Index += 16)
+        {
+            uint8x16x4_t Texels;
+            Texels.val[0] = Metallic ? vld1q_u8(Metallic + Index) : DefaultMetallicVec;
+            Texels.val[1] = Roughness ? vld1q_u8(Roughness + Index) : DefaultRoughnessVec;
+            Texels.val[2] = AO ? vld1q_u8(AO + Index) : DefaultAOVec;
+            Texels.val[3] = vdupq_n_u8(0xFF);
+            vst4q_u8(OutBGRA + Index * 4, Texels);
+        }
+#endif
+
+        for (; Index < NumPixels; ++Index)
+        {
+            uint8* Out = OutBGRA + Index * 4;
+            Out[0] = Metallic ? Metallic[Index] : DefaultMetallic;
+            Out[1] = Roughness ? Roughness[Index] : DefaultRoughness;
+            Out[2] = AO ? AO[Index] : DefaultAO;
+            Out[3] = 0xFF;
+        }
+    }
+
+    void PackORMParallel(const uint8* AO, const uint8* Roughness, const uint8* Metallic, uint8* OutBGRA, int32 NumPixels)
+    {
+        // Chunks stay multiples of the 16-pixel vector width
+        constexpr int32 ChunkPixels = 64 * 1024;
+        const int32 NumChunks = FMath::DivideAndRoundUp(NumPixels, ChunkPixels);
+
+        ParallelFor(NumChunks, [=](int32 Chunk)
+        {
+            const int32 Start = Chunk * ChunkPixels;
+            const int32 Count = FMath::Min(ChunkPixels, NumPixels - Start);
+            PackORM(AO ? AO + Start : nullptr, Roughness ? Roughness + Start : nullptr, Metallic ? Metallic + Start : nullptr,
+                OutBGRA + int64(Start) * 4, Count);
+        });
+    }
+
+    void DecodeAndPack(const FTilePBRSources& Sources, FTilePBRTexels& Out, int32 MaxSize)
+    {
+        ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_ORMPack);
+
+        FDecodedTileImage Normal;
+        if (Sources.Normal.IsValid() && DecodeTileImage(Sources.Normal->GetBytes(), ERGBFormat::BGRA, Normal, MaxSize))
+        {
+            Out.NormalSize = Normal.Size;
+            Out.Normal = MoveTemp(Normal.Pixels);
+        }
+
+        TArray<uint8> Maps[3];
+        const FTileImagePayloadPtr* MapSources[3] = { &Sources.AO, &Sources.Roughness, &Sources.Metallic };
+        FIntPoint Size = FIntPoint::ZeroValue;
+        for (int32 MapIndex = 0; MapIndex < 3; ++MapIndex)
+        {
+            FDecodedTileImage Map;
+            if (!MapSources[MapIndex]->IsValid() || !DecodeTileImage((*MapSources[MapIndex])->GetBytes(), ERGBFormat::Gray, Map, MaxSize))
+            {
+                continue;
+            }
+            if (Size == FIntPoint::ZeroValue)
+            {
+                Size = Map.Size;
+            }
+            if (Map.Size != Size)
+            {
+                UE_LOG(LogRoomViz, Warning, TEXT("PBR map is %dx%d, expected %dx%d; using the default instead"), Map.Size.X, Map.Size.Y, Size.X, Size.Y);
+                continue;
+            }
+            Maps[MapIndex] = MoveTemp(Map.Pixels);
+        }
+
+        if (Size == FIntPoint::ZeroValue)
+        {
+            return;
+        }
+
+        const int32 NumPixels = Size.X * Size.Y;
+        Out.ORMSize = Size;
+        Out.ORM.SetNumUninitialized(NumPixels * 4);
+        PackORMParallel(
+            Maps[0].Num() ? Maps[0].GetData() : nullptr,
+            Maps[1].Num() ? Maps[1].GetData() : nullptr,
+            Maps[2].Num() ? Maps[2].GetData() : nullptr,
+            Out.ORM.GetData(), NumPixels);
+    }
+}
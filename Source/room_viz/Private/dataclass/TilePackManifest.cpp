@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TilePackManifest.h"
+
+FString UTilePackManifest::GetPackFolder(FName InPackName)
+{
+    return FString::Printf(TEXT("/Game/TilePacks/%s"), *InPackName.ToString());
+}
+
+FSoftObjectPath UTilePackManifest::GetManifestPath(FName InPackName)
+{
+    const FString AssetName = FString::Printf(TEXT("TP_%s"), *InPackName.ToString());
+    return FSoftObjectPath(FString::Printf(TEXT("%s/%s.%s"), *GetPackFolder(InPackName), *AssetName, *AssetName));
+}
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "dataclass/TileTextureCache.h"
+#include "Engine/Texture2D.h"
+#include "Hash/xxhash.h"
+#include "UObject/UObjectGlobals.h"
+
+UTexture2D* FTileTextureCache::Find(uint64 Hash) const
+{
+    const TObjectKey<UTexture2D>* Key = TexturesByHash.Find(Hash);
+    const FEntry* Entry = Key ? Entries.Find(*Key) : nullptr;
+    return Entry ? Entry->Texture.Get() : nullptr;
+}
+
+void FTileTextureCache::AddHash(UTexture2D* Texture, uint64 Hash, int64 ResourceBytes)
+{
+    check(Texture);
+    FEntry* Entry = Entries.Find(Texture);
+    if (!Entry)
+    {
+        return;
+    }
+    Entry->ResourceBytes = FMath::Max(Entry->ResourceBytes, ResourceBytes);
+    if (!TexturesByHash.Contains(Hash))
+    {
+        TexturesByHash.Add(Hash, Texture);
+        Entry->Hashes.Add(Hash);
+    }
+}
+
+void FTileTextureCache::Acquire(const FString& TileID, UTexture2D* Texture)
+{
+    if (const TObjectKey<UTexture2D>* Current = TileTextures.Find(TileID))
+    {
+        if (*Current == TObjectKey<UTexture2D>(Texture))
+        {
+            return;
+        }
+        Release(TileID);
+    }
+
+    FEntry& Entry = Entries.FindOrAdd(Texture);
+    Entry.Texture = Texture;
+    ++Entry.RefCount;
+    TileTextures.Add(TileID, Texture);
+}
+
+void FTileTextureCache::Release(const FString& TileID)
+{
+    TObjectKey<UTexture2D> Texture;
+    if (!TileTextures.RemoveAndCopyValue(TileID, Texture))
+    {
+        return;
+    }
+
+    FEntry* Entry = Entries.Find(Texture);
+    if (Entry && --Entry->RefCount <= 0)
+    {
+        for (uint64 Hash : Entry->Hashes)
+        {
+            TexturesByHash.Remove(Hash);
+        }
+        Entries.Remove(Texture);
+    }
+}
+
+void FTileTextureCache::Reset()
+{
+    TexturesByHash.Reset();
+    Entries.Reset();
+    TileTextures.Reset();
+}
+
+uint64 FTileTextureCache::HashBytes(TConstArrayView<uint8> Bytes)
+{
+    return FXxHash64::HashBuffer(Bytes.GetData(), Bytes.Num()).Hash;
+}
+
+double FTileTextureCache::GetDedupRatio() const
+{
+    return Entries.Num() > 0 ? double(TileTextures.Num()) / Entries.Num() : 1.0;
+}
+
+int64 FTileTextureCache::GetBytesSaved() const
+{
+    int64 Saved = 0;
+    for (const TPair<TObjectKey<UTexture2D>, FEntry>& Pair : Entries)
+    {
+        Saved += FMath::Max(Pair.Value.RefCount - 1, 0) * Pair.Value.ResourceBytes;
+    }
+    return Saved;
+}
+
+void FTileTextureCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    for (TPair<TObjectKey<UTexture2D>, FEntry>& Pair : Entries)
+    {
+        Collector.AddReferencedObject(Pair.Value.Texture);
+    }
+}
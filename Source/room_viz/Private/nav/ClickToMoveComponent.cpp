@@ -0,0 +1,297 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "nav/ClickToMoveComponent.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "DrawDebugHelpers.h"
+
+UClickToMoveComponent::UClickToMoveComponent()
+{
+    // Only ticks while a coalesced goal is waiting for its path query
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UClickToMoveComponent::RequestMoveTo(const FVector& Goal)
+{
+    ++NumMoveRequests;
+
+    // Same goal as the one we are already heading to (or about to plan for)
+    const FVector& LatestGoal = bHasPendingGoal ? PendingGoal : CurrentGoal;
+    if ((bHasGoal || bHasPendingGoal) && FVector::DistSquared(LatestGoal, Goal) < FMath::Square(GoalTolerance))
+    {
+        return;
+    }
+
+    if (TryReusePath(Goal))
+    {
+        bHasPendingGoal = false;
+        return;
+    }
+
+    // Coalesce: only the latest goal is kept, the tick issues the query when allowed
+    PendingGoal = Goal;
+    bHasPendingGoal = true;
+    SetComponentTickEnabled(true);
+}
+
+void UClickToMoveComponent::StopMove()
+{
+    bHasPendingGoal = false;
+    bHasGoal = false;
+    CurrentPath.Reset();
+    SetComponentTickEnabled(false);
+
+    if (InFlightQueryID != INVALID_NAVQUERYID)
+    {
+        if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+        {
+            NavSys->AbortAsyncFindPathRequest(InFlightQueryID);
+        }
+        InFlightQueryID = INVALID_NAVQUERYID;
+    }
+
+    if (UPathFollowingComponent* PFollowComp = PathFollowing.Get())
+    {
+        PFollowComp->AbortMove(*this, FPathFollowingResultFlags::MovementStop);
+    }
+}
+
+void UClickToMoveComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (!bHasPendingGoal)
+    {
+        SetComponentTickEnabled(false);
+        return;
+    }
+
+    // One query in flight at a time; its completion picks up whatever goal is pending by then
+    const double Now = GetWorld()->GetTimeSeconds();
+    if (InFlightQueryID == INVALID_NAVQUERYID && Now - LastQueryTime >= MinRepathInterval)
+    {
+        bHasPendingGoal = false;
+        IssuePathQuery(PendingGoal);
+    }
+}
+
+void UClickToMoveComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (InFlightQueryID != INVALID_NAVQUERYID)
+    {
+        if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+        {
+            NavSys->AbortAsyncFindPathRequest(InFlightQueryID);
+        }
+        InFlightQueryID = INVALID_NAVQUERYID;
+    }
+    if (UPathFollowingComponent* PFollowComp = PathFollowing.Get())
+    {
+        PFollowComp->OnRequestFinished.RemoveAll(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UClickToMoveComponent::IssuePathQuery(const FVector& Goal)
+{
+    UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+    APawn* Pawn = Cast<APawn>(GetOwner());
+    const ANavigationData* NavData = GetNavData();
+    if (!NavSys || !Pawn || !NavData)
+    {
+        return;
+    }
+
+    FPathFindingQuery Query(this, *NavData, Pawn->GetNavAgentLocation(), Goal,
+        UNavigationQueryFilter::GetQueryFilter(*NavData, Pawn, nullptr));
+    Query.SetAllowPartialPaths(true);
+
+    InFlightQueryID = NavSys->FindPathAsync(Pawn->GetNavAgentPropertiesRef(), Query,
+        FNavPathQueryDelegate::CreateUObject(this, &UClickToMoveComponent::OnPathQueryFinished));
+    LastQueryTime = GetWorld()->GetTimeSeconds();
+    ++NumPathQueries;
+
+    CurrentGoal = Goal;
+    bHasGoal = true;
+}
+
+void UClickToMoveComponent::OnPathQueryFinished(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+    if (QueryID != InFlightQueryID)
+    {
+        return; // Aborted or superseded
+    }
+    InFlightQueryID = INVALID_NAVQUERYID;
+
+    if (Result == ENavigationQueryResult::Success && Path.IsValid() && Path->IsValid())
+    {
+        FollowPath(CurrentGoal, Path);
+    }
+
+    // A goal that arrived meanwhile may now be close enough to the fresh path
+    if (bHasPendingGoal && TryReusePath(PendingGoal))
+    {
+        bHasPendingGoal = false;
+    }
+}
+
+bool UClickToMoveComponent::TryReusePath(const FVector& Goal)
+{
+    UPathFollowingComponent* PFollowComp = PathFollowing.Get();
+    APawn* Pawn = Cast<APawn>(GetOwner());
+    const ANavigationData* NavData = GetNavData();
+    if (!PFollowComp || !Pawn || !NavData || !CurrentPath.IsValid() || !CurrentPath->IsValid()
+        || PFollowComp->GetStatus() != EPathFollowingStatus::Moving || PFollowComp->GetPath() != CurrentPath)
+    {
+        return false;
+    }
+
+    // Closest point on the part of the path that is still ahead of us
+    const TArray<FNavPathPoint>& Points = CurrentPath->GetPathPoints();
+    const int32 FirstSegment = FMath::Max<int32>(PFollowComp->GetCurrentPathIndex(), 0);
+    int32 BestSegment = INDEX_NONE;
+    FVector BestPoint = FVector::ZeroVector;
+    double BestDistSq = FMath::Square(PathReuseDistance);
+
+    for (int32 Index = FirstSegment; Index + 1 < Points.Num(); ++Index)
+    {
+        const FVector Candidate = FMath::ClosestPointOnSegment(Goal, Points[Index].Location, Points[Index + 1].Location);
+        const double DistSq = FVector::DistSquared(Candidate, Goal);
+        if (DistSq <= BestDistSq)
+        {
+            BestDistSq = DistSq;
+            BestSegment = Index;
+            BestPoint = Candidate;
+        }
+    }
+
+    if (BestSegment == INDEX_NONE)
+    {
+        return false;
+    }
+
+    // Corridor refinement: the detour from the path to the goal has to stay on the navmesh
+    FVector HitLocation;
+    const FSharedConstNavQueryFilter Filter = UNavigationQueryFilter::GetQueryFilter(*NavData, Pawn, nullptr);
+    if (NavData->Raycast(BestPoint, Goal, HitLocation, Filter, this))
+    {
+        return false;
+    }
+
+    TArray<FVector> NewPoints;
+    NewPoints.Reserve(BestSegment - FirstSegment + 3);
+    NewPoints.Add(Pawn->GetNavAgentLocation());
+    for (int32 Index = FirstSegment + 1; Index <= BestSegment; ++Index)
+    {
+        NewPoints.Add(Points[Index].Location);
+    }
+    if (!FVector::PointsAreNear(NewPoints.Last(), BestPoint, 1.f))
+    {
+        NewPoints.Add(BestPoint);
+    }
+    if (!FVector::PointsAreNear(NewPoints.Last(), Goal, 1.f))
+    {
+        NewPoints.Add(Goal);
+    }
+    if (NewPoints.Num() < 2)
+    {
+        return false;
+    }
+
+    FNavPathSharedPtr NewPath = MakeShared<FNavigationPath, ESPMode::ThreadSafe>(NewPoints);
+    NewPath->SetNavigationDataUsed(const_cast<ANavigationData*>(NavData));
+
+    ++NumPathReuses;
+    CurrentGoal = Goal;
+    bHasGoal = true;
+    FollowPath(Goal, NewPath);
+    return true;
+}
+
+void UClickToMoveComponent::FollowPath(const FVector& Goal, FNavPathSharedPtr Path)
+{
+    UPathFollowingComponent* PFollowComp = GetPathFollowing();
+    if (!PFollowComp || !PFollowComp->IsPathFollowingAllowed())
+    {
+        return;
+    }
+
+    CurrentPath = Path;
+    MoveRequestID = PFollowComp->RequestMove(FAIMoveRequest(Goal), Path);
+
+#if ENABLE_DRAW_DEBUG
+    if (bDrawDebugPath)
+    {
+        const TArray<FNavPathPoint>& Points = Path->GetPathPoints();
+        for (int32 Index = 0; Index + 1 < Points.Num(); ++Index)
+        {
+            DrawDebugLine(GetWorld(), Points[Index].Location, Points[Index + 1].Location, FColor::Green, false, 2.f, 0, 2.f);
+        }
+    }
+#endif
+}
+
+void UClickToMoveComponent::OnMoveFinished(FAIRequestID RequestID, const FPathFollowingResult& Result)
+{
+    // A query in flight owns CurrentGoal already; the move it replaces finishing changes nothing
+    if (RequestID != MoveRequestID || InFlightQueryID != INVALID_NAVQUERYID)
+    {
+        return;
+    }
+
+    // Once arrived the pawn may be moved away (a drop, a room switch), so the same spot has to count again
+    bHasGoal = false;
+    CurrentPath.Reset();
+    MoveRequestID = FAIRequestID::InvalidRequest;
+}
+
+AController* UClickToMoveComponent::GetController() const
+{
+    const APawn* Pawn = Cast<APawn>(GetOwner());
+    return Pawn ? Pawn->GetController() : nullptr;
+}
+
+const ANavigationData* UClickToMoveComponent::GetNavData() const
+{
+    const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+    const APawn* Pawn = Cast<APawn>(GetOwner());
+    if (!NavSys || !Pawn)
+    {
+        return nullptr;
+    }
+    return NavSys->GetNavDataForProps(Pawn->GetNavAgentPropertiesRef(), Pawn->GetNavAgentLocation());
+}
+
+UPathFollowingComponent* UClickToMoveComponent::GetPathFollowing()
+{
+    if (UPathFollowingComponent* PFollowComp = PathFollowing.Get())
+    {
+        return PFollowComp;
+    }
+
+    // Same setup as UAIBlueprintHelperLibrary::SimpleMoveToLocation for player controllers
+    AController* Controller = GetController();
+    if (!Controller)
+    {
+        return nullptr;
+    }
+
+    UPathFollowingComponent* PFollowComp = Controller->FindComponentByClass<UPathFollowingComponent>();
+    if (!PFollowComp)
+    {
+        PFollowComp = NewObject<UPathFollowingComponent>(Controller);
+        PFollowComp->RegisterComponentWithWorld(Controller->GetWorld());
+        PFollowComp->Initialize();
+    }
+
+    PFollowComp->OnRequestFinished.AddUObject(this, &UClickToMoveComponent::OnMoveFinished);
+    PathFollowing = PFollowComp;
+    return PFollowComp;
+}
@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/CatalogStandInServer.h"
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpPath.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Parse.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Math/RandomStream.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "room_viz.h"
+
+void FCatalogStandInConfig::ParseCommandLine(const TCHAR* Params)
+{
+    FParse::Value(Params, TEXT("StandInPort="), Port);
+    FParse::Value(Params, TEXT("TileCount="), TileCount);
+    FParse::Value(Params, TEXT("TileSize="), TileSize);
+    FParse::Value(Params, TEXT("JpegQuality="), JpegQuality);
+    FParse::Value(Params, TEXT("LatencyMs="), LatencyMs);
+    FParse::Value(Params, TEXT("BandwidthMBps="), BandwidthMBps);
+    bPNG = FParse::Param(Params, TEXT("PNG"));
+
+    TileCount = FMath::Max(TileCount, 0);
+    TileSize = FMath::Clamp(TileSize, 4, 16384);
+}
+
+FCatalogStandInServer::FCatalogStandInServer(const FCatalogStandInConfig& InConfig)
+    : Config(InConfig)
+{
+}
+
+FCatalogStandInServer::~FCatalogStandInServer()
+{
+    Stop();
+}
+
+bool FCatalogStandInServer::Start()
+{
+    GenerateTiles();
+
+    FHttpServerModule& HttpServer = FHttpServerModule::Get();
+    Router = HttpServer.GetHttpRouter(Config.Port, /*bFailOnBindFailure*/ true);
+    if (!Router.IsValid())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Stand-in server: could not bind port %d"), Config.Port);
+        return false;
+    }
+
+    CatalogRoute = Router->BindRoute(FHttpPath(TEXT("/FloorTiles.json")), EHttpServerRequestVerbs::VERB_GET,
+        FHttpRequestHandler::CreateRaw(this, &FCatalogStandInServer::HandleCatalog));
+    TileRoute = Router->BindRoute(FHttpPath(TEXT("/tiles/:id")), EHttpServerRequestVerbs::VERB_GET,
+        FHttpRequestHandler::CreateRaw(this, &FCatalogStandInServer::HandleTile));
+    HttpServer.StartAllListeners();
+
+    TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FCatalogStandInServer::TickPending));
+
+    UE_LOG(LogRoomViz, Display, TEXT("Stand-in server: %d %s tiles of %dpx at %s"),
+        Config.TileCount, Config.bPNG ? TEXT("PNG") : TEXT("JPEG"), Config.TileSize, *GetCatalogURL());
+    return true;
+}
+
+void FCatalogStandInServer::Stop()
+{
+    if (TickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+        TickerHandle.Reset();
+    }
+
+    if (Router.IsValid())
+    {
+        Router->UnbindRoute(CatalogRoute);
+        Router->UnbindRoute(TileRoute);
+        Router.Reset();
+    }
+
+    // Let clients see a closed connection rather than waiting on the simulated link forever
+    for (FPendingResponse& Entry : Pending)
+    {
+        Entry.OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServiceUnavail));
+    }
+    Pending.Empty();
+}
+
+FString FCatalogStandInServer::GetCatalogURL() const
+{
+    return FString::Printf(TEXT("http://127.0.0.1:%d/FloorTiles.json"), Config.Port);
+}
+
+FString FCatalogStandInServer::GetTileURL(int32 Index) const
+{
+    return FString::Printf(TEXT("http://127.0.0.1:%d/tiles/%d"), Config.Port, Index);
+}
+
+bool FCatalogStandInServer::WriteToDirectory(const FString& Dir)
+{
+    if (TileImages.Num() != Config.TileCount)
+    {
+        GenerateTiles();
+    }
+
+    const TCHAR* Extension = Config.bPNG ? TEXT("png") : TEXT("jpg");
+    for (int32 Index = 0; Index < TileImages.Num(); ++Index)
+    {
+        const FString Path = Dir / FString::Printf(TEXT("standin_%05d.%s"), Index, Extension);
+        if (!FFileHelper::SaveArrayToFile(TileImages[Index], *Path))
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Stand-in server: could not write %s"), *Path);
+            return false;
+        }
+    }
+
+    // Relative names, resolved against the catalog's directory by the parser
+    const FString Catalog = BuildCatalogJson([Extension](int32 Index) { return FString::Printf(TEXT("standin_%05d.%s"), Index, Extension); });
+    return FFileHelper::SaveStringToFile(Catalog, *(Dir / TEXT("FloorTiles.json")));
+}
+
+FString FCatalogStandInServer::BuildCatalogJson(TFunctionRef<FString(int32)> TileLocation) const
+{
+    TArray<TSharedPtr<FJsonValue>> Tiles;
+    Tiles.Reserve(Config.TileCount);
+    for (int32 Index = 0; Index < Config.TileCount; ++Index)
+    {
+        TSharedRef<FJsonObject> Tile = MakeShared<FJsonObject>();
+        Tile->SetStringField(TEXT("id"), FString::Printf(TEXT("standin_%05d"), Index));
+        Tile->SetStringField(TEXT("baseColorUrl"), TileLocation(Index));
+        Tiles.Add(MakeShared<FJsonValueObject>(Tile));
+    }
+
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetArrayField(TEXT("Tiles"), Tiles);
+
+    FString Body;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Body);
+    FJsonSerializer::Serialize(Root, Writer);
+    return Body;
+}
+
+bool FCatalogStandInServer::HandleCatalog(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+    const FString Body = BuildCatalogJson([this](int32 Index) { return GetTileURL(Index); });
+    const int64 NumBytes = Body.Len();
+    Send(FHttpServerResponse::Create(Body, TEXT("application/json")), NumBytes, OnComplete);
+    return true;
+}
+
+bool FCatalogStandInServer::HandleTile(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+    int32 Index = INDEX_NONE;
+    LexFromString(Index, *Request.PathParams.FindRef(TEXT("id")));
+    if (!TileImages.IsValidIndex(Index))
+    {
+        OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound));
+        return true;
+    }
+
+    const TArray64<uint8>& Image = TileImages[Index];
+    TArray<uint8> Body(Image.GetData(), IntCastChecked<int32>(Image.Num()));
+    Send(FHttpServerResponse::Create(MoveTemp(Body), Config.bPNG ? TEXT("image/png") : TEXT("image/jpeg")), Image.Num(), OnComplete);
+    return true;
+}
+
+void FCatalogStandInServer::Send(TUniquePtr<FHttpServerResponse> Response, int64 NumBytes, const FHttpResultCallback& OnComplete)
+{
+    ServedBytes += NumBytes;
+
+    const double Now = FPlatformTime::Seconds();
+    if (Config.LatencyMs <= 0.f && Config.BandwidthMBps <= 0.f)
+    {
+        OnComplete(MoveTemp(Response));
+        return;
+    }
+
+    // Responses share one link: each waits for the previous transfer, then for its own bytes
+    double DueTime = Now;
+    if (Config.BandwidthMBps > 0.f)
+    {
+        LinkFreeTime = FMath::Max(LinkFreeTime, Now) + double(NumBytes) / (double(Config.BandwidthMBps) * 1024.0 * 1024.0);
+        DueTime = LinkFreeTime;
+    }
+    DueTime += Config.LatencyMs / 1000.0;
+
+    FPendingResponse& Entry = Pending.AddDefaulted_GetRef();
+    Entry.DueTime = DueTime;
+    Entry.Response = MoveTemp(Response);
+    Entry.OnComplete = OnComplete;
+}
+
+bool FCatalogStandInServer::TickPending(float DeltaTime)
+{
+    const double Now = FPlatformTime::Seconds();
+    for (int32 Index = 0; Index < Pending.Num();)
+    {
+        if (Pending[Index].DueTime <= Now)
+        {
+            FPendingResponse Entry = MoveTemp(Pending[Index]);
+            Pending.RemoveAtSwap(Index);
+            Entry.OnComplete(MoveTemp(Entry.Response));
+        }
+        else
+        {
+            ++Index;
+        }
+    }
+    return true;
+}
+
+void FCatalogStandInServer::GenerateTiles()
+{
+    // Workers only look the module up
+    FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+    TileImages.SetNum(Config.TileCount);
+    ParallelFor(Config.TileCount, [this](int32 Index)
+    {
+        TileImages[Index] = EncodeSyntheticTile(Index, Config.TileSize, Config.bPNG, Config.JpegQuality);
+    });
+}
+
+TArray64<uint8> FCatalogStandInServer::EncodeSyntheticTile(int32 Index, int32 Size, bool bPNG, int32 JpegQuality)
+{
+    // Grout grid over a per-tile base colour plus noise, so JPEG sizes look like real photos
+    FRandomStream Random(Index * 7919 + 17);
+    const FColor Base((uint8)Random.RandRange(60, 230), (uint8)Random.RandRange(60, 230), (uint8)Random.RandRange(60, 230), 255);
+    const int32 GridStep = FMath::Max(Size / Random.RandRange(2, 8), 2);
+
+    TArray<FColor> Pixels;
+    Pixels.SetNumUninitialized(Size * Size);
+    for (int32 Y = 0; Y < Size; ++Y)
+    {
+        for (int32 X = 0; X < Size; ++X)
+        {
+            const bool bGrout = (X % GridStep) < 2 || (Y % GridStep) < 2;
+            const int32 Noise = Random.RandRange(-12, 12);
+            Pixels[Y * Size + X] = bGrout
+                ? FColor(40, 40, 40, 255)
+                : FColor((uint8)FMath::Clamp(Base.R + Noise, 0, 255), (uint8)FMath::Clamp(Base.G + Noise, 0, 255), (uint8)FMath::Clamp(Base.B + Noise, 0, 255), 255);
+        }
+    }
+
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+    TSharedPtr<IImageWrapper> Wrapper = ImageWrapperModule.CreateImageWrapper(bPNG ? EImageFormat::PNG : EImageFormat::JPEG);
+    if (Wrapper.IsValid() && Wrapper->SetRaw(Pixels.GetData(), Pixels.Num() * sizeof(FColor), Size, Size, ERGBFormat::BGRA, 8))
+    {
+        return Wrapper->GetCompressed(bPNG ? 0 : JpegQuality);
+    }
+    return TArray64<uint8>();
+}
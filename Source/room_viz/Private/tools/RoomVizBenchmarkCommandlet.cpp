@@ -0,0 +1,1196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/RoomVizBenchmarkCommandlet.h"
+#include "tools/CatalogStandInServer.h"
+#include "tools/RoomVizHeadlessSession.h"
+#include "dataclass/AdaptiveQualityPolicy.h"
+#include "dataclass/MaterialAPIManager.h"
+#include "dataclass/RoomVariantSubsystem.h"
+#include "dataclass/TileCatalogSources.h"
+#include "dataclass/TileImageAnalysis.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "dataclass/TileObjectPool.h"
+#include "nav/ClickToMoveComponent.h"
+#include "ui/FloorBoxSelection.h"
+#include "ui/UIUserWidget.h"
+#include "AIController.h"
+#include "Blueprint/UserWidget.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerStart.h"
+#include "Components/StaticMeshComponent.h"
+#include "NavigationSystem.h"
+#include "Algo/Count.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Materials/Material.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Math/RandomStream.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/UObjectArray.h"
+#include "room_viz.h"
+#include <atomic>
+
+namespace RoomVizBenchmark
+{
+    /** Percentiles and a bucketed histogram of frame times, in milliseconds */
+    TSharedRef<FJsonObject> MakeFrameTimeReport(TArray<double> FrameTimes)
+    {
+        TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+        Report->SetNumberField(TEXT("frames"), FrameTimes.Num());
+        if (FrameTimes.Num() == 0)
+        {
+            return Report;
+        }
+
+        FrameTimes.Sort();
+        auto Percentile = [&FrameTimes](double P)
+        {
+            const int32 Index = FMath::Clamp(FMath::CeilToInt32(P * FrameTimes.Num()) - 1, 0, FrameTimes.Num() - 1);
+            return FrameTimes[Index] * 1000.0;
+        };
+        Report->SetNumberField(TEXT("p50_ms"), Percentile(0.50));
+        Report->SetNumberField(TEXT("p95_ms"), Percentile(0.95));
+        Report->SetNumberField(TEXT("p99_ms"), Percentile(0.99));
+        Report->SetNumberField(TEXT("max_ms"), FrameTimes.Last() * 1000.0);
+
+        static constexpr double BucketEdgesMs[] = { 8.0, 16.7, 33.3, 50.0, 100.0 };
+        constexpr int32 NumEdges = UE_ARRAY_COUNT(BucketEdgesMs);
+        int32 Counts[NumEdges + 1] = {};
+        for (double FrameTime : FrameTimes)
+        {
+            int32 Bucket = 0;
+            while (Bucket < NumEdges && FrameTime * 1000.0 >= BucketEdgesMs[Bucket])
+            {
+                ++Bucket;
+            }
+            ++Counts[Bucket];
+        }
+
+        TArray<TSharedPtr<FJsonValue>> Histogram;
+        for (int32 Bucket = 0; Bucket <= NumEdges; ++Bucket)
+        {
+            TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+            Entry->SetNumberField(TEXT("min_ms"), Bucket == 0 ? 0.0 : BucketEdgesMs[Bucket - 1]);
+            if (Bucket < NumEdges)
+            {
+                Entry->SetNumberField(TEXT("max_ms"), BucketEdgesMs[Bucket]);
+            }
+            Entry->SetNumberField(TEXT("count"), Counts[Bucket]);
+            Histogram.Add(MakeShared<FJsonValueObject>(Entry));
+        }
+        Report->SetArrayField(TEXT("histogram"), Histogram);
+        return Report;
+    }
+
+    /** Highest process physical memory above the level at Start, sampled from a thread until Stop */
+    class FPeakMemorySampler
+    {
+    public:
+        void Start()
+        {
+            FMemory::Trim();
+            Baseline = FPlatformMemory::GetStats().UsedPhysical;
+            Peak = Baseline;
+            bRunning = true;
+            Sampler = Async(EAsyncExecution::Thread, [this]()
+            {
+                while (bRunning)
+                {
+                    Peak = FMath::Max<uint64>(Peak, FPlatformMemory::GetStats().UsedPhysical);
+                    FPlatformProcess::SleepNoStats(0.0005f);
+                }
+            });
+        }
+
+        int64 Stop()
+        {
+            Peak = FMath::Max<uint64>(Peak, FPlatformMemory::GetStats().UsedPhysical);
+            bRunning = false;
+            Sampler.Wait();
+            return int64(Peak) - int64(Baseline);
+        }
+
+    private:
+        uint64 Baseline = 0;
+        std::atomic<uint64> Peak = 0;
+        std::atomic<bool> bRunning = false;
+        TFuture<void> Sampler;
+    };
+
+    /**
+     * -Decode: time and peak memory of DecodeTileImage at each scale on synthetic 4K and 8K
+     * sources (-DecodeSizes=4096,8192 -Iterations=5 [-PNG]), plus the scale each consumer picks.
+     */
+    int32 RunDecodeBenchmark(const FString& Params)
+    {
+        FString SizesParam = TEXT("4096,8192");
+        FParse::Value(*Params, TEXT("DecodeSizes="), SizesParam);
+        int32 Iterations = 5;
+        FParse::Value(*Params, TEXT("Iterations="), Iterations);
+        Iterations = FMath::Max(Iterations, 1);
+        const bool bPNG = FParse::Param(*Params, TEXT("PNG"));
+        const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizDecode")));
+
+        FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+        const int32 TextureSize = URoomVizTileSettings::Get()->MaxTileTextureSize;
+        const int32 ThumbnailSize = 128; // FTileThumbnailAtlas default
+
+        TArray<FString> SizeStrings;
+        SizesParam.ParseIntoArray(SizeStrings, TEXT(","));
+        TArray<TSharedPtr<FJsonValue>> Sources;
+        for (const FString& SizeString : SizeStrings)
+        {
+            const int32 Size = FCString::Atoi(*SizeString);
+            const TArray64<uint8> Encoded = FCatalogStandInServer::EncodeSyntheticTile(0, Size, bPNG);
+            if (Size <= 0 || Encoded.Num() == 0)
+            {
+                UE_LOG(LogRoomViz, Error, TEXT("Benchmark: could not encode a %s source"), *SizeString);
+                return 1;
+            }
+            const TConstArrayView<uint8> Bytes(Encoded.GetData(), IntCastChecked<int32>(Encoded.Num()));
+
+            // Smallest scale first, so a large decode's freed pages cannot hide a smaller one's peak
+            TArray<TSharedPtr<FJsonValue>> Scales;
+            for (int32 Denominator = 8; Denominator >= 1; Denominator /= 2)
+            {
+                const int32 MaxSize = Denominator == 1 ? 0 : Size / Denominator;
+                TArray<double> Times;
+                int64 PeakBytes = 0;
+                FDecodedTileImage Image;
+                for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+                {
+                    Image = FDecodedTileImage();
+                    FPeakMemorySampler Sampler;
+                    Sampler.Start();
+                    const double StartTime = FPlatformTime::Seconds();
+                    if (!DecodeTileImage(Bytes, ERGBFormat::BGRA, Image, MaxSize))
+                    {
+                        UE_LOG(LogRoomViz, Error, TEXT("Benchmark: decode of the %d source failed at 1/%d"), Size, Denominator);
+                        Sampler.Stop();
+                        return 1;
+                    }
+                    Times.Add(FPlatformTime::Seconds() - StartTime);
+                    PeakBytes = FMath::Max(PeakBytes, Sampler.Stop());
+                }
+                Times.Sort();
+
+                TSharedRef<FJsonObject> Scale = MakeShared<FJsonObject>();
+                Scale->SetNumberField(TEXT("denominator"), Image.ScaleDenominator);
+                Scale->SetNumberField(TEXT("width"), Image.Size.X);
+                Scale->SetNumberField(TEXT("height"), Image.Size.Y);
+                Scale->SetNumberField(TEXT("median_ms"), Times[Times.Num() / 2] * 1000.0);
+                Scale->SetNumberField(TEXT("min_ms"), Times[0] * 1000.0);
+                Scale->SetNumberField(TEXT("decoded_bytes"), Image.Pixels.Num());
+                Scale->SetNumberField(TEXT("peak_memory_bytes"), double(PeakBytes));
+                Scales.Add(MakeShared<FJsonValueObject>(Scale));
+
+                UE_LOG(LogRoomViz, Display, TEXT("Benchmark: %d source at 1/%d -> %dx%d in %.1f ms, peak +%.1f MB"),
+                    Size, Image.ScaleDenominator, Image.Size.X, Image.Size.Y, Times[Times.Num() / 2] * 1000.0, PeakBytes / (1024.0 * 1024.0));
+            }
+
+            TSharedRef<FJsonObject> Consumers = MakeShared<FJsonObject>();
+            Consumers->SetNumberField(TEXT("thumbnail"), ChooseDecodeScale(FIntPoint(Size), ThumbnailSize));
+            Consumers->SetNumberField(TEXT("texture"), ChooseDecodeScale(FIntPoint(Size), TextureSize));
+            Consumers->SetNumberField(TEXT("full"), 1);
+
+            TSharedRef<FJsonObject> Source = MakeShared<FJsonObject>();
+            Source->SetNumberField(TEXT("size"), Size);
+            Source->SetNumberField(TEXT("encoded_bytes"), double(Encoded.Num()));
+            Source->SetArrayField(TEXT("scales"), Scales);
+            Source->SetObjectField(TEXT("consumer_denominators"), Consumers);
+            Sources.Add(MakeShared<FJsonValueObject>(Source));
+        }
+
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("scaled_decode"));
+        Report->SetStringField(TEXT("format"), bPNG ? TEXT("png") : TEXT("jpeg"));
+        Report->SetBoolField(TEXT("dct_scaling"), ROOMVIZ_WITH_TURBOJPEG != 0 && !bPNG);
+        Report->SetNumberField(TEXT("iterations"), Iterations);
+        Report->SetNumberField(TEXT("max_tile_texture_size"), TextureSize);
+        Report->SetArrayField(TEXT("sources"), Sources);
+        return ReportOutput.Write(Report) ? 0 : 1;
+    }
+
+    /**
+     * Cost of the tile image analysis next to the decode it follows on the worker, both at the
+     * runtime decode size (MaxTileTextureSize). Fails with exit code 2 when the analysis median
+     * exceeds -MaxOverheadPercent of the decode median at any source size.
+     */
+    int32 RunAnalysisBenchmark(const FString& Params)
+    {
+        FString SizesParam = TEXT("1024,2048,4096");
+        FParse::Value(*Params, TEXT("AnalysisSizes="), SizesParam);
+        int32 Iterations = 20;
+        FParse::Value(*Params, TEXT("Iterations="), Iterations);
+        Iterations = FMath::Max(Iterations, 1);
+        double MaxOverheadPercent = 5.0;
+        FParse::Value(*Params, TEXT("MaxOverheadPercent="), MaxOverheadPercent);
+        const bool bPNG = FParse::Param(*Params, TEXT("PNG"));
+        const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizAnalysis")));
+
+        FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+        const int32 TextureSize = URoomVizTileSettings::Get()->MaxTileTextureSize;
+
+        TArray<FString> SizeStrings;
+        SizesParam.ParseIntoArray(SizeStrings, TEXT(","));
+        TArray<TSharedPtr<FJsonValue>> Sources;
+        bool bPassed = true;
+        for (const FString& SizeString : SizeStrings)
+        {
+            const int32 Size = FCString::Atoi(*SizeString);
+            const TArray64<uint8> Encoded = FCatalogStandInServer::EncodeSyntheticTile(0, Size, bPNG);
+            if (Size <= 0 || Encoded.Num() == 0)
+            {
+                UE_LOG(LogRoomViz, Error, TEXT("Benchmark: could not encode a %s source"), *SizeString);
+                return 1;
+            }
+            const TConstArrayView<uint8> Bytes(Encoded.GetData(), IntCastChecked<int32>(Encoded.Num()));
+
+            TArray<double> DecodeTimes;
+            TArray<double> AnalysisTimes;
+            FDecodedTileImage Image;
+            FTileImageAnalysis Analysis;
+            for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+            {
+                Image = FDecodedTileImage();
+                const double StartTime = FPlatformTime::Seconds();
+                if (!DecodeTileImage(Bytes, ERGBFormat::BGRA, Image, TextureSize))
+                {
+                    UE_LOG(LogRoomViz, Error, TEXT("Benchmark: decode of the %d source failed"), Size);
+                    return 1;
+                }
+                const double DecodedTime = FPlatformTime::Seconds();
+                if (!TileImageAnalysis::Analyze(Image, Analysis))
+                {
+                    UE_LOG(LogRoomViz, Error, TEXT("Benchmark: analysis of the %d source failed"), Size);
+                    return 1;
+                }
+                DecodeTimes.Add(DecodedTime - StartTime);
+                AnalysisTimes.Add(FPlatformTime::Seconds() - DecodedTime);
+            }
+            DecodeTimes.Sort();
+            AnalysisTimes.Sort();
+
+            const double DecodeMs = DecodeTimes[DecodeTimes.Num() / 2] * 1000.0;
+            const double AnalysisMs = AnalysisTimes[AnalysisTimes.Num() / 2] * 1000.0;
+            const double OverheadPercent = DecodeMs > 0.0 ? AnalysisMs / DecodeMs * 100.0 : 0.0;
+            bPassed &= OverheadPercent <= MaxOverheadPercent;
+
+            TSharedRef<FJsonObject> Source = MakeShared<FJsonObject>();
+            Source->SetNumberField(TEXT("size"), Size);
+            Source->SetNumberField(TEXT("width"), Image.Size.X);
+            Source->SetNumberField(TEXT("height"), Image.Size.Y);
+            Source->SetNumberField(TEXT("decode_median_ms"), DecodeMs);
+            Source->SetNumberField(TEXT("analysis_median_ms"), AnalysisMs);
+            Source->SetNumberField(TEXT("analysis_max_ms"), AnalysisTimes.Last() * 1000.0);
+            Source->SetNumberField(TEXT("overhead_percent"), OverheadPercent);
+            Source->SetObjectField(TEXT("analysis"), TileImageAnalysis::ToJson(Analysis));
+            Sources.Add(MakeShared<FJsonValueObject>(Source));
+
+            UE_LOG(LogRoomViz, Display, TEXT("Benchmark: %d source decoded to %dx%d in %.2f ms, analyzed in %.3f ms (+%.2f%%), average #%s"),
+                Size, Image.Size.X, Image.Size.Y, DecodeMs, AnalysisMs, OverheadPercent, *Analysis.AverageColor.ToHex().Left(6));
+        }
+
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("image_analysis"));
+        Report->SetStringField(TEXT("format"), bPNG ? TEXT("png") : TEXT("jpeg"));
+        Report->SetNumberField(TEXT("iterations"), Iterations);
+        Report->SetNumberField(TEXT("max_tile_texture_size"), TextureSize);
+        Report->SetNumberField(TEXT("max_overhead_percent"), MaxOverheadPercent);
+        Report->SetBoolField(TEXT("passed"), bPassed);
+        Report->SetArrayField(TEXT("sources"), Sources);
+        if (!ReportOutput.Write(Report))
+        {
+            return 1;
+        }
+        return bPassed ? 0 : 2;
+    }
+
+    UMaterialInterface* LoadBaseMaterial()
+    {
+        UMaterialInterface* BaseMaterial = LoadObject<UMaterialInterface>(nullptr, TEXT("/Game/assets/M_BaseMaterial.M_BaseMaterial"));
+        return BaseMaterial ? BaseMaterial : UMaterial::GetDefaultMaterial(MD_Surface);
+    }
+
+    /** Full collections, in seconds, sorted */
+    TArray<double> TimeCollections(int32 Iterations)
+    {
+        TArray<double> Times;
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+            Times.Add(FPlatformTime::Seconds() - StartTime);
+        }
+        Times.Sort();
+        return Times;
+    }
+
+    /**
+     * -GC: garbage collection pause with 100, 1k and 5k tiles loaded, their objects pooled and
+     * clustered as in the app and then unclustered for comparison (-GCTileCounts=100,1000,5000
+     * -Iterations=5). Each tile has base color, normal and ORM textures, its own material
+     * instance and a palette entry; textures are small, only the object count matters here.
+     */
+    int32 RunGCBenchmark(const FString& Params)
+    {
+        FString CountsParam = TEXT("100,1000,5000");
+        FParse::Value(*Params, TEXT("GCTileCounts="), CountsParam);
+        int32 Iterations = 5;
+        FParse::Value(*Params, TEXT("Iterations="), Iterations);
+        Iterations = FMath::Max(Iterations, 1);
+        const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizGC")));
+
+        IConsoleVariable* ClusterTiles = IConsoleManager::Get().FindConsoleVariable(TEXT("RoomViz.GC.ClusterTiles"));
+        const bool bClusterTilesWas = ClusterTiles->GetBool();
+
+        FRoomVizHeadlessSession Session;
+        UMaterialInterface* BaseMaterial = LoadBaseMaterial();
+
+        const TArray<double> EmptyTimes = TimeCollections(Iterations);
+        const int32 EmptyObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+        TArray<FString> CountStrings;
+        CountsParam.ParseIntoArray(CountStrings, TEXT(","));
+        TArray<TSharedPtr<FJsonValue>> Runs;
+        for (const FString& CountString : CountStrings)
+        {
+            const int32 TileCount = FCString::Atoi(*CountString);
+            if (TileCount <= 0)
+            {
+                continue;
+            }
+
+            for (const bool bCluster : { true, false })
+            {
+                ClusterTiles->Set(bCluster, ECVF_SetByCode);
+
+                AMaterialAPIManager* Manager = Session.GetWorld()->SpawnActor<AMaterialAPIManager>();
+                UTileObjectPool* TexturePool = Manager->GetTilePool();
+                for (int32 Index = 0; Index < TileCount; ++Index)
+                {
+                    FTileMaterialData& Tile = Manager->ParsedTiles.AddDefaulted_GetRef();
+                    Tile.ID = FString::Printf(TEXT("gc-%05d"), Index);
+                    for (UTexture2D** Field : { &Tile.DownloadedTexture, &Tile.NormalTexture, &Tile.ORMTexture })
+                    {
+                        *Field = TexturePool->CreateTexture(FIntPoint(16, 16), PF_B8G8R8A8);
+                        (*Field)->UpdateResource();
+                        TexturePool->AddRef(*Field);
+                    }
+                }
+                TexturePool->Trim();
+
+                TStrongObjectPtr<UUIUserWidget> Palette(CreateWidget<UUIUserWidget>(Session.GetGameInstance(), UUIUserWidget::StaticClass()));
+                if (!Palette)
+                {
+                    UE_LOG(LogRoomViz, Error, TEXT("Benchmark: could not create the palette widget"));
+                    ClusterTiles->Set(bClusterTilesWas, ECVF_SetByCode);
+                    return 1;
+                }
+                TArray<FFloorMaterialData> Materials;
+                UUIUserWidget::BuildFloorMaterials(Manager->ParsedTiles, BaseMaterial, Palette->GetMaterialPool(), Materials);
+                Palette->InitializeMaterials(Materials);
+
+                const int32 NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+                const TArray<double> Times = TimeCollections(Iterations);
+
+                TSharedRef<FJsonObject> Run = MakeShared<FJsonObject>();
+                Run->SetNumberField(TEXT("tiles"), TileCount);
+                Run->SetBoolField(TEXT("clustered"), TexturePool->IsClustered() && Palette->GetMaterialPool()->IsClustered());
+                Run->SetNumberField(TEXT("uobjects"), NumObjects);
+                Run->SetNumberField(TEXT("pooled_objects"), TexturePool->GetNumObjects() + Palette->GetMaterialPool()->GetNumObjects());
+                Run->SetNumberField(TEXT("median_ms"), Times[Times.Num() / 2] * 1000.0);
+                Run->SetNumberField(TEXT("min_ms"), Times[0] * 1000.0);
+                Run->SetNumberField(TEXT("max_ms"), Times.Last() * 1000.0);
+                Runs.Add(MakeShared<FJsonValueObject>(Run));
+
+                UE_LOG(LogRoomViz, Display, TEXT("Benchmark: %d tiles %s, %d UObjects, GC median %.2f ms, max %.2f ms"),
+                    TileCount, bCluster ? TEXT("clustered") : TEXT("unclustered"), NumObjects, Times[Times.Num() / 2] * 1000.0, Times.Last() * 1000.0);
+
+                // Torn down through the pools, the way a catalog reload lets go of its objects
+                Palette->ResetPalette(TSet<UTexture2D*>());
+                Palette->GetMaterialPool()->Trim();
+                for (FTileMaterialData& Tile : Manager->ParsedTiles)
+                {
+                    for (UTexture2D* Texture : { Tile.DownloadedTexture, Tile.NormalTexture, Tile.ORMTexture })
+                    {
+                        TexturePool->Release(Texture);
+                    }
+                }
+                Manager->ParsedTiles.Reset();
+                TexturePool->Trim();
+                Palette.Reset();
+                Manager->Destroy();
+                CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+            }
+        }
+        ClusterTiles->Set(bClusterTilesWas, ECVF_SetByCode);
+
+        TSharedRef<FJsonObject> Empty = MakeShared<FJsonObject>();
+        Empty->SetNumberField(TEXT("uobjects"), EmptyObjects);
+        Empty->SetNumberField(TEXT("median_ms"), EmptyTimes[EmptyTimes.Num() / 2] * 1000.0);
+        Empty->SetNumberField(TEXT("max_ms"), EmptyTimes.Last() * 1000.0);
+
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("gc_pause"));
+        Report->SetNumberField(TEXT("iterations"), Iterations);
+        Report->SetObjectField(TEXT("no_tiles"), Empty);
+        Report->SetArrayField(TEXT("runs"), Runs);
+        return ReportOutput.Write(Report) ? 0 : 1;
+    }
+
+    /**
+     * -Rooms: switch through every room variant in the settings, first cold (nothing preloaded;
+     * streaming pumped until the rooms left are out of the world, then garbage collected) and then
+     * with each room preloaded before its switch (-Passes=3 -Map=<persistent map>). Times are from
+     * the switch request until the room is shown.
+     */
+    int32 RunRoomsBenchmark(const FString& Params)
+    {
+        int32 Passes = 3;
+        FParse::Value(*Params, TEXT("Passes="), Passes);
+        Passes = FMath::Max(Passes, 1);
+        double TimeoutSeconds = 120.0;
+        FParse::Value(*Params, TEXT("Timeout="), TimeoutSeconds);
+        FString MapName;
+        FParse::Value(*Params, TEXT("Map="), MapName);
+        const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizRooms")));
+
+        const TArray<FRoomVariantConfig>& Variants = URoomVizTileSettings::Get()->RoomVariants;
+        if (Variants.Num() < 2)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: needs at least two RoomVariants in the settings"));
+            return 1;
+        }
+
+        FRoomVizHeadlessSession Session;
+        if (!MapName.IsEmpty() && !Session.LoadMap(MapName))
+        {
+            return 1;
+        }
+        Session.SetUpdateLevelStreaming(true);
+        URoomVariantSubsystem* Rooms = URoomVariantSubsystem::Get(Session.GetWorld());
+        if (!Rooms)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: no room variant subsystem in the headless world"));
+            return 1;
+        }
+
+        // A loaded map began play, which opens its first room; start timing once that is shown
+        if (!Session.PumpUntil([Rooms]() { return !Rooms->IsSwitching(); }, TimeoutSeconds))
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: the start room did not show"));
+            return 1;
+        }
+
+        IConsoleVariable* PreloadNext = IConsoleManager::Get().FindConsoleVariable(TEXT("RoomViz.Room.PreloadNext"));
+        const bool bPreloadNextWas = PreloadNext->GetBool();
+
+        TArray<TSharedPtr<FJsonValue>> Switches;
+        double TotalSeconds[2] = {};
+        int32 NumSwitches[2] = {};
+        for (const bool bPreload : { false, true })
+        {
+            PreloadNext->Set(bPreload, ECVF_SetByCode);
+            for (int32 Pass = 0; Pass < Passes; ++Pass)
+            {
+                for (const FRoomVariantConfig& Room : Variants)
+                {
+                    if (Room.Name == Rooms->GetCurrentRoom())
+                    {
+                        continue;
+                    }
+                    if (bPreload)
+                    {
+                        // Normally already under way from the previous switch's prediction
+                        Rooms->PreloadRoom(Room.Name);
+                        if (!Session.PumpUntil([Rooms, &Room]() { return Rooms->IsRoomLoaded(Room.Name); }, TimeoutSeconds))
+                        {
+                            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: timed out preloading %s"), *Room.Name.ToString());
+                            PreloadNext->Set(bPreloadNextWas, ECVF_SetByCode);
+                            return 1;
+                        }
+                    }
+                    else
+                    {
+                        // Nothing of the room left in memory from an earlier visit: its level out
+                        // of the world first, else the collection finds it still referenced
+                        if (!Session.PumpUntil([Rooms]() { return Rooms->GetNumRoomsUnloading() == 0; }, TimeoutSeconds))
+                        {
+                            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: rooms still unloading after %.0f s"), TimeoutSeconds);
+                            PreloadNext->Set(bPreloadNextWas, ECVF_SetByCode);
+                            return 1;
+                        }
+                        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+                    }
+
+                    const int32 NumTimings = Rooms->GetSwitchTimings().Num();
+                    if (!Rooms->SwitchToRoom(Room.Name)
+                        || !Session.PumpUntil([Rooms, NumTimings]() { return Rooms->GetSwitchTimings().Num() > NumTimings; }, TimeoutSeconds))
+                    {
+                        UE_LOG(LogRoomViz, Error, TEXT("Benchmark: could not switch to %s"), *Room.Name.ToString());
+                        PreloadNext->Set(bPreloadNextWas, ECVF_SetByCode);
+                        return 1;
+                    }
+
+                    const URoomVariantSubsystem::FSwitchTiming& Timing = Rooms->GetSwitchTimings().Last();
+                    TotalSeconds[Timing.bPreloaded] += Timing.Seconds;
+                    ++NumSwitches[Timing.bPreloaded];
+
+                    TSharedRef<FJsonObject> Switch = MakeShared<FJsonObject>();
+                    Switch->SetStringField(TEXT("room"), Timing.Room.ToString());
+                    Switch->SetBoolField(TEXT("preloaded"), Timing.bPreloaded);
+                    Switch->SetNumberField(TEXT("ms"), Timing.Seconds * 1000.0);
+                    Switches.Add(MakeShared<FJsonValueObject>(Switch));
+                }
+            }
+        }
+        PreloadNext->Set(bPreloadNextWas, ECVF_SetByCode);
+        Rooms->LogReport();
+
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("room_switch"));
+        Report->SetStringField(TEXT("map"), MapName);
+        Report->SetNumberField(TEXT("cold_switches"), NumSwitches[0]);
+        Report->SetNumberField(TEXT("cold_avg_ms"), NumSwitches[0] > 0 ? TotalSeconds[0] / NumSwitches[0] * 1000.0 : 0.0);
+        Report->SetNumberField(TEXT("preloaded_switches"), NumSwitches[1]);
+        Report->SetNumberField(TEXT("preloaded_avg_ms"), NumSwitches[1] > 0 ? TotalSeconds[1] / NumSwitches[1] * 1000.0 : 0.0);
+        Report->SetArrayField(TEXT("switches"), Switches);
+        return ReportOutput.Write(Report) ? 0 : 1;
+    }
+
+    /** A synthetic load for FAdaptiveQualityPolicy: the full-quality frame cost over time, and when the customer interacts */
+    struct FQualityScenario
+    {
+        const TCHAR* Name;
+        float Seconds;
+        TFunction<float(float Time, FRandomStream& Noise)> CostAtFullQuality;
+        TFunction<bool(float Time)> Interacting;
+        /** Expectations checked on top of the general ones */
+        bool bMayDrop;
+        bool bMustEndWithinTarget;
+    };
+
+    /**
+     * -Quality: drive FAdaptiveQualityPolicy with synthetic frame-time traces, closed loop (each
+     * rung makes frames about 15% cheaper), and check its decisions: never raising quality while
+     * the customer interacts, at most three changes in any ten seconds, no drop for lone hitches,
+     * and reaching the target under steady overload. Fails with exit code 2 otherwise.
+     */
+    int32 RunQualityBenchmark(const FString& Params)
+    {
+        const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizQuality")));
+
+        const URoomVizTileSettings* Settings = URoomVizTileSettings::Get();
+        FAdaptiveQualityPolicy::FConfig Config;
+        Config.TargetFrameMs = Settings->TargetFrameMs;
+        Config.NumLevels = FMath::Max(Settings->QualityLadder.Num() + 1, 2);
+        const float Target = Config.TargetFrameMs;
+
+        const TArray<FQualityScenario> Scenarios = {
+            { TEXT("steady_overload"), 60.f,
+                [Target](float, FRandomStream& Noise) { return Target * 1.4f * Noise.FRandRange(0.95f, 1.05f); },
+                [](float) { return false; }, true, true },
+            { TEXT("drag_burst"), 60.f,
+                [Target](float Time, FRandomStream& Noise) { return Target * (Time >= 10.f && Time < 20.f ? 1.3f : 0.6f) * Noise.FRandRange(0.95f, 1.05f); },
+                [](float Time) { return Time >= 10.f && Time < 20.f; }, true, true },
+            { TEXT("hitches"), 60.f,
+                [Target](float Time, FRandomStream& Noise) { return FMath::Fmod(Time, 5.f) < 0.05f ? Target * 6.f : Target * 0.7f; },
+                [](float) { return false; }, false, true },
+            { TEXT("noisy_edge"), 180.f,
+                [Target](float, FRandomStream& Noise) { return Target * 1.05f * Noise.FRandRange(0.7f, 1.3f); },
+                [](float Time) { return FMath::Fmod(Time, 20.f) < 5.f; }, true, false },
+        };
+
+        TArray<TSharedPtr<FJsonValue>> Runs;
+        bool bPassed = true;
+        for (const FQualityScenario& Scenario : Scenarios)
+        {
+            FAdaptiveQualityPolicy Policy(Config);
+            FRandomStream Noise(1234);
+            TArray<float> ChangeTimes;
+            int32 RaisesWhileInteracting = 0;
+            int32 MaxChangesIn10s = 0;
+            float SecondsOverTarget = 0.f;
+            float LastCostMs = 0.f;
+
+            for (float Time = 0.f; Time < Scenario.Seconds;)
+            {
+                const int32 Level = Policy.GetLevel();
+                const float CostMs = Scenario.CostAtFullQuality(Time, Noise) * FMath::Pow(0.85f, float(Level));
+                // Vsync at 60 Hz: a frame never takes less than 16.7 ms of wall time
+                const float DeltaSeconds = FMath::Max(CostMs, 1000.f / 60.f) / 1000.f;
+
+                FAdaptiveQualitySample Sample;
+                Sample.DeltaSeconds = DeltaSeconds;
+                Sample.FrameMs = CostMs * 0.6f;
+                Sample.GPUMs = CostMs;
+                Sample.bInteracting = Scenario.Interacting(Time);
+                const int32 NewLevel = Policy.Update(Sample);
+
+                if (NewLevel != Level)
+                {
+                    RaisesWhileInteracting += NewLevel < Level && Sample.bInteracting ? 1 : 0;
+                    ChangeTimes.Add(Time);
+                    const int32 Recent = Algo::CountIf(ChangeTimes, [Time](float ChangeTime) { return Time - ChangeTime < 10.f; });
+                    MaxChangesIn10s = FMath::Max(MaxChangesIn10s, Recent);
+                }
+                SecondsOverTarget += CostMs > Target ? DeltaSeconds : 0.f;
+                LastCostMs = CostMs;
+                Time += DeltaSeconds;
+            }
+
+            TArray<FString> Failures;
+            if (RaisesWhileInteracting > 0)
+            {
+                Failures.Add(TEXT("raised quality while interacting"));
+            }
+            if (MaxChangesIn10s > 3)
+            {
+                Failures.Add(FString::Printf(TEXT("%d changes within 10 s"), MaxChangesIn10s));
+            }
+            if (!Scenario.bMayDrop && Policy.GetNumDrops() > 0)
+            {
+                Failures.Add(TEXT("dropped quality for lone hitches"));
+            }
+            if (Scenario.bMustEndWithinTarget && LastCostMs > Target * Config.DownRatio)
+            {
+                Failures.Add(FString::Printf(TEXT("ended at %.1f ms"), LastCostMs));
+            }
+            bPassed &= Failures.Num() == 0;
+
+            TSharedRef<FJsonObject> Run = MakeShared<FJsonObject>();
+            Run->SetStringField(TEXT("scenario"), Scenario.Name);
+            Run->SetNumberField(TEXT("seconds"), Scenario.Seconds);
+            Run->SetNumberField(TEXT("final_level"), Policy.GetLevel());
+            Run->SetNumberField(TEXT("final_ms"), LastCostMs);
+            Run->SetNumberField(TEXT("drops"), Policy.GetNumDrops());
+            Run->SetNumberField(TEXT("raises"), Policy.GetNumRaises());
+            Run->SetNumberField(TEXT("raises_undone"), Policy.GetNumFailedRaises());
+            Run->SetNumberField(TEXT("max_changes_in_10s"), MaxChangesIn10s);
+            Run->SetNumberField(TEXT("seconds_over_target"), SecondsOverTarget);
+            TArray<TSharedPtr<FJsonValue>> FailureValues;
+            for (const FString& Failure : Failures)
+            {
+                FailureValues.Add(MakeShared<FJsonValueString>(Failure));
+            }
+            Run->SetArrayField(TEXT("failures"), FailureValues);
+            Runs.Add(MakeShared<FJsonValueObject>(Run));
+
+            UE_LOG(LogRoomViz, Display, TEXT("Benchmark: %s: level %d, %d drops, %d raises (%d undone), %.1f s over target%s%s"),
+                Scenario.Name, Policy.GetLevel(), Policy.GetNumDrops(), Policy.GetNumRaises(), Policy.GetNumFailedRaises(), SecondsOverTarget,
+                Failures.Num() > 0 ? TEXT(" FAILED: ") : TEXT(""), *FString::Join(Failures, TEXT(", ")));
+        }
+
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("adaptive_quality"));
+        Report->SetNumberField(TEXT("target_ms"), Target);
+        Report->SetNumberField(TEXT("levels"), Config.NumLevels);
+        Report->SetBoolField(TEXT("passed"), bPassed);
+        Report->SetArrayField(TEXT("scenarios"), Runs);
+        if (!ReportOutput.Write(Report))
+        {
+            return 1;
+        }
+        return bPassed ? 0 : 2;
+    }
+
+    /**
+     * -BoxSelect: time FFloorBoxSelection updates over a grid of -Floors floors with pillars
+     * standing on some of them, while a marquee grows across a 1080p view and then slides back.
+     * Runs with the projection on workers and on the game thread. Fails with exit code 2 when the
+     * parallel run's 95th percentile exceeds -BudgetMs, a quarter of a 60 Hz frame by default.
+     */
+    int32 RunBoxSelectBenchmark(const FString& Params)
+    {
+        int32 NumFloors = 4000;
+        FParse::Value(*Params, TEXT("Floors="), NumFloors);
+        int32 NumFrames = 300;
+        FParse::Value(*Params, TEXT("Frames="), NumFrames);
+        double BudgetMs = 4.0;
+        FParse::Value(*Params, TEXT("BudgetMs="), BudgetMs);
+        const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizBoxSelect")));
+
+        FRoomVizHeadlessSession Session;
+        UWorld* World = Session.GetWorld();
+        UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+        if (!World || !Cube)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: no world or cube mesh for the box select run"));
+            return 1;
+        }
+
+        // Floors of 2 m, a 3 m pillar on every seventh one to give the occlusion traces something to find
+        constexpr float CellSize = 200.f;
+        const int32 GridSize = FMath::Max(FMath::CeilToInt32(FMath::Sqrt(float(NumFloors))), 1);
+        const float Extent = GridSize * CellSize * 0.5f;
+        for (int32 Index = 0; Index < NumFloors; ++Index)
+        {
+            const FVector Location(-Extent + (Index % GridSize + 0.5f) * CellSize, -Extent + (Index / GridSize + 0.5f) * CellSize, 0.0);
+            AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(Location, FRotator::ZeroRotator);
+            Floor->SetMobility(EComponentMobility::Movable);
+            Floor->GetStaticMeshComponent()->SetStaticMesh(Cube);
+            Floor->SetActorScale3D(FVector(CellSize / 100.f, CellSize / 100.f, 0.1f));
+            Floor->Tags.Add(TEXT("floor"));
+
+            if (Index % 7 == 0)
+            {
+                AStaticMeshActor* Pillar = World->SpawnActor<AStaticMeshActor>(Location + FVector(0.0, 0.0, 150.0), FRotator::ZeroRotator);
+                Pillar->SetMobility(EComponentMobility::Movable);
+                Pillar->GetStaticMeshComponent()->SetStaticMesh(Cube);
+                Pillar->SetActorScale3D(FVector(0.5f, 0.5f, 3.f));
+            }
+        }
+        Session.Pump(0.f);
+
+        const FIntPoint ViewSize(1920, 1080);
+        const FFloorSelectionView View = FFloorSelectionView::MakePerspective(
+            FVector(-Extent * 1.2, 0.0, Extent * 1.1), FRotator(-45.f, 0.f, 0.f), 90.f, ViewSize);
+        const FVector2D Corner(ViewSize.X * 0.05, ViewSize.Y * 0.05);
+
+        IConsoleVariable* ParallelVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("RoomViz.BoxSelect.Parallel"));
+        const bool bSavedParallel = ParallelVariable && ParallelVariable->GetBool();
+
+        TArray<TSharedPtr<FJsonValue>> Runs;
+        double ParallelP95Ms = 0.0;
+        for (const bool bParallel : { true, false })
+        {
+            if (ParallelVariable)
+            {
+                ParallelVariable->Set(bParallel, ECVF_SetByCode);
+            }
+
+            FFloorBoxSelection Selection;
+            Selection.Begin(World, nullptr);
+            TArray<double> UpdateTimes;
+            int32 MaxSelected = 0;
+            int32 TotalTraces = 0;
+            int32 TotalDeferred = 0;
+            for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+            {
+                // Grow to 90% of the view over the first half, then slide the whole marquee back to the corner
+                const float Alpha = float(Frame) / FMath::Max(NumFrames - 1, 1);
+                const FVector2D FarCorner = FVector2D(ViewSize) * 0.95;
+                const FVector2D Start = Alpha < 0.5f ? Corner : FMath::Lerp(Corner, FarCorner * 0.5, (Alpha - 0.5f) * 2.f);
+                const FVector2D End = Alpha < 0.5f ? FMath::Lerp(Corner, FarCorner, Alpha * 2.f) : FMath::Lerp(FarCorner, FarCorner * 0.5 + Corner, (Alpha - 0.5f) * 2.f);
+
+                const double StartTime = FPlatformTime::Seconds();
+                Selection.Update(View, FBox2D(Start, End));
+                UpdateTimes.Add(FPlatformTime::Seconds() - StartTime);
+
+                MaxSelected = FMath::Max(MaxSelected, Selection.Num());
+                TotalTraces += Selection.GetLastNumTraces();
+                TotalDeferred += Selection.GetLastNumDeferred();
+            }
+            Selection.Clear();
+
+            TSharedRef<FJsonObject> Run = MakeFrameTimeReport(UpdateTimes);
+            Run->SetBoolField(TEXT("parallel"), bParallel);
+            Run->SetNumberField(TEXT("max_selected"), MaxSelected);
+            Run->SetNumberField(TEXT("traces"), TotalTraces);
+            Run->SetNumberField(TEXT("deferred"), TotalDeferred);
+            Runs.Add(MakeShared<FJsonValueObject>(Run));
+
+            const double P95Ms = Run->GetNumberField(TEXT("p95_ms"));
+            ParallelP95Ms = bParallel ? P95Ms : ParallelP95Ms;
+            UE_LOG(LogRoomViz, Display, TEXT("Benchmark: box select over %d floors, %s: p50 %.2f ms, p95 %.2f ms, max %.2f ms; up to %d selected, %d traces, %d deferred"),
+                NumFloors, bParallel ? TEXT("parallel") : TEXT("game thread"), Run->GetNumberField(TEXT("p50_ms")), P95Ms,
+                Run->GetNumberField(TEXT("max_ms")), MaxSelected, TotalTraces, TotalDeferred);
+        }
+
+        if (ParallelVariable)
+        {
+            ParallelVariable->Set(bSavedParallel, ECVF_SetByCode);
+        }
+
+        const bool bPassed = ParallelP95Ms <= BudgetMs;
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("box_select"));
+        Report->SetNumberField(TEXT("floors"), NumFloors);
+        Report->SetNumberField(TEXT("frames"), NumFrames);
+        Report->SetNumberField(TEXT("budget_ms"), BudgetMs);
+        Report->SetBoolField(TEXT("passed"), bPassed);
+        Report->SetArrayField(TEXT("runs"), Runs);
+        if (!ReportOutput.Write(Report))
+        {
+            return 1;
+        }
+        return bPassed ? 0 : 2;
+    }
+    /**
+     * -NavPath: load the living-room map, build its navmesh and check that the player start
+     * reaches -Goals random points on it. Then drag a click-to-move goal across the room for
+     * -Frames frames on a possessed character and check what UClickToMoveComponent promises:
+     * at most one path query per frame and per MinRepathInterval, none left in flight, and a
+     * per-frame navigation cost in the second half of the drag no worse than in the first.
+     * Fails with exit code 2 otherwise.
+     */
+    int32 RunNavPathBenchmark(const FString& Params)
+    {
+        FString MapName = TEXT("/Game/ModernLivingRoom/Maps/Main");
+        FParse::Value(*Params, TEXT("Map="), MapName);
+        int32 NumGoals = 20;
+        FParse::Value(*Params, TEXT("Goals="), NumGoals);
+        int32 NumFrames = 600;
+        FParse::Value(*Params, TEXT("Frames="), NumFrames);
+        NumFrames = FMath::Max(NumFrames, 2);
+        float Radius = 1500.f;
+        FParse::Value(*Params, TEXT("Radius="), Radius);
+        float DragSpeed = 600.f;
+        FParse::Value(*Params, TEXT("DragSpeed="), DragSpeed);
+        const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizNavPath")));
+
+        FRoomVizHeadlessSession Session;
+        if (!Session.LoadMap(MapName))
+        {
+            return 1;
+        }
+        UWorld* World = Session.GetWorld();
+        UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+        if (!NavSys)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: %s has no navigation system"), *MapName);
+            return 1;
+        }
+
+        // Blocking; rebuilds from the level geometry where the navmesh allows runtime generation
+        const double BuildStartTime = FPlatformTime::Seconds();
+        NavSys->Build();
+        const double BuildSeconds = FPlatformTime::Seconds() - BuildStartTime;
+
+        FVector StartLocation = FVector::ZeroVector;
+        if (TActorIterator<APlayerStart> It(World); It)
+        {
+            StartLocation = It->GetActorLocation();
+        }
+        FNavLocation Start;
+        ANavigationData* NavData = NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate);
+        if (!NavData || !NavSys->ProjectPointToNavigation(StartLocation, Start, FVector(100.0, 100.0, 300.0)))
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: no navmesh under the player start of %s"), *MapName);
+            return 1;
+        }
+
+        // ── Paths from the player start ──
+        FMath::RandInit(0x5eed);
+        TArray<FVector> Waypoints = { Start.Location };
+        int32 NumPathsFound = 0;
+        double TotalPathLength = 0.0;
+        for (int32 Goal = 0; Goal < NumGoals; ++Goal)
+        {
+            FNavLocation Point;
+            if (!NavSys->GetRandomReachablePointInRadius(Start.Location, Radius, Point, NavData))
+            {
+                continue;
+            }
+            const FPathFindingResult Result = NavSys->FindPathSync(FPathFindingQuery(nullptr, *NavData, Start.Location, Point.Location));
+            if (Result.IsSuccessful() && !Result.IsPartial())
+            {
+                ++NumPathsFound;
+                TotalPathLength += Result.Path->GetLength();
+                Waypoints.Add(Point.Location);
+            }
+            else
+            {
+                UE_LOG(LogRoomViz, Warning, TEXT("Benchmark: no full path from %s to %s"), *Start.Location.ToString(), *Point.Location.ToString());
+            }
+        }
+
+        // ── A drag across those points, one goal a frame ──
+        ACharacter* Pawn = World->SpawnActor<ACharacter>(Start.Location + FVector(0.0, 0.0, 100.0), FRotator::ZeroRotator);
+        AAIController* Controller = World->SpawnActor<AAIController>();
+        if (!Pawn || !Controller || Waypoints.Num() < 2)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: could not set up the click-to-move pawn"));
+            return 1;
+        }
+        Controller->Possess(Pawn);
+        UClickToMoveComponent* ClickToMove = NewObject<UClickToMoveComponent>(Pawn);
+        ClickToMove->RegisterComponent();
+
+        constexpr float FrameDelta = 1.f / 60.f;
+        TArray<double> NavTimes[2];
+        int32 MaxQueriesPerFrame = 0;
+        int32 Segment = 0;
+        float SegmentAlpha = 0.f;
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+        {
+            const FVector& From = Waypoints[Segment % Waypoints.Num()];
+            const FVector& To = Waypoints[(Segment + 1) % Waypoints.Num()];
+            SegmentAlpha += DragSpeed * FrameDelta / FMath::Max(FVector::Dist(From, To), 1.0);
+            if (SegmentAlpha >= 1.f)
+            {
+                SegmentAlpha = 0.f;
+                ++Segment;
+            }
+
+            // Like the cursor trace landing on the floor, then the frame's navigation work
+            const int32 QueriesBefore = ClickToMove->GetNumPathQueries();
+            const double StartTime = FPlatformTime::Seconds();
+            ClickToMove->RequestMoveTo(FMath::Lerp(From, To, SegmentAlpha));
+            World->Tick(LEVELTICK_All, FrameDelta);
+            NavTimes[Frame * 2 / NumFrames].Add(FPlatformTime::Seconds() - StartTime);
+            Session.Pump(0.f);
+            MaxQueriesPerFrame = FMath::Max(MaxQueriesPerFrame, ClickToMove->GetNumPathQueries() - QueriesBefore);
+        }
+        const bool bSettled = Session.PumpUntil([World, ClickToMove]()
+        {
+            World->Tick(LEVELTICK_All, FrameDelta);
+            return !ClickToMove->IsQueryInFlight();
+        }, 5.0);
+
+        const int32 MaxQueries = FMath::CeilToInt32(NumFrames * FrameDelta / FMath::Max(ClickToMove->MinRepathInterval, FrameDelta)) + 1;
+        const TSharedRef<FJsonObject> FirstHalf = MakeFrameTimeReport(NavTimes[0]);
+        const TSharedRef<FJsonObject> SecondHalf = MakeFrameTimeReport(NavTimes[1]);
+        const bool bFlat = SecondHalf->GetNumberField(TEXT("p95_ms")) <= FirstHalf->GetNumberField(TEXT("p95_ms")) * 1.5 + 0.25;
+
+        TArray<FString> Violations;
+        if (NumPathsFound == 0 || NumPathsFound < NumGoals / 2)
+        {
+            Violations.Add(FString::Printf(TEXT("only %d of %d goals reachable"), NumPathsFound, NumGoals));
+        }
+        if (MaxQueriesPerFrame > 1 || ClickToMove->GetNumPathQueries() > MaxQueries)
+        {
+            Violations.Add(FString::Printf(TEXT("%d path queries, up to %d a frame; expected at most %d, one a frame"),
+                ClickToMove->GetNumPathQueries(), MaxQueriesPerFrame, MaxQueries));
+        }
+        if (!bSettled)
+        {
+            Violations.Add(TEXT("a path query never completed"));
+        }
+        if (!bFlat)
+        {
+            Violations.Add(TEXT("navigation cost grew during the drag"));
+        }
+        for (const FString& Violation : Violations)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: nav path: %s"), *Violation);
+        }
+
+        UE_LOG(LogRoomViz, Display, TEXT("Benchmark: navmesh built in %.1f ms, %d/%d paths; drag: %d requests, %d queries, %d reuses, nav p95 %.2f -> %.2f ms"),
+            BuildSeconds * 1000.0, NumPathsFound, NumGoals, ClickToMove->GetNumMoveRequests(), ClickToMove->GetNumPathQueries(),
+            ClickToMove->GetNumPathReuses(), FirstHalf->GetNumberField(TEXT("p95_ms")), SecondHalf->GetNumberField(TEXT("p95_ms")));
+
+        TArray<TSharedPtr<FJsonValue>> ViolationValues;
+        for (const FString& Violation : Violations)
+        {
+            ViolationValues.Add(MakeShared<FJsonValueString>(Violation));
+        }
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("nav_path"));
+        Report->SetStringField(TEXT("map"), MapName);
+        Report->SetNumberField(TEXT("build_ms"), BuildSeconds * 1000.0);
+        Report->SetNumberField(TEXT("goals"), NumGoals);
+        Report->SetNumberField(TEXT("paths_found"), NumPathsFound);
+        Report->SetNumberField(TEXT("avg_path_length"), NumPathsFound > 0 ? TotalPathLength / NumPathsFound : 0.0);
+        Report->SetNumberField(TEXT("move_requests"), ClickToMove->GetNumMoveRequests());
+        Report->SetNumberField(TEXT("path_queries"), ClickToMove->GetNumPathQueries());
+        Report->SetNumberField(TEXT("path_reuses"), ClickToMove->GetNumPathReuses());
+        Report->SetNumberField(TEXT("max_path_queries"), MaxQueries);
+        Report->SetObjectField(TEXT("nav_frame_time_first_half"), FirstHalf);
+        Report->SetObjectField(TEXT("nav_frame_time_second_half"), SecondHalf);
+        Report->SetArrayField(TEXT("violations"), ViolationValues);
+        Report->SetBoolField(TEXT("passed"), Violations.Num() == 0);
+        if (!ReportOutput.Write(Report))
+        {
+            return 1;
+        }
+        return Violations.Num() == 0 ? 0 : 2;
+    }
+}
+
+URoomVizBenchmarkCommandlet::URoomVizBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 URoomVizBenchmarkCommandlet::Main(const FString& Params)
+{
+    using namespace RoomVizBenchmark;
+
+    if (FParse::Param(*Params, TEXT("Decode")))
+    {
+        return RunDecodeBenchmark(Params);
+    }
+    if (FParse::Param(*Params, TEXT("Analysis")))
+    {
+        return RunAnalysisBenchmark(Params);
+    }
+    if (FParse::Param(*Params, TEXT("GC")))
+    {
+        return RunGCBenchmark(Params);
+    }
+    if (FParse::Param(*Params, TEXT("Rooms")))
+    {
+        return RunRoomsBenchmark(Params);
+    }
+    if (FParse::Param(*Params, TEXT("Quality")))
+    {
+        return RunQualityBenchmark(Params);
+    }
+    if (FParse::Param(*Params, TEXT("BoxSelect")))
+    {
+        return RunBoxSelectBenchmark(Params);
+    }
+    if (FParse::Param(*Params, TEXT("NavPath")))
+    {
+        return RunNavPathBenchmark(Params);
+    }
+
+    FCatalogStandInConfig ServerConfig;
+    ServerConfig.ParseCommandLine(*Params);
+
+    double TimeoutSeconds = 600.0;
+    FParse::Value(*Params, TEXT("Timeout="), TimeoutSeconds);
+    const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizBenchmark")));
+    FString SourceType = TEXT("http");
+    FParse::Value(*Params, TEXT("Source="), SourceType);
+    FString PakPath;
+    FParse::Value(*Params, TEXT("PakPath="), PakPath);
+    double GameThreadLoadMs = 0.0;
+    FParse::Value(*Params, TEXT("GameThreadLoadMs="), GameThreadLoadMs);
+    // The stand-in answers from the game thread's ticker, so loaded runs are best pointed at a server elsewhere
+    FString ExternalCatalogURL;
+    FParse::Value(*Params, TEXT("CatalogURL="), ExternalCatalogURL);
+
+    FCatalogStandInServer Server(ServerConfig);
+    if ((ExternalCatalogURL.IsEmpty() || SourceType != TEXT("http")) && !Server.Start())
+    {
+        return 1;
+    }
+
+    FRoomVizHeadlessSession Session;
+    AMaterialAPIManager* Manager = Session.GetWorld()->SpawnActor<AMaterialAPIManager>();
+    Session.AddTickedActor(Manager);
+
+    // Same tiles from each kind of source, so runs differ only in how the bytes arrive
+    if (SourceType == TEXT("local"))
+    {
+        const FString Dir = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("StandInTiles");
+        if (!Server.WriteToDirectory(Dir))
+        {
+            return 1;
+        }
+        Manager->SetCatalogSources({ MakeShared<FLocalDirectoryTileCatalogSource>(Dir, 0, !FParse::Param(*Params, TEXT("NoMemoryMap"))) });
+    }
+    else if (SourceType == TEXT("pak"))
+    {
+        if (PakPath.IsEmpty())
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: -Source=pak needs -PakPath=<bundle.pak>"));
+            return 1;
+        }
+        Manager->SetCatalogSources({ MakeShared<FPakBundleTileCatalogSource>(PakPath, 0) });
+    }
+    else if (SourceType == TEXT("pack"))
+    {
+        // Cooked textures from a pack built by -run=RoomVizTilePack; the stand-in only serves the other modes
+        FString PackName;
+        if (!FParse::Value(*Params, TEXT("Pack="), PackName))
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Benchmark: -Source=pack needs -Pack=<Name>"));
+            return 1;
+        }
+        Manager->SetCatalogSources({ MakeShared<FTilePackCatalogSource>(FName(*PackName), 0) });
+    }
+    else
+    {
+        SourceType = TEXT("http");
+        Manager->CatalogURL = ExternalCatalogURL.IsEmpty() ? Server.GetCatalogURL() : ExternalCatalogURL;
+    }
+
+    // ── Catalog load ──
+    const double StartTime = FPlatformTime::Seconds();
+    double FirstTileSeconds = -1.0;
+    double CompleteSeconds = -1.0;
+    Manager->OnTileTextureReady.AddLambda([&](const FTileMaterialData&)
+    {
+        if (FirstTileSeconds < 0.0)
+        {
+            FirstTileSeconds = FPlatformTime::Seconds() - StartTime;
+        }
+    });
+    Manager->OnCatalogComplete.AddLambda([&](const TArray<FTileMaterialData>&)
+    {
+        CompleteSeconds = FPlatformTime::Seconds() - StartTime;
+    });
+
+    // Simulated heavy frames; transfers complete off the game thread, so throughput should hold
+    FTSTicker::FDelegateHandle LoadHandle;
+    if (GameThreadLoadMs > 0.0)
+    {
+        LoadHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([GameThreadLoadMs](float)
+        {
+            const double EndTime = FPlatformTime::Seconds() + GameThreadLoadMs / 1000.0;
+            while (FPlatformTime::Seconds() < EndTime)
+            {
+            }
+            return true;
+        }));
+    }
+
+    Manager->FetchTileMaterials();
+    const bool bCompleted = Session.PumpUntil([&CompleteSeconds]() { return CompleteSeconds >= 0.0; }, TimeoutSeconds);
+    FTSTicker::GetCoreTicker().RemoveTicker(LoadHandle);
+    const TArray<double> LoadFrameTimes = Session.GetFrameTimes();
+
+    int32 TexturedTiles = 0;
+    for (const FTileMaterialData& Tile : Manager->ParsedTiles)
+    {
+        TexturedTiles += Tile.DownloadedTexture ? 1 : 0;
+    }
+
+    // ── Palette build: material instances plus the widget entries ──
+    double PaletteSeconds = -1.0;
+    if (bCompleted)
+    {
+        UMaterialInterface* BaseMaterial = LoadBaseMaterial();
+        UUIUserWidget* Palette = CreateWidget<UUIUserWidget>(Session.GetGameInstance(), UUIUserWidget::StaticClass());
+        if (Palette)
+        {
+            const double PaletteStart = FPlatformTime::Seconds();
+            TArray<FFloorMaterialData> Materials;
+            UUIUserWidget::BuildFloorMaterials(Manager->ParsedTiles, BaseMaterial, Palette->GetMaterialPool(), Materials);
+            Palette->InitializeMaterials(Materials);
+            PaletteSeconds = FPlatformTime::Seconds() - PaletteStart;
+        }
+    }
+
+    // ── Report ──
+    TSharedRef<FJsonObject> Config = MakeShared<FJsonObject>();
+    Config->SetStringField(TEXT("source"), SourceType);
+    Config->SetNumberField(TEXT("tile_count"), ServerConfig.TileCount);
+    Config->SetNumberField(TEXT("tile_size"), ServerConfig.TileSize);
+    Config->SetStringField(TEXT("format"), ServerConfig.bPNG ? TEXT("png") : TEXT("jpeg"));
+    Config->SetNumberField(TEXT("latency_ms"), ServerConfig.LatencyMs);
+    Config->SetNumberField(TEXT("bandwidth_mbps"), ServerConfig.BandwidthMBps);
+    Config->SetNumberField(TEXT("game_thread_load_ms"), GameThreadLoadMs);
+
+    TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("catalog_load"));
+    Report->SetObjectField(TEXT("config"), Config);
+    Report->SetBoolField(TEXT("completed"), bCompleted);
+    Report->SetNumberField(TEXT("tiles_textured"), TexturedTiles);
+    Report->SetNumberField(TEXT("served_bytes"), double(Server.GetServedBytes()));
+    Report->SetNumberField(TEXT("time_to_first_tile_ms"), FirstTileSeconds >= 0.0 ? FirstTileSeconds * 1000.0 : -1.0);
+    Report->SetNumberField(TEXT("time_to_catalog_complete_ms"), CompleteSeconds >= 0.0 ? CompleteSeconds * 1000.0 : -1.0);
+    Report->SetNumberField(TEXT("palette_build_ms"), PaletteSeconds >= 0.0 ? PaletteSeconds * 1000.0 : -1.0);
+    Report->SetNumberField(TEXT("tiles_per_second"), CompleteSeconds > 0.0 ? TexturedTiles / CompleteSeconds : 0.0);
+    Report->SetNumberField(TEXT("peak_used_physical_bytes"), double(Session.GetPeakUsedPhysical()));
+    Report->SetNumberField(TEXT("process_peak_used_physical_bytes"), double(FPlatformMemory::GetStats().PeakUsedPhysical));
+    Report->SetObjectField(TEXT("game_thread_frame_time"), MakeFrameTimeReport(LoadFrameTimes));
+
+    UE_LOG(LogRoomViz, Display, TEXT("Benchmark: %d/%d tiles, first tile %.1f ms, complete %.1f ms, palette %.1f ms"),
+        TexturedTiles, Manager->ParsedTiles.Num(), FirstTileSeconds * 1000.0, CompleteSeconds * 1000.0, PaletteSeconds * 1000.0);
+
+    Manager->OnTileTextureReady.Clear();
+    Manager->OnCatalogComplete.Clear();
+    Server.Stop();
+    const bool bWritten = ReportOutput.Write(Report);
+    return bCompleted && bWritten ? 0 : 1;
+}
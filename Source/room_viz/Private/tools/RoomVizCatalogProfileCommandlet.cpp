@@ -0,0 +1,567 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/RoomVizCatalogProfileCommandlet.h"
+#include "tools/CatalogStandInServer.h"
+#include "tools/RoomVizHeadlessSession.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "dataclass/TileCatalogSources.h"
+#include "dataclass/TileImageAnalysis.h"
+#include "dataclass/TilePBRPacking.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "room_viz.h"
+
+namespace RoomVizCatalogProfile
+{
+    struct FBudgets
+    {
+        int64 MaxSourceBytes = 8ll << 20;
+        int32 MaxDimension = 4096;
+        double MaxDecodeMs = 200.0;
+        int64 MaxRuntimeBytes = 32ll << 20;
+    };
+
+    /** One catalog entry, filled in by the fetch callbacks and then by its decode worker */
+    struct FTileProfile
+    {
+        FString ID;
+        bool bFetched = false;
+        bool bDecoded = false;
+        int32 NumImages = 0;
+        int64 SourceBytes = 0;
+        /** Base color as encoded, and the largest of all the tile's maps */
+        FIntPoint SourceSize = FIntPoint::ZeroValue;
+        FIntPoint LargestMapSize = FIntPoint::ZeroValue;
+        /** Base color as uploaded */
+        FIntPoint RuntimeSize = FIntPoint::ZeroValue;
+        double FetchMs = 0.0;
+        double DecodeMs = 0.0;
+        double PBRMs = 0.0;
+        /** BGRA8 without mips, as AMaterialAPIManager creates them */
+        int64 RuntimeBytes = 0;
+        /** The same maps with a full mip chain and BC1/BC5 compression */
+        int64 CookedBytesEstimate = 0;
+        /** Base color analysis, for -PopulateCache */
+        FTileImageAnalysis Analysis;
+        TArray<FString> Violations;
+    };
+
+    /** Fetched maps of a tile waiting for the last one */
+    struct FPendingTile
+    {
+        FTileImagePayloadPtr BaseColor;
+        FTilePBRSources PBR;
+        int32 Outstanding = 0;
+        bool bFailed = false;
+        double StartTime = 0.0;
+    };
+
+    /** Shared with the fetch and decode callbacks, which may outlive Main on timeout */
+    struct FProfileState
+    {
+        FCriticalSection Lock;
+        TArray<FTileProfile> Profiles;
+        TArray<FPendingTile> Pending;
+        TArray<int32> ReadyToDecode;
+        int32 NumFetching = 0;
+        int32 NumDecoding = 0;
+        int32 NumDone = 0;
+    };
+
+    /** Dimensions from the image header, without decoding; zero if the bytes are not an image */
+    FIntPoint ReadImageSize(TConstArrayView<uint8> Bytes)
+    {
+        IImageWrapperModule& IWM = FModuleManager::GetModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+        const EImageFormat Format = IWM.DetectImageFormat(Bytes.GetData(), Bytes.Num());
+        TSharedPtr<IImageWrapper> IW = Format != EImageFormat::Invalid ? IWM.CreateImageWrapper(Format) : nullptr;
+        return IW.IsValid() && IW->SetCompressed(Bytes.GetData(), Bytes.Num()) ? FIntPoint(int32(IW->GetWidth()), int32(IW->GetHeight())) : FIntPoint::ZeroValue;
+    }
+
+    /** Bytes per pixel of the platform-compressed formats the texture settings pick on desktop */
+    constexpr double BC1BytesPerPixel = 0.5; // TC_Default without alpha, TC_Masks
+    constexpr double BC5BytesPerPixel = 1.0; // TC_Normalmap
+
+    /** A full mip chain adds a third */
+    int64 EstimateCookedBytes(FIntPoint Size, double BytesPerPixel)
+    {
+        return int64(double(Size.X) * Size.Y * BytesPerPixel * 4.0 / 3.0);
+    }
+
+    /** Decode and pack one tile like AMaterialAPIManager does, and measure it; runs on a worker */
+    void ProfileTile(const FPendingTile& Tile, int32 MaxTextureSize, const FBudgets& Budgets, FTileProfile& Out)
+    {
+        const FTileImagePayloadPtr Maps[] = { Tile.BaseColor, Tile.PBR.Normal, Tile.PBR.AO, Tile.PBR.Roughness, Tile.PBR.Metallic };
+        for (const FTileImagePayloadPtr& Map : Maps)
+        {
+            if (!Map.IsValid())
+            {
+                continue;
+            }
+            const FIntPoint Size = ReadImageSize(Map->GetBytes());
+            ++Out.NumImages;
+            Out.SourceBytes += Map->GetBytes().Num();
+            if (Size.X * int64(Size.Y) > Out.LargestMapSize.X * int64(Out.LargestMapSize.Y))
+            {
+                Out.LargestMapSize = Size;
+            }
+            if (Map == Tile.BaseColor)
+            {
+                Out.SourceSize = Size;
+            }
+        }
+
+        FDecodedTileImage Image;
+        double StartTime = FPlatformTime::Seconds();
+        Out.bDecoded = DecodeTileImage(Tile.BaseColor->GetBytes(), ERGBFormat::BGRA, Image, MaxTextureSize);
+        Out.DecodeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+        Out.RuntimeSize = Image.Size;
+        Out.RuntimeBytes = Image.Pixels.Num();
+        Out.CookedBytesEstimate = EstimateCookedBytes(Image.Size, BC1BytesPerPixel);
+        TileImageAnalysis::Analyze(Image, Out.Analysis);
+
+        FTilePBRTexels Texels;
+        StartTime = FPlatformTime::Seconds();
+        TilePBRPacking::DecodeAndPack(Tile.PBR, Texels, MaxTextureSize);
+        Out.PBRMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+        Out.RuntimeBytes += Texels.Normal.Num() + Texels.ORM.Num();
+        Out.CookedBytesEstimate += EstimateCookedBytes(Texels.NormalSize, BC5BytesPerPixel) + EstimateCookedBytes(Texels.ORMSize, BC1BytesPerPixel);
+
+        if (!Out.bDecoded)
+        {
+            Out.Violations.Add(TEXT("decode failed"));
+        }
+        if (Out.SourceBytes > Budgets.MaxSourceBytes)
+        {
+            Out.Violations.Add(FString::Printf(TEXT("source %.1f MB"), Out.SourceBytes / (1024.0 * 1024.0)));
+        }
+        if (FMath::Max(Out.LargestMapSize.X, Out.LargestMapSize.Y) > Budgets.MaxDimension)
+        {
+            Out.Violations.Add(FString::Printf(TEXT("map %dx%d"), Out.LargestMapSize.X, Out.LargestMapSize.Y));
+        }
+        if (Out.DecodeMs + Out.PBRMs > Budgets.MaxDecodeMs)
+        {
+            Out.Violations.Add(FString::Printf(TEXT("decode %.0f ms"), Out.DecodeMs + Out.PBRMs));
+        }
+        if (Out.RuntimeBytes > Budgets.MaxRuntimeBytes)
+        {
+            Out.Violations.Add(FString::Printf(TEXT("runtime %.1f MB"), Out.RuntimeBytes / (1024.0 * 1024.0)));
+        }
+    }
+
+    FString EscapeCsv(const FString& Value)
+    {
+        if (!Value.Contains(TEXT(",")) && !Value.Contains(TEXT("\"")) && !Value.Contains(TEXT("\n")))
+        {
+            return Value;
+        }
+        return TEXT("\"") + Value.Replace(TEXT("\""), TEXT("\"\"")) + TEXT("\"");
+    }
+
+    FString MakeCsv(const TArray<FTileProfile>& Profiles)
+    {
+        FString Csv = TEXT("id,fetched,decoded,images,source_bytes,source_width,source_height,largest_map_width,largest_map_height,")
+            TEXT("runtime_width,runtime_height,fetch_ms,decode_ms,pbr_ms,runtime_bytes,cooked_bytes_estimate,violations\n");
+        for (const FTileProfile& Profile : Profiles)
+        {
+            Csv += FString::Printf(TEXT("%s,%d,%d,%d,%lld,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.2f,%lld,%lld,%s\n"),
+                *EscapeCsv(Profile.ID), Profile.bFetched, Profile.bDecoded, Profile.NumImages, Profile.SourceBytes,
+                Profile.SourceSize.X, Profile.SourceSize.Y, Profile.LargestMapSize.X, Profile.LargestMapSize.Y,
+                Profile.RuntimeSize.X, Profile.RuntimeSize.Y, Profile.FetchMs, Profile.DecodeMs, Profile.PBRMs,
+                Profile.RuntimeBytes, Profile.CookedBytesEstimate, *EscapeCsv(FString::Join(Profile.Violations, TEXT("; "))));
+        }
+        return Csv;
+    }
+
+    TSharedRef<FJsonObject> MakeTileJson(const FTileProfile& Profile)
+    {
+        TSharedRef<FJsonObject> Tile = MakeShared<FJsonObject>();
+        Tile->SetStringField(TEXT("id"), Profile.ID);
+        Tile->SetBoolField(TEXT("fetched"), Profile.bFetched);
+        Tile->SetBoolField(TEXT("decoded"), Profile.bDecoded);
+        Tile->SetNumberField(TEXT("images"), Profile.NumImages);
+        Tile->SetNumberField(TEXT("source_bytes"), double(Profile.SourceBytes));
+        Tile->SetNumberField(TEXT("source_width"), Profile.SourceSize.X);
+        Tile->SetNumberField(TEXT("source_height"), Profile.SourceSize.Y);
+        Tile->SetNumberField(TEXT("largest_map_width"), Profile.LargestMapSize.X);
+        Tile->SetNumberField(TEXT("largest_map_height"), Profile.LargestMapSize.Y);
+        Tile->SetNumberField(TEXT("runtime_width"), Profile.RuntimeSize.X);
+        Tile->SetNumberField(TEXT("runtime_height"), Profile.RuntimeSize.Y);
+        Tile->SetNumberField(TEXT("fetch_ms"), Profile.FetchMs);
+        Tile->SetNumberField(TEXT("decode_ms"), Profile.DecodeMs);
+        Tile->SetNumberField(TEXT("pbr_ms"), Profile.PBRMs);
+        Tile->SetNumberField(TEXT("runtime_bytes"), double(Profile.RuntimeBytes));
+        Tile->SetNumberField(TEXT("cooked_bytes_estimate"), double(Profile.CookedBytesEstimate));
+        TArray<TSharedPtr<FJsonValue>> Violations;
+        for (const FString& Violation : Profile.Violations)
+        {
+            Violations.Add(MakeShared<FJsonValueString>(Violation));
+        }
+        Tile->SetArrayField(TEXT("violations"), Violations);
+        return Tile;
+    }
+
+    double Percentile(TArray<double> Values, double Fraction)
+    {
+        if (Values.Num() == 0)
+        {
+            return 0.0;
+        }
+        Values.Sort();
+        return Values[FMath::Clamp(FMath::FloorToInt32(Fraction * Values.Num()), 0, Values.Num() - 1)];
+    }
+}
+
+URoomVizCatalogProfileCommandlet::URoomVizCatalogProfileCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 URoomVizCatalogProfileCommandlet::Main(const FString& Params)
+{
+    using namespace RoomVizCatalogProfile;
+
+    const URoomVizTileSettings* Settings = URoomVizTileSettings::Get();
+    int32 MaxTiles = MAX_int32;
+    FParse::Value(*Params, TEXT("MaxTiles="), MaxTiles);
+    int32 NumWorkers = FTaskGraphInterface::Get().GetNumBackgroundThreads();
+    FParse::Value(*Params, TEXT("Workers="), NumWorkers);
+    NumWorkers = FMath::Max(NumWorkers, 1);
+    int32 MaxDownloads = 16;
+    FParse::Value(*Params, TEXT("MaxDownloads="), MaxDownloads);
+    MaxDownloads = FMath::Max(MaxDownloads, 1);
+    double TimeoutSeconds = 1800.0;
+    FParse::Value(*Params, TEXT("Timeout="), TimeoutSeconds);
+
+    FBudgets Budgets;
+    double MaxSourceMB = 8.0;
+    FParse::Value(*Params, TEXT("MaxSourceMB="), MaxSourceMB);
+    Budgets.MaxSourceBytes = int64(MaxSourceMB * 1024.0 * 1024.0);
+    FParse::Value(*Params, TEXT("MaxDimension="), Budgets.MaxDimension);
+    FParse::Value(*Params, TEXT("MaxDecodeMs="), Budgets.MaxDecodeMs);
+    double MaxRuntimeMB = 32.0;
+    FParse::Value(*Params, TEXT("MaxRuntimeMB="), MaxRuntimeMB);
+    Budgets.MaxRuntimeBytes = int64(MaxRuntimeMB * 1024.0 * 1024.0);
+
+    const bool bPopulateCache = FParse::Param(*Params, TEXT("PopulateCache"));
+    FString CacheDir = FHttpTileCatalogSource::GetDefaultDiskCacheDir();
+    FParse::Value(*Params, TEXT("CacheDir="), CacheDir);
+
+    const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("CatalogProfile")));
+
+    // ── Source ──
+    TUniquePtr<FCatalogStandInServer> StandIn;
+    TSharedPtr<ITileCatalogSource> Source;
+    TSharedPtr<FHttpTileCatalogSource> HttpSource;
+    FString Location;
+    if (FParse::Param(*Params, TEXT("StandIn")))
+    {
+        FCatalogStandInConfig StandInConfig;
+        StandInConfig.ParseCommandLine(*Params);
+        StandIn = MakeUnique<FCatalogStandInServer>(StandInConfig);
+        if (!StandIn->Start())
+        {
+            return 1;
+        }
+        Source = HttpSource = MakeShared<FHttpTileCatalogSource>(StandIn->GetCatalogURL(), 0);
+    }
+    else if (FParse::Value(*Params, TEXT("Catalog="), Location))
+    {
+        Source = HttpSource = MakeShared<FHttpTileCatalogSource>(Location, 0);
+    }
+    else if (FParse::Value(*Params, TEXT("Dir="), Location))
+    {
+        Source = MakeShared<FLocalDirectoryTileCatalogSource>(Location, 0, Settings->bMemoryMapLocalFiles);
+    }
+    else
+    {
+        const FTileCatalogSourceConfig* Best = nullptr;
+        for (const FTileCatalogSourceConfig& Config : Settings->CatalogSources)
+        {
+            if (Config.bEnabled && !Config.Location.IsEmpty() && Config.Type != ETileCatalogSourceType::TilePack
+                && (!Best || Config.Priority > Best->Priority))
+            {
+                Best = &Config;
+            }
+        }
+        if (Best)
+        {
+            Source = Settings->CreateCatalogSource(*Best);
+            if (Best->Type == ETileCatalogSourceType::Http)
+            {
+                HttpSource = StaticCastSharedPtr<FHttpTileCatalogSource>(Source);
+            }
+        }
+    }
+    if (!Source.IsValid())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Catalog profile: no catalog source"));
+        return 1;
+    }
+    // HTTP images are really downloaded, never read from the cache; -PopulateCache only writes it
+    if (HttpSource.IsValid())
+    {
+        HttpSource->SetDiskCache(bPopulateCache ? CacheDir : FString(), /*bRead*/ false, /*bWrite*/ true, Settings->GetMaxHttpImageCacheBytes());
+    }
+    else if (bPopulateCache)
+    {
+        UE_LOG(LogRoomViz, Warning, TEXT("Catalog profile: -PopulateCache only applies to HTTP catalogs"));
+    }
+
+    FRoomVizHeadlessSession Session;
+    FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+    // ── Catalog ──
+    const double CatalogStartTime = FPlatformTime::Seconds();
+    TSharedRef<TOptional<TArray<FTileMaterialData>>> Catalog = MakeShared<TOptional<TArray<FTileMaterialData>>>();
+    TSharedRef<bool> bCatalogDone = MakeShared<bool>(false);
+    Source->FetchCatalog([Catalog, bCatalogDone](bool bSuccess, TArray<FTileMaterialData>&& Tiles)
+    {
+        if (bSuccess)
+        {
+            Catalog->Emplace(MoveTemp(Tiles));
+        }
+        *bCatalogDone = true;
+    });
+    if (!Session.PumpUntil([bCatalogDone]() { return *bCatalogDone; }, TimeoutSeconds) || !Catalog->IsSet())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Catalog profile: catalog of %s could not be fetched"), *Source->GetSourceName().ToString());
+        return 1;
+    }
+    const double CatalogMs = (FPlatformTime::Seconds() - CatalogStartTime) * 1000.0;
+
+    TArray<FTileMaterialData> Tiles = MoveTemp(Catalog->GetValue());
+    if (Tiles.Num() > MaxTiles)
+    {
+        Tiles.SetNum(MaxTiles);
+    }
+
+    // ── Tiles ──
+    // Up to MaxDownloads tiles are fetched at once; fetched tiles queue for one of NumWorkers decode slots
+    TSharedRef<FProfileState> State = MakeShared<FProfileState>();
+    State->Profiles.SetNum(Tiles.Num());
+    State->Pending.SetNum(Tiles.Num());
+    const int32 MaxTextureSize = Settings->MaxTileTextureSize;
+    int32 NextToFetch = 0;
+
+    // The app only fetches PBR maps with bTilePBRMaps, so they only count then
+    if (!Settings->bTilePBRMaps)
+    {
+        for (FTileMaterialData& Tile : Tiles)
+        {
+            Tile.ClearPBRMaps();
+        }
+    }
+
+    auto FetchTile = [&Source, &Tiles, State](int32 Index)
+    {
+        const FTileMaterialData& Tile = Tiles[Index];
+        TArray<TPair<FString, FTileImagePayloadPtr*>> Maps;
+        {
+            FScopeLock Lock(&State->Lock);
+            FPendingTile& Pending = State->Pending[Index];
+            State->Profiles[Index].ID = Tile.ID;
+            Pending.StartTime = FPlatformTime::Seconds();
+            Maps.Emplace(Tile.BaseColorURL, &Pending.BaseColor);
+            if (!Tile.NormalURL.IsEmpty()) Maps.Emplace(Tile.NormalURL, &Pending.PBR.Normal);
+            if (!Tile.AOURL.IsEmpty()) Maps.Emplace(Tile.AOURL, &Pending.PBR.AO);
+            if (!Tile.RoughnessURL.IsEmpty()) Maps.Emplace(Tile.RoughnessURL, &Pending.PBR.Roughness);
+            if (!Tile.MetallicURL.IsEmpty()) Maps.Emplace(Tile.MetallicURL, &Pending.PBR.Metallic);
+            Pending.Outstanding = Maps.Num();
+            ++State->NumFetching;
+        }
+
+        for (const TPair<FString, FTileImagePayloadPtr*>& Map : Maps)
+        {
+            Source->FetchImage(Map.Key, [State, Index, Slot = Map.Value](bool bSuccess, FTileImagePayloadPtr Payload)
+            {
+                FScopeLock Lock(&State->Lock);
+                FPendingTile& Pending = State->Pending[Index];
+                *Slot = bSuccess ? Payload : nullptr;
+                Pending.bFailed |= !bSuccess || !Payload.IsValid();
+                if (--Pending.Outstanding > 0)
+                {
+                    return;
+                }
+
+                --State->NumFetching;
+                FTileProfile& Profile = State->Profiles[Index];
+                Profile.FetchMs = (FPlatformTime::Seconds() - Pending.StartTime) * 1000.0;
+                Profile.bFetched = !Pending.bFailed;
+                if (Pending.bFailed)
+                {
+                    Profile.Violations.Add(TEXT("fetch failed"));
+                    Pending = FPendingTile();
+                    ++State->NumDone;
+                    return;
+                }
+                State->ReadyToDecode.Add(Index);
+            });
+        }
+    };
+
+    // Dispatches more work on every frame and tells the pump when every tile has been profiled
+    auto Dispatch = [&]()
+    {
+        TArray<int32> ToFetch;
+        TArray<int32> ToDecode;
+        {
+            FScopeLock Lock(&State->Lock);
+            for (int32 NumFetching = State->NumFetching; NumFetching < MaxDownloads && NextToFetch < Tiles.Num(); ++NumFetching)
+            {
+                ToFetch.Add(NextToFetch++);
+            }
+            while (State->NumDecoding < NumWorkers && State->ReadyToDecode.Num() > 0)
+            {
+                ToDecode.Add(State->ReadyToDecode[0]);
+                State->ReadyToDecode.RemoveAt(0);
+                ++State->NumDecoding;
+            }
+            if (State->NumDone == Tiles.Num())
+            {
+                return true;
+            }
+        }
+
+        for (int32 Index : ToFetch)
+        {
+            FetchTile(Index);
+        }
+        for (int32 Index : ToDecode)
+        {
+            AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [State, Index, MaxTextureSize, Budgets]()
+            {
+                FPendingTile Tile;
+                FTileProfile Profile;
+                {
+                    FScopeLock Lock(&State->Lock);
+                    Tile = MoveTemp(State->Pending[Index]);
+                    Profile.ID = State->Profiles[Index].ID;
+                    Profile.bFetched = true;
+                    Profile.FetchMs = State->Profiles[Index].FetchMs;
+                }
+
+                ProfileTile(Tile, MaxTextureSize, Budgets, Profile);
+
+                FScopeLock Lock(&State->Lock);
+                State->Profiles[Index] = MoveTemp(Profile);
+                --State->NumDecoding;
+                ++State->NumDone;
+            });
+        }
+        return false;
+    };
+
+    const double StartTime = FPlatformTime::Seconds();
+    const bool bCompleted = Session.PumpUntil(Dispatch, TimeoutSeconds, 1.f / 240.f);
+    const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+    if (!bCompleted)
+    {
+        FScopeLock Lock(&State->Lock);
+        UE_LOG(LogRoomViz, Error, TEXT("Catalog profile: timed out with %d of %d tiles profiled"), State->NumDone, Tiles.Num());
+        return 1;
+    }
+    if (bPopulateCache && !Session.PumpUntil([]() { return FHttpTileCatalogSource::GetNumPendingDiskCacheWrites() == 0; }, TimeoutSeconds))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Catalog profile: timed out writing the disk cache"));
+        return 1;
+    }
+    if (bPopulateCache && HttpSource.IsValid())
+    {
+        // Merged into what the folder has, so palettes start with placeholders too
+        const FString AnalysisPath = TileImageAnalysis::GetCachePath(CacheDir);
+        TMap<FString, FTileImageAnalysis> Analyses;
+        TileImageAnalysis::LoadCache(AnalysisPath, Analyses);
+        for (int32 Index = 0; Index < Tiles.Num(); ++Index)
+        {
+            if (State->Profiles[Index].Analysis.IsValid())
+            {
+                Analyses.Add(Tiles[Index].BaseColorURL, State->Profiles[Index].Analysis);
+            }
+        }
+        if (!TileImageAnalysis::SaveCache(AnalysisPath, Analyses))
+        {
+            return 1;
+        }
+    }
+
+    // ── Report ──
+    const TArray<FTileProfile>& Profiles = State->Profiles;
+    TArray<TSharedPtr<FJsonValue>> TileValues;
+    TArray<double> DecodeTimes;
+    int64 TotalSourceBytes = 0;
+    int64 TotalRuntimeBytes = 0;
+    int64 TotalCookedBytes = 0;
+    int32 NumFailed = 0;
+    int32 NumOverBudget = 0;
+    for (const FTileProfile& Profile : Profiles)
+    {
+        TileValues.Add(MakeShared<FJsonValueObject>(MakeTileJson(Profile)));
+        TotalSourceBytes += Profile.SourceBytes;
+        TotalRuntimeBytes += Profile.RuntimeBytes;
+        TotalCookedBytes += Profile.CookedBytesEstimate;
+        NumFailed += Profile.bFetched && Profile.bDecoded ? 0 : 1;
+        NumOverBudget += Profile.Violations.Num() > 0 ? 1 : 0;
+        if (Profile.bDecoded)
+        {
+            DecodeTimes.Add(Profile.DecodeMs + Profile.PBRMs);
+        }
+        if (Profile.Violations.Num() > 0)
+        {
+            UE_LOG(LogRoomViz, Warning, TEXT("Catalog profile: tile %s: %s"), *Profile.ID, *FString::Join(Profile.Violations, TEXT(", ")));
+        }
+    }
+
+    TSharedRef<FJsonObject> BudgetJson = MakeShared<FJsonObject>();
+    BudgetJson->SetNumberField(TEXT("max_source_bytes"), double(Budgets.MaxSourceBytes));
+    BudgetJson->SetNumberField(TEXT("max_dimension"), Budgets.MaxDimension);
+    BudgetJson->SetNumberField(TEXT("max_decode_ms"), Budgets.MaxDecodeMs);
+    BudgetJson->SetNumberField(TEXT("max_runtime_bytes"), double(Budgets.MaxRuntimeBytes));
+
+    TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("catalog_profile"));
+    Report->SetStringField(TEXT("source"), Source->GetSourceName().ToString());
+    Report->SetNumberField(TEXT("tiles"), Profiles.Num());
+    Report->SetNumberField(TEXT("failed"), NumFailed);
+    Report->SetNumberField(TEXT("over_budget"), NumOverBudget);
+    Report->SetNumberField(TEXT("workers"), NumWorkers);
+    Report->SetNumberField(TEXT("max_downloads"), MaxDownloads);
+    Report->SetNumberField(TEXT("max_tile_texture_size"), MaxTextureSize);
+    Report->SetNumberField(TEXT("catalog_ms"), CatalogMs);
+    Report->SetNumberField(TEXT("elapsed_seconds"), ElapsedSeconds);
+    Report->SetNumberField(TEXT("source_bytes"), double(TotalSourceBytes));
+    Report->SetNumberField(TEXT("runtime_bytes"), double(TotalRuntimeBytes));
+    Report->SetNumberField(TEXT("cooked_bytes_estimate"), double(TotalCookedBytes));
+    Report->SetNumberField(TEXT("decode_ms_p50"), Percentile(DecodeTimes, 0.5));
+    Report->SetNumberField(TEXT("decode_ms_p95"), Percentile(DecodeTimes, 0.95));
+    Report->SetNumberField(TEXT("decode_ms_max"), Percentile(DecodeTimes, 1.0));
+    Report->SetBoolField(TEXT("populated_cache"), bPopulateCache && HttpSource.IsValid());
+    Report->SetObjectField(TEXT("budgets"), BudgetJson);
+    Report->SetArrayField(TEXT("tile_profiles"), TileValues);
+
+    if (!ReportOutput.Write(Report))
+    {
+        return 1;
+    }
+    const FString CsvPath = FPaths::ChangeExtension(ReportOutput.OutputPath, TEXT("csv"));
+    if (!FFileHelper::SaveStringToFile(MakeCsv(Profiles), *CsvPath))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Catalog profile: could not write %s"), *CsvPath);
+        return 1;
+    }
+
+    UE_LOG(LogRoomViz, Display, TEXT("Catalog profile of %s: %d tiles in %.1f s, %d failed, %d over budget; %.1f MB encoded, %.1f MB at runtime (%.1f MB cooked)"),
+        *Source->GetSourceName().ToString(), Profiles.Num(), ElapsedSeconds, NumFailed, NumOverBudget,
+        TotalSourceBytes / (1024.0 * 1024.0), TotalRuntimeBytes / (1024.0 * 1024.0), TotalCookedBytes / (1024.0 * 1024.0));
+    UE_LOG(LogRoomViz, Display, TEXT("Catalog profile: CSV written to %s"), *CsvPath);
+    return NumOverBudget > 0 ? 2 : 0;
+}
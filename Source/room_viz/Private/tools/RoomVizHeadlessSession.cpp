@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/RoomVizHeadlessSession.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Containers/Ticker.h"
+#include "HttpModule.h"
+#include "HttpManager.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+#include "RoomVizMetrics.h"
+#include "room_viz.h"
+
+FRoomVizHeadlessSession::FRoomVizHeadlessSession()
+{
+    GameInstance.Reset(NewObject<UGameInstance>(GEngine));
+    GameInstance->InitializeStandalone();
+
+    // Commandlets run before the engine-init hook that starts it in games
+    RoomVizMetrics::StartEndpointIfConfigured();
+}
+
+FRoomVizHeadlessSession::~FRoomVizHeadlessSession()
+{
+    UWorld* World = GetWorld();
+    GameInstance->Shutdown();
+
+    if (World)
+    {
+        World->DestroyWorld(false);
+        GEngine->DestroyWorldContext(World);
+    }
+    GameInstance.Reset();
+}
+
+UWorld* FRoomVizHeadlessSession::GetWorld() const
+{
+    return GameInstance.IsValid() ? GameInstance->GetWorld() : nullptr;
+}
+
+bool FRoomVizHeadlessSession::LoadMap(const FString& MapName)
+{
+    FWorldContext* Context = GameInstance->GetWorldContext();
+    FString Error;
+    if (!Context || !GEngine->LoadMap(*Context, FURL(nullptr, *MapName, TRAVEL_Absolute), nullptr, Error))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Headless session: cannot load %s: %s"), *MapName, *Error);
+        return false;
+    }
+    return true;
+}
+
+void FRoomVizHeadlessSession::AddTickedActor(AActor* Actor)
+{
+    TickedActors.AddUnique(Actor);
+}
+
+double FRoomVizHeadlessSession::Pump(float DeltaTime)
+{
+    const double StartTime = FPlatformTime::Seconds();
+
+    FTSTicker::GetCoreTicker().Tick(DeltaTime);
+    FHttpModule::Get().GetHttpManager().Tick(DeltaTime);
+    FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+
+    if (bUpdateLevelStreaming)
+    {
+        // What the world tick would do: a slice of async loading, then add/remove streamed levels
+        ProcessAsyncLoading(true, false, 0.005f);
+        if (UWorld* World = GetWorld())
+        {
+            World->UpdateLevelStreaming();
+        }
+    }
+
+    for (int32 Index = TickedActors.Num() - 1; Index >= 0; --Index)
+    {
+        if (AActor* Actor = TickedActors[Index].Get())
+        {
+            Actor->Tick(DeltaTime);
+        }
+        else
+        {
+            TickedActors.RemoveAtSwap(Index);
+        }
+    }
+    ++GFrameCounter;
+
+    const double WorkTime = FPlatformTime::Seconds() - StartTime;
+    FrameTimes.Add(WorkTime);
+    PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+    if (WorkTime < DeltaTime)
+    {
+        FPlatformProcess::SleepNoStats(float(DeltaTime - WorkTime));
+    }
+    return WorkTime;
+}
+
+bool FRoomVizHeadlessSession::PumpUntil(TFunctionRef<bool()> Predicate, double TimeoutSeconds, float FrameDelta)
+{
+    const double EndTime = FPlatformTime::Seconds() + TimeoutSeconds;
+    while (!Predicate())
+    {
+        if (FPlatformTime::Seconds() > EndTime)
+        {
+            return false;
+        }
+        Pump(FrameDelta);
+    }
+    return true;
+}
+
+FRoomVizReportOutput::FRoomVizReportOutput(const TCHAR* Params, const FString& DefaultName)
+    : OutputPath(FPaths::ProjectSavedDir() / TEXT("Benchmarks") / DefaultName)
+{
+    FParse::Value(Params, TEXT("Label="), Label);
+    FParse::Value(Params, TEXT("Output="), OutputPath);
+}
+
+FString FRoomVizReportOutput::MakeTimestampedName(const TCHAR* Prefix)
+{
+    return FString::Printf(TEXT("%s-%s.json"), Prefix, *FDateTime::Now().ToString());
+}
+
+TSharedRef<FJsonObject> FRoomVizReportOutput::MakeReport(const TCHAR* Benchmark) const
+{
+    TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+    Report->SetStringField(TEXT("benchmark"), Benchmark);
+    Report->SetStringField(TEXT("label"), Label);
+    Report->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+    Report->SetStringField(TEXT("build_config"), LexToString(FApp::GetBuildConfiguration()));
+    return Report;
+}
+
+bool FRoomVizReportOutput::Write(const TSharedRef<FJsonObject>& Report, const FString& Path)
+{
+    FString Json;
+    FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&Json));
+    if (!FFileHelper::SaveStringToFile(Json, *Path))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Could not write report %s"), *Path);
+        return false;
+    }
+    UE_LOG(LogRoomViz, Display, TEXT("Report written to %s"), *Path);
+    return true;
+}
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/RoomVizInputRecording.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "JsonObjectConverter.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "room_viz.h"
+
+bool FRoomVizInputRecording::SaveToFile(const FString& Path) const
+{
+    FString Json;
+    if (!FJsonObjectConverter::UStructToJsonObjectString(*this, Json))
+    {
+        return false;
+    }
+    return FFileHelper::SaveStringToFile(Json, *Path);
+}
+
+bool FRoomVizInputRecording::LoadFromFile(const FString& Path)
+{
+    FString Json;
+    if (!FFileHelper::LoadFileToString(Json, *Path))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Input recording: cannot read %s"), *Path);
+        return false;
+    }
+    if (!FJsonObjectConverter::JsonObjectStringToUStruct(Json, this))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Input recording: %s is not a recording"), *Path);
+        return false;
+    }
+    return true;
+}
+
+namespace RoomVizInputRecorder
+{
+    namespace
+    {
+        struct FActiveRecording
+        {
+            FRoomVizInputRecording Recording;
+            TWeakObjectPtr<UWorld> World;
+            double StartTime = 0.0;
+            int32 LastCameraEvent = INDEX_NONE;
+            FTSTicker::FDelegateHandle TickHandle;
+        };
+
+        TUniquePtr<FActiveRecording> GActive;
+
+        /** Camera and pawn moves, one event per frame they changed in */
+        bool SampleCamera(float)
+        {
+            UWorld* World = GActive->World.Get();
+            APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+            if (!PC || !PC->PlayerCameraManager)
+            {
+                return true;
+            }
+
+            FRoomVizInputEvent Event;
+            Event.Type = ERoomVizInputEventType::Camera;
+            Event.CameraLocation = PC->PlayerCameraManager->GetCameraLocation();
+            Event.CameraRotation = PC->PlayerCameraManager->GetCameraRotation();
+            Event.PawnLocation = PC->GetPawn() ? PC->GetPawn()->GetActorLocation() : FVector::ZeroVector;
+
+            const FRoomVizInputEvent* Last = GActive->Recording.Events.IsValidIndex(GActive->LastCameraEvent)
+                ? &GActive->Recording.Events[GActive->LastCameraEvent] : nullptr;
+            if (!Last || !Last->CameraLocation.Equals(Event.CameraLocation, 0.1) || !Last->CameraRotation.Equals(Event.CameraRotation, 0.01f)
+                || !Last->PawnLocation.Equals(Event.PawnLocation, 0.1))
+            {
+                GActive->LastCameraEvent = GActive->Recording.Events.Num();
+                Record(MoveTemp(Event));
+            }
+            return true;
+        }
+    }
+
+    void Start(UWorld* World)
+    {
+        if (GActive || !World)
+        {
+            return;
+        }
+
+        GActive = MakeUnique<FActiveRecording>();
+        GActive->World = World;
+        // PIE worlds live in UEDPIE_N_ packages, which the replay cannot load
+        GActive->Recording.Map = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+        GActive->StartTime = FPlatformTime::Seconds();
+        GActive->TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&SampleCamera));
+        UE_LOG(LogRoomViz, Display, TEXT("Input recording started in %s"), *GActive->Recording.Map);
+    }
+
+    FString Stop(const FString& Name)
+    {
+        if (!GActive)
+        {
+            return FString();
+        }
+
+        FTSTicker::GetCoreTicker().RemoveTicker(GActive->TickHandle);
+        const FString Path = FPaths::ProjectSavedDir() / TEXT("InputRecordings")
+            / (Name.IsEmpty() ? FString::Printf(TEXT("Session-%s"), *FDateTime::Now().ToString()) : Name) + TEXT(".json");
+        const bool bSaved = GActive->Recording.SaveToFile(Path);
+        UE_LOG(LogRoomViz, Display, TEXT("Input recording: %d events %s %s"),
+            GActive->Recording.Events.Num(), bSaved ? TEXT("saved to") : TEXT("could not be saved to"), *Path);
+        GActive.Reset();
+        return bSaved ? Path : FString();
+    }
+
+    bool IsRecording()
+    {
+        return GActive.IsValid();
+    }
+
+    void Record(FRoomVizInputEvent&& Event)
+    {
+        if (GActive)
+        {
+            Event.Time = FPlatformTime::Seconds() - GActive->StartTime;
+            GActive->Recording.Events.Add(MoveTemp(Event));
+        }
+    }
+}
+
+static FAutoConsoleCommand CmdRecordStart(
+    TEXT("RoomViz.Record.Start"),
+    TEXT("Start recording palette drag/drop input and camera moves for -run=RoomVizReplay."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        RoomVizInputRecorder::Start(World);
+    }));
+
+static FAutoConsoleCommand CmdRecordStop(
+    TEXT("RoomViz.Record.Stop"),
+    TEXT("RoomViz.Record.Stop [Name]: stop recording and save to Saved/InputRecordings/<Name>.json."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        RoomVizInputRecorder::Stop(Args.Num() > 0 ? Args[0] : FString());
+    }));
@@ -0,0 +1,355 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/RoomVizReplayCommandlet.h"
+#include "tools/RoomVizHeadlessSession.h"
+#include "tools/RoomVizInputRecording.h"
+#include "dataclass/MaterialAPIManager.h"
+#include "ui/UIUserWidget.h"
+#include "room_viz/room_vizCharacter.h"
+#include "Blueprint/DragDropOperation.h"
+#include "Blueprint/UserWidget.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "HAL/FileManager.h"
+#include "Materials/Material.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/StrongObjectPtr.h"
+#include "room_viz.h"
+
+namespace RoomVizReplay
+{
+    struct FReplayOptions
+    {
+        FString MapOverride;
+        bool bNoMap = false;
+        FString CatalogURL;
+        double FixedStep = 1.0 / 60.0;
+        double TimeoutSeconds = 600.0;
+        double MaxRegressionPct = 20.0;
+        double MinRegressionMs = 0.05;
+    };
+
+    /** The recordings to replay: one file, or every .json in a folder (a suite) */
+    TArray<FString> FindFiles(const FString& Path, const TCHAR* Suffix)
+    {
+        TArray<FString> Files;
+        if (IFileManager::Get().DirectoryExists(*Path))
+        {
+            IFileManager::Get().FindFiles(Files, *(Path / FString(TEXT("*")) + Suffix), true, false);
+            for (FString& File : Files)
+            {
+                File = Path / File;
+            }
+            Files.Sort();
+        }
+        else if (IFileManager::Get().FileExists(*Path))
+        {
+            Files.Add(Path);
+        }
+        return Files;
+    }
+
+    /** Count, mean, percentiles and max of Samples (seconds), in milliseconds */
+    TSharedRef<FJsonObject> MakeTimingReport(TArray<double> Samples)
+    {
+        TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+        Report->SetNumberField(TEXT("count"), Samples.Num());
+        if (Samples.Num() == 0)
+        {
+            return Report;
+        }
+
+        Samples.Sort();
+        auto Percentile = [&Samples](double P)
+        {
+            const int32 Index = FMath::Clamp(FMath::CeilToInt32(P * Samples.Num()) - 1, 0, Samples.Num() - 1);
+            return Samples[Index] * 1000.0;
+        };
+        double Total = 0.0;
+        for (double Sample : Samples)
+        {
+            Total += Sample;
+        }
+        Report->SetNumberField(TEXT("avg_ms"), Total * 1000.0 / Samples.Num());
+        Report->SetNumberField(TEXT("p50_ms"), Percentile(0.50));
+        Report->SetNumberField(TEXT("p95_ms"), Percentile(0.95));
+        Report->SetNumberField(TEXT("max_ms"), Samples.Last() * 1000.0);
+        return Report;
+    }
+
+    TSharedPtr<FJsonObject> LoadReport(const FString& Path)
+    {
+        FString Json;
+        TSharedPtr<FJsonObject> Report;
+        if (FFileHelper::LoadFileToString(Json, *Path))
+        {
+            FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Report);
+        }
+        return Report;
+    }
+
+    /** Event types whose p95 cost grew past the baseline's by more than the allowed margin */
+    int32 CompareToBaseline(const FJsonObject& Report, const FJsonObject& Baseline, const FReplayOptions& Options)
+    {
+        const TSharedPtr<FJsonObject>* Events = nullptr;
+        const TSharedPtr<FJsonObject>* BaselineEvents = nullptr;
+        if (!Report.TryGetObjectField(TEXT("events"), Events) || !Baseline.TryGetObjectField(TEXT("events"), BaselineEvents))
+        {
+            return 0;
+        }
+
+        int32 NumRegressions = 0;
+        for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*Events)->Values)
+        {
+            const TSharedPtr<FJsonObject>* BaselineType = nullptr;
+            double P95 = 0.0;
+            double BaselineP95 = 0.0;
+            if (!(*BaselineEvents)->TryGetObjectField(Pair.Key, BaselineType)
+                || !Pair.Value->AsObject()->TryGetNumberField(TEXT("p95_ms"), P95)
+                || !(*BaselineType)->TryGetNumberField(TEXT("p95_ms"), BaselineP95))
+            {
+                continue;
+            }
+
+            // The absolute floor keeps sub-microsecond events from failing on timer noise
+            const double Limit = FMath::Max(BaselineP95 * (1.0 + Options.MaxRegressionPct / 100.0), BaselineP95 + Options.MinRegressionMs);
+            if (P95 > Limit)
+            {
+                UE_LOG(LogRoomViz, Error, TEXT("Replay: %s p95 %.3f ms regressed from baseline %.3f ms (limit %.3f ms)"),
+                    *Pair.Key, P95, BaselineP95, Limit);
+                ++NumRegressions;
+            }
+        }
+        return NumRegressions;
+    }
+
+    /** Replay one recording in a fresh world; null if it could not be set up */
+    TSharedPtr<FJsonObject> Replay(const FString& RecordingPath, const FReplayOptions& Options, const FRoomVizReportOutput& ReportOutput)
+    {
+        FRoomVizInputRecording Recording;
+        if (!Recording.LoadFromFile(RecordingPath))
+        {
+            return nullptr;
+        }
+
+        FRoomVizHeadlessSession Session;
+        const FString Map = Options.MapOverride.IsEmpty() ? Recording.Map : Options.MapOverride;
+        if (!Options.bNoMap && !Map.IsEmpty() && !Session.LoadMap(Map))
+        {
+            return nullptr;
+        }
+        UWorld* World = Session.GetWorld();
+
+        // ── Catalog and palette, as the level's manager and widget would build them ──
+        AMaterialAPIManager* Manager = World->SpawnActor<AMaterialAPIManager>();
+        Session.AddTickedActor(Manager);
+        if (!Options.CatalogURL.IsEmpty())
+        {
+            Manager->CatalogURL = Options.CatalogURL;
+        }
+        bool bCatalogComplete = false;
+        Manager->OnCatalogComplete.AddLambda([&bCatalogComplete](const TArray<FTileMaterialData>&) { bCatalogComplete = true; });
+        Manager->FetchTileMaterials();
+        if (!Session.PumpUntil([&bCatalogComplete]() { return bCatalogComplete; }, Options.TimeoutSeconds))
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Replay: catalog did not complete within %.0f s"), Options.TimeoutSeconds);
+            return nullptr;
+        }
+        Manager->OnCatalogComplete.Clear();
+
+        UUIUserWidget* Palette = CreateWidget<UUIUserWidget>(Session.GetGameInstance(), UUIUserWidget::StaticClass());
+        if (!Palette)
+        {
+            return nullptr;
+        }
+        Palette->BaseMaterial = LoadObject<UMaterialInterface>(nullptr, TEXT("/Game/assets/M_BaseMaterial.M_BaseMaterial"));
+        if (!Palette->BaseMaterial)
+        {
+            Palette->BaseMaterial = UMaterial::GetDefaultMaterial(MD_Surface);
+        }
+        TArray<FFloorMaterialData> Materials;
+        UUIUserWidget::BuildFloorMaterials(Manager->ParsedTiles, Palette->BaseMaterial, Palette->GetMaterialPool(), Materials);
+        Palette->InitializeMaterials(Materials);
+        Palette->FloorPreview.Initialize(Palette->BaseMaterial, Palette);
+
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+        Aroom_vizCharacter* Character = World->SpawnActor<Aroom_vizCharacter>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+
+        // ── Replay at a fixed step: events are dispatched in the first frame at or after their timestamp ──
+        const UEnum* EventEnum = StaticEnum<ERoomVizInputEventType>();
+        TMap<ERoomVizInputEventType, TArray<double>> EventTimes;
+        TStrongObjectPtr<UDragDropOperation> DragOperation;
+        int32 UnresolvedEntries = 0;
+        int32 NumDrops = 0;
+        int32 NumAppliedDrops = 0;
+
+        auto Dispatch = [&](const FRoomVizInputEvent& Event)
+        {
+            UBorder* Entry = Event.Entry.IsEmpty() ? nullptr : Palette->FindEntryByName(Event.Entry);
+            if (!Event.Entry.IsEmpty() && !Entry)
+            {
+                ++UnresolvedEntries;
+            }
+
+            switch (Event.Type)
+            {
+            case ERoomVizInputEventType::PointerDown:
+                Palette->BeginEntryDrag(Entry);
+                break;
+            case ERoomVizInputEventType::DragDetected:
+                DragOperation.Reset(Palette->CreateEntryDragOperation());
+                break;
+            case ERoomVizInputEventType::DragOver:
+                Palette->UpdateDragHover(Event.RayOrigin, Event.RayDirection, Character);
+                break;
+            case ERoomVizInputEventType::Drop:
+                ++NumDrops;
+                NumAppliedDrops += Palette->DropEntry(Entry, Character, Event.RayOrigin, Event.RayDirection) ? 1 : 0;
+                DragOperation.Reset();
+                break;
+            case ERoomVizInputEventType::PointerUp:
+                Palette->ApplyDropBackstop(Event.RayOrigin, Event.RayDirection, Character);
+                break;
+            case ERoomVizInputEventType::DragCancelled:
+                Palette->CancelEntryDrag();
+                DragOperation.Reset();
+                break;
+            case ERoomVizInputEventType::Camera:
+                if (Character)
+                {
+                    // Traces start from the recorded view, so the look direction matters as much as the position
+                    Character->SetActorLocation(Event.PawnLocation);
+                    Character->SetActorRotation(FRotator(0.0, Event.CameraRotation.Yaw, 0.0));
+                    if (AController* Controller = Character->GetController())
+                    {
+                        Controller->SetControlRotation(Event.CameraRotation);
+                    }
+                }
+                break;
+            }
+        };
+
+        Session.ResetFrameTimes();
+        double Clock = 0.0;
+        int32 NextEvent = 0;
+        while (NextEvent < Recording.Events.Num())
+        {
+            while (NextEvent < Recording.Events.Num() && Recording.Events[NextEvent].Time <= Clock)
+            {
+                const FRoomVizInputEvent& Event = Recording.Events[NextEvent++];
+                const double StartTime = FPlatformTime::Seconds();
+                Dispatch(Event);
+                EventTimes.FindOrAdd(Event.Type).Add(FPlatformTime::Seconds() - StartTime);
+            }
+            Session.Pump(float(Options.FixedStep));
+            Clock += Options.FixedStep;
+        }
+
+        // ── Report ──
+        TSharedRef<FJsonObject> Events = MakeShared<FJsonObject>();
+        for (const TPair<ERoomVizInputEventType, TArray<double>>& Pair : EventTimes)
+        {
+            Events->SetObjectField(EventEnum->GetNameStringByValue(int64(Pair.Key)), MakeTimingReport(Pair.Value));
+        }
+
+        TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("input_replay"));
+        Report->SetStringField(TEXT("recording"), FPaths::GetBaseFilename(RecordingPath));
+        Report->SetStringField(TEXT("map"), Options.bNoMap ? FString() : Map);
+        Report->SetNumberField(TEXT("fixed_step_ms"), Options.FixedStep * 1000.0);
+        Report->SetNumberField(TEXT("palette_entries"), Materials.Num());
+        Report->SetNumberField(TEXT("events_replayed"), Recording.Events.Num());
+        Report->SetNumberField(TEXT("unresolved_entries"), UnresolvedEntries);
+        Report->SetNumberField(TEXT("drops"), NumDrops);
+        Report->SetNumberField(TEXT("drops_applied"), NumAppliedDrops);
+        Report->SetObjectField(TEXT("events"), Events);
+        Report->SetObjectField(TEXT("game_thread_frame_time"), MakeTimingReport(Session.GetFrameTimes()));
+
+        UE_LOG(LogRoomViz, Display, TEXT("Replay: %s, %d events, %d/%d drops applied, %d unresolved entries"),
+            *FPaths::GetBaseFilename(RecordingPath), Recording.Events.Num(), NumAppliedDrops, NumDrops, UnresolvedEntries);
+
+        Palette->FloorPreview.Revert();
+        return Report;
+    }
+}
+
+URoomVizReplayCommandlet::URoomVizReplayCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 URoomVizReplayCommandlet::Main(const FString& Params)
+{
+    using namespace RoomVizReplay;
+
+    FString RecordingPath;
+    if (!FParse::Value(*Params, TEXT("Recording="), RecordingPath))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Replay: needs -Recording=<session.json or folder>"));
+        return 1;
+    }
+    const TArray<FString> Recordings = FindFiles(RecordingPath, TEXT(".json"));
+    if (Recordings.Num() == 0)
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Replay: no recordings at %s"), *RecordingPath);
+        return 1;
+    }
+
+    FReplayOptions Options;
+    FParse::Value(*Params, TEXT("Map="), Options.MapOverride);
+    Options.bNoMap = FParse::Param(*Params, TEXT("NoMap"));
+    FParse::Value(*Params, TEXT("CatalogURL="), Options.CatalogURL);
+    FParse::Value(*Params, TEXT("FixedStep="), Options.FixedStep);
+    Options.FixedStep = FMath::Max(Options.FixedStep, 0.001);
+    FParse::Value(*Params, TEXT("Timeout="), Options.TimeoutSeconds);
+    FParse::Value(*Params, TEXT("MaxRegressionPct="), Options.MaxRegressionPct);
+    FParse::Value(*Params, TEXT("MinRegressionMs="), Options.MinRegressionMs);
+    FString BaselinePath;
+    FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+    // Output= is a folder here: one report per recording, named after it
+    const FRoomVizReportOutput ReportOutput(*Params, TEXT("Replay"));
+
+    int32 NumFailed = 0;
+    int32 NumRegressions = 0;
+    for (const FString& Recording : Recordings)
+    {
+        const TSharedPtr<FJsonObject> Report = Replay(Recording, Options, ReportOutput);
+        if (!Report)
+        {
+            ++NumFailed;
+            continue;
+        }
+
+        const FString Name = FPaths::GetBaseFilename(Recording);
+        if (!FRoomVizReportOutput::Write(Report.ToSharedRef(), ReportOutput.OutputPath / Name + TEXT(".replay.json")))
+        {
+            ++NumFailed;
+        }
+
+        // A baseline folder holds the reports of a previous suite run, matched by recording name
+        if (!BaselinePath.IsEmpty())
+        {
+            const FString BaselineFile = IFileManager::Get().DirectoryExists(*BaselinePath)
+                ? BaselinePath / Name + TEXT(".replay.json") : BaselinePath;
+            if (const TSharedPtr<FJsonObject> Baseline = LoadReport(BaselineFile))
+            {
+                NumRegressions += CompareToBaseline(*Report, *Baseline, Options);
+            }
+            else
+            {
+                UE_LOG(LogRoomViz, Warning, TEXT("Replay: no baseline for %s at %s"), *Name, *BaselineFile);
+            }
+        }
+    }
+
+    UE_LOG(LogRoomViz, Display, TEXT("Replay: %d recordings, %d failed, %d regressions"), Recordings.Num(), NumFailed, NumRegressions);
+    return NumFailed > 0 ? 1 : NumRegressions > 0 ? 2 : 0;
+}
@@ -0,0 +1,443 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/RoomVizSoakCommandlet.h"
+#include "tools/CatalogStandInServer.h"
+#include "tools/RoomVizHeadlessSession.h"
+#include "dataclass/MaterialAPIManager.h"
+#include "ui/UIUserWidget.h"
+#include "room_viz/room_vizCharacter.h"
+#include "Blueprint/DragDropOperation.h"
+#include "Blueprint/UserWidget.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "Materials/Material.h"
+#include "Math/RandomStream.h"
+#include "Misc/Parse.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/UObjectIterator.h"
+#include "room_viz.h"
+
+namespace RoomVizSoak
+{
+    struct FSoakOptions
+    {
+        double DurationSeconds = 3600.0;
+        int32 MaxCycles = 0;
+        int32 DropsPerCycle = 200;
+        int32 WarmupCycles = 3;
+        double MaxObjectGrowthPct = 5.0;
+        double MaxRSSGrowthMB = 64.0;
+        double MaxTextureGrowthMB = 16.0;
+        double TimeoutSeconds = 600.0;
+        float FloorExtent = 1000.f;
+    };
+
+    /** What is alive after a cycle, once garbage has been collected */
+    struct FSample
+    {
+        int32 Cycle = 0;
+        double Seconds = 0.0;
+        int32 NumObjects = 0;
+        int64 TextureBytes = 0;
+        uint64 UsedPhysical = 0;
+        TMap<FName, int32> ObjectsByClass;
+    };
+
+    FSample TakeSample(int32 Cycle, double Seconds)
+    {
+        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+
+        FSample Sample;
+        Sample.Cycle = Cycle;
+        Sample.Seconds = Seconds;
+        for (TObjectIterator<UObject> It; It; ++It)
+        {
+            ++Sample.NumObjects;
+            ++Sample.ObjectsByClass.FindOrAdd(It->GetClass()->GetFName());
+            if (const UTexture2D* Texture = Cast<UTexture2D>(*It))
+            {
+                Sample.TextureBytes += Texture->CalcTextureMemorySizeEnum(TMC_AllMips);
+            }
+        }
+
+        // Freed but cached pages would read as growth
+        FMemory::Trim();
+        Sample.UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+        return Sample;
+    }
+
+    /** Least-squares slope of Values against their index: the steady change per cycle */
+    double Trend(TConstArrayView<double> Values)
+    {
+        const int32 Num = Values.Num();
+        if (Num < 2)
+        {
+            return 0.0;
+        }
+
+        double MeanY = 0.0;
+        for (double Value : Values)
+        {
+            MeanY += Value;
+        }
+        MeanY /= Num;
+        const double MeanX = (Num - 1) / 2.0;
+
+        double Covariance = 0.0;
+        double Variance = 0.0;
+        for (int32 Index = 0; Index < Num; ++Index)
+        {
+            Covariance += (Index - MeanX) * (Values[Index] - MeanY);
+            Variance += (Index - MeanX) * (Index - MeanX);
+        }
+        return Covariance / Variance;
+    }
+
+    /**
+     * Start, end and trend of one metric over the steady samples. It grew without bound when the
+     * trend, carried over the run, exceeds Allowed and the run did end higher than it started;
+     * a sawtooth that returns to its level is not growth.
+     */
+    TSharedRef<FJsonObject> MakeGrowthReport(TConstArrayView<double> Values, double Allowed, bool& bOutGrew)
+    {
+        const double PerCycle = Trend(Values);
+        const double Projected = PerCycle * FMath::Max(Values.Num() - 1, 0);
+        bOutGrew = Values.Num() > 1 && Projected > Allowed && Values.Last() > Values[0];
+
+        TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+        Report->SetNumberField(TEXT("start"), Values.Num() ? Values[0] : 0.0);
+        Report->SetNumberField(TEXT("end"), Values.Num() ? Values.Last() : 0.0);
+        Report->SetNumberField(TEXT("per_cycle"), PerCycle);
+        Report->SetNumberField(TEXT("allowed"), Allowed);
+        Report->SetBoolField(TEXT("grew"), bOutGrew);
+        return Report;
+    }
+
+    /**
+     * Destroy Character, if any, and spawn a new one with the palette widget, as a respawn does.
+     * Returns the new character's palette, constructed and bound to the world's manager.
+     */
+    UUIUserWidget* RespawnCharacter(UWorld* World, TWeakObjectPtr<Aroom_vizCharacter>& Character, TSharedPtr<SWidget>& PaletteSlate)
+    {
+        if (Aroom_vizCharacter* Previous = Character.Get())
+        {
+            Previous->Destroy();
+        }
+        PaletteSlate.Reset();
+
+        Aroom_vizCharacter* Spawned = World->SpawnActorDeferred<Aroom_vizCharacter>(Aroom_vizCharacter::StaticClass(),
+            FTransform(FVector(0.0, 0.0, 200.0)), nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+        Spawned->UIWidgetClass = UUIUserWidget::StaticClass();
+        Spawned->FinishSpawning(FTransform(FVector(0.0, 0.0, 200.0)));
+        Character = Spawned;
+
+        // A loaded map has begun play and BeginPlay already ran; the empty world never does
+        if (!Spawned->HasActorBegunPlay())
+        {
+            Spawned->DispatchBeginPlay();
+        }
+
+        UUIUserWidget* Palette = Spawned->UIWidgetInstance;
+        if (!Palette)
+        {
+            return nullptr;
+        }
+
+        // AddToViewport constructs nothing without a viewport; taking the Slate widget does
+        PaletteSlate = Palette->TakeWidget();
+        if (!Palette->BaseMaterial)
+        {
+            Palette->BaseMaterial = UMaterial::GetDefaultMaterial(MD_Surface);
+            Palette->FloorPreview.Initialize(Palette->BaseMaterial, Palette);
+        }
+        return Palette;
+    }
+
+    /** A grid of floors to drop on when no map is loaded, one component per cell */
+    void SpawnFloors(UWorld* World, float Extent)
+    {
+        UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+        if (!Cube)
+        {
+            UE_LOG(LogRoomViz, Warning, TEXT("Soak: no cube mesh, drops will not hit anything"));
+            return;
+        }
+
+        constexpr int32 GridSize = 4;
+        const float CellSize = 2.f * Extent / GridSize;
+        for (int32 X = 0; X < GridSize; ++X)
+        {
+            for (int32 Y = 0; Y < GridSize; ++Y)
+            {
+                const FVector Location(-Extent + (X + 0.5f) * CellSize, -Extent + (Y + 0.5f) * CellSize, 0.0);
+                AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(Location, FRotator::ZeroRotator);
+                Floor->SetMobility(EComponentMobility::Movable);
+                Floor->GetStaticMeshComponent()->SetStaticMesh(Cube);
+                Floor->SetActorScale3D(FVector(CellSize / 100.f, CellSize / 100.f, 0.1f));
+            }
+        }
+    }
+}
+
+URoomVizSoakCommandlet::URoomVizSoakCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 URoomVizSoakCommandlet::Main(const FString& Params)
+{
+    using namespace RoomVizSoak;
+
+    FCatalogStandInConfig ServerConfig;
+    ServerConfig.TileSize = 256;
+    ServerConfig.ParseCommandLine(*Params);
+
+    FSoakOptions Options;
+    FParse::Value(*Params, TEXT("Duration="), Options.DurationSeconds);
+    FParse::Value(*Params, TEXT("Cycles="), Options.MaxCycles);
+    FParse::Value(*Params, TEXT("DropsPerCycle="), Options.DropsPerCycle);
+    FParse::Value(*Params, TEXT("WarmupCycles="), Options.WarmupCycles);
+    Options.WarmupCycles = FMath::Max(Options.WarmupCycles, 0);
+    FParse::Value(*Params, TEXT("MaxObjectGrowthPct="), Options.MaxObjectGrowthPct);
+    FParse::Value(*Params, TEXT("MaxRSSGrowthMB="), Options.MaxRSSGrowthMB);
+    FParse::Value(*Params, TEXT("MaxTextureGrowthMB="), Options.MaxTextureGrowthMB);
+    FParse::Value(*Params, TEXT("Timeout="), Options.TimeoutSeconds);
+    FString MapName;
+    FParse::Value(*Params, TEXT("Map="), MapName);
+    const FRoomVizReportOutput ReportOutput(*Params, FRoomVizReportOutput::MakeTimestampedName(TEXT("RoomVizSoak")));
+
+    FCatalogStandInServer Server(ServerConfig);
+    if (!Server.Start())
+    {
+        return 1;
+    }
+
+    FRoomVizHeadlessSession Session;
+    if (!MapName.IsEmpty() && !Session.LoadMap(MapName))
+    {
+        return 1;
+    }
+    UWorld* World = Session.GetWorld();
+    if (MapName.IsEmpty())
+    {
+        SpawnFloors(World, Options.FloorExtent);
+    }
+
+    AMaterialAPIManager* Manager = World->SpawnActor<AMaterialAPIManager>();
+    Session.AddTickedActor(Manager);
+    Manager->CatalogURL = Server.GetCatalogURL();
+    bool bCatalogComplete = false;
+    Manager->OnCatalogComplete.AddLambda([&bCatalogComplete](const TArray<FTileMaterialData>&) { bCatalogComplete = true; });
+
+    // Same drops every run, so two runs of a build differ only by what leaks
+    FRandomStream Random(0x50A4);
+    TWeakObjectPtr<Aroom_vizCharacter> Character;
+    // Commandlets have no game viewport; this reference keeps the palette constructed in its place
+    TSharedPtr<SWidget> PaletteSlate;
+    TArray<FSample> Samples;
+    int32 NumDrops = 0;
+    int32 NumAppliedDrops = 0;
+    int32 NumFailedCycles = 0;
+    const double StartTime = FPlatformTime::Seconds();
+
+    for (int32 Cycle = 0; ; ++Cycle)
+    {
+        const double Elapsed = FPlatformTime::Seconds() - StartTime;
+        if ((Options.MaxCycles > 0 && Cycle >= Options.MaxCycles) || Elapsed >= Options.DurationSeconds)
+        {
+            break;
+        }
+
+        // ── Respawn: the old character's EndPlay lets its palette go, the new one's BeginPlay creates
+        //    a palette whose construction binds it to the manager and refreshes the catalog ──
+        bCatalogComplete = false;
+        UUIUserWidget* Palette = RespawnCharacter(World, Character, PaletteSlate);
+        if (!Palette)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Soak: the respawned character has no palette"));
+            return 1;
+        }
+
+        // The palette builds from OnMaterialsReady through the work queue
+        const bool bLoaded = Session.PumpUntil([&bCatalogComplete, &Palette, Manager]()
+        {
+            return bCatalogComplete && Palette->PendingPaletteTiles.Num() == 0 && Manager->GetWorkQueue().IsEmpty();
+        }, Options.TimeoutSeconds);
+        if (!bLoaded)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Soak: cycle %d did not load within %.0f s"), Cycle, Options.TimeoutSeconds);
+            ++NumFailedCycles;
+            continue;
+        }
+
+        // ── Drops: drag, hover, drop on a random floor spot ──
+        TArray<UBorder*> Entries;
+        Palette->MaterialEntryMap.GenerateKeyArray(Entries);
+        for (int32 Drop = 0; Drop < Options.DropsPerCycle && Entries.Num() > 0; ++Drop)
+        {
+            UBorder* Entry = Entries[Random.RandHelper(Entries.Num())];
+            const FVector RayOrigin(Random.FRandRange(-Options.FloorExtent, Options.FloorExtent), Random.FRandRange(-Options.FloorExtent, Options.FloorExtent), 1000.0);
+
+            Palette->BeginEntryDrag(Entry);
+            TStrongObjectPtr<UDragDropOperation> DragOperation(Palette->CreateEntryDragOperation());
+            Palette->UpdateDragHover(RayOrigin, FVector::DownVector, Character.Get());
+            NumAppliedDrops += Palette->DropEntry(Entry, Character.Get(), RayOrigin, FVector::DownVector) ? 1 : 0;
+            ++NumDrops;
+
+            if (Drop % 20 == 19)
+            {
+                Session.Pump(1.f / 60.f);
+            }
+        }
+        Session.Pump(1.f / 60.f);
+
+        const FSample& Sample = Samples.Add_GetRef(TakeSample(Cycle, FPlatformTime::Seconds() - StartTime));
+        UE_LOG(LogRoomViz, Display, TEXT("Soak: cycle %d at %.0f s, %d UObjects, textures %.1f MB, RSS %.1f MB"),
+            Cycle, Sample.Seconds, Sample.NumObjects, Sample.TextureBytes / (1024.0 * 1024.0), Sample.UsedPhysical / (1024.0 * 1024.0));
+    }
+
+    if (Aroom_vizCharacter* Last = Character.Get())
+    {
+        Last->Destroy();
+    }
+    PaletteSlate.Reset();
+    Manager->OnCatalogComplete.Clear();
+    Server.Stop();
+
+    // ── Growth past the warm-up ──
+    const TConstArrayView<FSample> Steady = TConstArrayView<FSample>(Samples).RightChop(Options.WarmupCycles);
+    const bool bJudged = Steady.Num() >= 3;
+    if (!bJudged)
+    {
+        UE_LOG(LogRoomViz, Warning, TEXT("Soak: %d cycles after the warm-up, at least 3 are needed to judge growth"), Steady.Num());
+    }
+
+    auto Series = [&Steady](TFunctionRef<double(const FSample&)> Value)
+    {
+        TArray<double> Values;
+        for (const FSample& Sample : Steady)
+        {
+            Values.Add(Value(Sample));
+        }
+        return Values;
+    };
+
+    bool bRSSGrew = false;
+    bool bTexturesGrew = false;
+    bool bObjectsGrew = false;
+    const TArray<double> ObjectSeries = Series([](const FSample& Sample) { return double(Sample.NumObjects); });
+    TSharedRef<FJsonObject> Growth = MakeShared<FJsonObject>();
+    Growth->SetObjectField(TEXT("used_physical_mb"), MakeGrowthReport(Series([](const FSample& Sample) { return Sample.UsedPhysical / (1024.0 * 1024.0); }), Options.MaxRSSGrowthMB, bRSSGrew));
+    Growth->SetObjectField(TEXT("texture_mb"), MakeGrowthReport(Series([](const FSample& Sample) { return Sample.TextureBytes / (1024.0 * 1024.0); }), Options.MaxTextureGrowthMB, bTexturesGrew));
+    Growth->SetObjectField(TEXT("uobjects"), MakeGrowthReport(ObjectSeries,
+        ObjectSeries.Num() ? ObjectSeries[0] * Options.MaxObjectGrowthPct / 100.0 : 0.0, bObjectsGrew));
+
+    // Per class: which object types leaked, and the top growers for context
+    TSet<FName> Classes;
+    for (const FSample& Sample : Steady)
+    {
+        for (const TPair<FName, int32>& Pair : Sample.ObjectsByClass)
+        {
+            Classes.Add(Pair.Key);
+        }
+    }
+
+    struct FClassGrowth
+    {
+        FName Class;
+        double Start = 0.0;
+        double End = 0.0;
+        double PerCycle = 0.0;
+        bool bLeaked = false;
+    };
+    TArray<FClassGrowth> ClassGrowth;
+    for (const FName& Class : Classes)
+    {
+        const TArray<double> Values = Series([Class](const FSample& Sample) { return double(Sample.ObjectsByClass.FindRef(Class)); });
+        FClassGrowth& Entry = ClassGrowth.AddDefaulted_GetRef();
+        Entry.Class = Class;
+        Entry.Start = Values[0];
+        Entry.End = Values.Last();
+        Entry.PerCycle = Trend(Values);
+
+        // One object kept per cycle is a leak even in a class of thousands: the run gained at
+        // least as many as it had cycles, and steadily rather than in one jump
+        const int32 NumSteadyCycles = Values.Num() - 1;
+        Entry.bLeaked = NumSteadyCycles > 0 && Entry.End - Entry.Start >= NumSteadyCycles && Entry.PerCycle >= 0.5;
+    }
+    ClassGrowth.Sort([](const FClassGrowth& A, const FClassGrowth& B) { return A.PerCycle > B.PerCycle; });
+
+    TArray<TSharedPtr<FJsonValue>> Leaked;
+    TArray<TSharedPtr<FJsonValue>> Growing;
+    for (const FClassGrowth& Entry : ClassGrowth)
+    {
+        if (Entry.PerCycle <= 0.0 || (!Entry.bLeaked && Growing.Num() >= 25))
+        {
+            continue;
+        }
+
+        TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+        Object->SetStringField(TEXT("class"), Entry.Class.ToString());
+        Object->SetNumberField(TEXT("start"), Entry.Start);
+        Object->SetNumberField(TEXT("end"), Entry.End);
+        Object->SetNumberField(TEXT("per_cycle"), Entry.PerCycle);
+        (Entry.bLeaked ? Leaked : Growing).Add(MakeShared<FJsonValueObject>(Object));
+
+        if (Entry.bLeaked && bJudged)
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Soak: %s grew from %.0f to %.0f (%.1f per cycle)"), *Entry.Class.ToString(), Entry.Start, Entry.End, Entry.PerCycle);
+        }
+    }
+
+    const bool bLeaks = bJudged && (bRSSGrew || bTexturesGrew || bObjectsGrew || Leaked.Num() > 0);
+
+    // ── Report ──
+    TArray<TSharedPtr<FJsonValue>> SampleValues;
+    for (const FSample& Sample : Samples)
+    {
+        TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+        Object->SetNumberField(TEXT("cycle"), Sample.Cycle);
+        Object->SetNumberField(TEXT("seconds"), Sample.Seconds);
+        Object->SetNumberField(TEXT("uobjects"), Sample.NumObjects);
+        Object->SetNumberField(TEXT("texture_bytes"), double(Sample.TextureBytes));
+        Object->SetNumberField(TEXT("used_physical_bytes"), double(Sample.UsedPhysical));
+        SampleValues.Add(MakeShared<FJsonValueObject>(Object));
+    }
+
+    TSharedRef<FJsonObject> Config = MakeShared<FJsonObject>();
+    Config->SetNumberField(TEXT("duration_s"), Options.DurationSeconds);
+    Config->SetNumberField(TEXT("max_cycles"), Options.MaxCycles);
+    Config->SetNumberField(TEXT("drops_per_cycle"), Options.DropsPerCycle);
+    Config->SetNumberField(TEXT("warmup_cycles"), Options.WarmupCycles);
+    Config->SetNumberField(TEXT("tile_count"), ServerConfig.TileCount);
+    Config->SetNumberField(TEXT("tile_size"), ServerConfig.TileSize);
+    Config->SetStringField(TEXT("map"), MapName);
+
+    TSharedRef<FJsonObject> Report = ReportOutput.MakeReport(TEXT("soak"));
+    Report->SetObjectField(TEXT("config"), Config);
+    Report->SetNumberField(TEXT("cycles"), Samples.Num());
+    Report->SetNumberField(TEXT("cycles_failed"), NumFailedCycles);
+    Report->SetNumberField(TEXT("elapsed_s"), FPlatformTime::Seconds() - StartTime);
+    Report->SetNumberField(TEXT("drops"), NumDrops);
+    Report->SetNumberField(TEXT("drops_applied"), NumAppliedDrops);
+    Report->SetBoolField(TEXT("judged"), bJudged);
+    Report->SetBoolField(TEXT("passed"), bJudged && !bLeaks && NumFailedCycles == 0);
+    Report->SetObjectField(TEXT("growth"), Growth);
+    Report->SetArrayField(TEXT("leaked_classes"), Leaked);
+    Report->SetArrayField(TEXT("growing_classes"), Growing);
+    Report->SetArrayField(TEXT("samples"), SampleValues);
+
+    const bool bWritten = ReportOutput.Write(Report);
+    UE_LOG(LogRoomViz, Display, TEXT("Soak: %d cycles, %d/%d drops applied, %d failed cycles, %d leaked classes%s"),
+        Samples.Num(), NumAppliedDrops, NumDrops, NumFailedCycles, Leaked.Num(), bLeaks ? TEXT(", unbounded growth") : TEXT(""));
+
+    return NumFailedCycles > 0 || !bWritten ? 1 : bLeaks ? 2 : 0;
+}
@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tools/RoomVizTilePackCommandlet.h"
+#include "tools/CatalogStandInServer.h"
+#include "tools/RoomVizHeadlessSession.h"
+#include "dataclass/TileCatalogSources.h"
+#include "dataclass/TilePackManifest.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "Engine/PrimaryAssetLabel.h"
+#include "Engine/Texture2D.h"
+#include "Async/Async.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "room_viz.h"
+
+#if WITH_EDITOR
+namespace RoomVizTilePack
+{
+    /** Tile IDs come from the catalog; keep them usable as object names */
+    FString MakeAssetName(const FString& Prefix, const FString& ID)
+    {
+        FString Name = Prefix + ID;
+        for (TCHAR& Char : Name)
+        {
+            if (!FChar::IsAlnum(Char) && Char != TEXT('_'))
+            {
+                Char = TEXT('_');
+            }
+        }
+        return Name;
+    }
+
+    template <typename AssetType>
+    AssetType* CreateAsset(const FString& Folder, const FString& AssetName)
+    {
+        UPackage* Package = CreatePackage(*(Folder / AssetName));
+        Package->FullyLoad();
+        return NewObject<AssetType>(Package, *AssetName, RF_Public | RF_Standalone);
+    }
+
+    bool SaveAsset(UObject* Asset)
+    {
+        UPackage* Package = Asset->GetPackage();
+        Package->MarkPackageDirty();
+
+        const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        if (!UPackage::SavePackage(Package, Asset, *Filename, SaveArgs))
+        {
+            UE_LOG(LogRoomViz, Error, TEXT("Tile pack: could not save %s"), *Filename);
+            return false;
+        }
+        return true;
+    }
+
+    /** Decode Bytes and save them as a mipped, platform-compressed texture asset */
+    UTexture2D* CreateTileTexture(const FString& Folder, const FString& ID, TConstArrayView<uint8> Bytes)
+    {
+        IImageWrapperModule& IWM = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+        const EImageFormat Format = IWM.DetectImageFormat(Bytes.GetData(), Bytes.Num());
+        TSharedPtr<IImageWrapper> IW = IWM.CreateImageWrapper(Format != EImageFormat::Invalid ? Format : EImageFormat::JPEG);
+        TArray<uint8> Raw;
+        if (!IW.IsValid() || !IW->SetCompressed(Bytes.GetData(), Bytes.Num()) || !IW->GetRaw(ERGBFormat::BGRA, 8, Raw))
+        {
+            UE_LOG(LogRoomViz, Warning, TEXT("Tile pack: could not decode tile %s"), *ID);
+            return nullptr;
+        }
+
+        UTexture2D* Texture = CreateAsset<UTexture2D>(Folder, MakeAssetName(TEXT("T_"), ID));
+        Texture->Source.Init(IW->GetWidth(), IW->GetHeight(), 1, 1, TSF_BGRA8, Raw.GetData());
+        Texture->SRGB = true;
+        Texture->CompressionSettings = TC_Default; // BC1 on desktop, ASTC/ETC2 on mobile, chosen at cook
+        Texture->MipGenSettings = TMGS_FromTextureGroup;
+        Texture->LODGroup = TEXTUREGROUP_World;
+        Texture->PostEditChange();
+
+        if (!SaveAsset(Texture))
+        {
+            return nullptr;
+        }
+
+        // Saved, so the source pixels can go with the next GC
+        Texture->ClearFlags(RF_Standalone);
+        return Texture;
+    }
+
+    /** Shared with the fetch callbacks, which may outlive Main on timeout */
+    struct FBuildState
+    {
+        FString Folder;
+        TArray<FTilePackEntry> Entries;
+        int32 Remaining = 0;
+        int32 NumCooked = 0;
+    };
+}
+#endif
+
+URoomVizTilePackCommandlet::URoomVizTilePackCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 URoomVizTilePackCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+    using namespace RoomVizTilePack;
+
+    FString PackNameString;
+    if (!FParse::Value(*Params, TEXT("Pack="), PackNameString))
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Usage: -run=RoomVizTilePack -Pack=<Name> [-Chunk=100] [-Catalog=<url> | -Dir=<folder> | -StandIn] [-MaxTiles=N]"));
+        return 1;
+    }
+    const FName PackName(*PackNameString);
+    int32 ChunkId = 100;
+    FParse::Value(*Params, TEXT("Chunk="), ChunkId);
+    int32 MaxTiles = MAX_int32;
+    FParse::Value(*Params, TEXT("MaxTiles="), MaxTiles);
+    double TimeoutSeconds = 1800.0;
+    FParse::Value(*Params, TEXT("Timeout="), TimeoutSeconds);
+
+    // ── Source ──
+    TUniquePtr<FCatalogStandInServer> StandIn;
+    TSharedPtr<ITileCatalogSource> Source;
+    FString Location;
+    if (FParse::Param(*Params, TEXT("StandIn")))
+    {
+        FCatalogStandInConfig StandInConfig;
+        StandInConfig.ParseCommandLine(*Params);
+        StandIn = MakeUnique<FCatalogStandInServer>(StandInConfig);
+        if (!StandIn->Start())
+        {
+            return 1;
+        }
+        Source = MakeShared<FHttpTileCatalogSource>(StandIn->GetCatalogURL(), 0);
+    }
+    else if (FParse::Value(*Params, TEXT("Catalog="), Location))
+    {
+        Source = MakeShared<FHttpTileCatalogSource>(Location, 0);
+    }
+    else if (FParse::Value(*Params, TEXT("Dir="), Location))
+    {
+        Source = MakeShared<FLocalDirectoryTileCatalogSource>(Location, 0, /*bInMemoryMap*/ true);
+    }
+    else
+    {
+        for (const TSharedRef<ITileCatalogSource>& Candidate : URoomVizTileSettings::Get()->CreateCatalogSources())
+        {
+            if (!Candidate->HasCookedTextures() && (!Source.IsValid() || Candidate->GetPriority() > Source->GetPriority()))
+            {
+                Source = Candidate;
+            }
+        }
+    }
+    if (!Source.IsValid())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Tile pack: no catalog source"));
+        return 1;
+    }
+
+    FRoomVizHeadlessSession Session;
+
+    // ── Catalog ──
+    TSharedRef<TOptional<TArray<FTileMaterialData>>> Catalog = MakeShared<TOptional<TArray<FTileMaterialData>>>();
+    TSharedRef<bool> bCatalogDone = MakeShared<bool>(false);
+    Source->FetchCatalog([Catalog, bCatalogDone](bool bSuccess, TArray<FTileMaterialData>&& Tiles)
+    {
+        if (bSuccess)
+        {
+            Catalog->Emplace(MoveTemp(Tiles));
+        }
+        *bCatalogDone = true;
+    });
+    if (!Session.PumpUntil([bCatalogDone]() { return *bCatalogDone; }, TimeoutSeconds) || !Catalog->IsSet())
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Tile pack: catalog of %s could not be fetched"), *Source->GetSourceName().ToString());
+        return 1;
+    }
+
+    TArray<FTileMaterialData> Tiles = MoveTemp(Catalog->GetValue());
+    if (Tiles.Num() > MaxTiles)
+    {
+        Tiles.SetNum(MaxTiles);
+    }
+
+    // ── Textures ──
+    TSharedRef<FBuildState> State = MakeShared<FBuildState>();
+    State->Folder = UTilePackManifest::GetPackFolder(PackName);
+    State->Entries.SetNum(Tiles.Num());
+    State->Remaining = Tiles.Num();
+
+    for (int32 Index = 0; Index < Tiles.Num(); ++Index)
+    {
+        const FTileMaterialData& Tile = Tiles[Index];
+        Source->FetchImage(Tile.BaseColorURL, [State, Index, ID = Tile.ID, URL = Tile.BaseColorURL](bool bSuccess, FTileImagePayloadPtr Payload)
+        {
+            // Assets are created and saved on the game thread
+            AsyncTask(ENamedThreads::GameThread, [State, Index, ID, URL, bSuccess, Payload]()
+            {
+                --State->Remaining;
+                UTexture2D* Texture = bSuccess && Payload.IsValid() ? CreateTileTexture(State->Folder, ID, Payload->GetBytes()) : nullptr;
+                if (!Texture)
+                {
+                    UE_LOG(LogRoomViz, Warning, TEXT("Tile pack: skipping tile %s"), *ID);
+                    return;
+                }
+
+                FTilePackEntry& Entry = State->Entries[Index];
+                Entry.ID = ID;
+                Entry.Texture = Texture;
+                Entry.SourceURL = URL;
+
+                // Source pixels of saved textures add up quickly on large packs
+                if (++State->NumCooked % 64 == 0)
+                {
+                    CollectGarbage(RF_NoFlags);
+                }
+            });
+        });
+    }
+
+    const bool bCompleted = Session.PumpUntil([State]() { return State->Remaining == 0; }, TimeoutSeconds);
+    if (!bCompleted)
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("Tile pack: timed out with %d tiles outstanding"), State->Remaining);
+        return 1;
+    }
+
+    // ── Manifest and chunk label ──
+    UTilePackManifest* Manifest = CreateAsset<UTilePackManifest>(State->Folder, UTilePackManifest::GetManifestPath(PackName).GetAssetName());
+    Manifest->PackName = PackName;
+    for (FTilePackEntry& Entry : State->Entries)
+    {
+        if (!Entry.ID.IsEmpty())
+        {
+            Manifest->Tiles.Add(MoveTemp(Entry));
+        }
+    }
+
+    UPrimaryAssetLabel* Label = CreateAsset<UPrimaryAssetLabel>(State->Folder, MakeAssetName(TEXT("Label_"), PackNameString));
+    Label->Rules.ChunkId = ChunkId;
+    Label->Rules.CookRule = EPrimaryAssetCookRule::AlwaysCook;
+    Label->bLabelAssetsInMyDirectory = true;
+
+    if (!SaveAsset(Manifest) || !SaveAsset(Label))
+    {
+        return 1;
+    }
+
+    UE_LOG(LogRoomViz, Display, TEXT("Tile pack %s: %d/%d tiles cooked into %s, chunk %d"),
+        *PackNameString, Manifest->Tiles.Num(), Tiles.Num(), *State->Folder, ChunkId);
+    return Manifest->Tiles.Num() == Tiles.Num() ? 0 : 1;
+#else
+    UE_LOG(LogRoomViz, Error, TEXT("RoomVizTilePack needs an editor build"));
+    return 1;
+#endif
+}
@@ -0,0 +1,285 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ui/FloorBoxSelection.h"
+#include "Async/ParallelFor.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Crc.h"
+#include "SceneView.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+static TAutoConsoleVariable<int32> CVarBoxSelectMaxTraces(
+    TEXT("RoomViz.BoxSelect.MaxTraces"),
+    256,
+    TEXT("Occlusion traces a marquee update may run; floors past the budget keep their previous state until a later frame traces them."));
+
+static TAutoConsoleVariable<bool> CVarBoxSelectParallel(
+    TEXT("RoomViz.BoxSelect.Parallel"),
+    true,
+    TEXT("Project floor bounds for the marquee on worker threads; off projects them on the game thread, for comparison."));
+
+namespace FloorBoxSelection
+{
+    /** As far as a drop trace reaches */
+    constexpr float TraceDistance = 10000.f;
+
+    /** Occlusion traces are reused while the overlap's middle stays within the same cell of this many pixels */
+    constexpr int32 SampleCellPixels = 8;
+
+    /** Candidates per ParallelFor batch; one is only eight corner transforms */
+    constexpr int32 MinBatchSize = 128;
+
+    /**
+     * Screen rectangle of Bounds in ViewRect pixels. Bounds reaching behind the camera cover
+     * the whole view, since their projection is unbounded; false if they are entirely behind it.
+     */
+    bool ProjectBounds(const FBox& Bounds, const FMatrix& ViewProjection, const FIntRect& ViewRect, FBox2D& OutRect)
+    {
+        OutRect = FBox2D(ForceInit);
+        int32 NumBehind = 0;
+        for (int32 Corner = 0; Corner < 8; ++Corner)
+        {
+            const FVector Point((Corner & 1) ? Bounds.Max.X : Bounds.Min.X, (Corner & 2) ? Bounds.Max.Y : Bounds.Min.Y, (Corner & 4) ? Bounds.Max.Z : Bounds.Min.Z);
+            const FVector4 Clip = ViewProjection.TransformFVector4(FVector4(Point, 1.0));
+            if (Clip.W <= UE_KINDA_SMALL_NUMBER)
+            {
+                ++NumBehind;
+                continue;
+            }
+            const double InvW = 1.0 / Clip.W;
+            OutRect += FVector2D(
+                ViewRect.Min.X + (0.5 + Clip.X * InvW * 0.5) * ViewRect.Width(),
+                ViewRect.Min.Y + (0.5 - Clip.Y * InvW * 0.5) * ViewRect.Height());
+        }
+
+        if (NumBehind == 8)
+        {
+            return false;
+        }
+        if (NumBehind > 0)
+        {
+            OutRect = FBox2D(FVector2D(ViewRect.Min), FVector2D(ViewRect.Max));
+        }
+        return true;
+    }
+}
+
+bool FFloorSelectionView::FromPlayer(const APlayerController* PC, FFloorSelectionView& Out)
+{
+    const ULocalPlayer* LocalPlayer = PC ? PC->GetLocalPlayer() : nullptr;
+    if (!LocalPlayer || !LocalPlayer->ViewportClient)
+    {
+        return false;
+    }
+
+    FSceneViewProjectionData ProjectionData;
+    if (!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData))
+    {
+        return false;
+    }
+    Out.ViewProjection = ProjectionData.ComputeViewProjectionMatrix();
+    Out.ViewRect = ProjectionData.GetConstrainedViewRect();
+    return true;
+}
+
+FFloorSelectionView FFloorSelectionView::MakePerspective(const FVector& Origin, const FRotator& Rotation, float FOVDegrees, FIntPoint Size)
+{
+    // Same setup as ULocalPlayer::GetProjectionData for a horizontal FOV
+    FSceneViewProjectionData ProjectionData;
+    ProjectionData.ViewOrigin = Origin;
+    ProjectionData.ViewRotationMatrix = FInverseRotationMatrix(Rotation) * FMatrix(
+        FPlane(0, 0, 1, 0),
+        FPlane(1, 0, 0, 0),
+        FPlane(0, 1, 0, 0),
+        FPlane(0, 0, 0, 1));
+    const float HalfFOV = FMath::DegreesToRadians(FOVDegrees) * 0.5f;
+    ProjectionData.ProjectionMatrix = FReversedZPerspectiveMatrix(HalfFOV, HalfFOV, 1.f, float(Size.X) / float(FMath::Max(Size.Y, 1)), GNearClippingPlane, GNearClippingPlane);
+    ProjectionData.SetViewRectangle(FIntRect(FIntPoint::ZeroValue, Size));
+
+    FFloorSelectionView View;
+    View.ViewProjection = ProjectionData.ComputeViewProjectionMatrix();
+    View.ViewRect = ProjectionData.GetConstrainedViewRect();
+    return View;
+}
+
+void FFloorBoxSelection::Begin(UWorld* InWorld, const AActor* InIgnoredActor)
+{
+    Clear();
+    World = InWorld;
+    IgnoredActor = InIgnoredActor;
+    bActive = InWorld != nullptr;
+    if (!InWorld)
+    {
+        return;
+    }
+
+    // Floors do not move while a marquee is drawn, so their bounds are read once
+    for (TActorIterator<AActor> It(InWorld); It; ++It)
+    {
+        if (!It->ActorHasTag(TEXT("floor")))
+        {
+            continue;
+        }
+        It->ForEachComponent<UStaticMeshComponent>(false, [this](UStaticMeshComponent* Component)
+        {
+            if (Component->IsRegistered() && Component->IsVisible())
+            {
+                FCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+                Candidate.Component = Component;
+                Candidate.Bounds = Component->Bounds.GetBox();
+            }
+        });
+    }
+}
+
+void FFloorBoxSelection::Update(const FFloorSelectionView& View, const FBox2D& InMarquee, bool bFinal)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_BoxSelect);
+    using namespace FloorBoxSelection;
+
+    UWorld* CurrentWorld = World.Get();
+    if (!bActive || !CurrentWorld)
+    {
+        return;
+    }
+    const double StartTime = FPlatformTime::Seconds();
+
+    const FBox2D Marquee(
+        FVector2D(FMath::Min(InMarquee.Min.X, InMarquee.Max.X), FMath::Min(InMarquee.Min.Y, InMarquee.Max.Y)),
+        FVector2D(FMath::Max(InMarquee.Min.X, InMarquee.Max.X), FMath::Max(InMarquee.Min.Y, InMarquee.Max.Y)));
+
+    // ── Projection cull on workers: bounds and view are plain data, no UObject is touched ──
+    const FMatrix ViewProjection = View.ViewProjection;
+    const FIntRect ViewRect = View.ViewRect;
+    ParallelFor(TEXT("FloorBoxSelection"), Candidates.Num(), MinBatchSize, [this, &ViewProjection, &ViewRect, &Marquee](int32 Index)
+    {
+        FCandidate& Candidate = Candidates[Index];
+        Candidate.bInMarquee = ProjectBounds(Candidate.Bounds, ViewProjection, ViewRect, Candidate.ScreenRect)
+            && Candidate.ScreenRect.Intersect(Marquee);
+    }, CVarBoxSelectParallel.GetValueOnGameThread() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+    Survivors.Reset();
+    for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+    {
+        if (Candidates[Index].bInMarquee)
+        {
+            Survivors.Add(Index);
+        }
+        else if (Candidates[Index].bSelected)
+        {
+            SetSelected(Candidates[Index], false);
+        }
+    }
+
+    // ── Occlusion refinement of the survivors, within the trace budget ──
+    const uint32 ViewHash = FCrc::MemCrc32(&ViewRect, sizeof(ViewRect), FCrc::MemCrc32(&ViewProjection, sizeof(ViewProjection)));
+    const FMatrix InvViewProjection = ViewProjection.Inverse();
+    const int32 MaxTraces = bFinal ? MAX_int32 : CVarBoxSelectMaxTraces.GetValueOnGameThread();
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(RoomVizBoxSelect), /*bTraceComplex*/ false, IgnoredActor.Get());
+
+    LastNumTraces = 0;
+    LastNumDeferred = 0;
+    for (int32 Index : Survivors)
+    {
+        FCandidate& Candidate = Candidates[Index];
+        UPrimitiveComponent* Component = Candidate.Component.Get();
+        if (!Component)
+        {
+            continue;
+        }
+
+        const FBox2D Overlap(
+            FVector2D(FMath::Max(Candidate.ScreenRect.Min.X, Marquee.Min.X), FMath::Max(Candidate.ScreenRect.Min.Y, Marquee.Min.Y)),
+            FVector2D(FMath::Min(Candidate.ScreenRect.Max.X, Marquee.Max.X), FMath::Min(Candidate.ScreenRect.Max.Y, Marquee.Max.Y)));
+        const FVector2D SamplePoint = Overlap.GetCenter();
+        const FIntPoint Sample(FMath::FloorToInt32(SamplePoint.X / SampleCellPixels), FMath::FloorToInt32(SamplePoint.Y / SampleCellPixels));
+
+        if (Candidate.TracedViewHash != ViewHash || Candidate.TracedSample != Sample)
+        {
+            if (LastNumTraces >= MaxTraces)
+            {
+                ++LastNumDeferred;
+                SetSelected(Candidate, Candidate.bVisible);
+                continue;
+            }
+
+            FVector RayOrigin, RayDirection;
+            FSceneView::DeprojectScreenToWorld(SamplePoint, ViewRect, InvViewProjection, RayOrigin, RayDirection);
+            FHitResult Hit;
+            Candidate.bVisible = CurrentWorld->LineTraceSingleByChannel(Hit, RayOrigin, RayOrigin + RayDirection * TraceDistance, ECC_Visibility, Params)
+                && Hit.GetComponent() == Component;
+            Candidate.TracedViewHash = ViewHash;
+            Candidate.TracedSample = Sample;
+            ++LastNumTraces;
+        }
+        SetSelected(Candidate, Candidate.bVisible);
+    }
+
+    const double Seconds = FPlatformTime::Seconds() - StartTime;
+    ++NumUpdates;
+    TotalUpdateSeconds += Seconds;
+    MaxUpdateSeconds = FMath::Max(MaxUpdateSeconds, Seconds);
+}
+
+void FFloorBoxSelection::Clear()
+{
+    for (FCandidate& Candidate : Candidates)
+    {
+        SetSelected(Candidate, false);
+    }
+    Candidates.Reset();
+    Survivors.Reset();
+    Selected.Reset();
+    bActive = false;
+}
+
+void FFloorBoxSelection::SetSelected(FCandidate& Candidate, bool bSelected)
+{
+    if (Candidate.bSelected == bSelected)
+    {
+        return;
+    }
+    Candidate.bSelected = bSelected;
+    UPrimitiveComponent* Component = Candidate.Component.Get();
+    if (bSelected)
+    {
+        Selected.Add(Component);
+    }
+    else
+    {
+        Selected.Remove(Component);
+    }
+    if (Component)
+    {
+        Component->SetRenderCustomDepth(bSelected);
+    }
+}
+
+TArray<UPrimitiveComponent*> FFloorBoxSelection::GetSelection() const
+{
+    TArray<UPrimitiveComponent*> Selection;
+    Selection.Reserve(Selected.Num());
+    for (const FCandidate& Candidate : Candidates)
+    {
+        UPrimitiveComponent* Component = Candidate.Component.Get();
+        if (Candidate.bSelected && Component)
+        {
+            Selection.Add(Component);
+        }
+    }
+    return Selection;
+}
+
+void FFloorBoxSelection::LogReport() const
+{
+    UE_LOG(LogRoomViz, Display, TEXT("Box select: %d of %d floors selected%s; %d updates, %.2f ms average, %.2f ms worst; last update %d traces, %d deferred"),
+        Selected.Num(), Candidates.Num(), bActive ? TEXT(" (marquee active)") : TEXT(""), NumUpdates,
+        NumUpdates ? TotalUpdateSeconds * 1000.0 / NumUpdates : 0.0, MaxUpdateSeconds * 1000.0, LastNumTraces, LastNumDeferred);
+}
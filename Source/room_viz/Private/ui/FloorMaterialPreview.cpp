@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ui/FloorMaterialPreview.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Components/MeshComponent.h"
+#include "Engine/Texture.h"
+#include "Engine/World.h"
+#include "dataclass/RoomVizTileSettings.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+namespace
+{
+    // Parameter names of M_BaseMaterial, built once so hover changes do no name lookups
+    const FName BaseColorParam(TEXT("BaseColor"));
+    const FName NormalParam(TEXT("Normal"));
+    const FName ORMParam(TEXT("ORM"));
+
+    UTexture* GetTexture(const UMaterialInterface* Material, FName Param)
+    {
+        UTexture* Texture = nullptr;
+        Material->GetTextureParameterValue(FHashedMaterialParameterInfo(Param), Texture);
+        return Texture;
+    }
+}
+
+void FFloorMaterialPreview::Initialize(UMaterialInterface* BaseMaterial, UObject* Outer)
+{
+    if (!BaseMaterial || Preview)
+    {
+        return;
+    }
+
+    LLM_SCOPE_BYTAG(RoomViz_MaterialInstances);
+
+    DefaultBaseColor = GetTexture(BaseMaterial, BaseColorParam);
+    bPBRMaps = URoomVizTileSettings::Get()->bTilePBRMaps;
+    if (bPBRMaps)
+    {
+        DefaultNormal = GetTexture(BaseMaterial, NormalParam);
+        DefaultORM = GetTexture(BaseMaterial, ORMParam);
+    }
+
+    // Every parameter gets its override slot now, so later updates only overwrite values
+    Preview = UMaterialInstanceDynamic::Create(BaseMaterial, Outer);
+    Preview->SetTextureParameterValue(BaseColorParam, DefaultBaseColor);
+    if (bPBRMaps)
+    {
+        Preview->SetTextureParameterValue(NormalParam, DefaultNormal);
+        Preview->SetTextureParameterValue(ORMParam, DefaultORM);
+    }
+}
+
+void FFloorMaterialPreview::SetSource(UMaterialInterface* Source)
+{
+    if (!Preview || !Source)
+    {
+        return;
+    }
+
+    UTexture* BaseColor = GetTexture(Source, BaseColorParam);
+    Preview->SetTextureParameterValue(BaseColorParam, BaseColor ? BaseColor : DefaultBaseColor.Get());
+    if (bPBRMaps)
+    {
+        UTexture* Normal = GetTexture(Source, NormalParam);
+        UTexture* ORM = GetTexture(Source, ORMParam);
+        Preview->SetTextureParameterValue(NormalParam, Normal ? Normal : DefaultNormal.Get());
+        Preview->SetTextureParameterValue(ORMParam, ORM ? ORM : DefaultORM.Get());
+    }
+}
+
+void FFloorMaterialPreview::SetTarget(UPrimitiveComponent* Component)
+{
+    UMeshComponent* Floor = Cast<UMeshComponent>(Component);
+    if (!Preview || Floor == Target.Get())
+    {
+        return;
+    }
+
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_PreviewSwap);
+    const double StartTime = FPlatformTime::Seconds();
+
+    // Restoring null clears the override rather than pinning the mesh's material as one. A floor
+    // something was dropped on meanwhile keeps the drop.
+    UMeshComponent* Previous = Target.Get();
+    if (Previous && Previous->GetMaterial(0) == Preview)
+    {
+        Previous->SetMaterial(0, TargetOverride);
+    }
+    Target = Floor;
+    TargetOverride = Floor && Floor->OverrideMaterials.IsValidIndex(0) ? Floor->OverrideMaterials[0].Get() : nullptr;
+    if (Floor)
+    {
+        Floor->SetMaterial(0, Preview);
+    }
+
+    const double Seconds = FPlatformTime::Seconds() - StartTime;
+    ++NumTransitions;
+    TotalTransitionSeconds += Seconds;
+    MaxTransitionSeconds = FMath::Max(MaxTransitionSeconds, Seconds);
+    bTransitionThisFrame = true;
+}
+
+void FFloorMaterialPreview::TickFrame()
+{
+    const double Now = FPlatformTime::Seconds();
+    const double FrameSeconds = LastFrameTime > 0.0 ? Now - LastFrameTime : 0.0;
+    LastFrameTime = Now;
+
+    if (FrameSeconds > 0.0 && bTransitionThisFrame)
+    {
+        ++NumTransitionFrames;
+        TotalTransitionFrameSeconds += FrameSeconds;
+        MaxTransitionFrameSeconds = FMath::Max(MaxTransitionFrameSeconds, FrameSeconds);
+    }
+    else if (FrameSeconds > 0.0 && bHoveringThisFrame)
+    {
+        ++NumHoverFrames;
+        TotalHoverFrameSeconds += FrameSeconds;
+    }
+    bTransitionThisFrame = false;
+    bHoveringThisFrame = Target.IsValid();
+}
+
+void FFloorMaterialPreview::LogReport() const
+{
+    UE_LOG(LogRoomViz, Display, TEXT("Floor preview: %d hover transitions, avg %.1f us, max %.1f us, previewing %s"),
+        NumTransitions, NumTransitions > 0 ? TotalTransitionSeconds * 1e6 / NumTransitions : 0.0, MaxTransitionSeconds * 1e6,
+        *GetNameSafe(Target.Get()));
+    UE_LOG(LogRoomViz, Display, TEXT("Floor preview frames: %d with a transition, avg %.2f ms, max %.2f ms; %d hovering without, avg %.2f ms"),
+        NumTransitionFrames, NumTransitionFrames > 0 ? TotalTransitionFrameSeconds * 1000.0 / NumTransitionFrames : 0.0, MaxTransitionFrameSeconds * 1000.0,
+        NumHoverFrames, NumHoverFrames > 0 ? TotalHoverFrameSeconds * 1000.0 / NumHoverFrames : 0.0);
+}
+
+void FFloorMaterialPreview::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    Collector.AddReferencedObject(Preview);
+    Collector.AddReferencedObject(DefaultBaseColor);
+    Collector.AddReferencedObject(DefaultNormal);
+    Collector.AddReferencedObject(DefaultORM);
+    Collector.AddReferencedObject(TargetOverride);
+}
@@ -0,0 +1,279 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ui/PalettePrefetcher.h"
+#include "dataclass/MaterialAPIManager.h"
+#include "HAL/IConsoleManager.h"
+#include "RoomVizMetrics.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+static TAutoConsoleVariable<bool> CVarPrefetchEnable(
+    TEXT("RoomViz.Prefetch.Enable"),
+    true,
+    TEXT("Build palette entries the user hovers or scrolls to ahead of the palette build, and prefetch their deferred PBR maps."));
+
+static TAutoConsoleVariable<float> CVarPrefetchHoverMs(
+    TEXT("RoomViz.Prefetch.HoverMs"),
+    150.f,
+    TEXT("How long the pointer has to rest on a palette entry before its maps are prefetched, in milliseconds."));
+
+static TAutoConsoleVariable<int32> CVarPrefetchMaxInFlight(
+    TEXT("RoomViz.Prefetch.MaxInFlight"),
+    2,
+    TEXT("Prefetches downloading at once. Lower on slow links so a drop's own fetch is not starved."));
+
+static const TCHAR* LexToString(EPalettePrefetchReason Reason)
+{
+    switch (Reason)
+    {
+    case EPalettePrefetchReason::Drag: return TEXT("drag");
+    case EPalettePrefetchReason::Hover: return TEXT("hover");
+    case EPalettePrefetchReason::Scroll: return TEXT("scroll");
+    default: return TEXT("?");
+    }
+}
+
+void FPalettePrefetcher::Reset()
+{
+    for (const TPair<FString, EPalettePrefetchReason>& Pair : InFlight)
+    {
+        if (AMaterialAPIManager* Mgr = Manager.Get())
+        {
+            Mgr->CancelPBRMaps(Pair.Key);
+        }
+    }
+    Queued.Reset();
+    InFlight.Reset();
+    Ready.Reset();
+    Dropped.Reset();
+    HoveredID.Reset();
+    bHoverRequested = false;
+    DraggedID.Reset();
+    ScrollTargets.Reset();
+    UpdateStats();
+}
+
+void FPalettePrefetcher::SetHovered(const FString& TileID, double Now)
+{
+    if (TileID != HoveredID)
+    {
+        HoveredID = TileID;
+        HoverStartTime = Now;
+        bHoverRequested = false;
+    }
+}
+
+void FPalettePrefetcher::OnDragStart(const FString& TileID)
+{
+    DraggedID = TileID;
+    Enqueue(TileID, EPalettePrefetchReason::Drag);
+}
+
+void FPalettePrefetcher::SetScrollTargets(const TArray<FString>& TileIDs)
+{
+    ScrollTargets = TSet<FString>(TileIDs);
+    for (const FString& TileID : TileIDs)
+    {
+        Enqueue(TileID, EPalettePrefetchReason::Scroll);
+    }
+}
+
+void FPalettePrefetcher::OnDrop(const FString& TileID)
+{
+    DraggedID.Reset();
+
+    const AMaterialAPIManager* Mgr = Manager.Get();
+    const FTileMaterialData* Tile = Mgr ? Mgr->ParsedTiles.FindByPredicate([&TileID](const FTileMaterialData& T) { return T.ID == TileID; }) : nullptr;
+    if (!Tile || !Tile->HasPBRMaps() || !Mgr->bDeferPBRMaps)
+    {
+        return;
+    }
+
+    ++NumDrops;
+    Dropped.Add(TileID);
+    if (Ready.Contains(TileID))
+    {
+        ++NumHits;
+        RoomVizMetrics::PrefetchHits.Add();
+    }
+    else
+    {
+        RoomVizMetrics::PrefetchMisses.Add();
+        NumLate += InFlight.Contains(TileID) ? 1 : 0;
+
+        // Missed: the dropped material gets its maps as soon as possible
+        Enqueue(TileID, EPalettePrefetchReason::Drag);
+    }
+    UpdateStats();
+}
+
+void FPalettePrefetcher::OnPBRMapsReady(const FString& TileID)
+{
+    if (InFlight.Remove(TileID))
+    {
+        Ready.Add(TileID);
+        UpdateStats();
+    }
+}
+
+void FPalettePrefetcher::Tick(double Now)
+{
+    AMaterialAPIManager* Mgr = Manager.Get();
+    if (!Mgr || !IsEnabled())
+    {
+        return;
+    }
+
+    if (!HoveredID.IsEmpty() && !bHoverRequested && (Now - HoverStartTime) * 1000.0 >= CVarPrefetchHoverMs.GetValueOnGameThread())
+    {
+        bHoverRequested = true;
+        Enqueue(HoveredID, EPalettePrefetchReason::Hover);
+    }
+
+    const int32 NumQueued = Queued.Num();
+    Queued.RemoveAll([this](const FRequest& Request) { return !IsWanted(Request.TileID, Request.Reason); });
+    NumCancelled += NumQueued - Queued.Num();
+
+    // Speculative work nobody wants anymore gives its slot to a newer request
+    const int32 MaxInFlight = FMath::Max(CVarPrefetchMaxInFlight.GetValueOnGameThread(), 1);
+    if (Queued.Num() > 0 && InFlight.Num() >= MaxInFlight)
+    {
+        TArray<FString> Stale;
+        for (const TPair<FString, EPalettePrefetchReason>& Pair : InFlight)
+        {
+            if (!IsWanted(Pair.Key, Pair.Value) && !Dropped.Contains(Pair.Key))
+            {
+                Stale.Add(Pair.Key);
+            }
+        }
+        for (int32 Index = 0; Index < Stale.Num() && InFlight.Num() + Queued.Num() > MaxInFlight; ++Index)
+        {
+            CancelInFlight(Stale[Index]);
+        }
+    }
+
+    while (Queued.Num() > 0 && InFlight.Num() < MaxInFlight)
+    {
+        const FRequest Request = Queued[0];
+        Queued.RemoveAt(0);
+
+        // Drags and misses get their textures ahead of other speculative work
+        const ERoomVizWorkPriority Priority = Request.Reason == EPalettePrefetchReason::Drag ? ERoomVizWorkPriority::Normal : ERoomVizWorkPriority::Low;
+        if (Mgr->RequestPBRMaps(Request.TileID, Priority))
+        {
+            InFlight.Add(Request.TileID, Request.Reason);
+            ++NumRequested[(int32)Request.Reason];
+            UE_LOG(LogRoomVizHotPath, Verbose, TEXT("Prefetch %s (%s)"), *Request.TileID, LexToString(Request.Reason));
+        }
+    }
+    UpdateStats();
+}
+
+int64 FPalettePrefetcher::GetWastedBytes() const
+{
+    const AMaterialAPIManager* Mgr = Manager.Get();
+    if (!Mgr)
+    {
+        return 0;
+    }
+
+    int64 Wasted = Mgr->GetDiscardedPBRBytes();
+    for (const FString& TileID : Ready)
+    {
+        if (!Dropped.Contains(TileID))
+        {
+            Wasted += Mgr->GetPBRMapBytes(TileID);
+        }
+    }
+    return Wasted;
+}
+
+void FPalettePrefetcher::LogReport() const
+{
+    UE_LOG(LogRoomViz, Display, TEXT("Prefetch: %d palette entries built early; PBR maps: %d drag, %d hover, %d scroll requests, %d cancelled, %d in flight, %d ready"),
+        NumEntriesPrefetched, NumRequested[(int32)EPalettePrefetchReason::Drag], NumRequested[(int32)EPalettePrefetchReason::Hover],
+        NumRequested[(int32)EPalettePrefetchReason::Scroll], NumCancelled, InFlight.Num(), Ready.Num());
+    UE_LOG(LogRoomViz, Display, TEXT("Prefetch: %d drops, %d hits (%.0f%%), %d still in flight, %.2f MB wasted"),
+        NumDrops, NumHits, GetHitRate() * 100.f, NumLate, GetWastedBytes() / (1024.0 * 1024.0));
+}
+
+bool FPalettePrefetcher::IsEnabled() const
+{
+    return Manager.IsValid() && CVarPrefetchEnable.GetValueOnGameThread();
+}
+
+bool FPalettePrefetcher::IsWanted(const FString& TileID, EPalettePrefetchReason Reason) const
+{
+    switch (Reason)
+    {
+    case EPalettePrefetchReason::Drag: return TileID == DraggedID || Dropped.Contains(TileID);
+    case EPalettePrefetchReason::Hover: return TileID == HoveredID;
+    case EPalettePrefetchReason::Scroll: return ScrollTargets.Contains(TileID);
+    default: return false;
+    }
+}
+
+void FPalettePrefetcher::Enqueue(const FString& TileID, EPalettePrefetchReason Reason)
+{
+    if (TileID.IsEmpty() || !IsEnabled())
+    {
+        return;
+    }
+
+    // Material instance and thumbnail first: cheap, queued on the manager's work queue, and what
+    // every configuration is waiting for
+    if (PrefetchEntry && PrefetchEntry(TileID))
+    {
+        ++NumEntriesPrefetched;
+    }
+    if (!Manager->bDeferPBRMaps || Ready.Contains(TileID))
+    {
+        return;
+    }
+
+    // Already running: a drag only raises the priority of its texture creation
+    if (EPalettePrefetchReason* Running = InFlight.Find(TileID))
+    {
+        if (Reason < *Running)
+        {
+            *Running = Reason;
+            Manager->RequestPBRMaps(TileID, ERoomVizWorkPriority::Normal);
+        }
+        return;
+    }
+
+    const int32 Existing = Queued.IndexOfByPredicate([&TileID](const FRequest& Request) { return Request.TileID == TileID; });
+    if (Existing != INDEX_NONE)
+    {
+        if (Queued[Existing].Reason <= Reason)
+        {
+            return;
+        }
+        Queued.RemoveAt(Existing);
+    }
+
+    // Behind requests at least as urgent, so equal ones keep their order
+    int32 Insert = 0;
+    while (Insert < Queued.Num() && Queued[Insert].Reason <= Reason)
+    {
+        ++Insert;
+    }
+    Queued.Insert(FRequest{ TileID, Reason }, Insert);
+}
+
+void FPalettePrefetcher::CancelInFlight(const FString& TileID)
+{
+    if (AMaterialAPIManager* Mgr = Manager.Get())
+    {
+        Mgr->CancelPBRMaps(TileID);
+    }
+    InFlight.Remove(TileID);
+    ++NumCancelled;
+}
+
+void FPalettePrefetcher::UpdateStats() const
+{
+    SET_DWORD_STAT(STAT_RoomViz_PrefetchesInFlight, InFlight.Num());
+    SET_FLOAT_STAT(STAT_RoomViz_PrefetchHitRate, GetHitRate() * 100.f);
+    SET_MEMORY_STAT(STAT_RoomViz_PrefetchWastedBytes, GetWastedBytes());
+}
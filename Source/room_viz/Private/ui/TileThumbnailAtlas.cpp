@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ui/TileThumbnailAtlas.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "CanvasTypes.h"
+#include "RHI.h"
+#include "Misc/App.h"
+#include "RoomVizStats.h"
+
+//////////////////////////////////////////////////////////////////////////
+// FShelfPacker
+
+bool FShelfPacker::Allocate(int32 Width, int32 Height, FIntRect& OutRect)
+{
+    if (Width > PageSize || Height > PageSize)
+    {
+        return false;
+    }
+
+    // Best-fitting shelf first, so small rects don't eat tall shelves
+    FShelf* BestShelf = nullptr;
+    for (FShelf& Shelf : Shelves)
+    {
+        if (Shelf.Height < Height || Shelf.Height > Height * 2)
+        {
+            continue;
+        }
+
+        for (int32 Index = 0; Index < Shelf.FreeRects.Num(); ++Index)
+        {
+            const FIntRect Free = Shelf.FreeRects[Index];
+            if (Free.Width() >= Width)
+            {
+                OutRect = FIntRect(Free.Min, Free.Min + FIntPoint(Width, Height));
+                Shelf.FreeRects.RemoveAtSwap(Index);
+                if (Free.Width() > Width)
+                {
+                    Shelf.FreeRects.Add(FIntRect(Free.Min.X + Width, Free.Min.Y, Free.Max.X, Free.Max.Y));
+                }
+                UsedArea += Width * Height;
+                return true;
+            }
+        }
+
+        if (Shelf.UsedWidth + Width <= PageSize && (!BestShelf || Shelf.Height < BestShelf->Height))
+        {
+            BestShelf = &Shelf;
+        }
+    }
+
+    if (!BestShelf)
+    {
+        if (NextShelfY + Height > PageSize)
+        {
+            return false;
+        }
+        BestShelf = &Shelves.AddDefaulted_GetRef();
+        BestShelf->Y = NextShelfY;
+        BestShelf->Height = Height;
+        NextShelfY += Height;
+    }
+
+    OutRect = FIntRect(BestShelf->UsedWidth, BestShelf->Y, BestShelf->UsedWidth + Width, BestShelf->Y + Height);
+    BestShelf->UsedWidth += Width;
+    UsedArea += Width * Height;
+    return true;
+}
+
+void FShelfPacker::Free(const FIntRect& Rect)
+{
+    for (FShelf& Shelf : Shelves)
+    {
+        if (Shelf.Y == Rect.Min.Y)
+        {
+            // Hand the full shelf height back, whatever the rect's own height was
+            Shelf.FreeRects.Add(FIntRect(Rect.Min.X, Shelf.Y, Rect.Max.X, Shelf.Y + Shelf.Height));
+            UsedArea -= Rect.Area();
+            return;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FTileThumbnailAtlas
+
+FTileThumbnailAtlas::FTileThumbnailAtlas(int32 InPageSize, int32 InThumbnailSize)
+    : PageSize(InPageSize)
+    , ThumbnailSize(FMath::Min(InThumbnailSize, InPageSize))
+{
+}
+
+bool FTileThumbnailAtlas::GetBrush(UTexture2D* Texture, FSlateBrush& OutBrush)
+{
+    if (!Texture || !FApp::CanEverRender())
+    {
+        return false;
+    }
+
+    if (const FSlot* Existing = Slots.Find(Texture))
+    {
+        OutBrush = MakeBrush(*Existing);
+        return true;
+    }
+
+    FSlot Slot;
+    for (int32 PageIndex = 0; PageIndex < Pages.Num() && Slot.Page == INDEX_NONE; ++PageIndex)
+    {
+        if (Pages[PageIndex].Packer.Allocate(ThumbnailSize, ThumbnailSize, Slot.Rect))
+        {
+            Slot.Page = PageIndex;
+        }
+    }
+    if (Slot.Page == INDEX_NONE)
+    {
+        const int32 PageIndex = AddPage();
+        if (!Pages[PageIndex].Packer.Allocate(ThumbnailSize, ThumbnailSize, Slot.Rect))
+        {
+            return false;
+        }
+        Slot.Page = PageIndex;
+    }
+
+    Slots.Add(Texture, Slot);
+    PendingDraws.Add(Texture);
+    OutBrush = MakeBrush(Slot);
+    return true;
+}
+
+void FTileThumbnailAtlas::Remove(UTexture2D* Texture)
+{
+    FSlot Slot;
+    if (Slots.RemoveAndCopyValue(Texture, Slot))
+    {
+        Pages[Slot.Page].Packer.Free(Slot.Rect);
+    }
+}
+
+void FTileThumbnailAtlas::RemoveAllExcept(const TSet<UTexture2D*>& Keep)
+{
+    for (auto It = Slots.CreateIterator(); It; ++It)
+    {
+        UTexture2D* Texture = It.Key().ResolveObjectPtr();
+        if (!Texture || !Keep.Contains(Texture))
+        {
+            Pages[It.Value().Page].Packer.Free(It.Value().Rect);
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void FTileThumbnailAtlas::Flush(TArray<UTexture2D*>* OutDrawn)
+{
+    if (PendingDraws.Num() == 0)
+    {
+        return;
+    }
+
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_PaletteBuild);
+
+    TArray<TWeakObjectPtr<UTexture2D>> StillPending;
+    for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+    {
+        FTextureRenderTargetResource* Target = Pages[PageIndex].RenderTarget->GameThread_GetRenderTargetResource();
+
+        TOptional<FCanvas> Canvas;
+        for (const TWeakObjectPtr<UTexture2D>& WeakTexture : PendingDraws)
+        {
+            UTexture2D* Texture = WeakTexture.Get();
+            const FSlot* Slot = Texture ? Slots.Find(Texture) : nullptr;
+            if (!Slot || Slot->Page != PageIndex)
+            {
+                continue;
+            }
+            if (!Target || !Texture->GetResource())
+            {
+                StillPending.Add(Texture);
+                continue;
+            }
+
+            // Scratch passes go to the render thread ahead of the page's canvas, which flushes last
+            FTexture* Source = Downsample(Texture);
+            if (!Canvas.IsSet())
+            {
+                Canvas.Emplace(Target, nullptr, FGameTime(), GMaxRHIFeatureLevel);
+            }
+            const FIntRect& Rect = Slot->Rect;
+            Canvas->DrawTile(Rect.Min.X, Rect.Min.Y, Rect.Width(), Rect.Height(), 0.f, 0.f, 1.f, 1.f,
+                FLinearColor::White, Source, SE_BLEND_Opaque);
+            if (Source != Texture->GetResource())
+            {
+                // The next downsample reuses the scratch targets
+                Canvas->Flush_GameThread();
+            }
+            if (OutDrawn)
+            {
+                OutDrawn->Add(Texture);
+            }
+        }
+
+        if (Canvas.IsSet())
+        {
+            Canvas->Flush_GameThread();
+        }
+    }
+    PendingDraws = MoveTemp(StillPending);
+}
+
+FTexture* FTileThumbnailAtlas::Downsample(UTexture2D* Texture)
+{
+    FTexture* Source = Texture->GetResource();
+    const int32 SourceSize = FMath::Max(Texture->GetSizeX(), Texture->GetSizeY());
+    if (Texture->GetNumMips() > 1 || SourceSize <= ThumbnailSize * 2)
+    {
+        return Source;
+    }
+
+    // Largest power-of-two multiple of the thumbnail under the source; only this first pass can
+    // shrink by less than half, the rest halve exactly down to twice the thumbnail
+    int32 Level = 0;
+    while ((ThumbnailSize << (Level + 2)) < SourceSize)
+    {
+        ++Level;
+    }
+    for (; Level >= 0; --Level)
+    {
+        UTextureRenderTarget2D* Scratch = GetScratchTarget(Level);
+        FTextureRenderTargetResource* Target = Scratch ? Scratch->GameThread_GetRenderTargetResource() : nullptr;
+        if (!Target)
+        {
+            break;
+        }
+
+        const int32 Size = Scratch->SizeX;
+        FCanvas Canvas(Target, nullptr, FGameTime(), GMaxRHIFeatureLevel);
+        Canvas.DrawTile(0.f, 0.f, Size, Size, 0.f, 0.f, 1.f, 1.f, FLinearColor::White, Source, SE_BLEND_Opaque);
+        Canvas.Flush_GameThread();
+        Source = Target;
+    }
+    return Source;
+}
+
+UTextureRenderTarget2D* FTileThumbnailAtlas::GetScratchTarget(int32 Level)
+{
+    if (ScratchTargets.IsValidIndex(Level) && ScratchTargets[Level])
+    {
+        return ScratchTargets[Level];
+    }
+
+    LLM_SCOPE_BYTAG(RoomViz_PaletteWidgets);
+
+    const int32 Size = ThumbnailSize << (Level + 1);
+    UTextureRenderTarget2D* Scratch = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+    Scratch->ClearColor = FLinearColor::Transparent;
+    Scratch->Filter = TF_Bilinear;
+    Scratch->InitCustomFormat(Size, Size, PF_B8G8R8A8, /*bInForceLinearGamma*/ false);
+    Scratch->UpdateResourceImmediate(true);
+
+    if (ScratchTargets.Num() <= Level)
+    {
+        ScratchTargets.SetNum(Level + 1);
+    }
+    ScratchTargets[Level] = Scratch;
+    return Scratch;
+}
+
+float FTileThumbnailAtlas::GetOccupancy() const
+{
+    int64 Used = 0;
+    for (const FPage& Page : Pages)
+    {
+        Used += Page.Packer.GetUsedArea();
+    }
+    return Pages.Num() > 0 ? float(double(Used) / (double(PageSize) * PageSize * Pages.Num())) : 0.f;
+}
+
+void FTileThumbnailAtlas::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    for (FPage& Page : Pages)
+    {
+        Collector.AddReferencedObject(Page.RenderTarget);
+    }
+    Collector.AddReferencedObjects(ScratchTargets);
+}
+
+int32 FTileThumbnailAtlas::AddPage()
+{
+    LLM_SCOPE_BYTAG(RoomViz_PaletteWidgets);
+
+    UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+    RenderTarget->ClearColor = FLinearColor::Transparent;
+    RenderTarget->InitCustomFormat(PageSize, PageSize, PF_B8G8R8A8, /*bInForceLinearGamma*/ false);
+    RenderTarget->UpdateResourceImmediate(true);
+
+    const int32 PageIndex = Pages.Emplace(PageSize);
+    Pages[PageIndex].RenderTarget = RenderTarget;
+    return PageIndex;
+}
+
+FSlateBrush FTileThumbnailAtlas::MakeBrush(const FSlot& Slot) const
+{
+    FSlateBrush Brush;
+    Brush.SetResourceObject(Pages[Slot.Page].RenderTarget);
+    Brush.ImageSize = FVector2D(Slot.Rect.Width(), Slot.Rect.Height());
+    Brush.SetUVRegion(FBox2f(
+        FVector2f(Slot.Rect.Min) / float(PageSize),
+        FVector2f(Slot.Rect.Max) / float(PageSize)));
+    return Brush;
+}
@@ -2,16 +2,22 @@
 
 
 #include "ui/UIUserWidget.h"
+#include "tools/RoomVizInputRecording.h"
 #include "Components/ScrollBox.h"
 #include "Components/Image.h"
 #include "Components/TextBlock.h"
 #include "Components/Border.h"
 #include "Components/HorizontalBox.h"
 #include "Engine/Texture2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
 #include "Blueprint/WidgetBlueprintLibrary.h"
+#include "Blueprint/SlateBlueprintLibrary.h"
 #include "Components/VerticalBox.h"
 #include "Blueprint/UserWidget.h"
+#include "dataclass/AdaptiveQualitySubsystem.h"
 #include "dataclass/MaterialAPIManager.h"
+#include "dataclass/RoomDesignState.h"
+#include "dataclass/TileObjectPool.h"
 #include "Engine/World.h"
 #include "EngineUtils.h"
 #include "Blueprint/WidgetTree.h"
@@ -20,9 +26,328 @@
 #include "room_viz/room_vizCharacter.h" //  CHARACTER HEADER
 #include "Components/CanvasPanel.h"
 #include "Components/CanvasPanelSlot.h"
+#include "Components/InvalidationBox.h"
+#include "Framework/Application/SlateApplication.h"
 #include "Input/Reply.h"
 #include "Input/Events.h"
+#include "Rendering/DrawElements.h"
+#include "Styling/CoreStyle.h"
 #include "Engine/StaticMeshActor.h"
+#include "HAL/IConsoleManager.h"
+#include "RHI.h"
+#include "Misc/Parse.h"
+#include "UObject/UObjectIterator.h"
+#include "RoomVizMetrics.h"
+#include "RoomVizStats.h"
+#include "room_viz.h"
+
+static TAutoConsoleVariable<bool> CVarPaletteUseAtlas(
+    TEXT("RoomViz.Palette.UseAtlas"),
+    true,
+    TEXT("Draw palette thumbnails from shared atlas pages instead of one texture per entry. Applies on the next palette build."));
+
+static TAutoConsoleVariable<bool> CVarPaletteInvalidation(
+    TEXT("RoomViz.Palette.Invalidation"),
+    true,
+    TEXT("Wrap the palette in an invalidation box so an idle palette skips Slate prepass and paint; only changed entries repaint."));
+
+static TAutoConsoleVariable<float> CVarPrefetchScrollSettleSpeed(
+    TEXT("RoomViz.Prefetch.ScrollSettleSpeed"),
+    600.f,
+    TEXT("Palette scroll speed (slate units per second) under which the entries coming into view are prefetched. Faster scrolling cancels them."));
+
+static TAutoConsoleVariable<float> CVarPrefetchScrollLookahead(
+    TEXT("RoomViz.Prefetch.ScrollLookahead"),
+    0.3f,
+    TEXT("How far ahead of the settling palette scroll to prefetch, in seconds of the current scroll velocity."));
+
+static FAutoConsoleCommand CmdPrefetchReport(
+    TEXT("RoomViz.Prefetch.Report"),
+    TEXT("Log palette prefetch requests, hit rate on drops and bytes fetched for nothing."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        for (TObjectIterator<UUIUserWidget> It; It; ++It)
+        {
+            if (!It->IsTemplate())
+            {
+                It->Prefetcher.LogReport();
+            }
+        }
+    }));
+
+static TAutoConsoleVariable<bool> CVarFloorPreview(
+    TEXT("RoomViz.Preview.Enable"),
+    true,
+    TEXT("While dragging a tile, show it on the hovered floor until the cursor leaves or the tile is dropped."));
+
+static FAutoConsoleCommand CmdFloorPreviewReport(
+    TEXT("RoomViz.Preview.Report"),
+    TEXT("Log the number and game-thread cost of floor preview hover transitions. 'stat RoomViz' shows them as Preview Swap."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        for (TObjectIterator<UUIUserWidget> It; It; ++It)
+        {
+            if (!It->IsTemplate())
+            {
+                It->FloorPreview.LogReport();
+            }
+        }
+    }));
+
+static FAutoConsoleCommand CmdBoxSelectReport(
+    TEXT("RoomViz.BoxSelect.Report"),
+    TEXT("Log the floors selected by the Shift-drag marquee and the game-thread cost of its updates. 'stat RoomViz' shows them as Box Select."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        for (TObjectIterator<UUIUserWidget> It; It; ++It)
+        {
+            if (!It->IsTemplate())
+            {
+                It->BoxSelection.LogReport();
+            }
+        }
+    }));
+
+static FAutoConsoleCommand CmdPaletteReport(
+    TEXT("RoomViz.Palette.Report"),
+    TEXT("Log palette entries, distinct thumbnail textures and atlas occupancy. Compare with 'stat Slate' batch counts."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        for (TObjectIterator<UUIUserWidget> It; It; ++It)
+        {
+            if (!It->IsTemplate())
+            {
+                It->LogPaletteReport();
+            }
+        }
+    }));
+
+namespace
+{
+    /**
+     * Analysis placeholders share one sheet texture. Each cell is the placeholder plus a border
+     * repeating its edge texels, so bilinear filtering blurs it over the thumbnail without
+     * reaching into the neighbouring cells.
+     */
+    constexpr int32 PlaceholderCellSize = TileImageAnalysis::PlaceholderSize + 2;
+    constexpr int32 PlaceholderSheetColumns = 32;
+    constexpr int32 PlaceholderSheetWidth = PlaceholderCellSize * PlaceholderSheetColumns;
+
+    bool HasPlaceholder(const FTileImageAnalysis& Analysis)
+    {
+        return Analysis.IsValid() && Analysis.Placeholder.Num() == FMath::Square(TileImageAnalysis::PlaceholderSize);
+    }
+
+    void WritePlaceholderCell(TArray<FColor>& Texels, int32 Cell, const FTileImageAnalysis& Analysis)
+    {
+        using namespace TileImageAnalysis;
+
+        const int32 CellX = (Cell % PlaceholderSheetColumns) * PlaceholderCellSize;
+        const int32 CellY = (Cell / PlaceholderSheetColumns) * PlaceholderCellSize;
+        if (Texels.Num() < (CellY + PlaceholderCellSize) * PlaceholderSheetWidth)
+        {
+            Texels.SetNumZeroed((CellY + PlaceholderCellSize) * PlaceholderSheetWidth);
+        }
+        for (int32 Y = 0; Y < PlaceholderCellSize; ++Y)
+        {
+            const int32 SourceY = FMath::Clamp(Y - 1, 0, PlaceholderSize - 1);
+            for (int32 X = 0; X < PlaceholderCellSize; ++X)
+            {
+                const int32 SourceX = FMath::Clamp(X - 1, 0, PlaceholderSize - 1);
+                Texels[(CellY + Y) * PlaceholderSheetWidth + CellX + X] = Analysis.Placeholder[SourceY * PlaceholderSize + SourceX];
+            }
+        }
+    }
+
+    UImage* GetEntryImage(const UBorder* Entry)
+    {
+        const UHorizontalBox* HBox = IsValid(Entry) ? Cast<UHorizontalBox>(Entry->GetContent()) : nullptr;
+        return HBox ? Cast<UImage>(HBox->GetChildAt(0)) : nullptr;
+    }
+
+    /**
+     * Slate's game-thread time per frame (platform tick, prepass and paint of every window) and
+     * the RHI draw calls of the frame, with palette invalidation off then on, or with the
+     * thumbnail atlas off then on (Compare=Atlas). Keep the mouse still while it runs.
+     */
+    struct FPaletteSlateProfile
+    {
+        static constexpr int32 WarmupFrames = 10;
+
+        TWeakObjectPtr<UUIUserWidget> Widget;
+        TArray<FFloorMaterialData> RestoreEntries;
+        TArray<FFloorMaterialData> Entries;
+        bool bSavedInvalidation = true;
+        bool bCompareAtlas = false;
+        bool bSavedAtlas = true;
+        int32 NumEntries = 0;
+        int32 NumFrames = 0;
+        int32 Pass = 0;
+        int32 Frame = 0;
+        double TickStart = 0.0;
+        TArray<double> Samples;
+        int64 TotalDrawCalls = 0;
+        FDelegateHandle PreTickHandle;
+        FDelegateHandle PostTickHandle;
+    };
+
+    TUniquePtr<FPaletteSlateProfile> GPaletteSlateProfile;
+
+    void SetPaletteInvalidation(bool bEnabled)
+    {
+        IConsoleManager::Get().FindConsoleVariable(TEXT("RoomViz.Palette.Invalidation"))->Set(bEnabled, ECVF_SetByCode);
+    }
+
+    /** Rebuild the profiled palette with the atlas on or off; entries pick their brushes when created */
+    void SetPaletteAtlas(FPaletteSlateProfile& Profile, bool bEnabled)
+    {
+        IConsoleManager::Get().FindConsoleVariable(TEXT("RoomViz.Palette.UseAtlas"))->Set(bEnabled, ECVF_SetByCode);
+        if (UUIUserWidget* Widget = Profile.Widget.Get())
+        {
+            Widget->InitializeMaterials(Profile.Entries);
+        }
+    }
+
+    void FinishPaletteSlateProfile()
+    {
+        FPaletteSlateProfile& Profile = *GPaletteSlateProfile;
+        FSlateApplication::Get().OnPreTick().Remove(Profile.PreTickHandle);
+        FSlateApplication::Get().OnPostTick().Remove(Profile.PostTickHandle);
+
+        SetPaletteInvalidation(Profile.bSavedInvalidation);
+        IConsoleManager::Get().FindConsoleVariable(TEXT("RoomViz.Palette.UseAtlas"))->Set(Profile.bSavedAtlas, ECVF_SetByCode);
+        if (UUIUserWidget* Widget = Profile.Widget.Get())
+        {
+            Widget->InitializeMaterials(Profile.RestoreEntries);
+        }
+        GPaletteSlateProfile.Reset();
+    }
+
+    void OnPaletteProfilePostTick(float)
+    {
+        FPaletteSlateProfile& Profile = *GPaletteSlateProfile;
+        if (!Profile.Widget.IsValid())
+        {
+            FinishPaletteSlateProfile();
+            return;
+        }
+
+        if (++Profile.Frame > FPaletteSlateProfile::WarmupFrames)
+        {
+            Profile.Samples.Add((FPlatformTime::Seconds() - Profile.TickStart) * 1000.0);
+            // The last frame the RHI finished, palette batches included
+            Profile.TotalDrawCalls += GNumDrawCallsRHI[0];
+        }
+        if (Profile.Samples.Num() < Profile.NumFrames)
+        {
+            return;
+        }
+
+        Profile.Samples.Sort();
+        double Total = 0.0;
+        for (double Ms : Profile.Samples)
+        {
+            Total += Ms;
+        }
+        UE_LOG(LogRoomViz, Display, TEXT("Palette Slate profile, %d entries, %s %s: %d frames, avg %.3f ms, median %.3f ms, p95 %.3f ms, avg %.1f RHI draw calls, %d thumbnail textures"),
+            Profile.NumEntries, Profile.bCompareAtlas ? TEXT("atlas") : TEXT("invalidation"), Profile.Pass == 0 ? TEXT("off") : TEXT("on"),
+            Profile.Samples.Num(), Total / Profile.Samples.Num(),
+            Profile.Samples[Profile.Samples.Num() / 2], Profile.Samples[FMath::Min(Profile.Samples.Num() * 95 / 100, Profile.Samples.Num() - 1)],
+            double(Profile.TotalDrawCalls) / Profile.Samples.Num(), Profile.Widget->GetNumThumbnailTextures());
+
+        Profile.Samples.Reset();
+        Profile.TotalDrawCalls = 0;
+        Profile.Frame = 0;
+        if (++Profile.Pass > 1)
+        {
+            FinishPaletteSlateProfile();
+            return;
+        }
+        if (Profile.bCompareAtlas)
+        {
+            SetPaletteAtlas(Profile, true);
+        }
+        else
+        {
+            SetPaletteInvalidation(true);
+        }
+    }
+}
+
+static FAutoConsoleCommand CmdPaletteProfile(
+    TEXT("RoomViz.Palette.Profile"),
+    TEXT("RoomViz.Palette.Profile [Entries=1000] [Frames=300] [Compare=Invalidation|Atlas]: fill the palette with Entries entries (repeating the current ones) and log Slate's per-frame cost and the RHI draw calls with invalidation, or the thumbnail atlas, off then on. The palette is restored afterwards."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        if (GPaletteSlateProfile || !FSlateApplication::IsInitialized())
+        {
+            return;
+        }
+
+        UUIUserWidget* Widget = nullptr;
+        for (TObjectIterator<UUIUserWidget> It; It; ++It)
+        {
+            if (!It->IsTemplate() && It->IsInViewport())
+            {
+                Widget = *It;
+                break;
+            }
+        }
+        if (!Widget)
+        {
+            UE_LOG(LogRoomViz, Warning, TEXT("RoomViz.Palette.Profile: no palette widget in the viewport"));
+            return;
+        }
+
+        int32 NumEntries = 1000;
+        int32 NumFrames = 300;
+        FString Compare;
+        for (const FString& Arg : Args)
+        {
+            FParse::Value(*Arg, TEXT("Entries="), NumEntries);
+            FParse::Value(*Arg, TEXT("Frames="), NumFrames);
+            FParse::Value(*Arg, TEXT("Compare="), Compare);
+        }
+
+        GPaletteSlateProfile = MakeUnique<FPaletteSlateProfile>();
+        FPaletteSlateProfile& Profile = *GPaletteSlateProfile;
+        Profile.Widget = Widget;
+        Profile.NumFrames = FMath::Max(NumFrames, 1);
+        Profile.bSavedInvalidation = CVarPaletteInvalidation.GetValueOnGameThread();
+        Profile.bSavedAtlas = CVarPaletteUseAtlas.GetValueOnGameThread();
+        Profile.bCompareAtlas = Compare.Equals(TEXT("Atlas"), ESearchCase::IgnoreCase);
+        Widget->MaterialEntryMap.GenerateValueArray(Profile.RestoreEntries);
+
+        // Never fewer than the current entries, so their material instances stay referenced by the palette meanwhile
+        Profile.NumEntries = FMath::Max(NumEntries, FMath::Max(Profile.RestoreEntries.Num(), 1));
+
+        TArray<FFloorMaterialData>& Entries = Profile.Entries;
+        Entries.Reserve(Profile.NumEntries);
+        for (int32 Index = 0; Index < Profile.NumEntries; ++Index)
+        {
+            FFloorMaterialData Data;
+            if (Profile.RestoreEntries.Num() > 0)
+            {
+                Data = Profile.RestoreEntries[Index % Profile.RestoreEntries.Num()];
+            }
+            Data.Name = FString::Printf(TEXT("%s #%d"), *Data.Name, Index);
+            Entries.Add(Data);
+        }
+        if (Profile.bCompareAtlas)
+        {
+            SetPaletteAtlas(Profile, false);
+        }
+        else
+        {
+            Widget->InitializeMaterials(Entries);
+            SetPaletteInvalidation(false);
+        }
+        Profile.PreTickHandle = FSlateApplication::Get().OnPreTick().AddLambda([](float)
+        {
+            GPaletteSlateProfile->TickStart = FPlatformTime::Seconds();
+        });
+        Profile.PostTickHandle = FSlateApplication::Get().OnPostTick().AddStatic(&OnPaletteProfilePostTick);
+    }));
 
 
 
@@ -35,8 +360,9 @@ void UUIUserWidget::NativeConstruct()
     BaseMaterial = Cast<UMaterialInterface>(StaticLoadObject(UMaterialInterface::StaticClass(), nullptr, *MaterialPath));
     if (!BaseMaterial)
     {
-        UE_LOG(LogTemp, Error, TEXT("❌ Failed to load BaseMaterial from: %s"), *MaterialPath);
+        UE_LOG(LogRoomViz, Error, TEXT("Failed to load BaseMaterial from: %s"), *MaterialPath);
     }
+    FloorPreview.Initialize(BaseMaterial, this);
 
     // Make widget focusable and visible so it can receive drag/drop
     SetIsFocusable(true);
@@ -61,12 +387,7 @@ void UUIUserWidget::NativeConstruct()
     MaterialsScrollBox->SetIsEnabled(false);
 
     // Add it under the root canvas
-    if (UCanvasPanel* RootCanvas = Cast<UCanvasPanel>(WidgetTree->RootWidget))
-    {
-        UCanvasPanelSlot* ScrollSlot = RootCanvas->AddChildToCanvas(MaterialsScrollBox);
-        ScrollSlot->SetAnchors(FAnchors(0.f, 0.f, 1.f, 1.f));
-        ScrollSlot->SetOffsets(FMargin(0.f));
-    }
+    ApplyPaletteInvalidation();
 
     // Bind to the API manager to get our textures
     if (UWorld* World = GetWorld())
@@ -74,88 +395,835 @@ void UUIUserWidget::NativeConstruct()
         for (TActorIterator<AMaterialAPIManager> It(World); It; ++It)
         {
             AMaterialAPIManager* Mgr = *It;
+            MaterialManager = Mgr;
             Mgr->OnMaterialsReady.AddDynamic(this, &UUIUserWidget::HandleMaterialsReady);
+            Mgr->OnCatalogMerged.AddUObject(this, &UUIUserWidget::HandleCatalogMerged);
+            Mgr->OnTilePBRMapsReady.AddUObject(this, &UUIUserWidget::HandleTilePBRMapsReady);
+            Mgr->OnTileTextureReady.AddUObject(this, &UUIUserWidget::HandleTileTextureReady);
+            Mgr->OnTileEvicted.AddUObject(this, &UUIUserWidget::HandleTileEvicted);
+            Prefetcher.SetManager(Mgr);
+            Prefetcher.SetEntryPrefetch([this](const FString& TileID) { return PrefetchPaletteEntry(TileID); });
             Mgr->FetchTileMaterials();
             break;
         }
     }
-}
+}
+
+
+
+void UUIUserWidget::HandleMaterialsReady(const TArray<FTileMaterialData>& DownloadedTiles)
+{
+    if (!BaseMaterial)
+    {
+        UE_LOG(LogRoomViz, Error, TEXT("BaseMaterial is not set in UIUserWidget"));
+        return;
+    }
+
+    UE_LOG(LogRoomViz, Log, TEXT("HandleMaterialsReady: received %d tiles"), DownloadedTiles.Num());
+
+    // Entries trickle in through the frame-budgeted queue instead of one long frame
+    TSet<UTexture2D*> Shown;
+    for (const FTileMaterialData& T : DownloadedTiles)
+    {
+        Shown.Add(T.DownloadedTexture);
+    }
+    ResetPalette(Shown);
+    PendingPaletteTiles = DownloadedTiles;
+    PendingEntriesBuilt.Init(false, PendingPaletteTiles.Num());
+    NumPendingEntriesBuilt = 0;
+    for (int32 Index = 0; Index < PendingPaletteTiles.Num(); ++Index)
+    {
+        PendingPaletteIndex.Add(PendingPaletteTiles[Index].ID, Index);
+    }
+
+    const int32 Build = ++PaletteBuildSerial;
+    TWeakObjectPtr<UUIUserWidget> WeakThis(this);
+    for (int32 Index = 0; Index < PendingPaletteTiles.Num(); ++Index)
+    {
+        GetWorkQueue().Enqueue(ERoomVizWorkPriority::Low, [WeakThis, Build, Index]()
+        {
+            if (UUIUserWidget* Widget = WeakThis.Get())
+            {
+                Widget->BuildPendingEntry(Build, Index);
+            }
+        });
+    }
+}
+
+void UUIUserWidget::BuildPendingEntry(int32 Build, int32 Index)
+{
+    if (Build != PaletteBuildSerial || !PendingEntriesBuilt.IsValidIndex(Index) || PendingEntriesBuilt[Index])
+    {
+        return;
+    }
+    PendingEntriesBuilt[Index] = true;
+
+    AddPaletteEntry(MakeFloorMaterial(PendingPaletteTiles[Index], BaseMaterial, GetMaterialPool(), PaletteMaterials));
+    FinishPendingEntry();
+}
+
+void UUIUserWidget::FinishPendingEntry()
+{
+    if (++NumPendingEntriesBuilt == PendingPaletteTiles.Num())
+    {
+        PendingPaletteTiles.Empty();
+        PendingPaletteIndex.Empty();
+        PendingEntriesBuilt.Empty();
+        RemovePlaceholders();
+        GetMaterialPool()->Trim();
+    }
+}
+
+bool UUIUserWidget::PrefetchPaletteEntry(const FString& TileID)
+{
+    const int32* Index = PendingPaletteIndex.Find(TileID);
+    if (!Index || PendingEntriesBuilt[*Index])
+    {
+        return false;
+    }
+
+    GetWorkQueue().Enqueue(ERoomVizWorkPriority::Normal, [WeakThis = TWeakObjectPtr<UUIUserWidget>(this), Build = PaletteBuildSerial, Index = *Index]()
+    {
+        if (UUIUserWidget* Widget = WeakThis.Get())
+        {
+            Widget->BuildPendingEntry(Build, Index);
+        }
+    });
+    return true;
+}
+
+void UUIUserWidget::HandleCatalogMerged(const TArray<FTileMaterialData>& Tiles)
+{
+    // A palette already showing stays until the new catalog is ready
+    AMaterialAPIManager* Mgr = MaterialManager.Get();
+    if (!Mgr || MaterialEntryMap.Num() > 0 || PendingPaletteTiles.Num() > 0)
+    {
+        return;
+    }
+
+    LLM_SCOPE_BYTAG(RoomViz_PaletteWidgets);
+
+    // The same catalog again (its cached analyses arrived) keeps its placeholders and redraws
+    // their cells; a different one starts over
+    TSet<FString> TileIDs;
+    TileIDs.Reserve(Tiles.Num());
+    for (const FTileMaterialData& Tile : Tiles)
+    {
+        TileIDs.Add(Tile.ID);
+    }
+    for (const TPair<FString, int32>& Pair : PlaceholderCells)
+    {
+        if (!TileIDs.Contains(Pair.Key))
+        {
+            RemovePlaceholders();
+            ++PaletteBuildSerial;
+            break;
+        }
+    }
+
+    TArray<FString> NewTiles;
+    for (const FTileMaterialData& Tile : Tiles)
+    {
+        if (!HasPlaceholder(Tile.Analysis))
+        {
+            continue;
+        }
+        const int32* Cell = PlaceholderCells.Find(Tile.ID);
+        if (!Cell)
+        {
+            Cell = &PlaceholderCells.Add(Tile.ID, PlaceholderCells.Num());
+            NewTiles.Add(Tile.ID);
+        }
+        WritePlaceholderCell(PlaceholderTexels, *Cell, Tile.Analysis);
+    }
+    if (PlaceholderCells.Num() == 0 || !UpdatePlaceholderSheet())
+    {
+        return;
+    }
+
+    // Trickled in like the real entries, which then take these over in place
+    const int32 Build = PaletteBuildSerial;
+    TWeakObjectPtr<UUIUserWidget> WeakThis(this);
+    for (const FString& ID : NewTiles)
+    {
+        Mgr->GetWorkQueue().Enqueue(ERoomVizWorkPriority::Low, [WeakThis, Build, ID]()
+        {
+            UUIUserWidget* Widget = WeakThis.Get();
+            const int32* Cell = Widget ? Widget->PlaceholderCells.Find(ID) : nullptr;
+            if (!Cell || Build != Widget->PaletteBuildSerial || !Widget->MaterialsScrollBox || Widget->PlaceholderEntries.Contains(ID))
+            {
+                return;
+            }
+
+            ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_PaletteBuild);
+            LLM_SCOPE_BYTAG(RoomViz_PaletteWidgets);
+            FFloorMaterialData Data;
+            Data.Name = ID;
+            Data.PreviewTexture = nullptr;
+            Data.MaterialAsset = nullptr;
+            UBorder* Entry = Widget->CreateMaterialEntry(Data);
+            if (UImage* Img = GetEntryImage(Entry))
+            {
+                Widget->SetPlaceholderBrush(Img, *Cell);
+            }
+            Widget->MaterialsScrollBox->AddChild(Entry);
+            Widget->PlaceholderEntries.Add(ID, Entry);
+            Widget->PlaceholderTileIDs.Add(Entry, ID);
+        });
+    }
+}
+
+bool UUIUserWidget::UpdatePlaceholderSheet()
+{
+    const int32 Height = PlaceholderTexels.Num() / PlaceholderSheetWidth;
+    UTexture2D* OldSheet = PlaceholderSheet;
+    if (!PlaceholderSheet || PlaceholderSheet->GetSizeY() < Height)
+    {
+        UTexture2D* Sheet = GetMaterialPool()->CreateTexture(FIntPoint(PlaceholderSheetWidth, FMath::RoundUpToPowerOfTwo(Height)), PF_B8G8R8A8);
+        if (!Sheet)
+        {
+            return false;
+        }
+        Sheet->Filter = TF_Bilinear;
+        Sheet->AddressX = TA_Clamp;
+        Sheet->AddressY = TA_Clamp;
+        Sheet->SRGB = true;
+        GetMaterialPool()->AddRef(Sheet);
+        PlaceholderSheet = Sheet;
+    }
+
+    // FColor is laid out BGRA; rows below the last cell are never sampled
+    FTexture2DMipMap& Mip = PlaceholderSheet->GetPlatformData()->Mips[0];
+    FMemory::Memcpy(Mip.BulkData.Lock(LOCK_READ_WRITE), PlaceholderTexels.GetData(), PlaceholderTexels.Num() * sizeof(FColor));
+    Mip.BulkData.Unlock();
+    PlaceholderSheet->UpdateResource();
+
+    if (OldSheet && OldSheet != PlaceholderSheet)
+    {
+        // Placeholders still drawn from the old sheet move over; ones already showing their thumbnail stay
+        for (const TPair<FString, UBorder*>& Pair : PlaceholderEntries)
+        {
+            UImage* Img = GetEntryImage(Pair.Value);
+            const int32* Cell = PlaceholderCells.Find(Pair.Key);
+            if (Img && Cell && Img->GetBrush().GetResourceObject() == OldSheet)
+            {
+                SetPlaceholderBrush(Img, *Cell);
+            }
+        }
+        GetMaterialPool()->Release(OldSheet);
+    }
+    return true;
+}
+
+void UUIUserWidget::SetPlaceholderBrush(UImage* Img, int32 Cell) const
+{
+    const FVector2f SheetSize(PlaceholderSheet->GetSizeX(), PlaceholderSheet->GetSizeY());
+    const FVector2f Min((Cell % PlaceholderSheetColumns) * PlaceholderCellSize + 1, (Cell / PlaceholderSheetColumns) * PlaceholderCellSize + 1);
+
+    FSlateBrush Brush;
+    Brush.SetResourceObject(PlaceholderSheet);
+    Brush.ImageSize = Img->GetBrush().ImageSize;
+    Brush.SetUVRegion(FBox2f(Min / SheetSize, (Min + FVector2f(TileImageAnalysis::PlaceholderSize)) / SheetSize));
+    Img->SetBrush(Brush);
+}
+
+void UUIUserWidget::RemovePlaceholders()
+{
+    for (const TPair<FString, UBorder*>& Pair : PlaceholderEntries)
+    {
+        if (IsValid(Pair.Value))
+        {
+            Pair.Value->RemoveFromParent();
+        }
+    }
+    PlaceholderEntries.Empty();
+    PlaceholderTileIDs.Empty();
+    PlaceholderCells.Empty();
+    PlaceholderTexels.Empty();
+
+    // Trim takes the sheet once nothing else holds it
+    if (PlaceholderSheet)
+    {
+        GetMaterialPool()->Release(PlaceholderSheet);
+        PlaceholderSheet = nullptr;
+    }
+}
+
+void UUIUserWidget::BuildFloorMaterials(const TArray<FTileMaterialData>& Tiles, UMaterialInterface* InBaseMaterial, UTileObjectPool* Pool, TArray<FFloorMaterialData>& OutMaterials)
+{
+    OutMaterials.Reserve(OutMaterials.Num() + Tiles.Num());
+
+    FSharedFloorMaterials SharedMaterials;
+    for (const FTileMaterialData& T : Tiles)
+    {
+        OutMaterials.Add(MakeFloorMaterial(T, InBaseMaterial, Pool, SharedMaterials));
+    }
+}
+
+FFloorMaterialData UUIUserWidget::MakeFloorMaterial(const FTileMaterialData& T, UMaterialInterface* InBaseMaterial, UTileObjectPool* Pool, FSharedFloorMaterials& SharedMaterials)
+{
+    FFloorMaterialData D;
+    D.Name = T.ID;
+    D.PreviewTexture = T.DownloadedTexture;
+    D.MaterialURL = T.BaseColorURL;
+    D.MaterialAsset = nullptr;
+
+    // Tiles sharing deduplicated textures share their material instance too
+    const FFloorTextureSet TextureSet(T.DownloadedTexture, T.NormalTexture, T.ORMTexture);
+    const TObjectPtr<UMaterialInstanceDynamic>* Shared = SharedMaterials.Find(TextureSet);
+    if (Shared && *Shared)
+    {
+        D.MaterialAsset = *Shared;
+    }
+    else if (T.DownloadedTexture)
+    {
+        ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_MIDCreation);
+        LLM_SCOPE_BYTAG(RoomViz_MaterialInstances);
+
+        UMaterialInstanceDynamic* DynMat = Pool->CreateMaterial(InBaseMaterial);
+        DynMat->SetTextureParameterValue(FName("BaseColor"), T.DownloadedTexture);
+        if (T.NormalTexture)
+        {
+            DynMat->SetTextureParameterValue(FName("Normal"), T.NormalTexture);
+        }
+        if (T.ORMTexture)
+        {
+            DynMat->SetTextureParameterValue(FName("ORM"), T.ORMTexture);
+        }
+        D.MaterialAsset = DynMat;
+        SharedMaterials.Add(TextureSet, DynMat);
+
+        UE_LOG(LogRoomVizHotPath, Verbose, TEXT("Material created for: %s"), *T.ID);
+    }
+    else
+    {
+        UE_LOG(LogRoomViz, Warning, TEXT("Missing texture for %s"), *T.ID);
+    }
+
+    return D;
+}
+
+void UUIUserWidget::InitializeMaterials(const TArray<FFloorMaterialData>& Materials)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_PaletteBuild);
+
+    TSet<UTexture2D*> Shown;
+    for (const FFloorMaterialData& Data : Materials)
+    {
+        Shown.Add(Data.PreviewTexture);
+    }
+    ResetPalette(Shown);
+    ++PaletteBuildSerial;
+
+    for (const FFloorMaterialData& Data : Materials)
+    {
+        AddPaletteEntry(Data);
+    }
+    RemovePlaceholders();
+    GetMaterialPool()->Trim();
+}
+
+void UUIUserWidget::ReleasePaletteMaterial(UMaterialInterface* Material)
+{
+    if (GetMaterialPool()->Release(Material) && GetMaterialPool()->GetRefCount(Material) == 0)
+    {
+        for (auto It = PaletteMaterials.CreateIterator(); It; ++It)
+        {
+            if (It.Value().Get() == Material)
+            {
+                It.RemoveCurrent();
+            }
+        }
+    }
+}
+
+FFrameBudgetedWorkQueue& UUIUserWidget::GetWorkQueue()
+{
+    AMaterialAPIManager* Mgr = MaterialManager.Get();
+    return Mgr ? Mgr->GetWorkQueue() : LocalWorkQueue;
+}
+
+UTileObjectPool* UUIUserWidget::GetMaterialPool()
+{
+    if (!MaterialPool)
+    {
+        MaterialPool = NewObject<UTileObjectPool>(this, TEXT("PaletteMaterialPool"));
+    }
+    return MaterialPool;
+}
+
+void UUIUserWidget::ResetPalette(const TSet<UTexture2D*>& Shown)
+{
+    if (!MaterialsScrollBox)
+    {
+        MaterialsScrollBox = WidgetTree->ConstructWidget<UScrollBox>(UScrollBox::StaticClass());
+
+        // Only set the root if it's not already set
+        if (!WidgetTree->RootWidget)
+        {
+            UCanvasPanel* RootPanel = WidgetTree->ConstructWidget<UCanvasPanel>(UCanvasPanel::StaticClass());
+            WidgetTree->RootWidget = RootPanel;
+
+            RootPanel->SetVisibility(ESlateVisibility::Visible);
+            RootPanel->SetIsEnabled(true);
+        }
+        ApplyPaletteInvalidation();
+    }
+
+    // Placeholders stay for the entries of their tiles to take over
+    TArray<UWidget*> Placeholders;
+    if (PlaceholderEntries.Num() > 0)
+    {
+        TSet<UWidget*> PlaceholderSet;
+        for (const TPair<FString, UBorder*>& Pair : PlaceholderEntries)
+        {
+            PlaceholderSet.Add(Pair.Value);
+        }
+        Placeholders = MaterialsScrollBox->GetAllChildren().FilterByPredicate([&PlaceholderSet](UWidget* Child) { return PlaceholderSet.Contains(Child); });
+    }
+    MaterialsScrollBox->ClearChildren();
+    for (UWidget* Placeholder : Placeholders)
+    {
+        MaterialsScrollBox->AddChild(Placeholder);
+    }
+    for (const TPair<UBorder*, FFloorMaterialData>& Pair : MaterialEntryMap)
+    {
+        ReleasePaletteMaterial(Pair.Value.MaterialAsset);
+    }
+    MaterialEntryMap.Empty();
+    SelectedEntry = nullptr;
+    PaletteMaterials.Empty();
+    PendingPaletteTiles.Empty();
+    PendingPaletteIndex.Empty();
+    PendingEntriesBuilt.Empty();
+    NumPendingEntriesBuilt = 0;
+    HoveredChildIndex = INDEX_NONE;
+
+    // Regions of tiles that left the palette go back to the atlas
+    ThumbnailAtlas.RemoveAllExcept(Shown);
+
+    Prefetcher.Reset();
+    ScrollTargetsOffset = -1.f;
+}
+
+void UUIUserWidget::AddPaletteEntry(const FFloorMaterialData& Data)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_PaletteBuild);
+    LLM_SCOPE_BYTAG(RoomViz_PaletteWidgets);
+
+    // A placeholder of the tile becomes its entry, keeping its place; failed images keep the placeholder
+    UBorder* Entry = nullptr;
+    if (PlaceholderEntries.RemoveAndCopyValue(Data.Name, Entry) && PlaceholderTileIDs.Remove(Entry) && IsValid(Entry) && Entry->GetParent() == MaterialsScrollBox)
+    {
+        UImage* Img = GetEntryImage(Entry);
+        if (Img && Data.PreviewTexture)
+        {
+            SetEntryThumbnail(Img, Data.PreviewTexture);
+        }
+    }
+    else
+    {
+        Entry = Cast<UBorder>(CreateMaterialEntry(Data));
+        if (!Entry) return;
+
+        MaterialsScrollBox->AddChild(Entry);
+    }
+    MaterialEntryMap.Add(Entry, Data);
+    GetMaterialPool()->AddRef(Data.MaterialAsset);
+
+    // Shared floors assigned this tile before it reached the palette
+    if (ARoomDesignState* Design = ARoomDesignState::Get(GetWorld()))
+    {
+        Design->OnTileMaterialAvailable(Data.Name);
+    }
+}
+
+void UUIUserWidget::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+{
+    Super::NativeTick(MyGeometry, InDeltaTime);
+
+    if (CVarPaletteInvalidation.GetValueOnGameThread() != (PaletteInvalidationBox != nullptr))
+    {
+        ApplyPaletteInvalidation();
+    }
+
+    // Thumbnails whose texture had no GPU resource yet
+    TArray<UTexture2D*> Drawn;
+    ThumbnailAtlas.Flush(&Drawn);
+    if (Drawn.Num() > 0)
+    {
+        const TSet<UTexture2D*> DrawnSet(Drawn);
+        for (const TPair<UBorder*, FFloorMaterialData>& Pair : MaterialEntryMap)
+        {
+            if (DrawnSet.Contains(Pair.Value.PreviewTexture))
+            {
+                InvalidateEntry(Pair.Key);
+            }
+        }
+    }
+
+    // Palette work queued while no manager was bound; the manager drains its own queue
+    if (!LocalWorkQueue.IsEmpty())
+    {
+        LocalWorkQueue.Drain(AMaterialAPIManager::GetWorkBudgetSeconds());
+    }
+
+    UpdateScrollPrefetch(InDeltaTime);
+    Prefetcher.Tick(FPlatformTime::Seconds());
+    FloorPreview.TickFrame();
+
+    // Mouse moves can outpace frames; the marquee is re-selected once per frame at most, and
+    // until the traces the budget deferred have all run even if the mouse stopped
+    if (BoxSelection.IsActive() && (bMarqueeDirty || BoxSelection.GetLastNumDeferred() > 0))
+    {
+        UpdateMarquee();
+    }
+}
+
+void UUIUserWidget::UpdateScrollPrefetch(float DeltaTime)
+{
+    if (!MaterialsScrollBox || DeltaTime <= 0.f)
+    {
+        return;
+    }
+
+    const float Offset = MaterialsScrollBox->GetScrollOffset();
+    ScrollVelocity = FMath::Lerp(ScrollVelocity, (Offset - LastScrollOffset) / DeltaTime, 0.5f);
+    LastScrollOffset = Offset;
+
+    // Flicking past entries: whatever was targeted is stale
+    if (FMath::Abs(ScrollVelocity) > CVarPrefetchScrollSettleSpeed.GetValueOnGameThread())
+    {
+        if (ScrollTargetsOffset >= 0.f)
+        {
+            Prefetcher.SetScrollTargets(TArray<FString>());
+            ScrollTargetsOffset = -1.f;
+        }
+        return;
+    }
+
+    const int32 NumChildren = MaterialsScrollBox->GetChildrenCount();
+    if (FMath::IsNearlyEqual(Offset, ScrollTargetsOffset, 1.f) && NumChildren == ScrollTargetsChildren)
+    {
+        return;
+    }
+    ScrollTargetsOffset = Offset;
+    ScrollTargetsChildren = NumChildren;
+
+    // Entries in view where the scroll is heading, from desired sizes since entries out of view are not painted
+    const float ViewHeight = MaterialsScrollBox->GetCachedGeometry().GetLocalSize().Y;
+    float Y = -(Offset + ScrollVelocity * CVarPrefetchScrollLookahead.GetValueOnGameThread());
+    TArray<FString> Targets;
+    for (int32 Index = 0; Index < NumChildren && Y <= ViewHeight; ++Index)
+    {
+        UWidget* Child = MaterialsScrollBox->GetChildAt(Index);
+        const float Height = Child->GetDesiredSize().Y;
+        if (Y + Height >= 0.f)
+        {
+            const FString TileID = GetEntryTileID(Cast<UBorder>(Child));
+            if (!TileID.IsEmpty())
+            {
+                Targets.Add(TileID);
+            }
+        }
+        Y += Height;
+    }
+    Prefetcher.SetScrollTargets(Targets);
+}
+
+UBorder* UUIUserWidget::FindEntryAt(const FVector2D& ScreenPos) const
+{
+    for (const TPair<UBorder*, FFloorMaterialData>& Pair : MaterialEntryMap)
+    {
+        UBorder* Entry = Pair.Key;
+        if (IsValid(Entry) && Entry->GetCachedWidget().IsValid() && Entry->GetCachedGeometry().IsUnderLocation(ScreenPos))
+        {
+            return Entry;
+        }
+    }
+    return nullptr;
+}
+
+int32 UUIUserWidget::FindPaletteChildAt(const FVector2D& ScreenPos) const
+{
+    if (!MaterialsScrollBox || !MaterialsScrollBox->GetCachedWidget().IsValid()
+        || !MaterialsScrollBox->GetCachedGeometry().IsUnderLocation(ScreenPos))
+    {
+        return INDEX_NONE;
+    }
+
+    auto IsUnder = [this, &ScreenPos](int32 Index)
+    {
+        const UWidget* Child = MaterialsScrollBox->GetChildAt(Index);
+        return Child && Child->GetCachedWidget().IsValid() && Child->GetCachedGeometry().IsUnderLocation(ScreenPos);
+    };
+
+    // The pointer mostly stays on an entry or moves to the next one
+    const int32 NumChildren = MaterialsScrollBox->GetChildrenCount();
+    for (const int32 Offset : { 0, 1, -1 })
+    {
+        const int32 Index = HoveredChildIndex + Offset;
+        if (HoveredChildIndex != INDEX_NONE && Index >= 0 && Index < NumChildren && IsUnder(Index))
+        {
+            return Index;
+        }
+    }
+    for (int32 Index = 0; Index < NumChildren; ++Index)
+    {
+        if (IsUnder(Index))
+        {
+            return Index;
+        }
+    }
+    return INDEX_NONE;
+}
+
+FString UUIUserWidget::GetEntryTileID(UBorder* Entry) const
+{
+    if (const FFloorMaterialData* Data = MaterialEntryMap.Find(Entry))
+    {
+        return Data->Name;
+    }
+    return PlaceholderTileIDs.FindRef(Entry);
+}
+
+FReply UUIUserWidget::NativeOnMouseMove(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
+{
+    if (BoxSelection.IsActive())
+    {
+        MarqueeEnd = InMouseEvent.GetScreenSpacePosition();
+        bMarqueeDirty = true;
+        Invalidate(EInvalidateWidgetReason::Paint);
+        return FReply::Handled();
+    }
+
+    HoveredChildIndex = FindPaletteChildAt(InMouseEvent.GetScreenSpacePosition());
+    UBorder* Hovered = HoveredChildIndex != INDEX_NONE ? Cast<UBorder>(MaterialsScrollBox->GetChildAt(HoveredChildIndex)) : nullptr;
+    Prefetcher.SetHovered(GetEntryTileID(Hovered), FPlatformTime::Seconds());
+
+    return Super::NativeOnMouseMove(InGeometry, InMouseEvent);
+}
+
+void UUIUserWidget::NativeOnMouseLeave(const FPointerEvent& InMouseEvent)
+{
+    HoveredChildIndex = INDEX_NONE;
+    Prefetcher.SetHovered(FString(), FPlatformTime::Seconds());
+
+    Super::NativeOnMouseLeave(InMouseEvent);
+}
+
+void UUIUserWidget::HandleTileTextureReady(const FTileMaterialData& Tile)
+{
+    FSlateBrush Brush;
+    if (!Tile.DownloadedTexture || !CVarPaletteUseAtlas.GetValueOnGameThread() || !ThumbnailAtlas.GetBrush(Tile.DownloadedTexture, Brush))
+    {
+        return;
+    }
+
+    // The placeholder shows the real image before its entry is built; the entry takes the same region
+    UBorder* Placeholder = PlaceholderEntries.FindRef(Tile.ID);
+    if (UImage* Img = IsValid(Placeholder) ? GetEntryImage(Placeholder) : nullptr)
+    {
+        Brush.ImageSize = Img->GetBrush().ImageSize;
+        Img->SetBrush(Brush);
+    }
+}
+
+void UUIUserWidget::HandleTileEvicted(const FTileMaterialData& Tile)
+{
+    bool bTextureShown = false;
+    for (auto It = MaterialEntryMap.CreateIterator(); It; ++It)
+    {
+        if (It.Value().Name != Tile.ID)
+        {
+            bTextureShown |= It.Value().PreviewTexture == Tile.DownloadedTexture;
+            continue;
+        }
+        if (IsValid(It.Key()))
+        {
+            It.Key()->RemoveFromParent();
+        }
+        if (SelectedEntry == It.Key())
+        {
+            SelectedEntry = nullptr;
+        }
+        ReleasePaletteMaterial(It.Value().MaterialAsset);
+        It.RemoveCurrent();
+    }
+
+    UBorder* Placeholder = nullptr;
+    if (PlaceholderEntries.RemoveAndCopyValue(Tile.ID, Placeholder))
+    {
+        PlaceholderTileIDs.Remove(Placeholder);
+        if (IsValid(Placeholder))
+        {
+            Placeholder->RemoveFromParent();
+        }
+    }
+
+    // A tile still waiting in the trickled build is not built at all
+    if (const int32* Index = PendingPaletteIndex.Find(Tile.ID))
+    {
+        if (!PendingEntriesBuilt[*Index])
+        {
+            PendingEntriesBuilt[*Index] = true;
+            FinishPendingEntry();
+        }
+    }
+
+    if (!bTextureShown)
+    {
+        ThumbnailAtlas.Remove(Tile.DownloadedTexture);
+    }
+    HoveredChildIndex = INDEX_NONE;
+}
+
+void UUIUserWidget::HandleTilePBRMapsReady(const FTileMaterialData& Tile)
+{
+    Prefetcher.OnPBRMapsReady(Tile.ID);
+
+    bool bUpdatedInPlace = false;
+    for (TPair<UBorder*, FFloorMaterialData>& Pair : MaterialEntryMap)
+    {
+        if (Pair.Value.Name != Tile.ID)
+        {
+            continue;
+        }
+
+        // An instance of this entry alone takes the maps in place, so floors it was dropped on get them too
+        UMaterialInstanceDynamic* MID = Cast<UMaterialInstanceDynamic>(Pair.Value.MaterialAsset);
+        if (MID && GetMaterialPool()->GetRefCount(MID) == 1)
+        {
+            ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_MIDCreation);
+            if (Tile.NormalTexture)
+            {
+                MID->SetTextureParameterValue(FName("Normal"), Tile.NormalTexture);
+            }
+            if (Tile.ORMTexture)
+            {
+                MID->SetTextureParameterValue(FName("ORM"), Tile.ORMTexture);
+            }
+            bUpdatedInPlace = true;
+        }
+        else
+        {
+            UMaterialInterface* Material = MakeFloorMaterial(Tile, BaseMaterial, GetMaterialPool(), PaletteMaterials).MaterialAsset;
+            GetMaterialPool()->AddRef(Material);
+            ReleasePaletteMaterial(Pair.Value.MaterialAsset);
+            Pair.Value.MaterialAsset = Material;
+        }
+    }
+
+    // The instance is in the pool's cluster, which does not trace the maps it just took
+    if (bUpdatedInPlace)
+    {
+        GetMaterialPool()->Recluster();
+    }
+
+    // Shared floors showing this tile switch to the new instance
+    if (ARoomDesignState* Design = ARoomDesignState::Get(GetWorld()))
+    {
+        Design->OnTileMaterialAvailable(Tile.ID);
+    }
+}
+
+void UUIUserWidget::ApplyPaletteInvalidation()
+{
+    UCanvasPanel* RootCanvas = Cast<UCanvasPanel>(WidgetTree->RootWidget);
+    if (!MaterialsScrollBox || !RootCanvas)
+    {
+        return;
+    }
+
+    MaterialsScrollBox->RemoveFromParent();
+    if (PaletteInvalidationBox)
+    {
+        PaletteInvalidationBox->RemoveFromParent();
+        PaletteInvalidationBox = nullptr;
+    }
+
+    UWidget* PaletteRoot = MaterialsScrollBox;
+    if (CVarPaletteInvalidation.GetValueOnGameThread())
+    {
+        // Entries are cached once painted; only entries invalidated since repaint
+        PaletteInvalidationBox = WidgetTree->ConstructWidget<UInvalidationBox>(UInvalidationBox::StaticClass());
+        PaletteInvalidationBox->SetCanCache(true);
+        PaletteInvalidationBox->SetVisibility(ESlateVisibility::SelfHitTestInvisible);
+        PaletteInvalidationBox->SetContent(MaterialsScrollBox);
+        PaletteRoot = PaletteInvalidationBox;
+    }
 
+    UCanvasPanelSlot* ScrollSlot = RootCanvas->AddChildToCanvas(PaletteRoot);
+    ScrollSlot->SetAnchors(FAnchors(0.f, 0.f, 1.f, 1.f));
+    ScrollSlot->SetOffsets(FMargin(0.f));
+}
 
+void UUIUserWidget::InvalidateEntry(UBorder* Entry)
+{
+    // Paint only: the entry's size does not change, so the rest of the palette keeps its cached layout
+    if (IsValid(Entry) && Entry->GetCachedWidget().IsValid())
+    {
+        Entry->GetCachedWidget()->Invalidate(EInvalidateWidgetReason::Paint);
+    }
+}
 
-void UUIUserWidget::HandleMaterialsReady(const TArray<FTileMaterialData>& DownloadedTiles)
+void UUIUserWidget::SetSelectedEntry(UBorder* Entry)
 {
-    if (!BaseMaterial)
+    if (Entry == SelectedEntry)
     {
-        UE_LOG(LogTemp, Error, TEXT("❌ BaseMaterial is not set in UIUserWidget"));
         return;
     }
 
-    TArray<FFloorMaterialData> FinalTiles;
-
-    for (const FTileMaterialData& T : DownloadedTiles)
+    // SetBrushColor invalidates paint on that border alone
+    if (IsValid(SelectedEntry))
     {
-        FFloorMaterialData D;
-        D.Name = T.ID;
-        D.PreviewTexture = T.DownloadedTexture;
-        D.MaterialURL = T.BaseColorURL;
-
-        if (T.DownloadedTexture)
-        {
-            UMaterialInstanceDynamic* DynMat = UMaterialInstanceDynamic::Create(BaseMaterial, this);
-            DynMat->SetTextureParameterValue(FName("BaseColor"), T.DownloadedTexture);
-            D.MaterialAsset = DynMat;
+        SelectedEntry->SetBrushColor(FLinearColor::Gray);
+    }
+    SelectedEntry = Entry;
+    if (IsValid(SelectedEntry))
+    {
+        SelectedEntry->SetBrushColor(SelectedEntryColor);
+    }
+}
 
-            UE_LOG(LogTemp, Log, TEXT("✅ Material created for: %s"), *T.ID);
-        }
-        else
+int32 UUIUserWidget::GetNumThumbnailTextures() const
+{
+    TSet<const UObject*> Resources;
+    for (const TPair<UBorder*, FFloorMaterialData>& Pair : MaterialEntryMap)
+    {
+        const UHorizontalBox* HBox = IsValid(Pair.Key) ? Cast<UHorizontalBox>(Pair.Key->GetContent()) : nullptr;
+        const UImage* Img = HBox ? Cast<UImage>(HBox->GetChildAt(0)) : nullptr;
+        if (Img && Img->GetBrush().GetResourceObject())
         {
-            UE_LOG(LogTemp, Warning, TEXT("❌ Missing texture for %s"), *T.ID);
+            Resources.Add(Img->GetBrush().GetResourceObject());
         }
-
-        FinalTiles.Add(D);
     }
-
-    InitializeMaterials(FinalTiles);
-    UE_LOG(LogTemp, Log, TEXT("HandleMaterialsReady: received %d tiles"), DownloadedTiles.Num());
+    return Resources.Num();
 }
 
-void UUIUserWidget::InitializeMaterials(const TArray<FFloorMaterialData>& Materials)
+void UUIUserWidget::LogPaletteReport() const
 {
-    if (!MaterialsScrollBox)
-    {
-        MaterialsScrollBox = WidgetTree->ConstructWidget<UScrollBox>(UScrollBox::StaticClass());
+    UE_LOG(LogRoomViz, Display, TEXT("Palette %s: %d entries, %d thumbnail textures, atlas %s with %d thumbnails on %d pages (%.0f%% used)"),
+        *GetName(), MaterialEntryMap.Num(), GetNumThumbnailTextures(), CVarPaletteUseAtlas.GetValueOnGameThread() ? TEXT("on") : TEXT("off"),
+        ThumbnailAtlas.GetNumThumbnails(), ThumbnailAtlas.GetNumPages(), ThumbnailAtlas.GetOccupancy() * 100.f);
+}
 
-        // Only set the root if it's not already set
-        if (!WidgetTree->RootWidget)
-        {
-            UCanvasPanel* RootPanel = WidgetTree->ConstructWidget<UCanvasPanel>(UCanvasPanel::StaticClass());
-            WidgetTree->RootWidget = RootPanel;
 
-            RootPanel->SetVisibility(ESlateVisibility::Visible);
-            RootPanel->SetIsEnabled(true);
 
-            UCanvasPanelSlot* ScrollSlot = RootPanel->AddChildToCanvas(MaterialsScrollBox);
-            ScrollSlot->SetAnchors(FAnchors(0.f, 0.f, 1.f, 1.f));
-            ScrollSlot->SetOffsets(FMargin(0.f));
-        }
+void UUIUserWidget::SetEntryThumbnail(UImage* Img, UTexture2D* Texture)
+{
+    FSlateBrush Brush;
+    if (CVarPaletteUseAtlas.GetValueOnGameThread() && ThumbnailAtlas.GetBrush(Texture, Brush))
+    {
+        Brush.ImageSize = Img->GetBrush().ImageSize;
+        Img->SetBrush(Brush);
     }
-
-    MaterialsScrollBox->ClearChildren();
-    MaterialEntryMap.Empty();
-
-    for (const FFloorMaterialData& Data : Materials)
+    else
     {
-        UBorder* Entry = Cast<UBorder>(CreateMaterialEntry(Data));
-        if (!Entry) continue;
-
-        MaterialsScrollBox->AddChild(Entry);
-        MaterialEntryMap.Add(Entry, Data);
+        Img->SetBrushFromTexture(Texture);
     }
 }
 
-
-
 UBorder* UUIUserWidget::CreateMaterialEntry(const FFloorMaterialData& Data)
 {
     // 1) Border container
@@ -174,7 +1242,10 @@ UBorder* UUIUserWidget::CreateMaterialEntry(const FFloorMaterialData& Data)
     
     // 3) Preview image
     UImage* Img = WidgetTree->ConstructWidget<UImage>(UImage::StaticClass());
-    if (Data.PreviewTexture) Img->SetBrushFromTexture(Data.PreviewTexture);
+    if (Data.PreviewTexture)
+    {
+        SetEntryThumbnail(Img, Data.PreviewTexture);
+    }
     HBox->AddChildToHorizontalBox(Img)->SetPadding(2);
 
     // 4) Name text
@@ -192,23 +1263,19 @@ FReply UUIUserWidget::NativeOnMouseButtonDown(const FGeometry& InGeometry, const
         const FVector2D ScreenPos = InMouseEvent.GetScreenSpacePosition();
         CachedMousePosition = ScreenPos;
 
-        for (auto& Pair : MaterialEntryMap)
+        if (UBorder* Entry = FindEntryAt(ScreenPos))
         {
-            UBorder* Entry = Pair.Key;
-            if (!IsValid(Entry)) continue;
-
-            // Get geometry in safe way
-            const FGeometry* EntryGeometry = Entry->GetCachedWidget().IsValid() ? &Entry->GetCachedGeometry() : nullptr;
-            if (!EntryGeometry) continue;
+            RecordInput(ERoomVizInputEventType::PointerDown, ScreenPos, FVector::ZeroVector, FVector::ZeroVector, Entry);
+            BeginEntryDrag(Entry);
+            return UWidgetBlueprintLibrary::DetectDragIfPressed(
+                InMouseEvent, Entry, EKeys::LeftMouseButton
+            ).NativeReply;
+        }
 
-            if (EntryGeometry->IsUnderLocation(ScreenPos))
-            {
-                DraggedBorder = Entry;
-                UE_LOG(LogTemp, Warning, TEXT("[UI] Detected drag start on '%s'"), *Pair.Value.Name);
-                return UWidgetBlueprintLibrary::DetectDragIfPressed(
-                    InMouseEvent, Entry, EKeys::LeftMouseButton
-                ).NativeReply;
-            }
+        if (InMouseEvent.IsShiftDown())
+        {
+            BeginMarquee(ScreenPos);
+            return FReply::Handled().CaptureMouse(TakeWidget());
         }
     }
 
@@ -221,23 +1288,8 @@ void UUIUserWidget::NativeOnDragDetected(const FGeometry& InGeometry,
     const FPointerEvent& InMouseEvent,
     UDragDropOperation*& OutOperation)
 {
-    if (!DraggedBorder || !MaterialEntryMap.Contains(DraggedBorder))
-    {
-        UE_LOG(LogTemp, Warning, TEXT("[UI] NativeOnDragDetected: no valid DraggedBorder"));
-        return;
-    }
-
-    const auto& Data = MaterialEntryMap[DraggedBorder];
-    UE_LOG(LogTemp, Warning, TEXT("[UI] NativeOnDragDetected: creating op for '%s'"),
-        *Data.Name);
-
-    UDragDropOperation* DragOp = UWidgetBlueprintLibrary::CreateDragDropOperation(
-        UDragDropOperation::StaticClass()
-    );
-    DragOp->Payload = DraggedBorder;
-    DragOp->DefaultDragVisual = DraggedBorder;
-    DragOp->Pivot = EDragPivot::CenterCenter;
-    OutOperation = DragOp;
+    RecordInput(ERoomVizInputEventType::DragDetected, InMouseEvent.GetScreenSpacePosition(), FVector::ZeroVector, FVector::ZeroVector, DraggedBorder);
+    OutOperation = CreateEntryDragOperation();
 }
 
 // 3) Drag‐over: let us know when pointer moves during a drag
@@ -252,29 +1304,12 @@ bool UUIUserWidget::NativeOnDragOver(const FGeometry& InGeometry, const FDragDro
     FVector WorldOrigin, WorldDir;
     if (PC->DeprojectScreenPositionToWorld(ScreenPos.X, ScreenPos.Y, WorldOrigin, WorldDir))
     {
-        FHitResult Hit;
-        FCollisionQueryParams Params;
-        if (APawn* Pawn = PC->GetPawn()) Params.AddIgnoredActor(Pawn);
-
-        if (World->LineTraceSingleByChannel(Hit, WorldOrigin, WorldOrigin + WorldDir * 10000.f, ECC_Visibility, Params))
-        {
-            AActor* HitActor = Hit.GetActor();
-            if (HitActor && HitActor->ActorHasTag("floor")) {
-                UPrimitiveComponent* Comp = Hit.GetComponent();
-                if (Comp && Comp != HighlightedComponent) {
-                    if (HighlightedComponent.IsValid())
-                        HighlightedComponent->SetRenderCustomDepth(false);
-                    Comp->SetRenderCustomDepth(true);
-                    HighlightedComponent = Comp;
-                }
-                return true;
-            }
-        }
+        RecordInput(ERoomVizInputEventType::DragOver, ScreenPos, WorldOrigin, WorldDir, nullptr);
+        UpdateDragHover(WorldOrigin, WorldDir, PC->GetPawn());
     }
-
-    if (HighlightedComponent.IsValid()) {
-        HighlightedComponent->SetRenderCustomDepth(false);
-        HighlightedComponent = nullptr;
+    else
+    {
+        ClearDragHover();
     }
 
     return true;
@@ -285,102 +1320,395 @@ bool UUIUserWidget::NativeOnDrop(const FGeometry& InGeometry,
     const FDragDropEvent& InDragDropEvent,
     UDragDropOperation* InOperation)
 {
-    UE_LOG(LogTemp, Warning, TEXT("[UI] NativeOnDrop at (%f,%f)"),
-        InDragDropEvent.GetScreenSpacePosition().X,
-        InDragDropEvent.GetScreenSpacePosition().Y);
+    const FVector2D ScreenPos = InDragDropEvent.GetScreenSpacePosition();
+    UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] NativeOnDrop at (%f,%f)"), ScreenPos.X, ScreenPos.Y);
 
     if (!InOperation || !InOperation->Payload)
         return false;
 
-    UBorder* DroppedBorder = Cast<UBorder>(InOperation->Payload);
-    if (!DroppedBorder || !MaterialEntryMap.Contains(DroppedBorder))
+    // Forward to your character
+    APlayerController* PC = GetOwningPlayer();
+    Aroom_vizCharacter* C = PC ? Cast<Aroom_vizCharacter>(PC->GetPawn()) : nullptr;
+    FVector WorldOrigin, WorldDir;
+    if (!C || !PC->DeprojectScreenPositionToWorld(ScreenPos.X, ScreenPos.Y, WorldOrigin, WorldDir))
+    {
+        FloorPreview.Revert();
         return false;
+    }
+
+    UBorder* DroppedBorder = Cast<UBorder>(InOperation->Payload);
+    RecordInput(ERoomVizInputEventType::Drop, ScreenPos, WorldOrigin, WorldDir, DroppedBorder);
+    return DropEntry(DroppedBorder, C, WorldOrigin, WorldDir);
+}
 
-    const FFloorMaterialData& Data = MaterialEntryMap[DroppedBorder];
-    if (!Data.MaterialAsset)
+// 5) Mouse‐up: finalize drop
+FReply UUIUserWidget::NativeOnMouseButtonUp(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
+{
+    if (InMouseEvent.GetEffectingButton() == EKeys::LeftMouseButton && BoxSelection.IsActive())
     {
-        UE_LOG(LogTemp, Error, TEXT("[UI] Drop: no MaterialAsset"));
-        return false;
+        MarqueeEnd = InMouseEvent.GetScreenSpacePosition();
+        EndMarquee();
+        return FReply::Handled().ReleaseMouseCapture();
     }
 
-    // Forward to your character
-    APlayerController* PC = GetOwningPlayer();
-    if (PC && PC->GetPawn())
+    if (InMouseEvent.GetEffectingButton() == EKeys::LeftMouseButton)
     {
-        if (Aroom_vizCharacter* C = Cast<Aroom_vizCharacter>(PC->GetPawn()))
+        const FVector2D ScreenPos = InMouseEvent.GetScreenSpacePosition();
+        UWorld* World = GetWorld();
+        APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+
+        FVector WorldOrigin = FVector::ZeroVector;
+        FVector WorldDir = FVector::ZeroVector;
+        if (PC && !PC->DeprojectScreenPositionToWorld(ScreenPos.X, ScreenPos.Y, WorldOrigin, WorldDir))
         {
-            C->OnMaterialDropped(Data, InDragDropEvent.GetScreenSpacePosition());
-            UE_LOG(LogTemp, Log, TEXT("[UI] Forwarded '%s' to character"), *Data.Name);
-            return true;
+            WorldDir = FVector::ZeroVector;
         }
+
+        RecordInput(ERoomVizInputEventType::PointerUp, ScreenPos, WorldOrigin, WorldDir, DraggedBorder);
+        ApplyDropBackstop(WorldOrigin, WorldDir, PC ? PC->GetPawn() : nullptr);
+        return FReply::Handled();
     }
+    return Super::NativeOnMouseButtonUp(InGeometry, InMouseEvent);
+}
+
+void UUIUserWidget::NativeOnDragCancelled(const FDragDropEvent& InDragDropEvent, UDragDropOperation* InOperation)
+{
+    Super::NativeOnDragCancelled(InDragDropEvent, InOperation);
 
-    return false;
+    RecordInput(ERoomVizInputEventType::DragCancelled, InDragDropEvent.GetScreenSpacePosition(), FVector::ZeroVector, FVector::ZeroVector, DraggedBorder);
+    CancelEntryDrag();
 }
 
-// 5) Mouse‐up: finalize drop
-FReply UUIUserWidget::NativeOnMouseButtonUp(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
+void UUIUserWidget::BeginEntryDrag(UBorder* Entry)
 {
-    if (InMouseEvent.GetEffectingButton() == EKeys::LeftMouseButton)
+    const FFloorMaterialData* Data = MaterialEntryMap.Find(Entry);
+    if (!Data)
     {
-        if (!IsValid(DraggedBorder)) {
-            UE_LOG(LogTemp, Warning, TEXT("[UI] MouseUp: DraggedBorder null"));
-            return FReply::Handled();
-        }
+        return;
+    }
 
-        if (!MaterialEntryMap.Contains(DraggedBorder)) {
-            UE_LOG(LogTemp, Warning, TEXT("[UI] MouseUp: Map miss"));
-            return FReply::Handled();
-        }
+    DraggedBorder = Entry;
+    Prefetcher.OnDragStart(Data->Name);
+    if (UAdaptiveQualitySubsystem* Quality = UAdaptiveQualitySubsystem::Get(GetWorld()))
+    {
+        Quality->NoteInteraction();
+    }
+    SetSelectedEntry(Entry);
+    UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] Detected drag start on '%s'"), *Data->Name);
+}
 
-        const FVector2D ScreenPos = InMouseEvent.GetScreenSpacePosition();
-        const FFloorMaterialData& Data = MaterialEntryMap[DraggedBorder];
+UDragDropOperation* UUIUserWidget::CreateEntryDragOperation()
+{
+    if (!DraggedBorder || !MaterialEntryMap.Contains(DraggedBorder))
+    {
+        UE_LOG(LogRoomVizHotPath, Warning, TEXT("[UI] NativeOnDragDetected: no valid DraggedBorder"));
+        return nullptr;
+    }
 
-        if (!IsValid(Data.MaterialAsset)) {
-            UE_LOG(LogTemp, Warning, TEXT("[UI] MouseUp: Invalid material asset"));
-            return FReply::Handled();
-        }
+    const auto& Data = MaterialEntryMap[DraggedBorder];
+    UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] NativeOnDragDetected: creating op for '%s'"),
+        *Data.Name);
 
-        UWorld* World = GetWorld();
-        if (!World) return FReply::Handled();
-        APlayerController* PC = World->GetFirstPlayerController();
-        if (!PC) return FReply::Handled();
-
-        FVector WorldOrigin, WorldDir;
-        if (!PC->DeprojectScreenPositionToWorld(ScreenPos.X, ScreenPos.Y, WorldOrigin, WorldDir))
-            return FReply::Handled();
-
-        FHitResult Hit;
-        FCollisionQueryParams Params;
-        if (APawn* Pawn = PC->GetPawn()) Params.AddIgnoredActor(Pawn);
-
-        if (World->LineTraceSingleByChannel(Hit, WorldOrigin, WorldOrigin + WorldDir * 10000.f, ECC_Visibility, Params))
-        {
-            if (Hit.GetActor() && Hit.GetActor()->ActorHasTag("floor")) {
-                UPrimitiveComponent* Comp = Hit.GetComponent();
-                if (IsValid(Comp)) {
-                    Comp->SetMaterial(0, Data.MaterialAsset);
-                    UE_LOG(LogTemp, Log, TEXT("[UI] ✅ DropBackstop applied '%s' to %s"), *Data.Name, *Comp->GetName());
-                }
+    UDragDropOperation* DragOp = UWidgetBlueprintLibrary::CreateDragDropOperation(
+        UDragDropOperation::StaticClass()
+    );
+    DragOp->Payload = DraggedBorder;
+    DragOp->DefaultDragVisual = DraggedBorder;
+    DragOp->Pivot = EDragPivot::CenterCenter;
+
+    FloorPreview.SetSource(Data.MaterialAsset);
+    return DragOp;
+}
+
+void UUIUserWidget::UpdateDragHover(const FVector& RayOrigin, const FVector& RayDirection, const AActor* IgnoredActor)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_HoverTrace);
+
+    UWorld* World = GetWorld();
+    if (!World) return;
+
+    if (UAdaptiveQualitySubsystem* Quality = UAdaptiveQualitySubsystem::Get(World))
+    {
+        Quality->NoteInteraction();
+    }
+
+    FHitResult Hit;
+    FCollisionQueryParams Params;
+    if (IgnoredActor) Params.AddIgnoredActor(IgnoredActor);
+
+    if (World->LineTraceSingleByChannel(Hit, RayOrigin, RayOrigin + RayDirection * 10000.f, ECC_Visibility, Params))
+    {
+        AActor* HitActor = Hit.GetActor();
+        if (HitActor && HitActor->ActorHasTag("floor")) {
+            UPrimitiveComponent* Comp = Hit.GetComponent();
+            if (Comp && Comp != HighlightedComponent) {
+                if (HighlightedComponent.IsValid() && !BoxSelection.IsSelected(HighlightedComponent.Get()))
+                    HighlightedComponent->SetRenderCustomDepth(false);
+                Comp->SetRenderCustomDepth(true);
+                HighlightedComponent = Comp;
             }
+            FloorPreview.SetTarget(CVarFloorPreview.GetValueOnGameThread() ? Comp : nullptr);
+            return;
         }
+    }
+
+    ClearDragHover();
+}
+
+void UUIUserWidget::ClearDragHover()
+{
+    if (HighlightedComponent.IsValid()) {
+        // Box-selected floors keep their outline
+        HighlightedComponent->SetRenderCustomDepth(BoxSelection.IsSelected(HighlightedComponent.Get()));
+        HighlightedComponent = nullptr;
+    }
+    FloorPreview.Revert();
+}
+
+bool UUIUserWidget::DropEntry(UBorder* Entry, Aroom_vizCharacter* Character, const FVector& RayOrigin, const FVector& RayDirection)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_Drop);
+    RoomVizMetrics::FScopedLatency Latency(RoomVizMetrics::DropSeconds);
+
+    // Hides the preview mesh; the floor itself was never changed by the hover
+    FloorPreview.Revert();
+
+    const FFloorMaterialData* Data = MaterialEntryMap.Find(Entry);
+    if (!Data || !Character)
+        return false;
+
+    if (!Data->MaterialAsset)
+    {
+        UE_LOG(LogRoomVizHotPath, Error, TEXT("[UI] Drop: no MaterialAsset"));
+        return false;
+    }
+
+    if (BoxSelection.Num() > 0 && IsOverSelection(RayOrigin, RayDirection, Character))
+    {
+        Character->ApplyDroppedMaterialToSurfaces(*Data, BoxSelection.GetSelection());
+    }
+    else
+    {
+        Character->ApplyDroppedMaterial(*Data, RayOrigin, RayDirection);
+    }
+    Prefetcher.OnDrop(Data->Name);
+    UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] Forwarded '%s' to character"), *Data->Name);
+    return true;
+}
+
+void UUIUserWidget::ApplyDropBackstop(const FVector& RayOrigin, const FVector& RayDirection, const AActor* IgnoredActor)
+{
+    ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_Drop);
+
+    if (!IsValid(DraggedBorder)) {
+        UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] MouseUp: DraggedBorder null"));
+        return;
+    }
+
+    if (!MaterialEntryMap.Contains(DraggedBorder)) {
+        UE_LOG(LogRoomVizHotPath, Warning, TEXT("[UI] MouseUp: Map miss"));
+        return;
+    }
+
+    FloorPreview.Revert();
+
+    const FFloorMaterialData& Data = MaterialEntryMap[DraggedBorder];
+
+    if (!IsValid(Data.MaterialAsset)) {
+        UE_LOG(LogRoomVizHotPath, Warning, TEXT("[UI] MouseUp: Invalid material asset"));
+        return;
+    }
+
+    UWorld* World = GetWorld();
+    if (!World || RayDirection.IsNearlyZero()) return;
+
+    FHitResult Hit;
+    FCollisionQueryParams Params;
+    if (IgnoredActor) Params.AddIgnoredActor(IgnoredActor);
 
-        // Clear highlight if any
-        if (HighlightedComponent.IsValid()) {
-            HighlightedComponent->SetRenderCustomDepth(false);
-            HighlightedComponent = nullptr;
+    if (World->LineTraceSingleByChannel(Hit, RayOrigin, RayOrigin + RayDirection * 10000.f, ECC_Visibility, Params))
+    {
+        if (Hit.GetActor() && Hit.GetActor()->ActorHasTag("floor")) {
+            UPrimitiveComponent* Comp = Hit.GetComponent();
+            Aroom_vizCharacter* Character = Cast<Aroom_vizCharacter>(GetOwningPlayerPawn());
+            if (Character && BoxSelection.IsSelected(Comp)) {
+                Character->ApplyDroppedMaterialToSurfaces(Data, BoxSelection.GetSelection());
+                Prefetcher.OnDrop(Data.Name);
+            }
+            else if (Character && IsValid(Comp)) {
+                // Same path as a delivered drop, so the design state and co-design clients get it
+                Character->ApplyDroppedMaterial(Data, RayOrigin, RayDirection);
+                Prefetcher.OnDrop(Data.Name);
+                UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] DropBackstop applied '%s' to %s"), *Data.Name, *Comp->GetName());
+            }
         }
+    }
 
-        DraggedBorder = nullptr;
-        return FReply::Handled();
+    // Clear highlight if any
+    if (HighlightedComponent.IsValid()) {
+        HighlightedComponent->SetRenderCustomDepth(BoxSelection.IsSelected(HighlightedComponent.Get()));
+        HighlightedComponent = nullptr;
     }
-    return Super::NativeOnMouseButtonUp(InGeometry, InMouseEvent);
+
+    DraggedBorder = nullptr;
 }
 
-void UUIUserWidget::NativeOnDragCancelled(const FDragDropEvent& InDragDropEvent, UDragDropOperation* InOperation)
+void UUIUserWidget::BeginMarquee(const FVector2D& ScreenPos)
 {
-    Super::NativeOnDragCancelled(InDragDropEvent, InOperation);
+    ClearDragHover();
+    MarqueeStart = ScreenPos;
+    MarqueeEnd = ScreenPos;
+    bMarqueeDirty = false;
+    BoxSelection.Begin(GetWorld(), GetOwningPlayerPawn());
+    Invalidate(EInvalidateWidgetReason::Paint);
+    UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] Marquee started over %d floors"), BoxSelection.GetNumCandidates());
+}
+
+void UUIUserWidget::UpdateMarquee(bool bFinal)
+{
+    bMarqueeDirty = false;
+
+    UWorld* World = GetWorld();
+    FFloorSelectionView View;
+    if (!World || !FFloorSelectionView::FromPlayer(GetOwningPlayer(), View))
+    {
+        return;
+    }
+
+    // Pointer events are in desktop space, the projection in viewport pixels
+    FVector2D StartPixel, EndPixel, ViewportPosition;
+    USlateBlueprintLibrary::AbsoluteToViewport(World, MarqueeStart, StartPixel, ViewportPosition);
+    USlateBlueprintLibrary::AbsoluteToViewport(World, MarqueeEnd, EndPixel, ViewportPosition);
+    BoxSelection.Update(View, FBox2D(StartPixel, EndPixel), bFinal);
+
+    if (UAdaptiveQualitySubsystem* Quality = UAdaptiveQualitySubsystem::Get(World))
+    {
+        Quality->NoteInteraction();
+    }
+}
+
+void UUIUserWidget::EndMarquee()
+{
+    constexpr double ClickSlop = 4.0;
+    if ((MarqueeEnd - MarqueeStart).GetAbsMax() < ClickSlop)
+    {
+        BoxSelection.Clear();
+    }
+    else
+    {
+        // No later tick would pick up what the budget deferred
+        UpdateMarquee(/*bFinal*/ true);
+        BoxSelection.End();
+    }
+    Invalidate(EInvalidateWidgetReason::Paint);
+    UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] Marquee selected %d floors"), BoxSelection.Num());
+}
+
+bool UUIUserWidget::IsOverSelection(const FVector& RayOrigin, const FVector& RayDirection, const AActor* IgnoredActor) const
+{
+    UWorld* World = GetWorld();
+    if (!World || RayDirection.IsNearlyZero())
+    {
+        return false;
+    }
+
+    FHitResult Hit;
+    FCollisionQueryParams Params;
+    if (IgnoredActor) Params.AddIgnoredActor(IgnoredActor);
+    return World->LineTraceSingleByChannel(Hit, RayOrigin, RayOrigin + RayDirection * 10000.f, ECC_Visibility, Params)
+        && BoxSelection.IsSelected(Hit.GetComponent());
+}
+
+int32 UUIUserWidget::NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+    FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+    LayerId = Super::NativePaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+    if (!BoxSelection.IsActive())
+    {
+        return LayerId;
+    }
 
-    UE_LOG(LogTemp, Warning, TEXT("[UI] DragCancelled: clearing drag state"));
+    const FVector2D LocalStart = AllottedGeometry.AbsoluteToLocal(MarqueeStart);
+    const FVector2D LocalEnd = AllottedGeometry.AbsoluteToLocal(MarqueeEnd);
+    const FVector2D Min(FMath::Min(LocalStart.X, LocalEnd.X), FMath::Min(LocalStart.Y, LocalEnd.Y));
+    const FVector2D Size = (LocalEnd - LocalStart).GetAbs();
+
+    ++LayerId;
+    FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(Size, FSlateLayoutTransform(Min)),
+        FCoreStyle::Get().GetBrush("WhiteBrush"), ESlateDrawEffect::None, SelectedEntryColor.CopyWithNewOpacity(0.15f));
+    const TArray<FVector2D> Outline = { Min, Min + FVector2D(Size.X, 0.0), Min + Size, Min + FVector2D(0.0, Size.Y), Min };
+    FSlateDrawElement::MakeLines(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(), Outline, ESlateDrawEffect::None, SelectedEntryColor, true, 1.f);
+    return LayerId;
+}
+
+void UUIUserWidget::CancelEntryDrag()
+{
+    UE_LOG(LogRoomVizHotPath, Verbose, TEXT("[UI] DragCancelled: clearing drag state"));
     DraggedBorder = nullptr;
+    ClearDragHover();
+}
+
+UBorder* UUIUserWidget::FindEntryByName(const FString& Name) const
+{
+    for (const TPair<UBorder*, FFloorMaterialData>& Pair : MaterialEntryMap)
+    {
+        if (Pair.Value.Name == Name)
+        {
+            return Pair.Key;
+        }
+    }
+    return nullptr;
+}
+
+UMaterialInterface* UUIUserWidget::FindTileMaterial(const FString& TileID) const
+{
+    const UBorder* Entry = FindEntryByName(TileID);
+    const FFloorMaterialData* Data = Entry ? MaterialEntryMap.Find(Entry) : nullptr;
+    return Data ? Data->MaterialAsset : nullptr;
+}
+
+void UUIUserWidget::RecordInput(ERoomVizInputEventType Type, const FVector2D& ScreenPos, const FVector& RayOrigin, const FVector& RayDirection, UBorder* Entry) const
+{
+    if (!RoomVizInputRecorder::IsRecording())
+    {
+        return;
+    }
+
+    FRoomVizInputEvent Event;
+    Event.Type = Type;
+    Event.ScreenPosition = ScreenPos;
+    Event.RayOrigin = RayOrigin;
+    Event.RayDirection = RayDirection;
+    if (const FFloorMaterialData* Data = MaterialEntryMap.Find(Entry))
+    {
+        Event.Entry = Data->Name;
+    }
+    RoomVizInputRecorder::Record(MoveTemp(Event));
+}
+
+void UUIUserWidget::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+    UUIUserWidget* This = CastChecked<UUIUserWidget>(InThis);
+    This->FloorPreview.AddReferencedObjects(Collector);
+    This->ThumbnailAtlas.AddReferencedObjects(Collector);
+    Super::AddReferencedObjects(InThis, Collector);
+}
+
+void UUIUserWidget::NativeDestruct()
+{
+    FloorPreview.Shutdown();
+    BoxSelection.Clear();
+
+    // NativeConstruct binds again if the widget comes back
+    if (AMaterialAPIManager* Mgr = MaterialManager.Get())
+    {
+        Mgr->OnMaterialsReady.RemoveDynamic(this, &UUIUserWidget::HandleMaterialsReady);
+        Mgr->OnCatalogMerged.RemoveAll(this);
+        Mgr->OnTilePBRMapsReady.RemoveAll(this);
+        Mgr->OnTileTextureReady.RemoveAll(this);
+        Mgr->OnTileEvicted.RemoveAll(this);
+        Prefetcher.SetManager(nullptr);
+    }
+
+    Super::NativeDestruct();
 }
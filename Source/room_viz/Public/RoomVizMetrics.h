@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Pipeline counters for fleet monitoring, served in Prometheus text format at /metrics by a
+ * local endpoint: URoomVizTileSettings::bMetricsEndpoint, or -RoomVizMetricsPort=<port> on the
+ * command line (commandlets included). The endpoint only binds when the HTTPServer listener
+ * override for its port in DefaultEngine.ini is a loopback address.
+ *
+ *   curl http://127.0.0.1:9464/metrics
+ *
+ * Recording is a relaxed atomic add from whichever thread measured it, so it is safe on hot
+ * paths and transfer threads alike; a scrape is formatted on a worker.
+ */
+namespace RoomVizMetrics
+{
+    class ROOM_VIZ_API FCounter
+    {
+    public:
+        void Add(uint64 Count = 1) { Value.fetch_add(Count, std::memory_order_relaxed); }
+        uint64 Get() const { return Value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64> Value{0};
+    };
+
+    class ROOM_VIZ_API FGauge
+    {
+    public:
+        void Add(int64 Delta) { Value.fetch_add(Delta, std::memory_order_relaxed); }
+        void Set(int64 InValue) { Value.store(InValue, std::memory_order_relaxed); }
+        int64 Get() const { return Value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<int64> Value{0};
+    };
+
+    /** Latency histogram over fixed bounds from 1 ms to 10 s */
+    class ROOM_VIZ_API FHistogram
+    {
+    public:
+        static constexpr int32 NumBounds = 13;
+        static const double BoundsSeconds[NumBounds];
+
+        void Observe(double Seconds);
+
+        /** Per-bucket counts (not cumulative), the last one above every bound; sum in seconds */
+        void Snapshot(uint64 (&OutCounts)[NumBounds + 1], double& OutSumSeconds) const;
+
+    private:
+        std::atomic<uint64> Counts[NumBounds + 1] = {};
+        std::atomic<uint64> SumMicroseconds{0};
+    };
+
+    /** Observes the time until the end of the scope */
+    class FScopedLatency
+    {
+    public:
+        explicit FScopedLatency(FHistogram& InHistogram) : Histogram(InHistogram), StartTime(FPlatformTime::Seconds()) {}
+        ~FScopedLatency() { Histogram.Observe(FPlatformTime::Seconds() - StartTime); }
+
+    private:
+        FHistogram& Histogram;
+        double StartTime;
+    };
+
+    /** The last Capacity frame times, for percentiles at scrape time; written from the game thread only */
+    class ROOM_VIZ_API FFrameTimeWindow
+    {
+    public:
+        static constexpr uint32 Capacity = 1024;
+
+        void Record(float Seconds);
+        TArray<float> Snapshot() const;
+        uint64 GetNumFrames() const { return Next.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<float> Samples[Capacity] = {};
+        std::atomic<uint64> Next{0};
+    };
+
+    extern ROOM_VIZ_API FHistogram CatalogFetchSeconds;
+    extern ROOM_VIZ_API FHistogram ImageDownloadSeconds;
+    extern ROOM_VIZ_API FHistogram ImageDecodeSeconds;
+    extern ROOM_VIZ_API FHistogram DropSeconds;
+    extern ROOM_VIZ_API FCounter TextureCacheHits;
+    extern ROOM_VIZ_API FCounter TextureCacheMisses;
+    extern ROOM_VIZ_API FCounter PrefetchHits;
+    extern ROOM_VIZ_API FCounter PrefetchMisses;
+    extern ROOM_VIZ_API FGauge TileTextureBytes;
+    extern ROOM_VIZ_API FGauge MaterialInstances;
+    extern ROOM_VIZ_API FGauge QualityLevel;
+    extern ROOM_VIZ_API FFrameTimeWindow FrameTimes;
+
+    /** Start the endpoint on Port; false if the port is not bound to loopback or cannot be bound */
+    ROOM_VIZ_API bool StartEndpoint(int32 Port);
+    ROOM_VIZ_API void StopEndpoint();
+
+    /** Start the endpoint if the settings or the command line ask for it */
+    ROOM_VIZ_API void StartEndpointIfConfigured();
+}
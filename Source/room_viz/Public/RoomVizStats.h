@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "HAL/LowLevelMemTracker.h"
+
+/**
+ * Instrumentation for the tile pipeline: `stat RoomViz` in game, the RoomViz trace channel in
+ * Unreal Insights (-trace=cpu,RoomViz) and the RoomViz LLM tags (-llm), which all sit under
+ * one RoomViz parent tag.
+ */
+
+DECLARE_STATS_GROUP(TEXT("RoomViz"), STATGROUP_RoomViz, STATCAT_Advanced);
+
+// Game-thread cost of each pipeline stage; Catalog Fetch is the whole fetch, request to merge
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Catalog Fetch"), STAT_RoomViz_CatalogFetch, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Catalog Parse"), STAT_RoomViz_CatalogParse, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Image Download"), STAT_RoomViz_ImageDownload, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Image Decode"), STAT_RoomViz_ImageDecode, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Texture Upload"), STAT_RoomViz_TextureUpload, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ORM Pack"), STAT_RoomViz_ORMPack, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MID Creation"), STAT_RoomViz_MIDCreation, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Palette Build"), STAT_RoomViz_PaletteBuild, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hover Trace"), STAT_RoomViz_HoverTrace, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drop"), STAT_RoomViz_Drop, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Box Select"), STAT_RoomViz_BoxSelect, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Preview Swap"), STAT_RoomViz_PreviewSwap, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Work Queue"), STAT_RoomViz_WorkQueue, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Inbox Drain"), STAT_RoomViz_InboxDrain, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pool Trim"), STAT_RoomViz_PoolTrim, STATGROUP_RoomViz, ROOM_VIZ_API);
+
+// Wall-clock latency of the async stages, last completed request
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Catalog Fetch Latency (ms)"), STAT_RoomViz_CatalogFetchLatency, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Image Download Latency (ms)"), STAT_RoomViz_ImageDownloadLatency, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Prefetch Hit Rate (%)"), STAT_RoomViz_PrefetchHitRate, STATGROUP_RoomViz, ROOM_VIZ_API);
+
+// Running totals
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pending Images"), STAT_RoomViz_PendingImages, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Queued Work"), STAT_RoomViz_QueuedWork, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Inbox Completions"), STAT_RoomViz_InboxCompletions, STATGROUP_RoomViz, ROOM_VIZ_API);
+// Objects alive in the tile and palette pools (UTileObjectPool), and the bytes fetched for current tiles
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Tile Textures"), STAT_RoomViz_NumTileTextures, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Material Instances"), STAT_RoomViz_NumMIDs, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Downloaded Bytes"), STAT_RoomViz_DownloadedBytes, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Dedup Saved Bytes"), STAT_RoomViz_DedupSavedBytes, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Shared Tile Textures"), STAT_RoomViz_NumSharedTiles, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Prefetches In Flight"), STAT_RoomViz_PrefetchesInFlight, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Prefetch Wasted Bytes"), STAT_RoomViz_PrefetchWastedBytes, STATGROUP_RoomViz, ROOM_VIZ_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quality Level"), STAT_RoomViz_QualityLevel, STATGROUP_RoomViz, ROOM_VIZ_API);
+
+UE_TRACE_CHANNEL_EXTERN(RoomVizChannel, ROOM_VIZ_API);
+
+LLM_DECLARE_TAG_API(RoomViz_TileTextures, ROOM_VIZ_API);
+LLM_DECLARE_TAG_API(RoomViz_PaletteWidgets, ROOM_VIZ_API);
+LLM_DECLARE_TAG_API(RoomViz_MaterialInstances, ROOM_VIZ_API);
+
+/** Scope both a RoomViz cycle stat and a matching Insights event on the RoomViz channel */
+#define ROOMVIZ_SCOPE_CYCLE_COUNTER(Stat) \
+    SCOPE_CYCLE_COUNTER(Stat); \
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, RoomVizChannel)
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One frame as the quality controller sees it */
+struct FAdaptiveQualitySample
+{
+    float DeltaSeconds = 0.f;
+    /** Game/render thread frame time */
+    float FrameMs = 0.f;
+    /** GPU frame time, 0 when the RHI does not report one */
+    float GPUMs = 0.f;
+    /** The customer is dragging a tile or moving the camera */
+    bool bInteracting = false;
+};
+
+/**
+ * Decides the quality level (0 = full, higher = cheaper) from a stream of frame samples. No
+ * engine state: UAdaptiveQualitySubsystem feeds it real frames and applies the level, and
+ * -run=RoomVizBenchmark -Quality feeds it synthetic traces.
+ *
+ * Hysteresis: quality drops once frames stay over TargetFrameMs * DownRatio for DownSeconds
+ * (InteractiveDownSeconds while the customer interacts), and comes back only while idle, after
+ * frames stay under TargetFrameMs * UpRatio for UpSeconds. Between the two ratios nothing
+ * moves. After every change the first SettleSeconds are ignored, as temporal upscaling and
+ * Lumen need a moment to converge. A raise that has to be undone soon after doubles the wait
+ * before the next one (up to MaxUpSeconds), so a level right at the edge does not flap.
+ */
+class ROOM_VIZ_API FAdaptiveQualityPolicy
+{
+public:
+    struct FConfig
+    {
+        float TargetFrameMs = 33.3f;
+        float DownRatio = 1.1f;
+        float UpRatio = 0.75f;
+        float DownSeconds = 1.f;
+        float InteractiveDownSeconds = 0.25f;
+        float UpSeconds = 4.f;
+        float MaxUpSeconds = 60.f;
+        /** No interaction for this long before quality may come back */
+        float IdleSeconds = 2.f;
+        float SettleSeconds = 0.5f;
+        /** Levels 0 .. NumLevels - 1 */
+        int32 NumLevels = 1;
+    };
+
+    explicit FAdaptiveQualityPolicy(const FConfig& InConfig);
+
+    /** Take one frame; returns the level to run at */
+    int32 Update(const FAdaptiveQualitySample& Sample);
+
+    /** Jump to Level (clamped), as if the policy had chosen it */
+    void SetLevel(int32 InLevel);
+
+    int32 GetLevel() const { return Level; }
+    int32 GetNumLevels() const { return Config.NumLevels; }
+    const FConfig& GetConfig() const { return Config; }
+
+    int32 GetNumDrops() const { return NumDrops; }
+    int32 GetNumRaises() const { return NumRaises; }
+    /** Raises undone within the backoff window */
+    int32 GetNumFailedRaises() const { return NumFailedRaises; }
+    float GetCurrentUpSeconds() const { return CurrentUpSeconds; }
+
+private:
+    void ChangeLevel(int32 NewLevel);
+
+    FConfig Config;
+    int32 Level = 0;
+
+    float OverSeconds = 0.f;
+    float UnderSeconds = 0.f;
+    float SecondsIdle = 0.f;
+    float SettleLeft = 0.f;
+    float SecondsSinceRaise = 0.f;
+    /** The last raise is younger than twice the wait that allowed it; a drop now undoes it */
+    bool bRaiseOnTrial = false;
+    float CurrentUpSeconds = 0.f;
+
+    int32 NumDrops = 0;
+    int32 NumRaises = 0;
+    int32 NumFailedRaises = 0;
+};
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "dataclass/AdaptiveQualityPolicy.h"
+#include "AdaptiveQualitySubsystem.generated.h"
+
+/**
+ * Holds URoomVizTileSettings::TargetFrameMs on weaker kiosks by walking the QualityLadder
+ * (screen percentage, shadow and Lumen quality) as FAdaptiveQualityPolicy decides. Frames are
+ * the slower of the game and render threads, and the GPU when the RHI reports it.
+ * Quality drops quickly while the customer drags tiles or moves the camera (NoteInteraction)
+ * and only climbs back once they stop.
+ *
+ * RoomViz.Quality.Adaptive turns it off, RoomViz.Quality.ForceLevel pins a rung and
+ * RoomViz.Quality.Report logs what it is doing. Console variables go back to their startup
+ * values when the world ends.
+ */
+UCLASS()
+class ROOM_VIZ_API UAdaptiveQualitySubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    static UAdaptiveQualitySubsystem* Get(const UWorld* World);
+
+    virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    /** The customer is doing something that has to stay smooth; counts as interaction for a short while */
+    void NoteInteraction();
+
+    int32 GetLevel() const { return AppliedLevel; }
+    void LogReport() const;
+
+private:
+    /** Set the console variables of every rung down to Level, and the startup values of the rest */
+    void ApplyLevel(int32 Level);
+
+    TUniquePtr<FAdaptiveQualityPolicy> Policy;
+    int32 AppliedLevel = 0;
+
+    /** Startup value of every console variable the ladder touches */
+    TMap<FString, FString> StartupValues;
+
+    double LastInteractionTime = -1.0;
+    float AverageFrameMs = 0.f;
+    float AverageGPUMs = 0.f;
+};
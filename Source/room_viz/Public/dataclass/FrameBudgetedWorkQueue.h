@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ERoomVizWorkPriority : uint8
+{
+    /** Work the user is waiting to see, e.g. tile textures */
+    High,
+    Normal,
+    /** Bulk work that can trail behind, e.g. palette entries */
+    Low,
+
+    Num
+};
+
+/**
+ * Game-thread-only finalization work (texture creation, material instances, widgets), run a
+ * few items per frame under a time budget instead of in bursts from async callbacks.
+ */
+class ROOM_VIZ_API FFrameBudgetedWorkQueue
+{
+public:
+    using FWork = TUniqueFunction<void()>;
+
+    void Enqueue(ERoomVizWorkPriority Priority, FWork&& Work);
+
+    /**
+     * Run queued work, highest priority first, until BudgetSeconds have passed. At least one item
+     * runs per call so the queue always drains. Returns the number of items run.
+     */
+    int32 Drain(double BudgetSeconds);
+
+    int32 Num() const;
+    bool IsEmpty() const { return Num() == 0; }
+    void Reset();
+
+private:
+    struct FLane
+    {
+        TArray<FWork> Items;
+        int32 Head = 0;
+    };
+
+    FLane Lanes[(int32)ERoomVizWorkPriority::Num];
+};
@@ -6,8 +6,19 @@
 #include "GameFramework/Actor.h"
 #include "Http.h"
 #include "UObject/NoExportTypes.h"
+#include "dataclass/TileTextureCache.h"
+#include "dataclass/FrameBudgetedWorkQueue.h"
+#include "dataclass/TileCompletionInbox.h"
+#include "dataclass/TileImageAnalysis.h"
 #include "MaterialAPIManager.generated.h"
 
+class ITileCatalogSource;
+struct FTileImagePayload;
+struct FTilePBRSources;
+struct FTilePBRTexels;
+struct FDecodedTileImage;
+class UTileObjectPool;
+
 USTRUCT(BlueprintType)
 struct FTileMaterialData
 {
@@ -22,9 +33,42 @@ struct FTileMaterialData
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
 	UTexture2D* DownloadedTexture = nullptr;
 
+	/** Catalog source this tile was taken from */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	FName SourceName;
+
+	// Optional PBR maps, dropped at merge unless URoomVizTileSettings::bTilePBRMaps; AO, roughness and metallic are packed into ORMTexture
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	FString NormalURL;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	FString AOURL;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	FString RoughnessURL;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	FString MetallicURL;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	UTexture2D* NormalTexture = nullptr;
+
+	/** R = AO, G = roughness, B = metallic */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	UTexture2D* ORMTexture = nullptr;
+
+	/** Colors of the base color image; from the tile analysis cache until the image is decoded */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+	FTileImageAnalysis Analysis;
+
+	bool HasPBRMaps() const { return !NormalURL.IsEmpty() || !AOURL.IsEmpty() || !RoughnessURL.IsEmpty() || !MetallicURL.IsEmpty(); }
+	void ClearPBRMaps() { NormalURL.Reset(); AOURL.Reset(); RoughnessURL.Reset(); MetallicURL.Reset(); }
+
 };
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnMaterialsReady, const TArray<FTileMaterialData>&, DownloadedTiles);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnTileTextureReady, const FTileMaterialData& /*Tile*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnTileCatalogComplete, const TArray<FTileMaterialData>& /*Tiles*/);
 
 UCLASS()
 class ROOM_VIZ_API AMaterialAPIManager : public  AActor
@@ -41,20 +85,171 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 	UPROPERTY(BlueprintAssignable, Category = "Tile API")
 	FOnMaterialsReady OnMaterialsReady;
 
-	/** Fetch tiles from remote JSON */
+	/** Fired for each tile as soon as its texture exists, before the whole catalog is ready */
+	FOnTileTextureReady OnTileTextureReady;
+
+	/** Native counterpart of OnMaterialsReady */
+	FOnTileCatalogComplete OnCatalogComplete;
+
+	/**
+	 * Fired once the catalog is known, before any texture; tiles carry their cached Analysis where
+	 * the tile analysis cache has one. Fired again if that cache finishes loading afterwards.
+	 */
+	FOnTileCatalogComplete OnCatalogMerged;
+
+	/** Fired when PBR maps fetched through RequestPBRMaps have their textures */
+	FOnTileTextureReady OnTilePBRMapsReady;
+
+	/** Fired by EvictTile while the tile still has its textures */
+	FOnTileTextureReady OnTileEvicted;
+
+	/** If set, fetch this HTTP catalog instead of the sources in URoomVizTileSettings */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tile API")
+	FString CatalogURL;
+
+	/** Fetch and merge the catalogs of all sources, then their images */
 	UFUNCTION(BlueprintCallable, Category = "Tile API")
 	void FetchTileMaterials();
 
-	void OnResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
-	void DownloadTileImage(const FString& URL, const FString& TileID);
-	void OnImageDownloaded(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString TileID);
+	/** Use these sources instead of the configured ones on the next fetch */
+	void SetCatalogSources(const TArray<TSharedRef<ITileCatalogSource>>& InSources);
+
+	void OnCatalogFetched(int32 Generation, int32 SourceIndex, bool bSuccess, TArray<FTileMaterialData>&& Tiles);
+	void MergeCatalogs();
+	void OnImageFetched(int32 Generation, const FString& TileID, bool bSuccess, TSharedPtr<FTileImagePayload, ESPMode::ThreadSafe> Payload, uint64 BytesHash);
+	void OnImageDecoded(int32 Generation, uint64 BytesHash, uint64 PixelHash, TSharedRef<FDecodedTileImage, ESPMode::ThreadSafe> Image, const FTileImageAnalysis& Analysis);
+	void OnTextureFetched(int32 Generation, const FString& TileID, UTexture2D* Texture);
+
+	/**
+	 * Attach a tile's base color (null if it failed) and finish the catalog once nothing is pending.
+	 * Without an Analysis, the tile takes that of another tile showing the same texture.
+	 */
+	void CompleteTile(const FString& TileID, UTexture2D* Texture, const FTileImageAnalysis* Analysis = nullptr);
+
+	/**
+	 * Fetch a tile's deferred PBR maps now (see bDeferPBRMaps). False if the tile has none, has
+	 * them already, or its fetch is in flight; in that case a cancelled fetch is revived and
+	 * a higher Priority applies to its texture creation.
+	 */
+	bool RequestPBRMaps(const FString& TileID, ERoomVizWorkPriority Priority = ERoomVizWorkPriority::Low);
+
+	/** Drop a RequestPBRMaps fetch: downloads in flight still land but are not decoded */
+	bool CancelPBRMaps(const FString& TileID);
+
+	/** Encoded size of a tile's maps fetched through RequestPBRMaps, 0 if none */
+	int64 GetPBRMapBytes(const FString& TileID) const { return PBRMapBytes.FindRef(TileID); }
+
+	/** Bytes of RequestPBRMaps fetches cancelled after their download had started */
+	int64 GetDiscardedPBRBytes() const { return DiscardedPBRBytes; }
+
+	/** Fetch a tile's normal/AO/roughness/metallic maps; they are decoded and packed on a worker */
+	void FetchPBRMaps(ITileCatalogSource& Source, const FTileMaterialData& Tile, int32 Generation);
+	void OnPBRMapsFetched(int32 Generation, const FString& TileID, TSharedRef<FTilePBRSources, ESPMode::ThreadSafe> Maps);
+	void OnPBRMapsPacked(int32 Generation, const FString& TileID, TSharedRef<FTilePBRTexels, ESPMode::ThreadSafe> Texels);
+	void FinishPendingImage();
+
+	/** Drop a tile; its texture goes once no other tile shares it */
+	UFUNCTION(BlueprintCallable, Category = "Tile API")
+	void EvictTile(const FString& TileID);
+
+	/** Also hash decoded pixels, so the same image encoded differently is shared too (one extra hash per decode) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tile API")
+	bool bDedupDecodedPixels = false;
+
+	/** Leave PBR maps until RequestPBRMaps asks for them; the catalog is ready once base colors are in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tile API")
+	bool bDeferPBRMaps = false;
+
+	const FTileTextureCache& GetTextureCache() const { return TextureCache; }
+
+	/** Owner of the textures created for tiles; each texture field of ParsedTiles holds one reference */
+	UTileObjectPool* GetTilePool();
+
+	/** Game-thread finalization work, drained in Tick under RoomViz.WorkBudgetMs */
+	FFrameBudgetedWorkQueue& GetWorkQueue() { return WorkQueue; }
+
+	/** RoomViz.WorkBudgetMs, for queues drained outside the manager */
+	static double GetWorkBudgetSeconds();
 
 	// Class member array
 	UPROPERTY()
 	TArray<FTileMaterialData> ParsedTiles;
 
 	int32 PendingImages = 0;
+
+	/** When the current catalog request was sent, for latency stats */
+	double FetchStartTime = 0.0;
+
+private:
+	TArray<TSharedRef<ITileCatalogSource>> Sources;
+
+	/** Per-source catalogs of the fetch in progress, merged once all have answered */
+	TArray<TArray<FTileMaterialData>> SourceCatalogs;
+	TMap<FString, int32> TileSourceIndex;
+	int32 PendingCatalogs = 0;
+
+	/** Bumped by every fetch so that callbacks of a superseded fetch are dropped */
+	int32 FetchGeneration = 0;
+
+	FTileTextureCache TextureCache;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UTileObjectPool> TilePool;
+
+	/** Point one of a tile's texture fields at Texture, moving the pool reference along */
+	void SetTileTexture(UTexture2D*& Field, UTexture2D* Texture);
+
+	/** Give back the pool references of a tile leaving ParsedTiles */
+	void ReleaseTileTextures(FTileMaterialData& Tile);
+
+	/** Encoded bytes fetched per tile, behind STAT_RoomViz_DownloadedBytes; 0 forgets the tile */
+	void SetDownloadedBytes(const FString& TileID, int64 NumBytes);
+	TMap<FString, int64> DownloadedBytesByTile;
+
+	/** Tiles sharing an image URL with the tile that fetches it, keyed by that tile's ID */
+	TMap<FString, TArray<FString>> DuplicateTiles;
+
+	/** Tiles waiting on an image being decoded, by hash of its bytes */
+	TMap<uint64, TArray<FString>> DecodingByHash;
+
+	/** RequestPBRMaps fetches not finished yet */
+	struct FDeferredPBRFetch
+	{
+		ERoomVizWorkPriority Priority = ERoomVizWorkPriority::Low;
+		bool bCancelled = false;
+	};
+	TMap<FString, FDeferredPBRFetch> DeferredPBRFetches;
+	TMap<FString, int64> PBRMapBytes;
+	int64 DiscardedPBRBytes = 0;
+
+	FFrameBudgetedWorkQueue WorkQueue;
+
+	/** Image transfers finished on HTTP/IO threads, drained in Tick ahead of WorkQueue */
+	FTileCompletionInboxRef Inbox = MakeShared<FTileCompletionInbox, ESPMode::ThreadSafe>();
+	int32 NumDownloadsSkipped = 0;
+	int32 NumDecodesSkipped = 0;
+
+	/** Tile analyses by base color URL, loaded from and saved next to the tile disk cache */
+	TMap<FString, FTileImageAnalysis> AnalysisCache;
+	bool bAnalysisCacheRequested = false;
+	bool bAnalysisCacheLoaded = false;
+
+	/** Analyses added since the last save; a save takes them over instead of copying AnalysisCache */
+	TMap<FString, FTileImageAnalysis> UnsavedAnalyses;
+
+	/** What the file holds, touched only by the load task and then by one save task at a time */
+	TSharedRef<TMap<FString, FTileImageAnalysis>, ESPMode::ThreadSafe> SavedAnalyses = MakeShared<TMap<FString, FTileImageAnalysis>, ESPMode::ThreadSafe>();
+	bool bAnalysisCacheSaving = false;
+
+	void LoadAnalysisCache();
+	void OnAnalysisCacheLoaded(TMap<FString, FTileImageAnalysis>&& Loaded);
+	/** Give tiles without an analysis their cached one; true if any got one */
+	bool ApplyCachedAnalyses();
+	/** Write the unsaved analyses unless a write is in flight; that one saves again when it finishes */
+	void SaveAnalysisCache();
 };
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "RoomDesignState.generated.h"
+
+class ARoomDesignState;
+class ULevel;
+class UMaterialInterface;
+class UPrimitiveComponent;
+
+/** One surface slot showing a catalog tile. Only the tile ID travels; each machine resolves it against its own palette. */
+USTRUCT()
+struct FRoomSurfaceAssignment : public FFastArraySerializerItem
+{
+    GENERATED_BODY()
+
+    /** Must be net-addressable, i.e. a component of an actor placed in the level */
+    UPROPERTY()
+    TObjectPtr<UPrimitiveComponent> Surface = nullptr;
+
+    UPROPERTY()
+    uint8 Slot = 0;
+
+    UPROPERTY()
+    FString TileID;
+
+    void PostReplicatedAdd(const struct FRoomDesignAssignments& InArraySerializer);
+    void PostReplicatedChange(const struct FRoomDesignAssignments& InArraySerializer);
+};
+
+/**
+ * Every assignment made in the session. Replicated as a fast array: after the first bunch,
+ * which is the snapshot a late joiner receives, only changed items are sent.
+ */
+USTRUCT()
+struct FRoomDesignAssignments : public FFastArraySerializer
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<FRoomSurfaceAssignment> Items;
+
+    /** Not replicated; set by the owning actor */
+    UPROPERTY(NotReplicated)
+    TObjectPtr<ARoomDesignState> Owner = nullptr;
+
+    bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+};
+
+template<>
+struct TStructOpsTypeTraits<FRoomDesignAssignments> : public TStructOpsTypeTraitsBase2<FRoomDesignAssignments>
+{
+    enum
+    {
+        WithNetDeltaSerializer = true,
+    };
+};
+
+/**
+ * Floor assignments shared by everyone in a co-design session. The server owns the state;
+ * clients send drops through Aroom_vizCharacter::ServerAssignTile and apply what replicates
+ * back. Tiles not in the local palette yet are applied once UUIUserWidget adds them.
+ *
+ * Try it on one machine with PIE (Net Mode: Play As Listen Server, 2+ players), or over
+ * loopback with a `-game -listen` instance and clients joining `127.0.0.1`.
+ * RoomViz.Design.Report logs replicated bytes per assignment on each side.
+ */
+UCLASS()
+class ROOM_VIZ_API ARoomDesignState : public AActor
+{
+    GENERATED_BODY()
+
+public:
+    ARoomDesignState();
+
+    /** The session's state, null until the game mode has spawned it (or it has replicated) */
+    static ARoomDesignState* Get(const UWorld* World);
+
+    virtual void PostInitializeComponents() override;
+    virtual void BeginPlay() override;
+    virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+    /** Server only: show TileID on Surface's material Slot for everyone */
+    void SetAssignment(UPrimitiveComponent* Surface, uint8 Slot, const FString& TileID);
+
+    /** Server only: forget the assignments of Level's surfaces, and of surfaces already gone; returns how many */
+    int32 RemoveAssignmentsIn(const ULevel* Level);
+
+    /** The local palette now has a material for TileID; apply the assignments waiting for it */
+    void OnTileMaterialAvailable(const FString& TileID);
+
+    /** Put the locally resolved material of Assignment on its surface; false if the tile is not in the palette */
+    bool ApplyAssignment(const FRoomSurfaceAssignment& Assignment) const;
+
+    /** Replicated bytes for this machine's side of the session, traffic accounted in NetDeltaSerialize */
+    void RecordTraffic(bool bSent, int64 Bits, int32 ItemsReceived);
+    void LogReport() const;
+
+    const TArray<FRoomSurfaceAssignment>& GetAssignments() const { return Assignments.Items; }
+
+private:
+    UMaterialInterface* ResolveTile(const FString& TileID) const;
+
+    UPROPERTY(Replicated)
+    FRoomDesignAssignments Assignments;
+
+    int32 NumAssignmentsMade = 0;
+    int32 NumItemsReceived = 0;
+    int64 BitsSent = 0;
+    int64 BitsReceived = 0;
+    int64 SnapshotBits = -1;
+    int32 SnapshotItems = 0;
+};
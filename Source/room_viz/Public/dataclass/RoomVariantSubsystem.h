@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RoomVariantSubsystem.generated.h"
+
+class ULevel;
+class ULevelStreamingDynamic;
+class UPrimitiveComponent;
+struct FRoomVariantConfig;
+
+/**
+ * Room variants (URoomVizTileSettings::RoomVariants) streamed into the persistent map as level
+ * instances, so switching rooms is an async load instead of a map travel: the tile manager, its
+ * caches, the palette and the shared design all stay. After each switch the room most often
+ * visited next is loaded hidden in the background, and switching to it only has to show it.
+ *
+ * Floor tiles follow the customer by surface ID (GetSurfaceIDs), which names a surface by its
+ * role in the room rather than by anything in the map, so rooms built separately still match.
+ * Surfaces with the same ID in the new room get the tiles of the old one through ARoomDesignState,
+ * on the server; the assignments of a room that unloads are dropped from it. The first room of
+ * the settings is shown when the game world begins play.
+ *
+ * Switching is local to the machine that asks; in a co-design session, switch on each of them.
+ */
+UCLASS()
+class ROOM_VIZ_API URoomVariantSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    static URoomVariantSubsystem* Get(const UWorld* World);
+
+    virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    virtual void Deinitialize() override;
+
+    /** Show room Name, streaming it in unless preloaded; the current room leaves once it is shown. False if unknown or already there */
+    bool SwitchToRoom(FName Name);
+
+    /** Load room Name hidden, so a later switch only has to show it */
+    bool PreloadRoom(FName Name);
+
+    /** The room most often switched to from From so far, else the one after it in the settings */
+    FName PredictNextRoom(FName From) const;
+
+    FName GetCurrentRoom() const { return CurrentRoom; }
+    bool IsSwitching() const { return !PendingRoom.IsNone(); }
+    bool IsRoomLoaded(FName Name) const;
+
+    /** Rooms let go of whose level is still in the world; streaming has to run until none are */
+    int32 GetNumRoomsUnloading() const;
+
+    struct FSwitchTiming
+    {
+        FName Room;
+        bool bPreloaded = false;
+        double Seconds = 0.0;
+    };
+
+    /** Request-to-visible time of every switch so far */
+    const TArray<FSwitchTiming>& GetSwitchTimings() const { return SwitchTimings; }
+    void LogReport() const;
+
+    /**
+     * IDs that carry a tile from room to room, for the static mesh surfaces of Level. A
+     * `Surface.<Name>` tag on the component or its actor wins. Otherwise it is the surface's role
+     * and its rank by area among the surfaces of that role: `Floor.0` is the room's largest floor,
+     * `Wall.1` its second largest wall, `Top.0` the largest raised horizontal surface (a counter,
+     * a ceiling). Other shapes get no ID and keep their tiles to themselves.
+     */
+    static TMap<const UPrimitiveComponent*, FName> GetSurfaceIDs(const ULevel* Level);
+
+    DECLARE_MULTICAST_DELEGATE_OneParam(FOnRoomShown, FName /*Room*/);
+    FOnRoomShown OnRoomShown;
+
+private:
+    UFUNCTION()
+    void HandleLevelShown();
+
+    UFUNCTION()
+    void HandleLevelLoaded();
+
+    ULevelStreamingDynamic* StreamRoom(const FRoomVariantConfig& Room, bool bVisible);
+    void UnloadRoom(FName Name);
+    void FinishSwitch();
+
+    /** Remember the tiles of every surface in the shared design by surface ID */
+    void CaptureAssignments();
+    int32 ApplyCarriedAssignments(ULevel* Level);
+
+    UPROPERTY()
+    TMap<FName, TObjectPtr<ULevelStreamingDynamic>> Rooms;
+
+    /** Rooms unloaded by UnloadRoom, until streaming has removed them */
+    TArray<TWeakObjectPtr<ULevelStreamingDynamic>> UnloadingRooms;
+
+    FName CurrentRoom;
+    FName PendingRoom;
+    bool bPendingPreloaded = false;
+    double SwitchStartTime = 0.0;
+
+    FName PreloadingRoom;
+    double PreloadStartTime = 0.0;
+
+    /** Switches from one room to another, for PredictNextRoom */
+    TMap<FName, TMap<FName, int32>> Transitions;
+
+    /** Tile per surface ID and material slot */
+    TMap<TPair<FName, uint8>, FString> CarriedTiles;
+
+    TArray<FSwitchTiming> SwitchTimings;
+};
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "RoomVizTileSettings.generated.h"
+
+class ITileCatalogSource;
+
+UENUM()
+enum class ETileCatalogSourceType : uint8
+{
+    /** Location is the catalog JSON URL */
+    Http,
+    /** Location is a folder, absolute or relative to the project directory */
+    LocalDirectory,
+    /** Location is a .pak file, absolute or relative to the project directory */
+    PakBundle,
+    /** Location is the name of a cooked tile pack (see URoomVizTilePackCommandlet) */
+    TilePack,
+};
+
+USTRUCT()
+struct FTileCatalogSourceConfig
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, Category = "Catalog")
+    ETileCatalogSourceType Type = ETileCatalogSourceType::Http;
+
+    UPROPERTY(EditAnywhere, Category = "Catalog")
+    FString Location;
+
+    /** When sources list the same tile ID, the highest priority wins */
+    UPROPERTY(EditAnywhere, Category = "Catalog")
+    int32 Priority = 0;
+
+    UPROPERTY(EditAnywhere, Category = "Catalog")
+    bool bEnabled = true;
+};
+
+/** A room streamed into the persistent map by URoomVariantSubsystem */
+USTRUCT()
+struct FRoomVariantConfig
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, Category = "Rooms")
+    FName Name;
+
+    /** Must not be a World Partition map; those cannot be streamed in as level instances */
+    UPROPERTY(EditAnywhere, Category = "Rooms", meta = (AllowedClasses = "/Script/Engine.World"))
+    FSoftObjectPath Map;
+
+    /** Where the room sits in the persistent map */
+    UPROPERTY(EditAnywhere, Category = "Rooms")
+    FTransform Transform;
+};
+
+/** One rung of the adaptive quality ladder: console variables set on top of the rungs above it */
+USTRUCT()
+struct FQualityStepConfig
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, Category = "Quality")
+    FName Name;
+
+    /** e.g. r.ScreenPercentage = 85; back to their startup values once quality climbs above this rung */
+    UPROPERTY(EditAnywhere, Category = "Quality")
+    TMap<FString, FString> ConsoleVariables;
+};
+
+/** Project Settings > Game > Room Viz Tiles */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Room Viz Tiles"))
+class ROOM_VIZ_API URoomVizTileSettings : public UDeveloperSettings
+{
+    GENERATED_BODY()
+
+public:
+    static const URoomVizTileSettings* Get() { return GetDefault<URoomVizTileSettings>(); }
+
+    /** Where tiles come from; all enabled sources are fetched and merged by priority */
+    UPROPERTY(config, EditAnywhere, Category = "Catalog")
+    TArray<FTileCatalogSourceConfig> CatalogSources;
+
+    /** Memory map local tile images instead of reading them into memory */
+    UPROPERTY(config, EditAnywhere, Category = "Catalog")
+    bool bMemoryMapLocalFiles = true;
+
+    /** Keep HTTP tile images in Saved/TileCache and load them from there on later runs (-run=RoomVizCatalogProfile -PopulateCache fills it ahead of time) */
+    UPROPERTY(config, EditAnywhere, Category = "Catalog")
+    bool bCacheHttpImages = true;
+
+    /** Size cap of the HTTP image cache; writes past it evict the least recently used images. 0 lets it grow without bound */
+    UPROPERTY(config, EditAnywhere, Category = "Catalog", meta = (ClampMin = "0", Units = "Megabytes", EditCondition = "bCacheHttpImages"))
+    int32 MaxHttpImageCacheMB = 2048;
+
+    /** Keep each tile's color analysis in Saved/TileCache/TileAnalysis.json, so the palette shows placeholders on later runs before any image arrives */
+    UPROPERTY(config, EditAnywhere, Category = "Catalog")
+    bool bCacheTileAnalysis = true;
+
+    /**
+     * Cap on the longer side of tile textures decoded at runtime. Bigger images are decoded at
+     * 1/2, 1/4 or 1/8 scale, the largest that fits (JPEGs decode directly at that scale), and
+     * box filtered the rest of the way if even 1/8 is too big. 0 keeps full resolution. Cooked
+     * tile packs are not affected.
+     */
+    UPROPERTY(config, EditAnywhere, Category = "Textures", meta = (ClampMin = "0"))
+    int32 MaxTileTextureSize = 2048;
+
+    /**
+     * Fetch tiles' normal, AO, roughness and metallic maps and bind them to the Normal and ORM
+     * parameters of the palette's base material. Off until M_BaseMaterial has those parameters;
+     * until then the maps would be downloaded, decoded and packed for nothing.
+     */
+    UPROPERTY(config, EditAnywhere, Category = "Textures")
+    bool bTilePBRMaps = false;
+
+    /** Rooms the customer can switch between without leaving the persistent map (RoomViz.Room.Switch) */
+    UPROPERTY(config, EditAnywhere, Category = "Rooms")
+    TArray<FRoomVariantConfig> RoomVariants;
+
+    const FRoomVariantConfig* FindRoomVariant(FName Name) const
+    {
+        return RoomVariants.FindByPredicate([Name](const FRoomVariantConfig& Room) { return Room.Name == Name; });
+    }
+
+    /** Step down QualityLadder at runtime to hold TargetFrameMs (UAdaptiveQualitySubsystem) */
+    UPROPERTY(config, EditAnywhere, Category = "Quality")
+    bool bAdaptiveQuality = true;
+
+    UPROPERTY(config, EditAnywhere, Category = "Quality", meta = (ClampMin = "1", EditCondition = "bAdaptiveQuality"))
+    float TargetFrameMs = 33.3f;
+
+    /** Cheaper settings in order; full quality is the project's own settings, above the first rung */
+    UPROPERTY(config, EditAnywhere, Category = "Quality", meta = (EditCondition = "bAdaptiveQuality"))
+    TArray<FQualityStepConfig> QualityLadder;
+
+    /** Serve pipeline counters at http://127.0.0.1:<MetricsPort>/metrics for a local Prometheus agent (RoomVizMetrics.h) */
+    UPROPERTY(config, EditAnywhere, Category = "Monitoring")
+    bool bMetricsEndpoint = false;
+
+    /** Needs a loopback listener override for the same port under [HTTPServer.Listeners] in DefaultEngine.ini */
+    UPROPERTY(config, EditAnywhere, Category = "Monitoring", meta = (ClampMin = "1", ClampMax = "65535", EditCondition = "bMetricsEndpoint"))
+    int32 MetricsPort = 9464;
+
+    /** Instantiate the enabled CatalogSources */
+    TArray<TSharedRef<ITileCatalogSource>> CreateCatalogSources() const;
+
+    /** Instantiate one source as CreateCatalogSources does, disk cache included; null for an empty location */
+    TSharedPtr<ITileCatalogSource> CreateCatalogSource(const FTileCatalogSourceConfig& Config) const;
+
+    int64 GetMaxHttpImageCacheBytes() const { return int64(MaxHttpImageCacheMB) * 1024 * 1024; }
+
+    virtual FName GetCategoryName() const override { return TEXT("Game"); }
+};
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Async/MappedFileHandle.h"
+#include "IImageWrapper.h"
+#include "dataclass/MaterialAPIManager.h"
+
+/**
+ * Bytes of one tile image. Depending on the source they are owned, borrowed from the HTTP
+ * response or memory mapped from disk; GetBytes hides the difference and never copies.
+ */
+struct ROOM_VIZ_API FTileImagePayload
+{
+    TArray<uint8> OwnedBytes;
+    FHttpResponsePtr Response;
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion; // Declared after MappedFile so it is released first
+
+    TConstArrayView<uint8> GetBytes() const;
+};
+
+using FTileImagePayloadPtr = TSharedPtr<FTileImagePayload, ESPMode::ThreadSafe>;
+
+/** A decoded 8-bit image */
+struct FDecodedTileImage
+{
+    FIntPoint Size = FIntPoint::ZeroValue;
+    TArray<uint8> Pixels;
+    /** Power-of-two scale the image was decoded at (1, 2, 4 or 8); a final resize to fit may shrink it further */
+    int32 ScaleDenominator = 1;
+};
+
+/**
+ * Decode JPEG or PNG bytes to 8-bit BGRA or gray. Safe on worker threads once the ImageWrapper
+ * module has been loaded on the game thread.
+ *
+ * With a MaxSize, the image's longer side comes out at MaxSize at most. It is decoded at the
+ * largest of 1/1, 1/2, 1/4 and 1/8 scale that fits (see ChooseDecodeScale); JPEGs are decoded
+ * directly at that scale in the DCT domain, so neither the time nor the memory of a full-size
+ * decode is paid, other formats are decoded at full size and box filtered down. Sources still
+ * too big at 1/8 are box filtered the rest of the way.
+ */
+ROOM_VIZ_API bool DecodeTileImage(TConstArrayView<uint8> Bytes, ERGBFormat Format, FDecodedTileImage& Out, int32 MaxSize = 0);
+
+/** Denominator of the largest power-of-two scale (down to 1/8) bringing SourceSize's longer side to MaxSize or less; 1 for MaxSize 0 */
+ROOM_VIZ_API int32 ChooseDecodeScale(FIntPoint SourceSize, int32 MaxSize);
+
+/** Called on the game thread with the catalog entries of one source */
+using FOnTileCatalogFetched = TUniqueFunction<void(bool bSuccess, TArray<FTileMaterialData>&& Tiles)>;
+
+/**
+ * Called with the image of one tile on whichever thread finished the transfer (HTTP or file IO
+ * thread, or a worker), never from inside FetchImage. Hand game-thread work over yourself, e.g.
+ * through an FTileCompletionInbox.
+ */
+using FOnTileImageFetched = TUniqueFunction<void(bool bSuccess, FTileImagePayloadPtr Payload)>;
+
+/** Called on the game thread with the cooked texture of one tile, null on failure */
+using FOnTileTextureFetched = TUniqueFunction<void(UTexture2D* Texture)>;
+
+/**
+ * Where tile catalogs and their images come from (HTTP, a local folder, a mounted bundle...).
+ * AMaterialAPIManager merges several sources by priority; see URoomVizTileSettings.
+ */
+class ROOM_VIZ_API ITileCatalogSource
+{
+public:
+    virtual ~ITileCatalogSource() = default;
+
+    /** Stamped on FTileMaterialData::SourceName for every tile this source provides */
+    virtual FName GetSourceName() const = 0;
+
+    /** When sources list the same tile ID, the highest priority wins */
+    virtual int32 GetPriority() const = 0;
+
+    virtual void FetchCatalog(FOnTileCatalogFetched&& OnComplete) = 0;
+    /** Fetch one image of a tile; Location is one of its catalog URLs (base color, normal...) */
+    virtual void FetchImage(const FString& Location, FOnTileImageFetched&& OnComplete) = 0;
+
+    /** Sources holding cooked textures hand them over through FetchTexture, skipping FetchImage and the decode */
+    virtual bool HasCookedTextures() const { return false; }
+    virtual void FetchTexture(const FTileMaterialData& Tile, FOnTileTextureFetched&& OnComplete) { OnComplete(nullptr); }
+};
+
+/** FloorTiles.json parsing shared by all sources */
+struct ROOM_VIZ_API FTileCatalogParser
+{
+    /**
+     * Parse a { "Tiles": [ { "id", "baseColorUrl" } ] } catalog. Entries may also carry
+     * "normalUrl", "aoUrl", "roughnessUrl" and "metallicUrl".
+     * Image locations without a scheme or absolute path are resolved against BaseLocation.
+     */
+    static bool Parse(const FString& Json, const FString& BaseLocation, TArray<FTileMaterialData>& OutTiles);
+
+    static FString ResolveLocation(const FString& Location, const FString& BaseLocation);
+};
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "dataclass/TileCatalogSource.h"
+
+/**
+ * Catalog JSON and images over HTTP(S); image bytes stay in the HTTP response.
+ *
+ * With a disk cache, images are kept under the cache folder by URL and read from there on
+ * later runs instead of downloaded. Catalogs publish changed images under new URLs, so
+ * entries are never revalidated; delete the folder to start over. Only complete JPEG/PNG
+ * bodies are cached, a cached file that fails to read or is truncated is deleted and
+ * downloaded again, and past a size cap the least recently used images are evicted.
+ */
+class ROOM_VIZ_API FHttpTileCatalogSource : public ITileCatalogSource
+{
+public:
+    FHttpTileCatalogSource(const FString& InCatalogURL, int32 InPriority);
+
+    virtual FName GetSourceName() const override { return SourceName; }
+    virtual int32 GetPriority() const override { return Priority; }
+    virtual void FetchCatalog(FOnTileCatalogFetched&& OnComplete) override;
+    virtual void FetchImage(const FString& Location, FOnTileImageFetched&& OnComplete) override;
+
+    /**
+     * Read images from and/or write downloads to Dir; an empty Dir turns the cache off. Writes
+     * evict the least recently used images once the folder holds more than MaxBytes (0: no cap).
+     */
+    void SetDiskCache(const FString& Dir, bool bRead, bool bWrite, int64 MaxBytes = 0);
+
+    /** Where the disk cache in Dir keeps the image at URL */
+    static FString GetDiskCachePath(const FString& Dir, const FString& URL);
+
+    /** Saved/TileCache, shared by every HTTP source of the project */
+    static FString GetDefaultDiskCacheDir();
+
+    /** Cache writes still in flight across all sources; wait for 0 before exiting a commandlet */
+    static int32 GetNumPendingDiskCacheWrites();
+
+    /** Whether Bytes hold a whole JPEG or PNG, end marker included; needs the ImageWrapper module loaded */
+    static bool IsCompleteImage(TConstArrayView<uint8> Bytes);
+
+private:
+    /** Download Location; CachePath non-empty writes a valid body to the disk cache */
+    static void Download(const FString& Location, const FString& CachePath, int64 MaxCacheBytes, FOnTileImageFetched&& OnComplete);
+
+    /** Write a downloaded image to the cache from a worker; a partial file never takes the final name */
+    static void WriteToDiskCache(const FString& Path, FTileImagePayloadPtr Payload, int64 MaxCacheBytes);
+
+    /** Delete the least recently used images of Dir until it holds less than MaxBytes; blocking, on a worker */
+    static void TrimDiskCache(const FString& Dir, int64 MaxBytes);
+
+    FString CatalogURL;
+    FName SourceName;
+    int32 Priority = 0;
+
+    FString DiskCacheDir;
+    int64 MaxDiskCacheBytes = 0;
+    bool bReadDiskCache = false;
+    bool bWriteDiskCache = false;
+};
+
+/**
+ * Tiles in a local folder (e.g. a NAS share). Uses Directory/FloorTiles.json when present,
+ * otherwise every .jpg/.jpeg/.png in the folder is a tile named after its file.
+ * Images are memory mapped on a worker when the platform file allows it, else read with async
+ * file I/O; either way the game thread never waits on the file system.
+ */
+class ROOM_VIZ_API FLocalDirectoryTileCatalogSource : public ITileCatalogSource
+{
+public:
+    FLocalDirectoryTileCatalogSource(const FString& InDirectory, int32 InPriority, bool bInMemoryMap);
+
+    virtual FName GetSourceName() const override { return SourceName; }
+    virtual int32 GetPriority() const override { return Priority; }
+    virtual void FetchCatalog(FOnTileCatalogFetched&& OnComplete) override;
+    virtual void FetchImage(const FString& Location, FOnTileImageFetched&& OnComplete) override;
+
+protected:
+    FString Directory;
+    FName SourceName;
+    int32 Priority = 0;
+    bool bMemoryMap = true;
+};
+
+/**
+ * A shipped .pak bundle holding a tile folder. The pak is mounted on first use and then read
+ * like a local directory through the pak platform file (cooked containers alongside it are
+ * mounted by the engine as well). Needs the pak platform file, i.e. packaged or -pak runs.
+ */
+class ROOM_VIZ_API FPakBundleTileCatalogSource : public FLocalDirectoryTileCatalogSource
+{
+public:
+    FPakBundleTileCatalogSource(const FString& InPakPath, int32 InPriority);
+    virtual ~FPakBundleTileCatalogSource() override;
+
+    virtual void FetchCatalog(FOnTileCatalogFetched&& OnComplete) override;
+
+private:
+    bool Mount();
+
+    FString PakPath;
+    bool bMounted = false;
+};
+
+/**
+ * A cooked tile pack made by the RoomVizTilePack commandlet. Location is the pack name; the
+ * manifest and textures are streamed through the engine loader from whatever container holds
+ * them (the pack's chunk in the Paks folder in packaged builds, loose assets in the editor).
+ */
+class ROOM_VIZ_API FTilePackCatalogSource : public ITileCatalogSource
+{
+public:
+    FTilePackCatalogSource(FName InPackName, int32 InPriority);
+
+    virtual FName GetSourceName() const override { return SourceName; }
+    virtual int32 GetPriority() const override { return Priority; }
+    virtual void FetchCatalog(FOnTileCatalogFetched&& OnComplete) override;
+    virtual void FetchImage(const FString& Location, FOnTileImageFetched&& OnComplete) override;
+    virtual bool HasCookedTextures() const override { return true; }
+    virtual void FetchTexture(const FTileMaterialData& Tile, FOnTileTextureFetched&& OnComplete) override;
+
+private:
+    FName PackName;
+    FName SourceName;
+    int32 Priority = 0;
+
+    /** Keeps the manifest loaded while the source is alive */
+    TSharedPtr<struct FStreamableHandle> ManifestHandle;
+};
+
+/** Reads a whole file with IAsyncReadFileHandle; OnComplete runs on a worker thread */
+ROOM_VIZ_API void ReadTileFileAsync(const FString& Path, TUniqueFunction<void(bool bSuccess, TArray<uint8>&& Bytes)>&& OnComplete);
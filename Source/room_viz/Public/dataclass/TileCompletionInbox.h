@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+/**
+ * Hand-off from the threads finishing tile transfers (HTTP, file IO) to the game thread.
+ * Producers push lock-free from any thread; the game thread drains under a time budget, so a
+ * slow frame delays only the game-thread half of a completion, never the transfers themselves.
+ * Owners share it with their callbacks, which keeps pushes safe after the owner is gone.
+ */
+class ROOM_VIZ_API FTileCompletionInbox
+{
+public:
+    using FCompletion = TUniqueFunction<void()>;
+
+    /** Any thread */
+    void Push(FCompletion&& Completion);
+
+    /** Game thread: run completions in arrival order until BudgetSeconds have passed, at least one. Returns the number run */
+    int32 Drain(double BudgetSeconds);
+
+    int32 Num() const { return NumPending.load(std::memory_order_relaxed); }
+    bool IsEmpty() const { return Num() == 0; }
+
+private:
+    TQueue<FCompletion, EQueueMode::Mpsc> Queue;
+    std::atomic<int32> NumPending = 0;
+};
+
+using FTileCompletionInboxRef = TSharedRef<FTileCompletionInbox, ESPMode::ThreadSafe>;
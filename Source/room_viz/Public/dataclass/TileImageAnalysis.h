@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileImageAnalysis.generated.h"
+
+class FJsonObject;
+struct FDecodedTileImage;
+
+/**
+ * Color summary of a tile's base color image, computed on the decode worker (see
+ * TileImageAnalysis::Analyze) and kept in the tile disk cache, so the palette can draw a
+ * placeholder and sort by color before the texture exists.
+ */
+USTRUCT(BlueprintType)
+struct FTileImageAnalysis
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+    FColor AverageColor = FColor::Black;
+
+    /** Mean of the most common color, quantized to 3 bits per channel */
+    UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+    FColor DominantColor = FColor::Black;
+
+    /** Share of pixels per luminance band, darkest first; sums to 1 */
+    UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+    TArray<float> LuminanceHistogram;
+
+    /** PlaceholderSize x PlaceholderSize mean colors, row major, meant to be drawn bilinearly filtered */
+    UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tile")
+    TArray<FColor> Placeholder;
+
+    bool IsValid() const { return Placeholder.Num() > 0; }
+};
+
+namespace TileImageAnalysis
+{
+    constexpr int32 PlaceholderSize = 4;
+    constexpr int32 NumLuminanceBins = 16;
+
+    /** Rows summed per placeholder cell row at most; the histogram takes every fourth pixel of them */
+    constexpr int32 MaxRowsPerCell = 32;
+
+    /** Sum the B, G and R bytes of NumPixels BGRA8 pixels. SSE2 or NEON with a scalar tail */
+    ROOM_VIZ_API void SumBGR(const uint8* BGRA, int32 NumPixels, uint64 OutSums[3]);
+
+    /**
+     * Average and dominant color, luminance histogram and placeholder of a decoded BGRA image.
+     * Reads at most MaxRowsPerCell evenly spaced rows per placeholder row, so the cost grows with
+     * the width only; false for an empty image. Thread safe.
+     */
+    ROOM_VIZ_API bool Analyze(const FDecodedTileImage& Image, FTileImageAnalysis& Out);
+
+    ROOM_VIZ_API TSharedRef<FJsonObject> ToJson(const FTileImageAnalysis& Analysis);
+    ROOM_VIZ_API bool FromJson(const FJsonObject& Json, FTileImageAnalysis& Out);
+
+    /** The analysis cache of a tile disk cache folder, next to its images (FHttpTileCatalogSource::GetDefaultDiskCacheDir) */
+    ROOM_VIZ_API FString GetCachePath(const FString& DiskCacheDir);
+
+    /** Analyses by base color URL; blocking file IO, keep it off the game thread */
+    ROOM_VIZ_API bool LoadCache(const FString& Path, TMap<FString, FTileImageAnalysis>& Out);
+    ROOM_VIZ_API bool SaveCache(const FString& Path, const TMap<FString, FTileImageAnalysis>& Analyses);
+}
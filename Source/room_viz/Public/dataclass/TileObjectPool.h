@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "PixelFormat.h"
+#include "TileObjectPool.generated.h"
+
+class UMaterialInstanceDynamic;
+class UMaterialInterface;
+class UTexture2D;
+
+/**
+ * Owner of the runtime objects a catalog creates: transient tile textures (AMaterialAPIManager)
+ * and palette material instances (UUIUserWidget). Objects are created inside the pool and their
+ * users are counted through AddRef / Release rather than inferred from whoever still holds a
+ * copy. Unused objects leave at Trim, which the owner calls when a batch is done (catalog ready,
+ * palette built), so release happens at known points instead of whenever reachability says.
+ *
+ * With RoomViz.GC.ClusterTiles the pool is the root of a GC cluster holding its objects, and
+ * reachability analysis handles the catalog as one cluster instead of thousands of objects.
+ * RoomViz.GC.Report lists the pools; -run=RoomVizBenchmark -GC times collections against them.
+ */
+UCLASS(Transient)
+class ROOM_VIZ_API UTileObjectPool : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    /** New transient texture owned by the pool, unused until AddRef */
+    UTexture2D* CreateTexture(FIntPoint Size, EPixelFormat Format);
+
+    /** New instance of Parent owned by the pool, unused until AddRef */
+    UMaterialInstanceDynamic* CreateMaterial(UMaterialInterface* Parent);
+
+    /** One more user of Object; false (and nothing counted) if the pool does not own it */
+    bool AddRef(UObject* Object);
+    bool Release(UObject* Object);
+    int32 GetRefCount(const UObject* Object) const;
+
+    /**
+     * Let go of the objects nobody uses, then group the rest into the cluster again. With
+     * RoomViz.GC.DestroyReleased they are marked as garbage on the spot. Returns how many left.
+     */
+    int32 Trim();
+
+    /** Let go of everything, used or not */
+    void Reset();
+
+    /**
+     * Build the cluster again after its objects gained references (a material instance given
+     * new textures, say). References added after clustering are not traced otherwise.
+     */
+    void Recluster();
+
+    int32 GetNumObjects() const { return Objects.Num(); }
+    int32 GetNumUnused() const;
+    bool IsClustered() const;
+    void LogReport() const;
+
+    virtual bool CanBeClusterRoot() const override;
+    virtual void BeginDestroy() override;
+
+private:
+    void Adopt(UObject* Object, int64 Bytes);
+    void DissolveCluster();
+
+    /** Take Objects[Index] out of the RoomVizMetrics gauges */
+    void UntrackMetrics(int32 Index);
+
+    UPROPERTY()
+    TArray<TObjectPtr<UObject>> Objects;
+
+    /** Users of Objects[i] */
+    TArray<int32> RefCounts;
+    /** Memory of Objects[i] if it is a texture; 0 for material instances */
+    TArray<int64> TextureBytes;
+    TMap<const UObject*, int32> IndexOf;
+};
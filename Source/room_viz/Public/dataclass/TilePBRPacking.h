@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "dataclass/TileCatalogSource.h"
+
+/** Encoded PBR maps of one tile, any of which may be missing */
+struct FTilePBRSources
+{
+    FTileImagePayloadPtr Normal;
+    FTileImagePayloadPtr AO;
+    FTileImagePayloadPtr Roughness;
+    FTileImagePayloadPtr Metallic;
+};
+
+/** Decoded BGRA8 texels ready for upload; empty arrays for maps the tile does not have */
+struct FTilePBRTexels
+{
+    FIntPoint NormalSize = FIntPoint::ZeroValue;
+    TArray<uint8> Normal;
+    FIntPoint ORMSize = FIntPoint::ZeroValue;
+    TArray<uint8> ORM;
+};
+
+namespace TilePBRPacking
+{
+    /** Values used for a channel whose map is missing */
+    constexpr uint8 DefaultAO = 255;
+    constexpr uint8 DefaultRoughness = 128;
+    constexpr uint8 DefaultMetallic = 0;
+
+    /**
+     * Interleave three 8-bit maps into BGRA8 ORM texels: R = AO, G = roughness, B = metallic,
+     * A = 255. Null inputs are filled with the defaults. SSE2 or NEON with a scalar tail.
+     */
+    ROOM_VIZ_API void PackORM(const uint8* AO, const uint8* Roughness, const uint8* Metallic, uint8* OutBGRA, int32 NumPixels);
+
+    /** PackORM split across worker threads */
+    ROOM_VIZ_API void PackORMParallel(const uint8* AO, const uint8* Roughness, const uint8* Metallic, uint8* OutBGRA, int32 NumPixels);
+
+    /**
+     * Decode the maps and pack AO/roughness/metallic into one ORM image. Maps whose size differs
+     * from the first present one are dropped. MaxSize caps the decode as in DecodeTileImage.
+     * Thread safe; meant for worker threads.
+     */
+    ROOM_VIZ_API void DecodeAndPack(const FTilePBRSources& Sources, FTilePBRTexels& Out, int32 MaxSize = 0);
+}
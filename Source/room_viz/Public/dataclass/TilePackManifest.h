@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "TilePackManifest.generated.h"
+
+class UTexture2D;
+
+USTRUCT(BlueprintType)
+struct FTilePackEntry
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tile")
+    FString ID;
+
+    /** Cooked texture, loaded on demand */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tile")
+    TSoftObjectPtr<UTexture2D> Texture;
+
+    /** Where the image was taken from when the pack was built */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tile")
+    FString SourceURL;
+};
+
+/**
+ * Table of contents of a cooked tile pack, written by the RoomVizTilePack commandlet.
+ * A pack lives in /Game/TilePacks/<PackName>/ and is assigned to its own chunk by a
+ * primary asset label next to this manifest.
+ */
+UCLASS(BlueprintType)
+class ROOM_VIZ_API UTilePackManifest : public UDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tile Pack")
+    FName PackName;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tile Pack")
+    TArray<FTilePackEntry> Tiles;
+
+    /** Long package path of a pack's folder, e.g. /Game/TilePacks/Showroom */
+    static FString GetPackFolder(FName InPackName);
+
+    /** Object path of a pack's manifest */
+    static FSoftObjectPath GetManifestPath(FName InPackName);
+};
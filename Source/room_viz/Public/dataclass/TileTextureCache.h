@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class FReferenceCollector;
+class UTexture2D;
+
+/**
+ * Tile textures keyed by content hash, so catalog entries with identical images share one
+ * texture. Hashes of the encoded bytes and, optionally, of the decoded pixels both map to the
+ * texture. Each tile holds one reference; a texture is dropped when its last tile is released,
+ * and only textures some tile holds are in the cache at all.
+ * The owner keeps the textures alive by forwarding its AddReferencedObjects.
+ */
+class ROOM_VIZ_API FTileTextureCache
+{
+public:
+    /** Texture registered under Hash, if any */
+    UTexture2D* Find(uint64 Hash) const;
+
+    /**
+     * Register Hash for Texture; ResourceBytes is what each extra user of it saves. Ignored
+     * unless a tile has acquired Texture, so acquire first.
+     */
+    void AddHash(UTexture2D* Texture, uint64 Hash, int64 ResourceBytes);
+
+    /** TileID now uses Texture, replacing its previous one */
+    void Acquire(const FString& TileID, UTexture2D* Texture);
+    void Release(const FString& TileID);
+    void Reset();
+
+    static uint64 HashBytes(TConstArrayView<uint8> Bytes);
+
+    int32 GetNumTiles() const { return TileTextures.Num(); }
+    int32 GetNumTextures() const { return Entries.Num(); }
+
+    /** Tiles per unique texture, 1 when nothing is shared */
+    double GetDedupRatio() const;
+
+    /** Texture memory not allocated thanks to sharing */
+    int64 GetBytesSaved() const;
+
+    /** Forwarded from the owner's AddReferencedObjects */
+    void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+    struct FEntry
+    {
+        TObjectPtr<UTexture2D> Texture;
+        TArray<uint64, TInlineAllocator<2>> Hashes;
+        int64 ResourceBytes = 0;
+        int32 RefCount = 0;
+    };
+
+    // Keyed by object key, so a texture allocated where a collected one was never matches its entry
+    TMap<uint64, TObjectKey<UTexture2D>> TexturesByHash;
+    TMap<TObjectKey<UTexture2D>, FEntry> Entries;
+    TMap<FString, TObjectKey<UTexture2D>> TileTextures;
+};
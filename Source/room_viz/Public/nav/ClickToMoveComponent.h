@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "NavigationSystemTypes.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "AITypes.h"
+#include "ClickToMoveComponent.generated.h"
+
+class AController;
+class ANavigationData;
+class UPathFollowingComponent;
+struct FPathFollowingResult;
+
+/**
+ * Click/touch-to-move for a player pawn.
+ * RequestMoveTo can be called every frame while the button is held: goals are coalesced so that
+ * at most one async path query is in flight, and goals landing near the path being followed
+ * reuse that path instead of re-planning.
+ */
+UCLASS(ClassGroup = (Navigation), meta = (BlueprintSpawnableComponent))
+class ROOM_VIZ_API UClickToMoveComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    UClickToMoveComponent();
+
+    /** Move the owning pawn towards Goal (world space) */
+    UFUNCTION(BlueprintCallable, Category = "Navigation")
+    void RequestMoveTo(const FVector& Goal);
+
+    /** Drop any pending goal, cancel the in-flight query and stop path following */
+    UFUNCTION(BlueprintCallable, Category = "Navigation")
+    void StopMove();
+
+    /** New goals closer than this to the current goal are ignored */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation")
+    float GoalTolerance = 30.f;
+
+    /** New goals closer than this to the remaining path are reached by refining the path's tail */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation")
+    float PathReuseDistance = 150.f;
+
+    /** Minimum time between two async path queries, in seconds */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation")
+    float MinRepathInterval = 0.1f;
+
+    /** Draw the followed path (non-shipping builds only) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation")
+    bool bDrawDebugPath = false;
+
+    // Counters, handy for checking that navigation cost stays flat while dragging
+    int32 GetNumMoveRequests() const { return NumMoveRequests; }
+    int32 GetNumPathQueries() const { return NumPathQueries; }
+    int32 GetNumPathReuses() const { return NumPathReuses; }
+    bool IsQueryInFlight() const { return InFlightQueryID != INVALID_NAVQUERYID; }
+
+protected:
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+    void IssuePathQuery(const FVector& Goal);
+    void OnPathQueryFinished(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+    /** Serve Goal from the path being followed; false if a fresh query is needed */
+    bool TryReusePath(const FVector& Goal);
+    void FollowPath(const FVector& Goal, FNavPathSharedPtr Path);
+
+    /** Path following is done with our move (arrived, blocked or aborted); the goal no longer holds */
+    void OnMoveFinished(FAIRequestID RequestID, const FPathFollowingResult& Result);
+
+    AController* GetController() const;
+    const ANavigationData* GetNavData() const;
+    UPathFollowingComponent* GetPathFollowing();
+
+    FNavPathSharedPtr CurrentPath;
+    FVector CurrentGoal = FVector::ZeroVector;
+    FVector PendingGoal = FVector::ZeroVector;
+    bool bHasGoal = false;
+    bool bHasPendingGoal = false;
+    FAIRequestID MoveRequestID;
+
+    uint32 InFlightQueryID = INVALID_NAVQUERYID;
+    double LastQueryTime = -UE_BIG_NUMBER;
+
+    TWeakObjectPtr<UPathFollowingComponent> PathFollowing;
+
+    int32 NumMoveRequests = 0;
+    int32 NumPathQueries = 0;
+    int32 NumPathReuses = 0;
+};
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpRouteHandle.h"
+#include "HttpResultCallback.h"
+#include "Containers/Ticker.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+struct FHttpServerResponse;
+
+/** What the stand-in serves and how slow the simulated link is */
+struct FCatalogStandInConfig
+{
+    int32 Port = 8089;
+    int32 TileCount = 100;
+    int32 TileSize = 1024;
+    /** Serve PNG instead of JPEG tiles */
+    bool bPNG = false;
+    int32 JpegQuality = 85;
+    /** Added to every response */
+    float LatencyMs = 0.f;
+    /** Shared link bandwidth in MB/s, 0 = unlimited */
+    float BandwidthMBps = 0.f;
+
+    /** Read -StandInPort= -TileCount= -TileSize= -PNG -JpegQuality= -LatencyMs= -BandwidthMBps= */
+    void ParseCommandLine(const TCHAR* Params);
+};
+
+/**
+ * Local HTTP server that imitates the remote tile catalog: /FloorTiles.json lists TileCount
+ * synthetic tiles served from /tiles/:id. Responses are delayed to model latency and a
+ * bandwidth-limited link. Runs on the HTTPServer module, so it needs the core ticker pumped.
+ */
+class ROOM_VIZ_API FCatalogStandInServer
+{
+public:
+    explicit FCatalogStandInServer(const FCatalogStandInConfig& InConfig);
+    ~FCatalogStandInServer();
+
+    /** Generate the tile images and start listening; false if the port could not be bound */
+    bool Start();
+    void Stop();
+
+    FString GetCatalogURL() const;
+    FString GetTileURL(int32 Index) const;
+
+    /** Write the same catalog as FloorTiles.json plus image files into Dir, for local-source runs */
+    bool WriteToDirectory(const FString& Dir);
+
+    /** The synthetic image served for tile Index; thread safe once ImageWrapper is loaded */
+    static TArray64<uint8> EncodeSyntheticTile(int32 Index, int32 Size, bool bPNG, int32 JpegQuality = 85);
+
+    const FCatalogStandInConfig& GetConfig() const { return Config; }
+    int64 GetServedBytes() const { return ServedBytes; }
+
+private:
+    bool HandleCatalog(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+    bool HandleTile(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+    /** Queue a response behind the simulated link */
+    void Send(TUniquePtr<FHttpServerResponse> Response, int64 NumBytes, const FHttpResultCallback& OnComplete);
+    bool TickPending(float DeltaTime);
+
+    void GenerateTiles();
+    FString BuildCatalogJson(TFunctionRef<FString(int32)> TileLocation) const;
+
+    struct FPendingResponse
+    {
+        double DueTime = 0.0;
+        TUniquePtr<FHttpServerResponse> Response;
+        FHttpResultCallback OnComplete;
+    };
+
+    FCatalogStandInConfig Config;
+    TSharedPtr<IHttpRouter> Router;
+    FHttpRouteHandle CatalogRoute;
+    FHttpRouteHandle TileRoute;
+    FTSTicker::FDelegateHandle TickerHandle;
+
+    TArray<TArray64<uint8>> TileImages;
+    TArray<FPendingResponse> Pending;
+    double LinkFreeTime = 0.0;
+    int64 ServedBytes = 0;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoomVizBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless load benchmark of the tile pipeline against a local catalog stand-in.
+ *
+ *   UnrealEditor-Cmd room_viz.uproject -run=RoomVizBenchmark -nullrhi -unattended
+ *       [-TileCount=100] [-TileSize=1024] [-PNG] [-LatencyMs=0] [-BandwidthMBps=0]
+ *       [-Source=http|local|pak|pack] [-PakPath=<bundle.pak>] [-Pack=<Name>] [-NoMemoryMap]
+ *       [-GameThreadLoadMs=0] [-CatalogURL=<url>] [-Label=<commit>] [-Output=<path.json>] [-Timeout=600]
+ *
+ * Reports time to first tile, time to catalog-complete, peak memory, game-thread frame time
+ * distribution and palette build time as JSON (Saved/Benchmarks by default).
+ * -GameThreadLoadMs burns that long on the game thread every frame, to check that catalog
+ * throughput does not depend on frame time. The stand-in itself answers from the game thread,
+ * so such runs should use -CatalogURL with a stand-in or server running in another process.
+ *
+ * With -Decode it instead times DecodeTileImage at 1/1 to 1/8 scale on synthetic sources,
+ * with the peak memory of each decode: [-DecodeSizes=4096,8192] [-Iterations=5] [-PNG].
+ *
+ * With -Analysis it times the tile image analysis against the decode it follows, at the runtime
+ * decode size; exit code 2 when it adds more than -MaxOverheadPercent:
+ * [-AnalysisSizes=1024,2048,4096] [-Iterations=20] [-MaxOverheadPercent=5] [-PNG].
+ *
+ * With -GC it times full garbage collections with 100, 1k and 5k tiles' textures, material
+ * instances and palette entries loaded, clustered and not: [-GCTileCounts=100,1000,5000] [-Iterations=5].
+ *
+ * With -Rooms it times switches between the RoomVariants of the settings, cold and with the room
+ * preloaded: [-Map=<persistent map>] [-Passes=3] [-Timeout=120].
+ *
+ * With -Quality it runs the adaptive quality controller's decisions (FAdaptiveQualityPolicy)
+ * against synthetic frame-time traces, no rendering needed; exit code 2 when one misbehaves.
+ *
+ * With -BoxSelect it times marquee selection updates (FFloorBoxSelection) over a grid of floors,
+ * projected on workers and on the game thread: [-Floors=4000] [-Frames=300] [-BudgetMs=4].
+ *
+ * With -NavPath it builds the living-room navmesh, checks paths from the player start and drags
+ * a click-to-move goal across the room (UClickToMoveComponent); exit code 2 when paths are
+ * missing or the path queries do not stay coalesced and flat:
+ * [-Map=/Game/ModernLivingRoom/Maps/Main] [-Goals=20] [-Radius=1500] [-Frames=600] [-DragSpeed=600].
+ */
+UCLASS()
+class URoomVizBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    URoomVizBenchmarkCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
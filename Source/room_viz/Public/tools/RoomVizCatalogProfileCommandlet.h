@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoomVizCatalogProfileCommandlet.generated.h"
+
+/**
+ * Runtime cost of every tile in a catalog, for the content team before they publish.
+ *
+ *   UnrealEditor-Cmd room_viz.uproject -run=RoomVizCatalogProfile -nullrhi -unattended
+ *       [-Catalog=<url> | -Dir=<folder> | -StandIn [-TileCount=1000 ...]] [-MaxTiles=N]
+ *       [-Workers=N] [-MaxDownloads=16]
+ *       [-MaxSourceMB=8] [-MaxDimension=4096] [-MaxDecodeMs=200] [-MaxRuntimeMB=32]
+ *       [-PopulateCache [-CacheDir=<folder>]] [-Output=<path.json>] [-Timeout=1800]
+ *
+ * Tiles go through the same steps as in AMaterialAPIManager: every map is fetched from the
+ * source, then decoded at MaxTileTextureSize and PBR-packed on -Workers task-graph workers
+ * (all of them by default). Per tile the report lists the encoded bytes, full and runtime
+ * dimensions, fetch and decode times, the texture memory the app allocates and an estimate of
+ * the same textures with mips and block compression, as a cooked tile pack holds them.
+ *
+ * Tiles over a budget, or that fail to fetch or decode, are listed with the reason and fail
+ * the run with exit code 2. The JSON report (Saved/Benchmarks by default) has a CSV twin next
+ * to it. With -PopulateCache, HTTP downloads and each tile's color analysis are also written to
+ * the client disk cache (Saved/TileCache unless -CacheDir), so kiosks imaged from this machine
+ * start warm, placeholders included.
+ */
+UCLASS()
+class URoomVizCatalogProfileCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    URoomVizCatalogProfileCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/StrongObjectPtr.h"
+
+class AActor;
+class FJsonObject;
+class UGameInstance;
+class UWorld;
+
+/**
+ * Standalone game instance and world for commandlets (-nullrhi friendly).
+ * Nothing ticks on its own: Pump runs one frame of tickers, HTTP, game-thread tasks and the
+ * registered actors, and records the frame's game-thread work time.
+ */
+class ROOM_VIZ_API FRoomVizHeadlessSession
+{
+public:
+    FRoomVizHeadlessSession();
+    ~FRoomVizHeadlessSession();
+
+    UWorld* GetWorld() const;
+    UGameInstance* GetGameInstance() const { return GameInstance.Get(); }
+
+    /** Replace the empty world with MapName (a package path such as /Game/Maps/Room); false on failure */
+    bool LoadMap(const FString& MapName);
+
+    /** Actors spawned into a headless world never begin play, so they are ticked from Pump */
+    void AddTickedActor(AActor* Actor);
+
+    /** Also flush async package loading and update level streaming in Pump, for streamed rooms (URoomVariantSubsystem) */
+    void SetUpdateLevelStreaming(bool bUpdate) { bUpdateLevelStreaming = bUpdate; }
+
+    /** Run one frame, then sleep out the rest of DeltaTime. Returns the frame's work time in seconds */
+    double Pump(float DeltaTime);
+
+    /** Pump at FrameDelta until Predicate holds; false on timeout */
+    bool PumpUntil(TFunctionRef<bool()> Predicate, double TimeoutSeconds, float FrameDelta = 1.f / 60.f);
+
+    const TArray<double>& GetFrameTimes() const { return FrameTimes; }
+    void ResetFrameTimes() { FrameTimes.Reset(); }
+
+    /** Highest process physical memory seen by Pump */
+    uint64 GetPeakUsedPhysical() const { return PeakUsedPhysical; }
+
+private:
+    TStrongObjectPtr<UGameInstance> GameInstance;
+    TArray<TWeakObjectPtr<AActor>> TickedActors;
+    TArray<double> FrameTimes;
+    uint64 PeakUsedPhysical = 0;
+    bool bUpdateLevelStreaming = false;
+};
+
+/**
+ * Label= and Output= of a commandlet report, and the header fields every report starts with,
+ * so the commandlets' outputs stay comparable.
+ */
+struct ROOM_VIZ_API FRoomVizReportOutput
+{
+    FString Label;
+    /** Output=, or Saved/Benchmarks/<DefaultName> */
+    FString OutputPath;
+
+    FRoomVizReportOutput(const TCHAR* Params, const FString& DefaultName);
+
+    /** <Prefix>-<local time>.json, for reports that should not overwrite the previous run's */
+    static FString MakeTimestampedName(const TCHAR* Prefix);
+
+    /** A report with benchmark, label, timestamp and build_config set */
+    TSharedRef<FJsonObject> MakeReport(const TCHAR* Benchmark) const;
+
+    /** Serialize Report to Path (OutputPath by default); false, logged, if it could not be written */
+    bool Write(const TSharedRef<FJsonObject>& Report) const { return Write(Report, OutputPath); }
+    static bool Write(const TSharedRef<FJsonObject>& Report, const FString& Path);
+};
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RoomVizInputRecording.generated.h"
+
+class UWorld;
+
+UENUM()
+enum class ERoomVizInputEventType : uint8
+{
+    PointerDown,
+    DragDetected,
+    DragOver,
+    Drop,
+    PointerUp,
+    DragCancelled,
+    Camera,
+};
+
+/**
+ * One step of the palette drag/drop path. Pointer events carry the world ray they were
+ * deprojected to, so a replay needs neither a viewport nor the recorded screen size.
+ */
+USTRUCT()
+struct FRoomVizInputEvent
+{
+    GENERATED_BODY()
+
+    /** Seconds since the recording started */
+    UPROPERTY()
+    double Time = 0.0;
+
+    UPROPERTY()
+    ERoomVizInputEventType Type = ERoomVizInputEventType::PointerDown;
+
+    UPROPERTY()
+    FVector2D ScreenPosition = FVector2D::ZeroVector;
+
+    UPROPERTY()
+    FVector RayOrigin = FVector::ZeroVector;
+
+    UPROPERTY()
+    FVector RayDirection = FVector::ZeroVector;
+
+    /** Palette entry (tile ID) the event is about */
+    UPROPERTY()
+    FString Entry;
+
+    // Camera events
+    UPROPERTY()
+    FVector CameraLocation = FVector::ZeroVector;
+
+    UPROPERTY()
+    FRotator CameraRotation = FRotator::ZeroRotator;
+
+    UPROPERTY()
+    FVector PawnLocation = FVector::ZeroVector;
+};
+
+USTRUCT()
+struct FRoomVizInputRecording
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    int32 Version = 1;
+
+    /** Map the session was recorded in */
+    UPROPERTY()
+    FString Map;
+
+    UPROPERTY()
+    TArray<FRoomVizInputEvent> Events;
+
+    bool SaveToFile(const FString& Path) const;
+    bool LoadFromFile(const FString& Path);
+};
+
+/**
+ * Records the drag/drop path of a live session (RoomViz.Record.Start / RoomViz.Record.Stop).
+ * UUIUserWidget feeds it pointer events; camera and pawn moves are sampled every frame.
+ * Recordings go to Saved/InputRecordings and are replayed by -run=RoomVizReplay.
+ */
+namespace RoomVizInputRecorder
+{
+    ROOM_VIZ_API void Start(UWorld* World);
+
+    /** Stop and save; returns the file written, empty if nothing was recording or the save failed */
+    ROOM_VIZ_API FString Stop(const FString& Name = FString());
+
+    ROOM_VIZ_API bool IsRecording();
+
+    /** Append Event, stamped with the time since Start */
+    ROOM_VIZ_API void Record(FRoomVizInputEvent&& Event);
+}
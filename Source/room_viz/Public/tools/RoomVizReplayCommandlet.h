@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoomVizReplayCommandlet.generated.h"
+
+/**
+ * Headless replay of recorded drag/drop sessions (RoomViz.Record.Start / Stop) against
+ * UUIUserWidget and the character, at a fixed timestep.
+ *
+ *   UnrealEditor-Cmd room_viz.uproject -run=RoomVizReplay -nullrhi -unattended
+ *       -Recording=<session.json or folder of them> [-Map=<package>] [-NoMap] [-CatalogURL=<url>]
+ *       [-FixedStep=0.016667] [-Output=<folder>] [-Timeout=600]
+ *       [-Baseline=<report.json or folder of them>] [-MaxRegressionPct=20] [-MinRegressionMs=0.05]
+ *
+ * Writes <session>.replay.json per recording with the game-thread cost of each event type and
+ * the frame time distribution. With -Baseline, a p95 event cost above the baseline's by more
+ * than the allowed margin fails the run (exit code 2), so a suite of sessions can gate builds.
+ */
+UCLASS()
+class URoomVizReplayCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    URoomVizReplayCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
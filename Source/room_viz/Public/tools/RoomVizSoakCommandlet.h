@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoomVizSoakCommandlet.generated.h"
+
+/**
+ * Long-running leak check: respawns the character, which brings a new palette and a catalog
+ * refresh, and simulates drops against the local catalog stand-in, the way a kiosk runs for weeks.
+ *
+ *   UnrealEditor-Cmd room_viz.uproject -run=RoomVizSoak -nullrhi -unattended
+ *       [-Duration=3600] [-Cycles=0] [-DropsPerCycle=200] [-WarmupCycles=3]
+ *       [-TileCount=100] [-TileSize=256] [-PNG] [-Map=<package>]
+ *       [-MaxObjectGrowthPct=5] [-MaxRSSGrowthMB=64] [-MaxTextureGrowthMB=16]
+ *       [-Output=<path.json>] [-Timeout=600]
+ *
+ * Each cycle destroys the previous Aroom_vizCharacter and spawns a new one; its BeginPlay and
+ * EndPlay create and remove the palette as in the game, and the palette's construction binds it
+ * to the manager and refreshes the catalog. After each cycle it collects garbage and samples
+ * live UObjects per class, tile texture memory and process RSS.
+ *
+ * Past the warm-up, a class that gained at least one object per cycle has leaked, however small
+ * its count; totals fail when their steady rise (least-squares trend over the run) exceeds the
+ * allowed growth. Either fails the run with exit code 2. The JSON report (Saved/Benchmarks by
+ * default) lists the classes that grew, with their counts at the start and end of the run.
+ */
+UCLASS()
+class URoomVizSoakCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    URoomVizSoakCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoomVizTilePackCommandlet.generated.h"
+
+/**
+ * Turns a tile catalog into a cooked tile pack for offline installs (editor only).
+ *
+ *   UnrealEditor-Cmd room_viz.uproject -run=RoomVizTilePack -Pack=<Name> [-Chunk=100]
+ *       [-Catalog=<url> | -Dir=<folder> | -StandIn [-TileCount=1000 ...]] [-MaxTiles=N] [-Timeout=1800]
+ *
+ * Every image becomes a UTexture2D asset with mips and default (platform) compression under
+ * /Game/TilePacks/<Name>, listed by a UTilePackManifest. A primary asset label assigns the
+ * folder to chunk -Chunk, so packaging with chunks and IoStore gives the pack its own
+ * pakchunk<N> .pak/.utoc/.ucas. Without a catalog argument the highest-priority configured
+ * source is used.
+ */
+UCLASS()
+class URoomVizTilePackCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    URoomVizTilePackCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
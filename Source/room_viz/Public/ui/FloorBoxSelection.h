@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class AActor;
+class APlayerController;
+class UPrimitiveComponent;
+class UWorld;
+
+/** What the selection is projected through: the player's view, or a synthetic one for benchmarks */
+struct ROOM_VIZ_API FFloorSelectionView
+{
+    FMatrix ViewProjection = FMatrix::Identity;
+    /** Viewport pixels; marquee rectangles are in the same space */
+    FIntRect ViewRect;
+
+    /** The view of PC's local player as the renderer sets it up; false without a viewport */
+    static bool FromPlayer(const APlayerController* PC, FFloorSelectionView& Out);
+
+    /** A perspective view at Origin looking along Rotation */
+    static FFloorSelectionView MakePerspective(const FVector& Origin, const FRotator& Rotation, float FOVDegrees, FIntPoint Size);
+};
+
+/**
+ * Marquee selection of floor surfaces, for tiling many floors with one drop.
+ *
+ * Begin gathers the static mesh components of actors tagged "floor" once. Every Update then
+ * projects their bounds to the screen on worker threads (ParallelFor) and culls whatever
+ * misses the marquee; only the survivors get an occlusion trace through the middle of their
+ * overlap with the marquee. Trace results are kept until the view or that overlap moves, and
+ * at most RoomViz.BoxSelect.MaxTraces run per update, so dragging across thousands of floors
+ * stays within a frame. Selected surfaces are outlined through custom depth, like the hovered one.
+ */
+class ROOM_VIZ_API FFloorBoxSelection
+{
+public:
+    /** Start a marquee in World, replacing the current selection; IgnoredActor (the pawn) never occludes */
+    void Begin(UWorld* World, const AActor* IgnoredActor);
+
+    /**
+     * Select the floors visible inside Marquee (viewport pixels, any corner order). bFinal
+     * ignores the trace budget, so nothing is left deferred; for the update that ends a marquee.
+     */
+    void Update(const FFloorSelectionView& View, const FBox2D& Marquee, bool bFinal = false);
+
+    /** Stop following the marquee and keep the selection */
+    void End() { bActive = false; }
+
+    /** Drop the selection and its outlines */
+    void Clear();
+
+    bool IsActive() const { return bActive; }
+    bool IsSelected(const UPrimitiveComponent* Component) const { return Component && Selected.Contains(Component); }
+    int32 Num() const { return Selected.Num(); }
+    TArray<UPrimitiveComponent*> GetSelection() const;
+
+    int32 GetNumCandidates() const { return Candidates.Num(); }
+    /** Traces run by the last Update, and how many it left for later because of the budget */
+    int32 GetLastNumTraces() const { return LastNumTraces; }
+    int32 GetLastNumDeferred() const { return LastNumDeferred; }
+
+    void LogReport() const;
+
+private:
+    struct FCandidate
+    {
+        TWeakObjectPtr<UPrimitiveComponent> Component;
+        FBox Bounds;
+        /** Screen rectangle of the bounds from the last projection */
+        FBox2D ScreenRect;
+        /** Occlusion trace cache: view and sample pixel it was traced for */
+        uint32 TracedViewHash = 0;
+        FIntPoint TracedSample = FIntPoint(MIN_int32, MIN_int32);
+        bool bVisible = false;
+        bool bInMarquee = false;
+        bool bSelected = false;
+    };
+
+    void SetSelected(FCandidate& Candidate, bool bSelected);
+
+    TWeakObjectPtr<UWorld> World;
+    TWeakObjectPtr<const AActor> IgnoredActor;
+    TArray<FCandidate> Candidates;
+    /** Indices of the candidates that passed the projection cull, reused across updates */
+    TArray<int32> Survivors;
+    /** Selected components, for IsSelected on every hover and drop trace */
+    TSet<TObjectKey<UPrimitiveComponent>> Selected;
+    bool bActive = false;
+
+    int32 LastNumTraces = 0;
+    int32 LastNumDeferred = 0;
+    int32 NumUpdates = 0;
+    double TotalUpdateSeconds = 0.0;
+    double MaxUpdateSeconds = 0.0;
+};
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+class UMeshComponent;
+class UPrimitiveComponent;
+class UTexture;
+
+/**
+ * Shows the dragged tile on the floor under the cursor before it is dropped. One preview
+ * instance of the base material is created up front; hovering a floor swaps it in as that
+ * floor's override and leaving puts the floor's own override back. A drag only rewrites the
+ * instance's texture parameters, so nothing is allocated per hover.
+ */
+class ROOM_VIZ_API FFloorMaterialPreview
+{
+public:
+    /** Create the preview instance; call once before any drag */
+    void Initialize(UMaterialInterface* BaseMaterial, UObject* Outer);
+
+    /**
+     * Copy Source's BaseColor texture to the preview, and its Normal/ORM textures with
+     * URoomVizTileSettings::bTilePBRMaps; base material defaults for the ones it lacks.
+     */
+    void SetSource(UMaterialInterface* Source);
+
+    /** Show the preview on Component (a mesh floor) instead of the floor previewed so far */
+    void SetTarget(UPrimitiveComponent* Component);
+
+    /** Give the previewed floor its own material back */
+    void Revert() { SetTarget(nullptr); }
+
+    /** Revert; the owner calls this when it goes away */
+    void Shutdown() { Revert(); }
+
+    UMeshComponent* GetTarget() const { return Target.Get(); }
+
+    /**
+     * Once per frame from the owner's tick: charges the frame that just ended to the transition
+     * or the plain hover statistics, so the end-of-frame render state work is counted too.
+     */
+    void TickFrame();
+
+    /** Log hover transitions, their game-thread cost and the frames they happened in */
+    void LogReport() const;
+
+    /** Forwarded from the owner's AddReferencedObjects */
+    void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+    TObjectPtr<UMaterialInstanceDynamic> Preview;
+    TObjectPtr<UTexture> DefaultBaseColor;
+    TObjectPtr<UTexture> DefaultNormal;
+    TObjectPtr<UTexture> DefaultORM;
+    bool bPBRMaps = false;
+
+    TWeakObjectPtr<UMeshComponent> Target;
+    /** The target's slot 0 override before the preview took it; null when it had none */
+    TObjectPtr<UMaterialInterface> TargetOverride;
+
+    int32 NumTransitions = 0;
+    double TotalTransitionSeconds = 0.0;
+    double MaxTransitionSeconds = 0.0;
+
+    /** Whole frames while hovering, split by whether a transition happened in them */
+    bool bTransitionThisFrame = false;
+    bool bHoveringThisFrame = false;
+    double LastFrameTime = 0.0;
+    int32 NumTransitionFrames = 0;
+    double TotalTransitionFrameSeconds = 0.0;
+    double MaxTransitionFrameSeconds = 0.0;
+    int32 NumHoverFrames = 0;
+    double TotalHoverFrameSeconds = 0.0;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AMaterialAPIManager;
+
+/** What made the palette ask for a tile, most urgent first */
+enum class EPalettePrefetchReason : uint8
+{
+    Drag,
+    Hover,
+    Scroll,
+    Num
+};
+
+/**
+ * Speculative work for the palette entries the user hovers, drags or scrolls to, so they are
+ * complete by the time they are used:
+ *  - entries still waiting in the trickled palette build (placeholders) get their material
+ *    instance and thumbnail built ahead of the rest, through the owner's entry prefetch;
+ *  - with bTilePBRMaps and AMaterialAPIManager::bDeferPBRMaps, the tile's PBR maps are fetched, so its first drop
+ *    already has the full material.
+ *
+ * PBR requests wait in a queue and at most RoomViz.Prefetch.MaxInFlight run at once. A request
+ * whose trigger no longer holds (pointer left the entry, scroll moved on) is dropped from the
+ * queue, or cancelled in flight when a newer request needs its slot.
+ */
+class ROOM_VIZ_API FPalettePrefetcher
+{
+public:
+    void SetManager(AMaterialAPIManager* InManager) { Manager = InManager; }
+
+    /** Build a tile's palette entry ahead of the palette build; returns false if it is built or unknown */
+    void SetEntryPrefetch(TFunction<bool(const FString& TileID)>&& InPrefetchEntry) { PrefetchEntry = MoveTemp(InPrefetchEntry); }
+
+    /** Forget requests and interest of the previous palette; metrics are kept */
+    void Reset();
+
+    /** Entry under the pointer, empty when none; requested after RoomViz.Prefetch.HoverMs */
+    void SetHovered(const FString& TileID, double Now);
+
+    /** A drag can end in a drop at any moment: requested right away, ahead of everything else */
+    void OnDragStart(const FString& TileID);
+
+    /** Entries the palette scroll is settling on; replaces the previous targets */
+    void SetScrollTargets(const TArray<FString>& TileIDs);
+
+    /** Count a drop of TileID as a hit when its maps were prefetched in time */
+    void OnDrop(const FString& TileID);
+
+    void OnPBRMapsReady(const FString& TileID);
+
+    /** Hover timer, stale request cleanup and request start; call once per frame */
+    void Tick(double Now);
+
+    /** Drops with the maps already there over drops of tiles with deferred maps */
+    float GetHitRate() const { return NumDrops > 0 ? float(NumHits) / NumDrops : 0.f; }
+
+    /** Bytes of cancelled prefetches plus prefetched maps of tiles never dropped */
+    int64 GetWastedBytes() const;
+
+    void LogReport() const;
+
+private:
+    struct FRequest
+    {
+        FString TileID;
+        EPalettePrefetchReason Reason = EPalettePrefetchReason::Scroll;
+    };
+
+    bool IsEnabled() const;
+    bool IsWanted(const FString& TileID, EPalettePrefetchReason Reason) const;
+    void Enqueue(const FString& TileID, EPalettePrefetchReason Reason);
+    void CancelInFlight(const FString& TileID);
+    void UpdateStats() const;
+
+    TWeakObjectPtr<AMaterialAPIManager> Manager;
+    TFunction<bool(const FString&)> PrefetchEntry;
+
+    /** Not started yet, most urgent first */
+    TArray<FRequest> Queued;
+    TMap<FString, EPalettePrefetchReason> InFlight;
+    TSet<FString> Ready;
+    TSet<FString> Dropped;
+
+    FString HoveredID;
+    double HoverStartTime = 0.0;
+    bool bHoverRequested = false;
+    FString DraggedID;
+    TSet<FString> ScrollTargets;
+
+    int32 NumRequested[(int32)EPalettePrefetchReason::Num] = {};
+    int32 NumEntriesPrefetched = 0;
+    int32 NumCancelled = 0;
+    int32 NumDrops = 0;
+    int32 NumHits = 0;
+    int32 NumLate = 0;
+};
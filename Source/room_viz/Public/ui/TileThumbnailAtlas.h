@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Styling/SlateBrush.h"
+
+class FReferenceCollector;
+class FTexture;
+class UTexture2D;
+class UTextureRenderTarget2D;
+
+/**
+ * Shelf packer for one square page. Rects are placed left to right on horizontal shelves;
+ * freed rects go back to their shelf and are reused by anything that fits.
+ */
+class ROOM_VIZ_API FShelfPacker
+{
+public:
+    explicit FShelfPacker(int32 InPageSize) : PageSize(InPageSize) {}
+
+    /** False if the page has no room for a Width x Height rect */
+    bool Allocate(int32 Width, int32 Height, FIntRect& OutRect);
+    void Free(const FIntRect& Rect);
+
+    int32 GetUsedArea() const { return UsedArea; }
+    int32 GetPageSize() const { return PageSize; }
+
+private:
+    struct FShelf
+    {
+        int32 Y = 0;
+        int32 Height = 0;
+        int32 UsedWidth = 0;
+        TArray<FIntRect> FreeRects;
+    };
+
+    int32 PageSize = 0;
+    int32 NextShelfY = 0;
+    int32 UsedArea = 0;
+    TArray<FShelf> Shelves;
+};
+
+/**
+ * Palette thumbnails packed into a few render target pages, so Slate can draw a whole palette
+ * from one or two textures instead of one texture per entry. Thumbnails are drawn on the GPU
+ * (any tile texture works, cooked or transient) in one canvas pass per page and frame.
+ *
+ * Regions come and go one texture at a time (GetBrush, Remove), as tiles arrive and are evicted.
+ * Textures without mips, as runtime-decoded tiles are, would alias when drawn straight at
+ * thumbnail size; they are halved through scratch targets first, each pass a bilinear tap
+ * between four texels, i.e. a 2x2 box filter.
+ *
+ * The owner keeps the pages and scratch targets alive by forwarding its AddReferencedObjects.
+ */
+class ROOM_VIZ_API FTileThumbnailAtlas
+{
+public:
+    explicit FTileThumbnailAtlas(int32 InPageSize = 2048, int32 InThumbnailSize = 128);
+
+    /**
+     * Brush for Texture's thumbnail, allocating and queueing its region on first use.
+     * False when the atlas cannot take it (no RHI, or an oversized page request).
+     */
+    bool GetBrush(UTexture2D* Texture, FSlateBrush& OutBrush);
+
+    /** Free the region of a texture no longer shown */
+    void Remove(UTexture2D* Texture);
+
+    /** Free every region whose texture is not in Keep */
+    void RemoveAllExcept(const TSet<UTexture2D*>& Keep);
+
+    /**
+     * Draw queued thumbnails into their pages; ones whose texture has no resource yet stay queued.
+     * Textures drawn this call are appended to OutDrawn when given.
+     */
+    void Flush(TArray<UTexture2D*>* OutDrawn = nullptr);
+
+    int32 GetNumThumbnails() const { return Slots.Num(); }
+    int32 GetNumPages() const { return Pages.Num(); }
+    float GetOccupancy() const;
+
+    /** Forwarded from the owner's AddReferencedObjects */
+    void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+    struct FPage
+    {
+        TObjectPtr<UTextureRenderTarget2D> RenderTarget;
+        FShelfPacker Packer;
+        explicit FPage(int32 PageSize) : Packer(PageSize) {}
+    };
+
+    struct FSlot
+    {
+        int32 Page = INDEX_NONE;
+        FIntRect Rect;
+    };
+
+    int32 AddPage();
+    FSlateBrush MakeBrush(const FSlot& Slot) const;
+
+    /**
+     * Box-filter Texture down to twice the thumbnail size or less through the scratch targets;
+     * returns the last one it drew to, or Texture itself if it is small enough or has mips.
+     */
+    FTexture* Downsample(UTexture2D* Texture);
+
+    /** Scratch target of ThumbnailSize << (Level + 1) texels a side, created on first use */
+    UTextureRenderTarget2D* GetScratchTarget(int32 Level);
+
+    int32 PageSize;
+    int32 ThumbnailSize;
+    TArray<FPage> Pages;
+    TArray<TObjectPtr<UTextureRenderTarget2D>> ScratchTargets;
+    TMap<TObjectKey<UTexture2D>, FSlot> Slots;
+    TArray<TWeakObjectPtr<UTexture2D>> PendingDraws;
+};
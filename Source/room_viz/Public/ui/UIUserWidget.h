@@ -9,6 +9,10 @@
 #include "dataclass/MaterialAPIManager.h"
 #include "Components/SizeBox.h"
 #include "Components/ScrollBox.h"
+#include "ui/TileThumbnailAtlas.h"
+#include "ui/PalettePrefetcher.h"
+#include "ui/FloorMaterialPreview.h"
+#include "ui/FloorBoxSelection.h"
 #include "UIUserWidget.generated.h"
 
 class UScrollBox;
@@ -18,6 +22,11 @@ class UImage;
 class UTextBlock;
 class UHorizontalBox;
 class UWidget;
+class UMaterialInstanceDynamic;
+class UInvalidationBox;
+class Aroom_vizCharacter;
+class UTileObjectPool;
+enum class ERoomVizInputEventType : uint8;
 
 USTRUCT(BlueprintType)
 struct FFloorMaterialData
@@ -38,6 +47,39 @@ struct FFloorMaterialData
     UMaterialInterface* MaterialAsset;
 };
 
+/** BaseColor, Normal and ORM textures of a palette material */
+USTRUCT()
+struct FFloorTextureSet
+{
+    GENERATED_BODY()
+
+    FFloorTextureSet() = default;
+    FFloorTextureSet(UTexture2D* InBaseColor, UTexture2D* InNormal, UTexture2D* InORM)
+        : BaseColor(InBaseColor), Normal(InNormal), ORM(InORM)
+    {
+    }
+
+    UPROPERTY()
+    TObjectPtr<UTexture2D> BaseColor;
+
+    UPROPERTY()
+    TObjectPtr<UTexture2D> Normal;
+
+    UPROPERTY()
+    TObjectPtr<UTexture2D> ORM;
+
+    bool operator==(const FFloorTextureSet& Other) const
+    {
+        return BaseColor == Other.BaseColor && Normal == Other.Normal && ORM == Other.ORM;
+    }
+
+    friend uint32 GetTypeHash(const FFloorTextureSet& Set)
+    {
+        return HashCombineFast(GetTypeHash(Set.BaseColor), HashCombineFast(GetTypeHash(Set.Normal), GetTypeHash(Set.ORM)));
+    }
+};
+using FSharedFloorMaterials = TMap<FFloorTextureSet, TObjectPtr<UMaterialInstanceDynamic>>;
+
 UCLASS()
 class ROOM_VIZ_API UUIUserWidget : public UUserWidget
 {
@@ -46,12 +88,21 @@ class ROOM_VIZ_API UUIUserWidget : public UUserWidget
     //UUIUserWidget(const FObjectInitializer& ObjectInitializer);
 public:
     virtual void NativeConstruct() override;
+    virtual void NativeDestruct() override;
     virtual FReply NativeOnMouseButtonDown(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
     virtual void NativeOnDragDetected(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent, UDragDropOperation*& OutOperation) override;
     virtual bool NativeOnDrop(const FGeometry& InGeometry, const FDragDropEvent& InDragDropEvent, UDragDropOperation* InOperation) override;
     bool NativeOnDragOver(const FGeometry& InGeometry, const FDragDropEvent& InDragDropEvent, UDragDropOperation* InOperation);
     virtual FReply NativeOnMouseButtonUp(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
     virtual void NativeOnDragCancelled(const FDragDropEvent& InDragDropEvent, UDragDropOperation* InOperation) override;
+    virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+    virtual FReply NativeOnMouseMove(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
+    virtual void NativeOnMouseLeave(const FPointerEvent& InMouseEvent) override;
+    virtual int32 NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+        FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+    /** Reports the objects held by the non-UObject helpers below */
+    static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
 
 
     UFUNCTION(BlueprintCallable, Category = "Floor Materials")
@@ -60,6 +111,43 @@ public:
     UFUNCTION()
     void HandleMaterialsReady(const TArray<FTileMaterialData>& DownloadedTiles);
 
+    /** Give the tile's entries a material with its prefetched normal and ORM maps */
+    void HandleTilePBRMapsReady(const FTileMaterialData& Tile);
+
+    /** Queue the thumbnail of a tile as soon as its texture exists, and show it on the tile's placeholder */
+    void HandleTileTextureReady(const FTileMaterialData& Tile);
+
+    /** Take an evicted tile out of the palette; its atlas region goes back unless another tile shares the texture */
+    void HandleTileEvicted(const FTileMaterialData& Tile);
+
+    /** Fill an empty palette with placeholder entries, drawn from the tiles' cached analyses, until HandleMaterialsReady */
+    void HandleCatalogMerged(const TArray<FTileMaterialData>& Tiles);
+    void RemovePlaceholders();
+
+    /** Upload PlaceholderTexels, moving the placeholders to a taller sheet when the cells outgrow it */
+    bool UpdatePlaceholderSheet();
+    void SetPlaceholderBrush(UImage* Img, int32 Cell) const;
+
+    /** Turn downloaded tiles into palette entries, one material instance of InBaseMaterial per distinct texture set (BaseColor, Normal, ORM parameters), created in Pool */
+    static void BuildFloorMaterials(const TArray<FTileMaterialData>& Tiles, UMaterialInterface* InBaseMaterial, UTileObjectPool* Pool, TArray<FFloorMaterialData>& OutMaterials);
+
+    /** One palette entry's data; reuses the instance in SharedMaterials when the textures match. Unused until an entry takes it */
+    static FFloorMaterialData MakeFloorMaterial(const FTileMaterialData& Tile, UMaterialInterface* InBaseMaterial, UTileObjectPool* Pool, FSharedFloorMaterials& SharedMaterials);
+
+    /** Owner of the palette's material instances; each entry of MaterialEntryMap holds a reference to its own */
+    UTileObjectPool* GetMaterialPool();
+
+    /** Empty the palette, keeping atlas regions of the Shown textures */
+    void ResetPalette(const TSet<UTexture2D*>& Shown);
+    void AddPaletteEntry(const FFloorMaterialData& Data);
+
+    /** Put the scroll box under the root canvas, inside an invalidation box when RoomViz.Palette.Invalidation is set */
+    void ApplyPaletteInvalidation();
+
+    /** Repaint one entry (thumbnail drawn, selection changed) without touching the rest of the cached palette */
+    void InvalidateEntry(UBorder* Entry);
+    void SetSelectedEntry(UBorder* Entry);
+
     UPROPERTY(meta = (BindWidget))
     class UScrollBox* MaterialsScrollBox;
 
@@ -73,12 +161,61 @@ public:
     // if you prefer your existing CreateMaterialEntry you'd skip this and use the UBorder hack below
 
 
-    // Map each entry Border back to its data
+    // Map each entry Border back to its data; the material instances live in MaterialPool
+    UPROPERTY()
     TMap<UBorder*, FFloorMaterialData> MaterialEntryMap;
 
+    UPROPERTY(Transient)
+    TObjectPtr<UTileObjectPool> MaterialPool;
+
     // Helper to spawn one entry
     UBorder* CreateMaterialEntry(const FFloorMaterialData& Data);
+    /** Show Texture in an entry's image, from the thumbnail atlas when it has it */
+    void SetEntryThumbnail(UImage* Img, UTexture2D* Texture);
+
+    /** Entries of tiles without a texture yet, by tile ID; not draggable, not in MaterialEntryMap */
+    UPROPERTY()
+    TMap<FString, UBorder*> PlaceholderEntries;
+    /** PlaceholderEntries inverted, for hover and scroll lookups */
+    TMap<UBorder*, FString> PlaceholderTileIDs;
+
+    /** Every placeholder is a cell of this one texture, created in the material pool */
+    UPROPERTY(Transient)
+    TObjectPtr<UTexture2D> PlaceholderSheet;
+    /** The sheet's texels, whole rows of cells, kept to redraw cells and fill a taller sheet */
+    TArray<FColor> PlaceholderTexels;
+    /** Sheet cell of each tile with a placeholder, queued or shown */
+    TMap<FString, int32> PlaceholderCells;
     UBorder* DraggedBorder = nullptr;
+
+    UBorder* FindEntryAt(const FVector2D& ScreenPos) const;
+
+    /**
+     * Index in the scroll box of the entry or placeholder under ScreenPos, INDEX_NONE if none.
+     * Tries the hovered one and its neighbours before scanning, so mouse moves stay O(1).
+     */
+    int32 FindPaletteChildAt(const FVector2D& ScreenPos) const;
+    /** Tile of an entry or placeholder, empty for anything else */
+    FString GetEntryTileID(UBorder* Entry) const;
+    int32 HoveredChildIndex = INDEX_NONE;
+    UBorder* FindEntryByName(const FString& Name) const;
+
+    /** Palette material of a tile, null until its entry exists; how ARoomDesignState resolves replicated tile IDs */
+    UMaterialInterface* FindTileMaterial(const FString& TileID) const;
+
+    // Drag/drop steps behind the Slate handlers, taking world rays so the input replay
+    // (-run=RoomVizReplay) can drive them without a viewport
+    void BeginEntryDrag(UBorder* Entry);
+    UDragDropOperation* CreateEntryDragOperation();
+    void UpdateDragHover(const FVector& RayOrigin, const FVector& RayDirection, const AActor* IgnoredActor);
+    void ClearDragHover();
+    bool DropEntry(UBorder* Entry, Aroom_vizCharacter* Character, const FVector& RayOrigin, const FVector& RayDirection);
+    /** Mouse-up fallback for drops Slate did not deliver: applies the dragged material along the ray */
+    void ApplyDropBackstop(const FVector& RayOrigin, const FVector& RayDirection, const AActor* IgnoredActor);
+    void CancelEntryDrag();
+
+    /** Hand the event to RoomVizInputRecorder when a recording is running */
+    void RecordInput(ERoomVizInputEventType Type, const FVector2D& ScreenPos, const FVector& RayOrigin, const FVector& RayDirection, UBorder* Entry) const;
     
     FVector2D CachedMousePosition;
 
@@ -94,4 +231,83 @@ public:
     // Inside your UIUserWidget class
     TWeakObjectPtr<UPrimitiveComponent> HighlightedComponent = nullptr;
 
+    /** The dragged tile shown on the hovered floor (RoomViz.Preview.Enable) */
+    FFloorMaterialPreview FloorPreview;
+
+    /** Floors caught by a Shift-drag marquee; a drop on any of them tiles them all (RoomViz.BoxSelect.*) */
+    FFloorBoxSelection BoxSelection;
+
+    void BeginMarquee(const FVector2D& ScreenPos);
+    /** Re-select under the marquee; at most once a frame, from NativeTick, bFinal to finish every deferred trace */
+    void UpdateMarquee(bool bFinal = false);
+    /** Keep the selection, complete under the final marquee, or drop it if the marquee was only a Shift-click */
+    void EndMarquee();
+
+    /** Whether the ray's first hit is a box-selected floor */
+    bool IsOverSelection(const FVector& RayOrigin, const FVector& RayDirection, const AActor* IgnoredActor) const;
+
+    /** Marquee corners in absolute (desktop) coordinates, like the pointer events */
+    FVector2D MarqueeStart = FVector2D::ZeroVector;
+    FVector2D MarqueeEnd = FVector2D::ZeroVector;
+    bool bMarqueeDirty = false;
+
+    TWeakObjectPtr<AMaterialAPIManager> MaterialManager;
+
+    UPROPERTY()
+    UInvalidationBox* PaletteInvalidationBox = nullptr;
+
+    UPROPERTY()
+    UBorder* SelectedEntry = nullptr;
+
+    UPROPERTY(EditAnywhere, Category = "UI")
+    FLinearColor SelectedEntryColor = FLinearColor(0.9f, 0.6f, 0.1f);
+
+    /** Tiles of the palette build in progress, added a few per frame through the manager's work queue */
+    UPROPERTY()
+    TArray<FTileMaterialData> PendingPaletteTiles;
+    TMap<FString, int32> PendingPaletteIndex;
+    TBitArray<> PendingEntriesBuilt;
+    int32 NumPendingEntriesBuilt = 0;
+
+    /** Add PendingPaletteTiles[Index] to the palette unless already there; the last one finishes the build */
+    void BuildPendingEntry(int32 Build, int32 Index);
+    void FinishPendingEntry();
+
+    /** Build a pending tile's entry at Normal priority, ahead of the trickled build (FPalettePrefetcher) */
+    bool PrefetchPaletteEntry(const FString& TileID);
+
+    /**
+     * Instance per texture set of the palette, shared by its entries. Entries leave when the
+     * pool's last reference to their instance goes (ReleasePaletteMaterial), before Trim can
+     * drop it, so a hit is always an instance the pool still owns.
+     */
+    UPROPERTY(Transient)
+    TMap<FFloorTextureSet, TObjectPtr<UMaterialInstanceDynamic>> PaletteMaterials;
+    int32 PaletteBuildSerial = 0;
+
+    /** Release an entry's material and forget it in PaletteMaterials once nothing uses it */
+    void ReleasePaletteMaterial(UMaterialInterface* Material);
+
+    /** The manager's work queue, or LocalWorkQueue (drained in NativeTick) when there is no manager */
+    FFrameBudgetedWorkQueue& GetWorkQueue();
+    FFrameBudgetedWorkQueue LocalWorkQueue;
+
+    /** Prefetches deferred PBR maps of entries hovered, dragged or scrolled to (RoomViz.Prefetch.*) */
+    FPalettePrefetcher Prefetcher;
+
+    /** Feed the prefetcher the entries a slowing scroll is about to show */
+    void UpdateScrollPrefetch(float DeltaTime);
+
+    float LastScrollOffset = 0.f;
+    float ScrollVelocity = 0.f;
+    float ScrollTargetsOffset = -1.f;
+    int32 ScrollTargetsChildren = 0;
+
+    /** Palette thumbnails, shared pages so Slate batches the entries (RoomViz.Palette.UseAtlas) */
+    FTileThumbnailAtlas ThumbnailAtlas;
+
+    /** Log entry count, distinct thumbnail textures (an upper bound on image draw batches) and atlas use */
+    void LogPaletteReport() const;
+    int32 GetNumThumbnailTextures() const;
+
 };
\ No newline at end of file
@@ -8,6 +8,17 @@ public class room_viz : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput","NavigationSystem","AIModule", "HTTP", "Json", "JsonUtilities", "UMG", "ImageWrapper", "Slate", "SlateCore" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput","NavigationSystem","AIModule", "HTTP", "Json", "JsonUtilities", "UMG", "ImageWrapper", "Slate", "SlateCore", "HTTPServer", "DeveloperSettings", "NetCore", "RenderCore", "RHI" });
+
+		// Scaled JPEG decodes go to libjpeg-turbo directly; ImageWrapper only decodes at full size
+		if (Target.Platform == UnrealTargetPlatform.Win64 || Target.Platform == UnrealTargetPlatform.Linux || Target.Platform == UnrealTargetPlatform.Mac)
+		{
+			AddEngineThirdPartyPrivateStaticDependencies(Target, "LibJpegTurbo");
+			PrivateDefinitions.Add("ROOMVIZ_WITH_TURBOJPEG=1");
+		}
+		else
+		{
+			PrivateDefinitions.Add("ROOMVIZ_WITH_TURBOJPEG=0");
+		}
 	}
 }
@@ -3,5 +3,7 @@
 #include "room_viz.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogRoomViz);
+DEFINE_LOG_CATEGORY(LogRoomVizHotPath);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, room_viz, "room_viz" );
- 
\ No newline at end of file
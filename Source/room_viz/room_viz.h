@@ -3,3 +3,21 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Logging/LogMacros.h"
+
+/** General room_viz logging (catalog, materials, UI setup) */
+DECLARE_LOG_CATEGORY_EXTERN(LogRoomViz, Log, All);
+
+/**
+ * Per-event logging on hot paths (drag detection, hover, drops).
+ * Statements more verbose than ROOMVIZ_HOTPATH_LOG_VERBOSITY are compiled out; override it from Build.cs if needed.
+ */
+#ifndef ROOMVIZ_HOTPATH_LOG_VERBOSITY
+#if UE_BUILD_SHIPPING || UE_BUILD_TEST
+#define ROOMVIZ_HOTPATH_LOG_VERBOSITY Warning
+#else
+#define ROOMVIZ_HOTPATH_LOG_VERBOSITY All
+#endif
+#endif
+
+DECLARE_LOG_CATEGORY_EXTERN(LogRoomVizHotPath, Warning, ROOMVIZ_HOTPATH_LOG_VERBOSITY);
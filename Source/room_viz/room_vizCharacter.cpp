@@ -16,12 +16,16 @@
 #include "DrawDebugHelpers.h"
 #include "CollisionQueryParams.h"
 #include "GameFramework/PlayerController.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
+#include "nav/ClickToMoveComponent.h"
+#include "dataclass/AdaptiveQualitySubsystem.h"
+#include "dataclass/RoomDesignState.h"
 #include "ui/UIUserWidget.h"
 #include "Kismet/GameplayStatics.h"
 #include "Framework/Application/SlateApplication.h" // at top
 #include "Components/PrimitiveComponent.h"
 #include "Engine/StaticMeshActor.h" // ✅ Add this at top of .cpp
+#include "RoomVizStats.h"
+#include "room_viz.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
@@ -62,6 +66,9 @@ Aroom_vizCharacter::Aroom_vizCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	// Click-to-move: async path queries, coalesced while the button is held
+	ClickToMove = CreateDefaultSubobject<UClickToMoveComponent>(TEXT("ClickToMove"));
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 }
@@ -98,15 +105,27 @@ void Aroom_vizCharacter::BeginPlay()
 		}
 		else
 		{
-			UE_LOG(LogTemp, Error, TEXT("Failed to create UIWidgetInstance"));
+			UE_LOG(LogRoomViz, Error, TEXT("Failed to create UIWidgetInstance"));
 		}
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("UIWidgetClass is not set!"));
+		UE_LOG(LogRoomViz, Error, TEXT("UIWidgetClass is not set!"));
 	}
 }
 
+void Aroom_vizCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// A respawned character creates its own palette; this one would otherwise stay in the viewport with its materials
+	if (UIWidgetInstance)
+	{
+		UIWidgetInstance->RemoveFromParent();
+		UIWidgetInstance = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -166,6 +185,11 @@ void Aroom_vizCharacter::Move(const FInputActionValue& Value)
 		// add movement 
 		AddMovementInput(ForwardDirection, MovementVector.Y);
 		AddMovementInput(RightDirection, MovementVector.X);
+
+		if (UAdaptiveQualitySubsystem* Quality = UAdaptiveQualitySubsystem::Get(GetWorld()))
+		{
+			Quality->NoteInteraction();
+		}
 	}
 }
 
@@ -179,6 +203,11 @@ void Aroom_vizCharacter::Look(const FInputActionValue& Value)
 		// add yaw and pitch input to controller
 		AddControllerYawInput(LookAxisVector.X);
 		AddControllerPitchInput(LookAxisVector.Y);
+
+		if (UAdaptiveQualitySubsystem* Quality = UAdaptiveQualitySubsystem::Get(GetWorld()))
+		{
+			Quality->NoteInteraction();
+		}
 	}
 }
 
@@ -200,8 +229,9 @@ void Aroom_vizCharacter::TouchMove(const FInputActionValue& Value)
 
 		if (GetWorld()->LineTraceSingleByChannel(Hit, Start, End, ECC_GameTraceChannel1, Params))
 		{
-			// Debug
+#if ENABLE_DRAW_DEBUG
 			DrawDebugSphere(GetWorld(), Hit.ImpactPoint, 20.f, 12, FColor::Green, false, 2.f);
+#endif
 
 			MoveCharacterToLocation(Hit.ImpactPoint);
 		}
@@ -215,46 +245,58 @@ void Aroom_vizCharacter::DragMove(const FInputActionValue& Value)
 
 void Aroom_vizCharacter::MoveCharacterToLocation(const FVector& Destination)
 {
-	if (APlayerController* PC = Cast<APlayerController>(GetController()))
+	// Coalesced with any goal still being planned, see UClickToMoveComponent
+	if (ClickToMove)
 	{
-		// Issue a navigation request via the AI helper
-		UAIBlueprintHelperLibrary::SimpleMoveToLocation(PC, Destination);
+		ClickToMove->RequestMoveTo(Destination);
 	}
-
-
 }
 
 void Aroom_vizCharacter::OnMaterialDropped(const FFloorMaterialData& DroppedData, const FVector2D& ScreenPosition)
 {
-	UE_LOG(LogTemp, Warning, TEXT("🧩 OnMaterialDropped called with material: %s"), *DroppedData.Name);
-	UE_LOG(LogTemp, Log, TEXT("🖱️ ScreenPosition: X=%f, Y=%f"), ScreenPosition.X, ScreenPosition.Y);
+	ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_Drop);
+
+	UE_LOG(LogRoomVizHotPath, Verbose, TEXT("OnMaterialDropped '%s' at X=%f, Y=%f"), *DroppedData.Name, ScreenPosition.X, ScreenPosition.Y);
 
 	APlayerController* PC = Cast<APlayerController>(GetController());
 	if (!PC)
 	{
-		UE_LOG(LogTemp, Error, TEXT("❌ PlayerController not found"));
+		UE_LOG(LogRoomVizHotPath, Error, TEXT("OnMaterialDropped: PlayerController not found"));
 		return;
 	}
 
 	if (!DroppedData.MaterialAsset)
 	{
-		UE_LOG(LogTemp, Error, TEXT("❌ Dropped material is null"));
+		UE_LOG(LogRoomVizHotPath, Error, TEXT("OnMaterialDropped: dropped material is null"));
 		return;
 	}
 
 	FVector WorldOrigin, WorldDirection;
 	if (!PC->DeprojectScreenPositionToWorld(ScreenPosition.X, ScreenPosition.Y, WorldOrigin, WorldDirection))
 	{
-		UE_LOG(LogTemp, Error, TEXT("❌ Deprojection failed"));
+		UE_LOG(LogRoomVizHotPath, Warning, TEXT("OnMaterialDropped: deprojection failed"));
+		return;
+	}
+
+	ApplyDroppedMaterial(DroppedData, WorldOrigin, WorldDirection);
+}
+
+void Aroom_vizCharacter::ApplyDroppedMaterial(const FFloorMaterialData& DroppedData, const FVector& WorldOrigin, const FVector& WorldDirection)
+{
+	if (!DroppedData.MaterialAsset)
+	{
+		UE_LOG(LogRoomVizHotPath, Error, TEXT("OnMaterialDropped: dropped material is null"));
 		return;
 	}
 
 	FVector TraceStart = WorldOrigin;
 	FVector TraceEnd = WorldOrigin + (WorldDirection * 10000.0f);
 
-	UE_LOG(LogTemp, Log, TEXT("🧭 LineTrace: %s -> %s"), *TraceStart.ToString(), *TraceEnd.ToString());
+	UE_LOG(LogRoomVizHotPath, VeryVerbose, TEXT("OnMaterialDropped trace: %s -> %s"), *TraceStart.ToString(), *TraceEnd.ToString());
 
+#if ENABLE_DRAW_DEBUG
 	DrawDebugLine(GetWorld(), TraceStart, TraceEnd, FColor::Red, false, 5.0f, 0, 2.0f);
+#endif
 
 	FHitResult Hit;
 	FCollisionQueryParams Params;
@@ -262,23 +304,99 @@ void Aroom_vizCharacter::OnMaterialDropped(const FFloorMaterialData& DroppedData
 
 	if (GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_Visibility, Params))
 	{
+#if ENABLE_DRAW_DEBUG
 		DrawDebugSphere(GetWorld(), Hit.ImpactPoint, 25.0f, 16, FColor::Green, false, 5.0f);
+#endif
 
 		UPrimitiveComponent* HitComp = Hit.GetComponent();
-		UE_LOG(LogTemp, Log, TEXT("✅ Hit component: %s"), *GetNameSafe(HitComp));
 
 		if (UStaticMeshComponent* MeshComp = Cast<UStaticMeshComponent>(HitComp))
 		{
 			MeshComp->SetMaterial(0, DroppedData.MaterialAsset);
-			UE_LOG(LogTemp, Log, TEXT("🎯 Applied material to mesh: %s"), *MeshComp->GetName());
+			UE_LOG(LogRoomVizHotPath, Verbose, TEXT("Applied '%s' to mesh: %s"), *DroppedData.Name, *MeshComp->GetName());
+
+			// Shown locally right away; the server's copy replicates to everyone else
+			if (HasAuthority())
+			{
+				if (ARoomDesignState* Design = ARoomDesignState::Get(GetWorld()))
+				{
+					Design->SetAssignment(MeshComp, 0, DroppedData.Name);
+				}
+			}
+			else
+			{
+				ServerAssignTile(MeshComp, 0, DroppedData.Name);
+			}
 		}
 		else
 		{
-			UE_LOG(LogTemp, Error, TEXT("❌ Hit component is not UStaticMeshComponent"));
+			UE_LOG(LogRoomVizHotPath, Warning, TEXT("OnMaterialDropped: hit component %s is not a UStaticMeshComponent"), *GetNameSafe(HitComp));
 		}
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("❌ Line trace did not hit anything"));
+		UE_LOG(LogRoomVizHotPath, Verbose, TEXT("OnMaterialDropped: line trace did not hit anything"));
+	}
+}
+
+void Aroom_vizCharacter::ApplyDroppedMaterialToSurfaces(const FFloorMaterialData& DroppedData, const TArray<UPrimitiveComponent*>& Surfaces)
+{
+	ROOMVIZ_SCOPE_CYCLE_COUNTER(STAT_RoomViz_Drop);
+
+	if (!DroppedData.MaterialAsset)
+	{
+		UE_LOG(LogRoomVizHotPath, Error, TEXT("OnMaterialDropped: dropped material is null"));
+		return;
+	}
+
+	TArray<UPrimitiveComponent*> Applied;
+	Applied.Reserve(Surfaces.Num());
+	for (UPrimitiveComponent* Surface : Surfaces)
+	{
+		if (IsValid(Surface))
+		{
+			Surface->SetMaterial(0, DroppedData.MaterialAsset);
+			Applied.Add(Surface);
+		}
+	}
+	UE_LOG(LogRoomVizHotPath, Verbose, TEXT("Applied '%s' to %d selected surfaces"), *DroppedData.Name, Applied.Num());
+
+	if (HasAuthority())
+	{
+		if (ARoomDesignState* Design = ARoomDesignState::Get(GetWorld()))
+		{
+			for (UPrimitiveComponent* Surface : Applied)
+			{
+				Design->SetAssignment(Surface, 0, DroppedData.Name);
+			}
+		}
+		return;
+	}
+
+	// Batches keep each RPC's bunch small however many floors the marquee caught
+	constexpr int32 SurfacesPerCall = 256;
+	for (int32 Start = 0; Start < Applied.Num(); Start += SurfacesPerCall)
+	{
+		const int32 Count = FMath::Min(SurfacesPerCall, Applied.Num() - Start);
+		ServerAssignTiles(TArray<UPrimitiveComponent*>(Applied.GetData() + Start, Count), 0, DroppedData.Name);
+	}
+}
+
+void Aroom_vizCharacter::ServerAssignTiles_Implementation(const TArray<UPrimitiveComponent*>& Surfaces, uint8 Slot, const FString& TileID)
+{
+	if (ARoomDesignState* Design = ARoomDesignState::Get(GetWorld()))
+	{
+		for (UPrimitiveComponent* Surface : Surfaces)
+		{
+			Design->SetAssignment(Surface, Slot, TileID);
+		}
+	}
+}
+
+void Aroom_vizCharacter::ServerAssignTile_Implementation(UPrimitiveComponent* Surface, uint8 Slot, const FString& TileID)
+{
+	if (ARoomDesignState* Design = ARoomDesignState::Get(GetWorld()))
+	{
+		Design->SetAssignment(Surface, Slot, TileID);
 	}
 }
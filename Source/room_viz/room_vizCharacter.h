@@ -12,6 +12,7 @@ class USpringArmComponent;
 class UCameraComponent;
 class UInputMappingContext;
 class UInputAction;
+class UClickToMoveComponent;
 struct FInputActionValue;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
@@ -28,6 +29,10 @@ class Aroom_vizCharacter : public ACharacter
 	/** Follow camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	UCameraComponent* FollowCamera;
+
+	/** Coalesces click-to-move goals into async path queries */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Navigation, meta = (AllowPrivateAccess = "true"))
+	UClickToMoveComponent* ClickToMove;
 	
 	/** MappingContext */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
@@ -80,11 +85,15 @@ protected:
 	// To add mapping context
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns ClickToMove subobject **/
+	FORCEINLINE class UClickToMoveComponent* GetClickToMove() const { return ClickToMove; }
 
 	//Widget class implementation
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UI")
@@ -97,5 +106,19 @@ public:
 	//void OnMaterialDropped(const FFloorMaterialData& DroppedMaterial, const FVector2D& ScreenPosition);
 	//void OnMaterialDropped(const FFloorMaterialData& Data, FVector2D DropPosition);
 	void OnMaterialDropped(const FFloorMaterialData& DroppedData, const FVector2D& ScreenPosition);
+
+	/** Apply DroppedData to the static mesh hit by the ray, as OnMaterialDropped does after deprojecting */
+	void ApplyDroppedMaterial(const FFloorMaterialData& DroppedData, const FVector& WorldOrigin, const FVector& WorldDirection);
+
+	/** Apply DroppedData to every surface of a box selection at once, with one server call per batch of surfaces */
+	void ApplyDroppedMaterialToSurfaces(const FFloorMaterialData& DroppedData, const TArray<UPrimitiveComponent*>& Surfaces);
+
+	/** Record a drop in the session's shared design (ARoomDesignState); only the tile ID is sent */
+	UFUNCTION(Server, Reliable)
+	void ServerAssignTile(UPrimitiveComponent* Surface, uint8 Slot, const FString& TileID);
+
+	/** ServerAssignTile for many surfaces */
+	UFUNCTION(Server, Reliable)
+	void ServerAssignTiles(const TArray<UPrimitiveComponent*>& Surfaces, uint8 Slot, const FString& TileID);
 };
 
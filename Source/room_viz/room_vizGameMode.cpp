@@ -2,6 +2,8 @@
 
 #include "room_vizGameMode.h"
 #include "room_vizCharacter.h"
+#include "dataclass/RoomDesignState.h"
+#include "Engine/World.h"
 #include "UObject/ConstructorHelpers.h"
 
 Aroom_vizGameMode::Aroom_vizGameMode()
@@ -13,3 +15,13 @@ Aroom_vizGameMode::Aroom_vizGameMode()
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
 }
+
+void Aroom_vizGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	if (!ARoomDesignState::Get(GetWorld()))
+	{
+		GetWorld()->SpawnActor<ARoomDesignState>();
+	}
+}
@@ -13,6 +13,9 @@ class Aroom_vizGameMode : public AGameModeBase
 
 public:
 	Aroom_vizGameMode();
+
+	/** Spawns the session's ARoomDesignState unless the level already has one */
+	virtual void StartPlay() override;
 };
 
 